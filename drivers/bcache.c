@@ -0,0 +1,1284 @@
+/****************************************************************************
+ * drivers/bcache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mount.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <queue.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/fs/procfs.h>
+#include <nuttx/drivers/bcache.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_DRVR_BCACHE_WRDELAY
+#  define CONFIG_DRVR_BCACHE_WRDELAY 0
+#endif
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && CONFIG_DRVR_BCACHE_WRDELAY > 0
+#  define BCACHE_WRITEBEHIND 1
+#endif
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+#  define BCACHE_NAMELEN   32
+#  define BCACHE_LINELEN   96
+#  define bcache_count(d,f,n) ((d)->stats.f += (n))
+#else
+#  define bcache_count(d,f,n)
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One cached sector.  Blocks that hold no sector are kept at the tail of
+ * the LRU list so that they are used before any valid block is evicted.
+ */
+
+struct bcache_block_s
+{
+  dq_entry_t lru;                      /* LRU list link (must be first) */
+  FAR struct bcache_block_s *hnext;    /* Next block in the hash chain */
+  size_t     sector;                   /* The cached sector */
+  bool       valid;                    /* True: sector holds valid data */
+  bool       dirty;                    /* True: must be written back */
+  FAR uint8_t *data;                   /* The sector data */
+};
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+struct bcache_stats_s
+{
+  uint32_t   hits;                     /* Sectors read from the cache */
+  uint32_t   misses;                   /* Sectors read from the device */
+  uint32_t   readahead;                /* Sectors read ahead */
+  uint32_t   writes;                   /* Sectors written to the cache */
+  uint32_t   writebacks;               /* Write requests to the device */
+  uint32_t   wrsectors;                /* Sectors written to the device */
+};
+#endif
+
+struct bcache_dev_s
+{
+  FAR struct inode *inode;             /* The underlying block driver */
+  sem_t      exclsem;                  /* Exclusive access to the cache */
+  struct geometry geo;                 /* Underlying device geometry */
+  size_t     nblocks;                  /* Number of blocks in the cache */
+  size_t     ndirty;                   /* Number of dirty blocks */
+  size_t     hashmask;                 /* Hash table size - 1 */
+  size_t     nextsector;               /* Sector following the last read */
+  uint16_t   maxio;                    /* Max sectors in one transfer */
+  uint16_t   refs;                     /* Number of open references */
+  dq_queue_t lru;                      /* Most recently used at the head */
+  FAR struct bcache_block_s *blocks;   /* The cache blocks */
+  FAR struct bcache_block_s **hash;    /* Sector to block hash table */
+  FAR struct bcache_block_s **ioblks;  /* Blocks filled by one read */
+  FAR uint8_t *iobuf;                  /* Bounce buffer of maxio sectors */
+#ifdef BCACHE_WRITEBEHIND
+  struct work_s work;                  /* Timed write back */
+  sem_t      wbsem;                    /* Posted by the worker when closing */
+  uint8_t    wbpending;                /* Write backs queued or running */
+  bool       closing;                  /* bcache_unregister() in progress */
+#endif
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+  FAR struct bcache_dev_s *flink;      /* Next cache in g_bcache_list */
+  struct bcache_stats_s stats;         /* Statistics */
+  char       name[BCACHE_NAMELEN];     /* Path of the cached device */
+#endif
+};
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+/* This structure describes one open /proc/bcache file */
+
+struct bcache_file_s
+{
+  struct procfs_file_s base;           /* Base open file structure */
+  char line[BCACHE_LINELEN];           /* Buffer for formatted lines */
+};
+#endif
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     bcache_open(FAR struct inode *inode);
+static int     bcache_close(FAR struct inode *inode);
+static ssize_t bcache_read(FAR struct inode *inode,
+                 FAR unsigned char *buffer, size_t start_sector,
+                 unsigned int nsectors);
+static ssize_t bcache_write(FAR struct inode *inode,
+                 FAR const unsigned char *buffer, size_t start_sector,
+                 unsigned int nsectors);
+static int     bcache_geometry(FAR struct inode *inode,
+                 FAR struct geometry *geometry);
+static int     bcache_ioctl(FAR struct inode *inode, int cmd,
+                 unsigned long arg);
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+static int     bcache_procfs_open(FAR struct file *filep,
+                 FAR const char *relpath, int oflags, mode_t mode);
+static int     bcache_procfs_close(FAR struct file *filep);
+static ssize_t bcache_procfs_read(FAR struct file *filep, FAR char *buffer,
+                 size_t buflen);
+static int     bcache_procfs_dup(FAR const struct file *oldp,
+                 FAR struct file *newp);
+static int     bcache_procfs_stat(FAR const char *relpath,
+                 FAR struct stat *buf);
+static void    bcache_procfs_remove(FAR struct bcache_dev_s *dev);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct block_operations g_bcache_bops =
+{
+  bcache_open,     /* open */
+  bcache_close,    /* close */
+  bcache_read,     /* read */
+  bcache_write,    /* write */
+  bcache_geometry, /* geometry */
+  bcache_ioctl     /* ioctl */
+#ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+  , NULL           /* unlink */
+#endif
+};
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+static const struct procfs_operations g_bcache_procfsops =
+{
+  bcache_procfs_open,  /* open */
+  bcache_procfs_close, /* close */
+  bcache_procfs_read,  /* read */
+  NULL,                /* write */
+  bcache_procfs_dup,   /* dup */
+  NULL,                /* opendir */
+  NULL,                /* closedir */
+  NULL,                /* readdir */
+  NULL,                /* rewinddir */
+  bcache_procfs_stat   /* stat */
+};
+
+static const struct procfs_entry_s g_bcache_procfs =
+{
+  "bcache",
+  &g_bcache_procfsops
+};
+
+/* All registered caches.  Modified and traversed with the scheduler
+ * locked.
+ */
+
+static FAR struct bcache_dev_s *g_bcache_list;
+static bool g_bcache_procfs_registered;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_semtake
+ ****************************************************************************/
+
+static int bcache_semtake(FAR struct bcache_dev_s *dev)
+{
+  return nxsem_wait(&dev->exclsem);
+}
+
+#define bcache_semgive(d) nxsem_post(&(d)->exclsem)
+
+/****************************************************************************
+ * Name: bcache_lookup
+ *
+ * Description:
+ *   Return the block that holds 'sector' or NULL if it is not cached.
+ *
+ ****************************************************************************/
+
+static FAR struct bcache_block_s *
+bcache_lookup(FAR struct bcache_dev_s *dev, size_t sector)
+{
+  FAR struct bcache_block_s *blk;
+
+  for (blk = dev->hash[sector & dev->hashmask]; blk != NULL;
+       blk = blk->hnext)
+    {
+      if (blk->sector == sector)
+        {
+          return blk;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bcache_hashremove
+ ****************************************************************************/
+
+static void bcache_hashremove(FAR struct bcache_dev_s *dev,
+                              FAR struct bcache_block_s *blk)
+{
+  FAR struct bcache_block_s **pp;
+
+  for (pp = &dev->hash[blk->sector & dev->hashmask]; *pp != NULL;
+       pp = &(*pp)->hnext)
+    {
+      if (*pp == blk)
+        {
+          *pp = blk->hnext;
+          break;
+        }
+    }
+
+  blk->hnext = NULL;
+  blk->valid = false;
+}
+
+/****************************************************************************
+ * Name: bcache_touch
+ *
+ * Description:
+ *   Make the block the most recently used one.
+ *
+ ****************************************************************************/
+
+static inline void bcache_touch(FAR struct bcache_dev_s *dev,
+                                FAR struct bcache_block_s *blk)
+{
+  dq_rem(&blk->lru, &dev->lru);
+  dq_addfirst(&blk->lru, &dev->lru);
+}
+
+/****************************************************************************
+ * Name: bcache_writeback
+ *
+ * Description:
+ *   Write back the dirty block together with the dirty blocks that hold
+ *   the neighbouring sectors, up to maxio sectors in one request.
+ *
+ ****************************************************************************/
+
+static int bcache_writeback(FAR struct bcache_dev_s *dev,
+                            FAR struct bcache_block_s *blk)
+{
+  FAR struct bcache_block_s *next;
+  size_t sector = blk->sector;
+  size_t nsectors;
+  size_t i;
+  ssize_t nwritten;
+
+  DEBUGASSERT(blk->dirty);
+
+  /* Find the first dirty sector of the run */
+
+  while (sector > 0 && blk->sector - sector + 1 < dev->maxio)
+    {
+      next = bcache_lookup(dev, sector - 1);
+      if (next == NULL || !next->dirty)
+        {
+          break;
+        }
+
+      sector--;
+    }
+
+  /* Collect the run in the bounce buffer */
+
+  for (nsectors = 0; nsectors < dev->maxio; nsectors++)
+    {
+      next = bcache_lookup(dev, sector + nsectors);
+      if (next == NULL || !next->dirty)
+        {
+          break;
+        }
+
+      memcpy(&dev->iobuf[nsectors * dev->geo.geo_sectorsize], next->data,
+             dev->geo.geo_sectorsize);
+    }
+
+  DEBUGASSERT(nsectors > 0);
+
+  nwritten = dev->inode->u.i_bops->write(dev->inode, dev->iobuf, sector,
+                                         nsectors);
+  if (nwritten < 0)
+    {
+      ferr("ERROR: Write of %zu sectors at %zu failed: %zd\n",
+           nsectors, sector, nwritten);
+      return (int)nwritten;
+    }
+
+  if ((size_t)nwritten != nsectors)
+    {
+      return -EIO;
+    }
+
+  for (i = 0; i < nsectors; i++)
+    {
+      bcache_lookup(dev, sector + i)->dirty = false;
+    }
+
+  dev->ndirty -= nsectors;
+  bcache_count(dev, writebacks, 1);
+  bcache_count(dev, wrsectors, nsectors);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_flush
+ *
+ * Description:
+ *   Write back all dirty blocks.
+ *
+ ****************************************************************************/
+
+static int bcache_flush(FAR struct bcache_dev_s *dev)
+{
+  size_t i;
+  int ret = OK;
+  int tmp;
+
+  for (i = 0; i < dev->nblocks && dev->ndirty > 0; i++)
+    {
+      if (dev->blocks[i].dirty)
+        {
+          tmp = bcache_writeback(dev, &dev->blocks[i]);
+          if (tmp < 0)
+            {
+              ret = tmp;
+            }
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_alloc
+ *
+ * Description:
+ *   Assign the least recently used block to 'sector' and make it the most
+ *   recently used one.  The contents of the block are undefined.
+ *
+ ****************************************************************************/
+
+static FAR struct bcache_block_s *
+bcache_alloc(FAR struct bcache_dev_s *dev, size_t sector, FAR int *errcode)
+{
+  FAR struct bcache_block_s *blk;
+  int ret;
+
+  blk = (FAR struct bcache_block_s *)dev->lru.tail;
+  DEBUGASSERT(blk != NULL);
+
+  if (blk->dirty)
+    {
+      ret = bcache_writeback(dev, blk);
+      if (ret < 0)
+        {
+          *errcode = ret;
+          return NULL;
+        }
+    }
+
+  if (blk->valid)
+    {
+      bcache_hashremove(dev, blk);
+    }
+
+  blk->sector = sector;
+  blk->valid  = true;
+  blk->hnext  = dev->hash[sector & dev->hashmask];
+  dev->hash[sector & dev->hashmask] = blk;
+
+  bcache_touch(dev, blk);
+  return blk;
+}
+
+/****************************************************************************
+ * Name: bcache_invalidate
+ *
+ * Description:
+ *   Drop a clean block from the cache.
+ *
+ ****************************************************************************/
+
+static void bcache_invalidate(FAR struct bcache_dev_s *dev,
+                              FAR struct bcache_block_s *blk)
+{
+  DEBUGASSERT(!blk->dirty);
+
+  bcache_hashremove(dev, blk);
+  dq_rem(&blk->lru, &dev->lru);
+  dq_addlast(&blk->lru, &dev->lru);
+}
+
+/****************************************************************************
+ * Name: bcache_worker
+ *
+ * Description:
+ *   Timed write back, runs on the low priority work queue.  If the cache
+ *   is being unregistered, the worker only tells bcache_unregister() that
+ *   it no longer uses the cache.
+ *
+ ****************************************************************************/
+
+#ifdef BCACHE_WRITEBEHIND
+static void bcache_worker(FAR void *arg)
+{
+  FAR struct bcache_dev_s *dev = (FAR struct bcache_dev_s *)arg;
+
+  nxsem_wait_uninterruptible(&dev->exclsem);
+
+  DEBUGASSERT(dev->wbpending > 0);
+  dev->wbpending--;
+
+  if (dev->closing)
+    {
+      nxsem_post(&dev->wbsem);
+    }
+  else
+    {
+      bcache_flush(dev);
+    }
+
+  bcache_semgive(dev);
+}
+#endif
+
+/****************************************************************************
+ * Name: bcache_open
+ ****************************************************************************/
+
+static int bcache_open(FAR struct inode *inode)
+{
+  FAR struct bcache_dev_s *dev;
+  int ret;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+
+  ret = bcache_semtake(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev->refs++;
+  bcache_semgive(dev);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_close
+ ****************************************************************************/
+
+static int bcache_close(FAR struct inode *inode)
+{
+  FAR struct bcache_dev_s *dev;
+  int ret;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+
+  nxsem_wait_uninterruptible(&dev->exclsem);
+
+  DEBUGASSERT(dev->refs > 0);
+  dev->refs--;
+
+  /* Nothing is left behind in the cache when the last user goes away */
+
+  ret = OK;
+  if (dev->refs == 0)
+    {
+      ret = bcache_flush(dev);
+    }
+
+  bcache_semgive(dev);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_read
+ ****************************************************************************/
+
+static ssize_t bcache_read(FAR struct inode *inode,
+                           FAR unsigned char *buffer, size_t start_sector,
+                           unsigned int nsectors)
+{
+  FAR struct bcache_dev_s *dev;
+  FAR struct bcache_block_s *blk;
+  size_t sectsize;
+  size_t sector;
+  size_t nread;
+  size_t nreq;
+  size_t n;
+  size_t i;
+  ssize_t ret;
+  int errcode;
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+  bool sequential;
+#endif
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+  sectsize = dev->geo.geo_sectorsize;
+
+  ret = bcache_semtake(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+  sequential = (start_sector == dev->nextsector);
+#endif
+
+  for (nread = 0; nread < nsectors; )
+    {
+      sector = start_sector + nread;
+
+      blk = bcache_lookup(dev, sector);
+      if (blk != NULL)
+        {
+          memcpy(&buffer[nread * sectsize], blk->data, sectsize);
+          bcache_touch(dev, blk);
+          bcache_count(dev, hits, 1);
+          nread++;
+          continue;
+        }
+
+      /* Read the run of sectors that are not cached with one request */
+
+      n = 1;
+      while (n < dev->maxio && nread + n < nsectors &&
+             bcache_lookup(dev, sector + n) == NULL)
+        {
+          n++;
+        }
+
+      nreq = n;
+
+#ifdef CONFIG_DRVR_BCACHE_READAHEAD
+      /* If the run reaches the end of a sequential read, then continue
+       * with the sectors that are likely to be read next.
+       */
+
+      if (sequential && nread + n == nsectors)
+        {
+          while (n < dev->maxio && sector + n < dev->geo.geo_nsectors &&
+                 bcache_lookup(dev, sector + n) == NULL)
+            {
+              n++;
+            }
+        }
+#endif
+
+      /* Assign the blocks first: evicting dirty blocks uses the bounce
+       * buffer.
+       */
+
+      errcode = OK;
+      for (i = 0; i < n; i++)
+        {
+          dev->ioblks[i] = bcache_alloc(dev, sector + i, &errcode);
+        }
+
+      ret = dev->inode->u.i_bops->read == NULL ? -EACCES : 0;
+      if (ret == 0)
+        {
+          ret = dev->inode->u.i_bops->read(dev->inode, dev->iobuf, sector,
+                                           n);
+        }
+
+      if (ret <= 0)
+        {
+          for (i = 0; i < n; i++)
+            {
+              if (dev->ioblks[i] != NULL)
+                {
+                  bcache_invalidate(dev, dev->ioblks[i]);
+                }
+            }
+
+          if (ret == 0)
+            {
+              ret = errcode < 0 ? errcode : -EIO;
+            }
+
+          goto errout;
+        }
+
+      /* Fill the cache and the caller's buffer */
+
+      for (i = 0; i < n; i++)
+        {
+          blk = dev->ioblks[i];
+          if (i >= (size_t)ret)
+            {
+              if (blk != NULL)
+                {
+                  bcache_invalidate(dev, blk);
+                }
+
+              continue;
+            }
+
+          if (blk != NULL)
+            {
+              memcpy(blk->data, &dev->iobuf[i * sectsize], sectsize);
+            }
+
+          if (i < nreq)
+            {
+              memcpy(&buffer[(nread + i) * sectsize],
+                     &dev->iobuf[i * sectsize], sectsize);
+            }
+        }
+
+      if ((size_t)ret < nreq)
+        {
+          /* Short read from the device */
+
+          nread += ret;
+          break;
+        }
+
+      nread += nreq;
+      bcache_count(dev, misses, nreq);
+      bcache_count(dev, readahead, ret - nreq);
+    }
+
+  dev->nextsector = start_sector + nread;
+  bcache_semgive(dev);
+  return nread;
+
+errout:
+  dev->nextsector = start_sector + nread;
+  bcache_semgive(dev);
+  return nread > 0 ? (ssize_t)nread : ret;
+}
+
+/****************************************************************************
+ * Name: bcache_write
+ ****************************************************************************/
+
+static ssize_t bcache_write(FAR struct inode *inode,
+                            FAR const unsigned char *buffer,
+                            size_t start_sector, unsigned int nsectors)
+{
+  FAR struct bcache_dev_s *dev;
+  FAR struct bcache_block_s *blk;
+  size_t sectsize;
+  size_t nwritten;
+  int errcode;
+  int ret;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+  sectsize = dev->geo.geo_sectorsize;
+
+  if (dev->inode->u.i_bops->write == NULL)
+    {
+      return -EACCES;
+    }
+
+  ret = bcache_semtake(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  errcode = OK;
+  for (nwritten = 0; nwritten < nsectors; nwritten++)
+    {
+      blk = bcache_lookup(dev, start_sector + nwritten);
+      if (blk != NULL)
+        {
+          bcache_touch(dev, blk);
+        }
+      else
+        {
+          blk = bcache_alloc(dev, start_sector + nwritten, &errcode);
+          if (blk == NULL)
+            {
+              break;
+            }
+        }
+
+      memcpy(blk->data, &buffer[nwritten * sectsize], sectsize);
+      if (!blk->dirty)
+        {
+          blk->dirty = true;
+          dev->ndirty++;
+        }
+    }
+
+  bcache_count(dev, writes, nwritten);
+
+#ifdef BCACHE_WRITEBEHIND
+  /* Start the write back timer unless it is already running */
+
+  if (dev->ndirty > 0 && !dev->closing && work_available(&dev->work))
+    {
+      if (work_queue(LPWORK, &dev->work, bcache_worker, dev,
+                     MSEC2TICK(CONFIG_DRVR_BCACHE_WRDELAY)) == OK)
+        {
+          dev->wbpending++;
+        }
+    }
+#endif
+
+  bcache_semgive(dev);
+  return nwritten > 0 ? (ssize_t)nwritten : errcode;
+}
+
+/****************************************************************************
+ * Name: bcache_geometry
+ ****************************************************************************/
+
+static int bcache_geometry(FAR struct inode *inode,
+                           FAR struct geometry *geometry)
+{
+  FAR struct bcache_dev_s *dev;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+
+  return dev->inode->u.i_bops->geometry(dev->inode, geometry);
+}
+
+/****************************************************************************
+ * Name: bcache_ioctl
+ *
+ * Description:
+ *   The cache is written back before any command is passed on so that the
+ *   underlying driver sees the current data (BIOC_XIPBASE, for example).
+ *
+ ****************************************************************************/
+
+static int bcache_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
+{
+  FAR struct bcache_dev_s *dev;
+  int ret;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+
+  ret = bcache_semtake(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = bcache_flush(dev);
+  bcache_semgive(dev);
+
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (dev->inode->u.i_bops->ioctl == NULL)
+    {
+      return cmd == BIOC_FLUSH ? OK : -ENOTTY;
+    }
+
+  ret = dev->inode->u.i_bops->ioctl(dev->inode, cmd, arg);
+  if (cmd == BIOC_FLUSH && ret == -ENOTTY)
+    {
+      ret = OK;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_free
+ ****************************************************************************/
+
+static void bcache_free(FAR struct bcache_dev_s *dev)
+{
+  if (dev->hash != NULL)
+    {
+      kmm_free(dev->hash);
+    }
+
+  if (dev->ioblks != NULL)
+    {
+      kmm_free(dev->ioblks);
+    }
+
+  if (dev->iobuf != NULL)
+    {
+      kmm_free(dev->iobuf);
+    }
+
+  if (dev->blocks != NULL)
+    {
+      kmm_free(dev->blocks);
+    }
+
+#ifdef BCACHE_WRITEBEHIND
+  nxsem_destroy(&dev->wbsem);
+#endif
+  nxsem_destroy(&dev->exclsem);
+  kmm_free(dev);
+}
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+/****************************************************************************
+ * Name: bcache_procfs_open
+ ****************************************************************************/
+
+static int bcache_procfs_open(FAR struct file *filep,
+                              FAR const char *relpath, int oflags,
+                              mode_t mode)
+{
+  FAR struct bcache_file_s *priv;
+
+  finfo("Open '%s'\n", relpath);
+
+  /* PROCFS is read-only */
+
+  if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0)
+    {
+      ferr("ERROR: Only O_RDONLY supported\n");
+      return -EACCES;
+    }
+
+  if (strcmp(relpath, "bcache") != 0)
+    {
+      ferr("ERROR: relpath is '%s'\n", relpath);
+      return -ENOENT;
+    }
+
+  priv = (FAR struct bcache_file_s *)
+    kmm_zalloc(sizeof(struct bcache_file_s));
+  if (priv == NULL)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  filep->f_priv = (FAR void *)priv;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_close
+ ****************************************************************************/
+
+static int bcache_procfs_close(FAR struct file *filep)
+{
+  FAR struct bcache_file_s *priv;
+
+  priv = (FAR struct bcache_file_s *)filep->f_priv;
+  DEBUGASSERT(priv);
+
+  kmm_free(priv);
+  filep->f_priv = NULL;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_read
+ ****************************************************************************/
+
+static ssize_t bcache_procfs_read(FAR struct file *filep, FAR char *buffer,
+                                  size_t buflen)
+{
+  FAR struct bcache_file_s *priv;
+  FAR struct bcache_dev_s *dev;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  off_t offset = filep->f_pos;
+
+  priv = (FAR struct bcache_file_s *)filep->f_priv;
+  DEBUGASSERT(priv);
+
+  linesize = snprintf(priv->line, BCACHE_LINELEN,
+                      "%-16s %10s %10s %10s %10s %10s %10s %6s\n",
+                      "Device", "Hits", "Misses", "Readahead", "Writes",
+                      "Writebacks", "Wrsectors", "Dirty");
+  totalsize = procfs_memcpy(priv->line, linesize, buffer, buflen, &offset);
+
+  sched_lock();
+  for (dev = g_bcache_list; dev != NULL && totalsize < buflen;
+       dev = dev->flink)
+    {
+      linesize = snprintf(priv->line, BCACHE_LINELEN,
+                          "%-16s %10lu %10lu %10lu %10lu %10lu %10lu %6lu\n",
+                          dev->name,
+                          (unsigned long)dev->stats.hits,
+                          (unsigned long)dev->stats.misses,
+                          (unsigned long)dev->stats.readahead,
+                          (unsigned long)dev->stats.writes,
+                          (unsigned long)dev->stats.writebacks,
+                          (unsigned long)dev->stats.wrsectors,
+                          (unsigned long)dev->ndirty);
+      copysize = procfs_memcpy(priv->line, linesize, &buffer[totalsize],
+                               buflen - totalsize, &offset);
+      totalsize += copysize;
+    }
+
+  sched_unlock();
+
+  filep->f_pos += totalsize;
+  return totalsize;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_dup
+ ****************************************************************************/
+
+static int bcache_procfs_dup(FAR const struct file *oldp,
+                             FAR struct file *newp)
+{
+  FAR struct bcache_file_s *oldpriv;
+  FAR struct bcache_file_s *newpriv;
+
+  oldpriv = (FAR struct bcache_file_s *)oldp->f_priv;
+  DEBUGASSERT(oldpriv);
+
+  newpriv = (FAR struct bcache_file_s *)
+    kmm_zalloc(sizeof(struct bcache_file_s));
+  if (newpriv == NULL)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  memcpy(newpriv, oldpriv, sizeof(struct bcache_file_s));
+  newp->f_priv = (FAR void *)newpriv;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_stat
+ ****************************************************************************/
+
+static int bcache_procfs_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+  if (strcmp(relpath, "bcache") != 0)
+    {
+      ferr("ERROR: relpath is '%s'\n", relpath);
+      return -ENOENT;
+    }
+
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_remove
+ *
+ * Description:
+ *   Remove a cache from the list shown in /proc/bcache.
+ *
+ ****************************************************************************/
+
+static void bcache_procfs_remove(FAR struct bcache_dev_s *dev)
+{
+  FAR struct bcache_dev_s **pp;
+
+  sched_lock();
+  for (pp = &g_bcache_list; *pp != NULL; pp = &(*pp)->flink)
+    {
+      if (*pp == dev)
+        {
+          *pp = dev->flink;
+          break;
+        }
+    }
+
+  sched_unlock();
+}
+#endif /* CONFIG_DRVR_BCACHE_PROCFS */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_register
+ *
+ * Description:
+ *   Create a cached block device on top of an existing block driver.
+ *
+ ****************************************************************************/
+
+int bcache_register(FAR const char *blkdev, FAR const char *cachedev,
+                    size_t nblocks)
+{
+  FAR struct bcache_dev_s *dev;
+  FAR struct inode *inode;
+  FAR uint8_t *data;
+  size_t nhash;
+  size_t i;
+  int ret;
+
+  if (blkdev == NULL || cachedev == NULL)
+    {
+      return -EINVAL;
+    }
+
+  if (nblocks == 0)
+    {
+      nblocks = CONFIG_DRVR_BCACHE_NBLOCKS;
+    }
+
+  /* Open the underlying block driver.  It stays open while the cache is
+   * registered.
+   */
+
+  ret = open_blockdriver(blkdev, 0, &inode);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to open %s: %d\n", blkdev, ret);
+      return ret;
+    }
+
+  dev = (FAR struct bcache_dev_s *)kmm_zalloc(sizeof(struct bcache_dev_s));
+  if (dev == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_inode;
+    }
+
+  dev->inode   = inode;
+  dev->nblocks = nblocks;
+  dev->maxio   = nblocks < CONFIG_DRVR_BCACHE_MAXIO ?
+                 nblocks : CONFIG_DRVR_BCACHE_MAXIO;
+  nxsem_init(&dev->exclsem, 0, 1);
+
+#ifdef BCACHE_WRITEBEHIND
+  /* wbsem is used for signaling and, hence, should not have priority
+   * inheritance enabled.
+   */
+
+  nxsem_init(&dev->wbsem, 0, 0);
+  nxsem_setprotocol(&dev->wbsem, SEM_PRIO_NONE);
+#endif
+
+  ret = -ENOTTY;
+  if (inode->u.i_bops->geometry != NULL)
+    {
+      ret = inode->u.i_bops->geometry(inode, &dev->geo);
+    }
+
+  if (ret < 0 || !dev->geo.geo_available || dev->geo.geo_sectorsize == 0)
+    {
+      ferr("ERROR: No geometry for %s: %d\n", blkdev, ret);
+      ret = ret < 0 ? ret : -ENODEV;
+      goto errout_with_dev;
+    }
+
+  /* The hash table has a power of two number of chains */
+
+  nhash = 1;
+  while (nhash < nblocks)
+    {
+      nhash <<= 1;
+    }
+
+  dev->hashmask = nhash - 1;
+
+  dev->blocks = (FAR struct bcache_block_s *)
+    kmm_zalloc(nblocks * (sizeof(struct bcache_block_s) +
+                          dev->geo.geo_sectorsize));
+  dev->hash   = (FAR struct bcache_block_s **)
+    kmm_zalloc(nhash * sizeof(FAR struct bcache_block_s *));
+  dev->ioblks = (FAR struct bcache_block_s **)
+    kmm_malloc(dev->maxio * sizeof(FAR struct bcache_block_s *));
+  dev->iobuf  = (FAR uint8_t *)
+    kmm_malloc(dev->maxio * dev->geo.geo_sectorsize);
+
+  if (dev->blocks == NULL || dev->hash == NULL || dev->ioblks == NULL ||
+      dev->iobuf == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_dev;
+    }
+
+  /* The sector data follows the block array */
+
+  data = (FAR uint8_t *)&dev->blocks[nblocks];
+  for (i = 0; i < nblocks; i++)
+    {
+      dev->blocks[i].data = &data[i * dev->geo.geo_sectorsize];
+      dq_addlast(&dev->blocks[i].lru, &dev->lru);
+    }
+
+  /* No read has happened yet, so the first read is not sequential */
+
+  dev->nextsector = SIZE_MAX;
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+  strncpy(dev->name, cachedev, BCACHE_NAMELEN - 1);
+#endif
+
+  ret = register_blockdriver(cachedev, &g_bcache_bops, 0666, dev);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to register %s: %d\n", cachedev, ret);
+      goto errout_with_dev;
+    }
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+  sched_lock();
+  dev->flink    = g_bcache_list;
+  g_bcache_list = dev;
+
+  if (!g_bcache_procfs_registered)
+    {
+      g_bcache_procfs_registered = true;
+      procfs_register(&g_bcache_procfs);
+    }
+
+  sched_unlock();
+#endif
+
+  return OK;
+
+errout_with_dev:
+  bcache_free(dev);
+
+errout_with_inode:
+  close_blockdriver(inode);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_unregister
+ *
+ * Description:
+ *   Remove a cached block device created by bcache_register().
+ *
+ ****************************************************************************/
+
+int bcache_unregister(FAR const char *cachedev)
+{
+  FAR struct bcache_dev_s *dev;
+  FAR struct inode *inode;
+  int ret;
+
+  if (cachedev == NULL)
+    {
+      return -EINVAL;
+    }
+
+  ret = open_blockdriver(cachedev, MS_RDONLY, &inode);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to open %s: %d\n", cachedev, ret);
+      return ret;
+    }
+
+  if (inode->u.i_bops != &g_bcache_bops)
+    {
+      close_blockdriver(inode);
+      return -EINVAL;
+    }
+
+  dev = (FAR struct bcache_dev_s *)inode->i_private;
+  close_blockdriver(inode);
+
+  DEBUGASSERT(dev != NULL);
+
+  /* Are there still open references to the device? */
+
+  if (dev->refs > 0)
+    {
+      return -EBUSY;
+    }
+
+  ret = unregister_blockdriver(cachedev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#ifdef CONFIG_DRVR_BCACHE_PROCFS
+  bcache_procfs_remove(dev);
+#endif
+
+  /* The last close has written back the cache.  Stop the write back timer
+   * and release the underlying device.
+   */
+
+  nxsem_wait_uninterruptible(&dev->exclsem);
+
+#ifdef BCACHE_WRITEBEHIND
+  /* A write back that could not be cancelled may already be running and
+   * waiting for exclsem.  Wait until every such worker has let go of the
+   * cache before it is freed.
+   */
+
+  dev->closing = true;
+  if (work_cancel(LPWORK, &dev->work) == OK)
+    {
+      dev->wbpending--;
+    }
+
+  while (dev->wbpending > 0)
+    {
+      bcache_semgive(dev);
+      nxsem_wait_uninterruptible(&dev->wbsem);
+      nxsem_wait_uninterruptible(&dev->exclsem);
+    }
+#endif
+
+  ret = bcache_flush(dev);
+  bcache_semgive(dev);
+
+  close_blockdriver(dev->inode);
+  bcache_free(dev);
+  return ret;
+}
+
+#endif /* CONFIG_DRVR_BCACHE */
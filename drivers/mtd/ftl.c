@@ -57,6 +57,8 @@
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/drivers/rwbuffer.h>
 
+#include "ftl_log.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -87,7 +89,9 @@ struct ftl_struct_s
   uint16_t              blkper;  /* R/W blocks per erase block */
   uint16_t              refs;    /* Number of references */
   bool                  unlinked;/* The driver has been unlinked */
-#ifdef CONFIG_FS_WRITABLE
+#ifdef CONFIG_FTL_LOG
+  FAR struct ftl_log_s *log;     /* Log-structured translation layer */
+#elif defined(CONFIG_FS_WRITABLE)
   FAR uint8_t          *eblock;  /* One, in-memory erase block */
 #endif
 };
@@ -180,7 +184,9 @@ static int ftl_close(FAR struct inode *inode)
 #ifdef FTL_HAVE_RWBUFFER
       rwb_uninitialize(&dev->rwb);
 #endif
-#ifdef CONFIG_FS_WRITABLE
+#ifdef CONFIG_FTL_LOG
+      ftl_log_uninitialize(dev->log);
+#elif defined(CONFIG_FS_WRITABLE)
       if (dev->eblock)
         {
           kmm_free(dev->eblock);
@@ -205,9 +211,15 @@ static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
   struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
   ssize_t nread;
 
+#ifdef CONFIG_FTL_LOG
+  /* Logical sectors are mapped to flash pages by the log layer */
+
+  nread   = ftl_log_read(dev->log, buffer, startblock, nblocks);
+#else
   /* Read the full erase block into the buffer */
 
   nread   = MTD_BREAD(dev->mtd, startblock, nblocks, buffer);
+#endif
   if (nread != nblocks)
     {
       ferr("ERROR: Read %d blocks starting at block %d failed: %d\n",
@@ -248,7 +260,26 @@ static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_WRITABLE
+#ifdef CONFIG_FTL_LOG
+static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
+                         off_t startblock, size_t nblocks)
+{
+  struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
+  ssize_t nxfrd;
+
+  /* Sectors are appended to the log; no erase block is read back */
+
+  nxfrd = ftl_log_write(dev->log, buffer, startblock, nblocks);
+  if (nxfrd != nblocks)
+    {
+      ferr("ERROR: Write %d blocks starting at block %d failed: %d\n",
+            nblocks, startblock, nxfrd);
+    }
+
+  return nxfrd;
+}
+
+#elif defined(CONFIG_FS_WRITABLE)
 static int ftl_alloc_eblock(FAR struct ftl_struct_s *dev)
 {
   if (dev->eblock == NULL)
@@ -493,7 +524,11 @@ static int ftl_geometry(FAR struct inode *inode, struct geometry *geometry)
 #else
       geometry->geo_writeenabled  = false;
 #endif
+#ifdef CONFIG_FTL_LOG
+      geometry->geo_nsectors      = ftl_log_nsectors(dev->log);
+#else
       geometry->geo_nsectors      = dev->geo.neraseblocks * dev->blkper;
+#endif
       geometry->geo_sectorsize    = dev->geo.blocksize;
 
       finfo("available: true mediachanged: false writeenabled: %s\n",
@@ -531,6 +566,13 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 
   if (cmd == BIOC_XIPBASE)
     {
+#ifdef CONFIG_FTL_LOG
+      /* Logical sectors are not stored in order; there is no linear view
+       * of the block device in the FLASH.
+       */
+
+      return -ENOTTY;
+#else
       /* The argument accompanying the BIOC_XIPBASE should be non-NULL.  If
        * DEBUG is enabled, we will catch it here instead of in the MTD
        * driver.
@@ -547,6 +589,7 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       /* Just change the BIOC_XIPBASE command to the MTDIOC_XIPBASE command. */
 
       cmd = MTDIOC_XIPBASE;
+#endif
     }
 #ifdef CONFIG_FTL_WRITEBUFFER
   else if (cmd == BIOC_FLUSH)
@@ -590,7 +633,9 @@ static int ftl_unlink(FAR struct inode *inode)
 #ifdef FTL_HAVE_RWBUFFER
       rwb_uninitialize(&dev->rwb);
 #endif
-#ifdef CONFIG_FS_WRITABLE
+#ifdef CONFIG_FTL_LOG
+      ftl_log_uninitialize(dev->log);
+#elif defined(CONFIG_FS_WRITABLE)
       if (dev->eblock)
         {
           kmm_free(dev->eblock);
@@ -658,11 +703,27 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd)
       dev->blkper = dev->geo.erasesize / dev->geo.blocksize;
       DEBUGASSERT(dev->blkper * dev->geo.blocksize == dev->geo.erasesize);
 
+#ifdef CONFIG_FTL_LOG
+      /* Scan the FLASH and rebuild the logical to physical sector map */
+
+      ret = ftl_log_initialize(mtd, &dev->geo, &dev->log);
+      if (ret < 0)
+        {
+          ferr("ERROR: ftl_log_initialize failed: %d\n", ret);
+          kmm_free(dev);
+          return ret;
+        }
+#endif
+
       /* Configure read-ahead/write buffering */
 
 #ifdef FTL_HAVE_RWBUFFER
       dev->rwb.blocksize   = dev->geo.blocksize;
+#ifdef CONFIG_FTL_LOG
+      dev->rwb.nblocks     = ftl_log_nsectors(dev->log);
+#else
       dev->rwb.nblocks     = dev->geo.neraseblocks * dev->blkper;
+#endif
       dev->rwb.dev         = (FAR void *)dev;
       dev->rwb.wrflush     = ftl_flush;
       dev->rwb.rhreload    = ftl_reload;
@@ -679,6 +740,9 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd)
       if (ret < 0)
         {
           ferr("ERROR: rwb_initialize failed: %d\n", ret);
+#ifdef CONFIG_FTL_LOG
+          ftl_log_uninitialize(dev->log);
+#endif
           kmm_free(dev);
           return ret;
         }
@@ -692,6 +756,9 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd)
           ferr("ERROR: register_blockdriver failed: %d\n", -ret);
 #ifdef FTL_HAVE_RWBUFFER
           rwb_uninitialize(&dev->rwb);
+#endif
+#ifdef CONFIG_FTL_LOG
+          ftl_log_uninitialize(dev->log);
 #endif
           kmm_free(dev);
         }
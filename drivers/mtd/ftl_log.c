@@ -0,0 +1,1292 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* A log-structured flash translation layer.
+ *
+ * Logical sectors are never rewritten in place.  Each write appends the
+ * data to the erase block that is currently open, preceded by a summary
+ * page that records the logical sector number and a CRC of each of the
+ * data pages that follow it:
+ *
+ *   +--------+---------+------+-----+------+---------+------+-----+
+ *   | header | summary | data | ... | data | summary | data | ... |
+ *   +--------+---------+------+-----+------+---------+------+-----+
+ *
+ * The block header holds the erase count of the block and is written
+ * right after the block is erased.  Each summary carries a global sequence
+ * number so that the most recent copy of a logical sector can be found
+ * when the map is rebuilt from the flash contents.  Because a summary is
+ * always written before its data, the chain of summaries in a block can
+ * be followed from the header without ever interpreting user data.
+ *
+ * Only the most recently written group of pages can be torn by a power
+ * loss; the CRCs of its data pages are verified when the device is
+ * scanned and torn pages fall back to the previous copy of the sector.
+ *
+ * Blocks holding mostly stale copies are reclaimed by copying their live
+ * pages to the open block and erasing them.  Free blocks are allocated in
+ * order of increasing erase count and, when the erase counts drift apart,
+ * the block with the lowest count is reclaimed as well so that it does not
+ * keep static data forever.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <crc32.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/mtd/mtd.h>
+
+#include "ftl_log.h"
+
+#ifdef CONFIG_FTL_LOG
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_FTL_LOG_NRESERVE
+#  define CONFIG_FTL_LOG_NRESERVE 3
+#endif
+
+#ifndef CONFIG_FTL_LOG_WEARLEVEL
+#  define CONFIG_FTL_LOG_WEARLEVEL 64
+#endif
+
+#define FTL_LOG_BMAGIC       0x424c5446  /* "FTLB" */
+#define FTL_LOG_SMAGIC       0x534c5446  /* "FTLS" */
+#define FTL_LOG_UNMAPPED     0xffffffff
+#define FTL_LOG_ERASEDSTATE  0xff        /* Returned for unwritten sectors */
+
+/* Block states */
+
+#define FTL_BLOCK_UNKNOWN    0           /* Must be erased before use */
+#define FTL_BLOCK_FREE       1           /* Erased, with a block header */
+#define FTL_BLOCK_OPEN       2           /* Being written */
+#define FTL_BLOCK_FULL       3           /* Only reclaimed by the GC */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Block header in the first page of each erase block */
+
+struct ftl_log_bhdr_s
+{
+  uint32_t magic;                  /* FTL_LOG_BMAGIC */
+  uint32_t erasecount;             /* Number of times the block was erased */
+  uint32_t crc;                    /* CRC32 of the fields above */
+};
+
+/* Summary page header, followed by nentries of struct ftl_log_entry_s */
+
+struct ftl_log_shdr_s
+{
+  uint32_t magic;                  /* FTL_LOG_SMAGIC */
+  uint32_t seq;                    /* Global sequence number */
+  uint16_t nentries;               /* Number of data pages that follow */
+  uint16_t reserved;
+  uint32_t crc;                    /* CRC32 of the above and the entries */
+};
+
+struct ftl_log_entry_s
+{
+  uint32_t lsector;                /* Logical sector held in the data page */
+  uint32_t crc;                    /* CRC32 of the data page */
+};
+
+/* RAM state of each erase block */
+
+struct ftl_log_block_s
+{
+  uint32_t erasecount;             /* Number of times the block was erased */
+  uint16_t nvalid;                 /* Number of pages holding live sectors */
+  uint8_t  state;                  /* See FTL_BLOCK_* definitions */
+};
+
+struct ftl_log_s
+{
+  FAR struct mtd_dev_s *mtd;       /* Contained MTD interface */
+  sem_t    exclsem;                /* Serializes access to the state */
+  uint32_t blocksize;              /* Size of one R/W block (page) */
+  uint32_t neraseblocks;           /* Number of erase blocks */
+  uint32_t nsectors;               /* Number of logical sectors */
+  uint32_t nfree;                  /* Number of FREE and UNKNOWN blocks */
+  uint32_t seq;                    /* Next summary sequence number */
+  uint32_t maxerase;               /* Highest erase count of any block */
+  uint16_t blkper;                 /* R/W blocks per erase block */
+  uint16_t nentries;               /* Entries per summary page */
+  uint16_t dense;                  /* Data pages in a densely packed block */
+  uint16_t curpage;                /* Next page to write in curblock */
+  int32_t  curblock;               /* The open erase block (-1: none) */
+  FAR uint32_t *map;               /* Logical sector to page map */
+  FAR struct ftl_log_block_s *blocks;
+  FAR uint8_t *sumbuf;             /* Summary page being written */
+  FAR uint8_t *gcbuf;              /* Summary page being reclaimed */
+  FAR uint8_t *pagebuf;            /* Page copy buffer */
+  FAR uint32_t *gcsrc;             /* Source pages of the group in sumbuf */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int ftl_log_reserve(FAR struct ftl_log_s *log, bool gc);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_page
+ *
+ * Description:
+ *   Return the MTD block number of a page in an erase block
+ *
+ ****************************************************************************/
+
+static inline uint32_t ftl_log_page(FAR struct ftl_log_s *log,
+                                    uint32_t block, uint32_t page)
+{
+  return block * log->blkper + page;
+}
+
+/****************************************************************************
+ * Name: ftl_log_bread and ftl_log_bwrite
+ ****************************************************************************/
+
+static int ftl_log_bread(FAR struct ftl_log_s *log, uint32_t page,
+                         size_t npages, FAR uint8_t *buffer)
+{
+  ssize_t nread = MTD_BREAD(log->mtd, page, npages, buffer);
+
+  if (nread != npages)
+    {
+      ferr("ERROR: Read %u pages at %lu failed: %d\n",
+           (unsigned int)npages, (unsigned long)page, (int)nread);
+      return nread < 0 ? (int)nread : -EIO;
+    }
+
+  return OK;
+}
+
+static int ftl_log_bwrite(FAR struct ftl_log_s *log, uint32_t page,
+                          size_t npages, FAR const uint8_t *buffer)
+{
+  ssize_t nwritten = MTD_BWRITE(log->mtd, page, npages, buffer);
+
+  if (nwritten != npages)
+    {
+      ferr("ERROR: Write %u pages at %lu failed: %d\n",
+           (unsigned int)npages, (unsigned long)page, (int)nwritten);
+      return nwritten < 0 ? (int)nwritten : -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_checksummary
+ *
+ * Description:
+ *   Check if the page holds a valid summary that fits in the erase block
+ *   after the page 'page'.
+ *
+ ****************************************************************************/
+
+static bool ftl_log_checksummary(FAR struct ftl_log_s *log,
+                                 FAR const uint8_t *buffer, uint32_t page)
+{
+  FAR const struct ftl_log_shdr_s *shdr =
+    (FAR const struct ftl_log_shdr_s *)buffer;
+  uint32_t crc;
+
+  if (shdr->magic != FTL_LOG_SMAGIC || shdr->nentries == 0 ||
+      shdr->nentries > log->nentries ||
+      page + 1 + shdr->nentries > log->blkper)
+    {
+      return false;
+    }
+
+  crc = crc32(buffer, offsetof(struct ftl_log_shdr_s, crc));
+  crc = crc32part(buffer + sizeof(struct ftl_log_shdr_s),
+                  shdr->nentries * sizeof(struct ftl_log_entry_s), crc);
+  return crc == shdr->crc;
+}
+
+/****************************************************************************
+ * Name: ftl_log_erased
+ *
+ * Description:
+ *   Check if a page read from the flash looks erased
+ *
+ ****************************************************************************/
+
+static bool ftl_log_erased(FAR struct ftl_log_s *log,
+                           FAR const uint8_t *buffer)
+{
+  uint32_t i;
+
+  for (i = 1; i < log->blocksize; i++)
+    {
+      if (buffer[i] != buffer[0])
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ftl_log_erase
+ *
+ * Description:
+ *   Erase a block and write its block header.  The block becomes FREE.
+ *
+ ****************************************************************************/
+
+static int ftl_log_erase(FAR struct ftl_log_s *log, uint32_t block)
+{
+  FAR struct ftl_log_block_s *blk = &log->blocks[block];
+  FAR struct ftl_log_bhdr_s *bhdr;
+  int ret;
+
+  ret = MTD_ERASE(log->mtd, block, 1);
+  if (ret < 0)
+    {
+      ferr("ERROR: Erase block %lu failed: %d\n", (unsigned long)block, ret);
+      blk->state = FTL_BLOCK_UNKNOWN;
+      return ret;
+    }
+
+  blk->erasecount++;
+  if (blk->erasecount > log->maxerase)
+    {
+      log->maxerase = blk->erasecount;
+    }
+
+  memset(log->pagebuf, FTL_LOG_ERASEDSTATE, log->blocksize);
+  bhdr             = (FAR struct ftl_log_bhdr_s *)log->pagebuf;
+  bhdr->magic      = FTL_LOG_BMAGIC;
+  bhdr->erasecount = blk->erasecount;
+  bhdr->crc        = crc32(log->pagebuf,
+                           offsetof(struct ftl_log_bhdr_s, crc));
+
+  ret = ftl_log_bwrite(log, ftl_log_page(log, block, 0), 1, log->pagebuf);
+  if (ret < 0)
+    {
+      blk->state = FTL_BLOCK_UNKNOWN;
+      return ret;
+    }
+
+  blk->state  = FTL_BLOCK_FREE;
+  blk->nvalid = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_writesummary
+ *
+ * Description:
+ *   Write the summary in sumbuf describing the next 'n' pages of the open
+ *   block.
+ *
+ ****************************************************************************/
+
+static int ftl_log_writesummary(FAR struct ftl_log_s *log, uint16_t n)
+{
+  FAR struct ftl_log_shdr_s *shdr = (FAR struct ftl_log_shdr_s *)log->sumbuf;
+  size_t used = sizeof(struct ftl_log_shdr_s) +
+                n * sizeof(struct ftl_log_entry_s);
+  uint32_t crc;
+
+  shdr->magic    = FTL_LOG_SMAGIC;
+  shdr->seq      = log->seq++;
+  shdr->nentries = n;
+  shdr->reserved = 0xffff;
+
+  crc = crc32(log->sumbuf, offsetof(struct ftl_log_shdr_s, crc));
+  shdr->crc = crc32part(log->sumbuf + sizeof(struct ftl_log_shdr_s),
+                        n * sizeof(struct ftl_log_entry_s), crc);
+
+  memset(log->sumbuf + used, FTL_LOG_ERASEDSTATE, log->blocksize - used);
+  return ftl_log_bwrite(log, ftl_log_page(log, log->curblock, log->curpage),
+                        1, log->sumbuf);
+}
+
+/****************************************************************************
+ * Name: ftl_log_remap
+ *
+ * Description:
+ *   Make 'page' the current copy of the logical sector.
+ *
+ ****************************************************************************/
+
+static void ftl_log_remap(FAR struct ftl_log_s *log, uint32_t lsector,
+                          uint32_t page)
+{
+  uint32_t old = log->map[lsector];
+
+  if (old != FTL_LOG_UNMAPPED)
+    {
+      DEBUGASSERT(log->blocks[old / log->blkper].nvalid > 0);
+      log->blocks[old / log->blkper].nvalid--;
+    }
+
+  log->map[lsector] = page;
+  log->blocks[page / log->blkper].nvalid++;
+}
+
+/****************************************************************************
+ * Name: ftl_log_copygroup
+ *
+ * Description:
+ *   Write the 'cnt' entries collected in sumbuf as a new group in the open
+ *   block, copying the data from the pages listed in gcsrc.
+ *
+ ****************************************************************************/
+
+static int ftl_log_copygroup(FAR struct ftl_log_s *log, uint16_t cnt)
+{
+  FAR struct ftl_log_entry_s *entry =
+    (FAR struct ftl_log_entry_s *)(log->sumbuf +
+                                   sizeof(struct ftl_log_shdr_s));
+  uint32_t newpage;
+  uint16_t i;
+  int ret;
+
+  ret = ftl_log_writesummary(log, cnt);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  log->curpage++;
+
+  for (i = 0; i < cnt; i++)
+    {
+      ret = ftl_log_bread(log, log->gcsrc[i], 1, log->pagebuf);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      newpage = ftl_log_page(log, log->curblock, log->curpage);
+      ret     = ftl_log_bwrite(log, newpage, 1, log->pagebuf);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ftl_log_remap(log, entry[i].lsector, newpage);
+      log->curpage++;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_reclaim
+ *
+ * Description:
+ *   Copy the live pages of a FULL block to the open block, then erase it.
+ *   The summaries of the block are followed to find the logical sectors;
+ *   a page is live if the map still refers to it.  Live pages from all of
+ *   the groups of the block are gathered into as few new groups as
+ *   possible.
+ *
+ ****************************************************************************/
+
+static int ftl_log_reclaim(FAR struct ftl_log_s *log, uint32_t victim)
+{
+  FAR struct ftl_log_shdr_s *shdr = (FAR struct ftl_log_shdr_s *)log->gcbuf;
+  FAR struct ftl_log_entry_s *src;
+  FAR struct ftl_log_entry_s *dst;
+  uint32_t page = 1;
+  uint32_t first;
+  uint16_t limit = 0;
+  uint16_t cnt = 0;
+  uint16_t i;
+  int ret;
+
+  finfo("Reclaim block %lu: %u live pages\n",
+        (unsigned long)victim, log->blocks[victim].nvalid);
+
+  src = (FAR struct ftl_log_entry_s *)(log->gcbuf + sizeof(*shdr));
+  dst = (FAR struct ftl_log_entry_s *)(log->sumbuf + sizeof(*shdr));
+
+  while (page < log->blkper && log->blocks[victim].nvalid > cnt)
+    {
+      ret = ftl_log_bread(log, ftl_log_page(log, victim, page), 1,
+                          log->gcbuf);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (!ftl_log_checksummary(log, log->gcbuf, page))
+        {
+          break;
+        }
+
+      first = ftl_log_page(log, victim, page + 1);
+
+      for (i = 0; i < shdr->nentries; i++)
+        {
+          if (src[i].lsector >= log->nsectors ||
+              log->map[src[i].lsector] != first + i)
+            {
+              continue;
+            }
+
+          /* Make room in the open block for the group being collected */
+
+          if (limit == 0)
+            {
+              ret = ftl_log_reserve(log, true);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              limit = log->blkper - log->curpage - 1;
+              if (limit > log->nentries)
+                {
+                  limit = log->nentries;
+                }
+            }
+
+          log->gcsrc[cnt] = first + i;
+          dst[cnt++]      = src[i];
+
+          if (cnt == limit)
+            {
+              ret = ftl_log_copygroup(log, cnt);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              limit = 0;
+              cnt   = 0;
+            }
+        }
+
+      page += 1 + shdr->nentries;
+    }
+
+  if (cnt > 0)
+    {
+      ret = ftl_log_copygroup(log, cnt);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (log->blocks[victim].nvalid > 0)
+    {
+      ferr("ERROR: Block %lu still has %u live pages\n",
+           (unsigned long)victim, log->blocks[victim].nvalid);
+      return -EIO;
+    }
+
+  ret = ftl_log_erase(log, victim);
+  log->nfree++;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_gc
+ *
+ * Description:
+ *   Reclaim the FULL block with the fewest live pages.
+ *
+ ****************************************************************************/
+
+static int ftl_log_gc(FAR struct ftl_log_s *log)
+{
+  uint32_t victim = FTL_LOG_UNMAPPED;
+  uint32_t block;
+
+  for (block = 0; block < log->neraseblocks; block++)
+    {
+      if (log->blocks[block].state == FTL_BLOCK_FULL &&
+          (victim == FTL_LOG_UNMAPPED ||
+           log->blocks[block].nvalid < log->blocks[victim].nvalid))
+        {
+          victim = block;
+        }
+    }
+
+  /* Reclaiming a block that is as full as a densely packed one would not
+   * gain anything.
+   */
+
+  if (victim == FTL_LOG_UNMAPPED || log->blocks[victim].nvalid >= log->dense)
+    {
+      ferr("ERROR: No space to reclaim\n");
+      return -ENOSPC;
+    }
+
+  return ftl_log_reclaim(log, victim);
+}
+
+/****************************************************************************
+ * Name: ftl_log_wearlevel
+ *
+ * Description:
+ *   Reclaim the FULL block with the lowest erase count if it has fallen too
+ *   far behind.  Such a block holds static data that would otherwise keep
+ *   it out of the rotation.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FTL_LOG_WEARLEVEL > 0
+static int ftl_log_wearlevel(FAR struct ftl_log_s *log)
+{
+  uint32_t victim = FTL_LOG_UNMAPPED;
+  uint32_t block;
+
+  for (block = 0; block < log->neraseblocks; block++)
+    {
+      if (log->blocks[block].state == FTL_BLOCK_FULL &&
+          (victim == FTL_LOG_UNMAPPED ||
+           log->blocks[block].erasecount < log->blocks[victim].erasecount))
+        {
+          victim = block;
+        }
+    }
+
+  if (victim == FTL_LOG_UNMAPPED ||
+      log->maxerase - log->blocks[victim].erasecount <=
+      CONFIG_FTL_LOG_WEARLEVEL)
+    {
+      return OK;
+    }
+
+  return ftl_log_reclaim(log, victim);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_reserve
+ *
+ * Description:
+ *   Make sure that the open block has room for a summary and at least one
+ *   data page, opening a new block if necessary.  Writes from the user
+ *   ('gc' false) first reclaim blocks to keep CONFIG_FTL_LOG_NRESERVE free
+ *   blocks for the garbage collector itself.
+ *
+ ****************************************************************************/
+
+static int ftl_log_reserve(FAR struct ftl_log_s *log, bool gc)
+{
+  FAR struct ftl_log_block_s *blk;
+  uint32_t ngc = 0;
+  uint32_t block;
+  uint32_t best;
+  int ret;
+
+  for (; ; )
+    {
+      /* Reclaim before using the open block, too: A block opened by the
+       * garbage collector must not eat into the reserve, otherwise a power
+       * loss may leave no free block to relocate to after the next mount.
+       */
+
+      if (!gc && log->nfree < CONFIG_FTL_LOG_NRESERVE)
+        {
+          /* Reclaiming every block once without getting enough free
+           * blocks means that there is nothing left to gain.
+           */
+
+          if (ngc++ > log->neraseblocks)
+            {
+              return -ENOSPC;
+            }
+
+          ret = ftl_log_gc(log);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          continue;
+        }
+
+      if (log->curblock >= 0)
+        {
+          if (log->blkper - log->curpage >= 2)
+            {
+              return OK;
+            }
+
+          /* The open block is full */
+
+          log->blocks[log->curblock].state = FTL_BLOCK_FULL;
+          log->curblock = -1;
+
+#if CONFIG_FTL_LOG_WEARLEVEL > 0
+          if (!gc)
+            {
+              ret = ftl_log_wearlevel(log);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              continue;
+            }
+#endif
+        }
+
+      /* Open the free block with the lowest erase count */
+
+      best = FTL_LOG_UNMAPPED;
+      for (block = 0; block < log->neraseblocks; block++)
+        {
+          blk = &log->blocks[block];
+          if ((blk->state == FTL_BLOCK_FREE ||
+               blk->state == FTL_BLOCK_UNKNOWN) &&
+              (best == FTL_LOG_UNMAPPED ||
+               blk->erasecount < log->blocks[best].erasecount))
+            {
+              best = block;
+            }
+        }
+
+      if (best == FTL_LOG_UNMAPPED)
+        {
+          return -ENOSPC;
+        }
+
+      blk = &log->blocks[best];
+      if (blk->state == FTL_BLOCK_UNKNOWN)
+        {
+          ret = ftl_log_erase(log, best);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      log->nfree--;
+      blk->state    = FTL_BLOCK_OPEN;
+      log->curblock = best;
+      log->curpage  = 1;
+    }
+}
+
+/****************************************************************************
+ * Name: ftl_log_readsectors and ftl_log_writesectors
+ *
+ * Description:
+ *   Read or write logical sectors.  The caller holds exclsem.
+ *
+ ****************************************************************************/
+
+static int ftl_log_readsectors(FAR struct ftl_log_s *log,
+                               FAR uint8_t *buffer, uint32_t lsector,
+                               size_t nsectors)
+{
+  uint32_t page;
+  size_t n;
+  int ret;
+
+  while (nsectors > 0)
+    {
+      page = log->map[lsector];
+      if (page == FTL_LOG_UNMAPPED)
+        {
+          memset(buffer, FTL_LOG_ERASEDSTATE, log->blocksize);
+          n = 1;
+        }
+      else
+        {
+          /* Read sectors that are also consecutive in the flash at once */
+
+          for (n = 1; n < nsectors && log->map[lsector + n] == page + n;
+               n++)
+            {
+            }
+
+          ret = ftl_log_bread(log, page, n, buffer);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      buffer   += n * log->blocksize;
+      lsector  += n;
+      nsectors -= n;
+    }
+
+  return OK;
+}
+
+static int ftl_log_writesectors(FAR struct ftl_log_s *log,
+                                FAR const uint8_t *buffer, uint32_t lsector,
+                                size_t nsectors)
+{
+  FAR struct ftl_log_entry_s *entry;
+  uint32_t page;
+  uint16_t n;
+  uint16_t i;
+  int ret;
+
+  entry = (FAR struct ftl_log_entry_s *)
+          (log->sumbuf + sizeof(struct ftl_log_shdr_s));
+
+  while (nsectors > 0)
+    {
+      ret = ftl_log_reserve(log, false);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      n = log->blkper - log->curpage - 1;
+      if (n > log->nentries)
+        {
+          n = log->nentries;
+        }
+
+      if (n > nsectors)
+        {
+          n = nsectors;
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          entry[i].lsector = lsector + i;
+          entry[i].crc     = crc32(buffer + i * log->blocksize,
+                                   log->blocksize);
+        }
+
+      ret = ftl_log_writesummary(log, n);
+      if (ret == OK)
+        {
+          page = ftl_log_page(log, log->curblock, log->curpage + 1);
+          ret  = ftl_log_bwrite(log, page, n, buffer);
+        }
+
+      if (ret < 0)
+        {
+          /* Do not append anything more to a block in an unknown state */
+
+          log->blocks[log->curblock].state = FTL_BLOCK_FULL;
+          log->curblock = -1;
+          return ret;
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          ftl_log_remap(log, lsector + i, page + i);
+        }
+
+      log->curpage += 1 + n;
+      buffer       += n * log->blocksize;
+      lsector      += n;
+      nsectors     -= n;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_apply
+ *
+ * Description:
+ *   Apply the entries of one summary while scanning the device.
+ *
+ ****************************************************************************/
+
+static void ftl_log_apply(FAR struct ftl_log_s *log, FAR uint32_t *seqtab,
+                          FAR const uint8_t *summary, uint32_t first)
+{
+  FAR const struct ftl_log_shdr_s *shdr =
+    (FAR const struct ftl_log_shdr_s *)summary;
+  FAR const struct ftl_log_entry_s *entry =
+    (FAR const struct ftl_log_entry_s *)(summary + sizeof(*shdr));
+  uint32_t lsector;
+  uint16_t i;
+
+  for (i = 0; i < shdr->nentries; i++)
+    {
+      lsector = entry[i].lsector;
+      if (lsector < log->nsectors &&
+          (log->map[lsector] == FTL_LOG_UNMAPPED ||
+           (int32_t)(shdr->seq - seqtab[lsector]) > 0))
+        {
+          ftl_log_remap(log, lsector, first + i);
+          seqtab[lsector] = shdr->seq;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: ftl_log_scan
+ *
+ * Description:
+ *   Rebuild the map and the block states from the flash contents.
+ *
+ ****************************************************************************/
+
+static int ftl_log_scan(FAR struct ftl_log_s *log)
+{
+  FAR struct ftl_log_bhdr_s *bhdr =
+    (FAR struct ftl_log_bhdr_s *)log->pagebuf;
+  FAR struct ftl_log_shdr_s *shdr =
+    (FAR struct ftl_log_shdr_s *)log->gcbuf;
+  FAR struct ftl_log_entry_s *entry =
+    (FAR struct ftl_log_entry_s *)(log->gcbuf + sizeof(*shdr));
+  FAR struct ftl_log_block_s *blk;
+  FAR uint32_t *seqtab;
+  FAR uint32_t *torn = NULL;
+  FAR uint8_t *copy = NULL;
+  uint32_t lastpage = FTL_LOG_UNMAPPED;
+  uint32_t lastseq = 0;
+  uint32_t lastend = 0;
+  uint32_t ntorn = 0;
+  uint32_t ecsum = 0;
+  uint32_t nknown = 0;
+  uint32_t block;
+  uint32_t page;
+  uint32_t i;
+  bool found = false;
+  bool erased;
+  int ret = OK;
+
+  seqtab = (FAR uint32_t *)kmm_malloc(log->nsectors * sizeof(uint32_t));
+  if (seqtab == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (block = 0; block < log->neraseblocks; block++)
+    {
+      blk = &log->blocks[block];
+
+      ret = ftl_log_bread(log, ftl_log_page(log, block, 0), 1,
+                          log->pagebuf);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      if (bhdr->magic != FTL_LOG_BMAGIC ||
+          bhdr->crc != crc32(log->pagebuf,
+                             offsetof(struct ftl_log_bhdr_s, crc)))
+        {
+          blk->state = FTL_BLOCK_UNKNOWN;
+          continue;
+        }
+
+      blk->erasecount = bhdr->erasecount;
+      blk->state      = FTL_BLOCK_FREE;
+      ecsum          += bhdr->erasecount;
+      nknown++;
+
+      if (bhdr->erasecount > log->maxerase)
+        {
+          log->maxerase = bhdr->erasecount;
+        }
+
+      /* Follow the chain of summaries.  The group with the highest
+       * sequence number is applied last, after its data is verified.
+       */
+
+      for (page = 1; page < log->blkper; page += 1 + shdr->nentries)
+        {
+          ret = ftl_log_bread(log, ftl_log_page(log, block, page), 1,
+                              log->gcbuf);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+
+          if (!ftl_log_checksummary(log, log->gcbuf, page))
+            {
+              break;
+            }
+
+          blk->state = FTL_BLOCK_FULL;
+
+          if (found && (int32_t)(shdr->seq - lastseq) < 0)
+            {
+              ftl_log_apply(log, seqtab, log->gcbuf,
+                            ftl_log_page(log, block, page + 1));
+              continue;
+            }
+
+          if (found)
+            {
+              /* Apply the previous most recent group */
+
+              ret = ftl_log_bread(log, lastpage, 1, log->sumbuf);
+              if (ret < 0)
+                {
+                  goto errout;
+                }
+
+              ftl_log_apply(log, seqtab, log->sumbuf, lastpage + 1);
+            }
+
+          found    = true;
+          lastseq  = shdr->seq;
+          lastpage = ftl_log_page(log, block, page);
+        }
+
+      /* The pages after the last summary can only be written if they are
+       * still erased:  The next summary may have been torn.  A block
+       * without summaries is then FREE; the most recently written block
+       * can be appended to.
+       */
+
+      erased = page < log->blkper && ftl_log_erased(log, log->gcbuf);
+      if (blk->state == FTL_BLOCK_FREE && !erased)
+        {
+          blk->state = FTL_BLOCK_UNKNOWN;
+        }
+
+      if (found && lastpage / log->blkper == block)
+        {
+          lastend = erased ? page : log->blkper;
+        }
+    }
+
+  /* Verify the data of the most recent group before applying it */
+
+  if (found)
+    {
+      ret = ftl_log_bread(log, lastpage, 1, log->gcbuf);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      torn = (FAR uint32_t *)kmm_malloc(shdr->nentries * sizeof(uint32_t));
+      if (torn == NULL)
+        {
+          ret = -ENOMEM;
+          goto errout;
+        }
+
+      for (i = 0; i < shdr->nentries; i++)
+        {
+          ret = ftl_log_bread(log, lastpage + 1 + i, 1, log->pagebuf);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+
+          if (crc32(log->pagebuf, log->blocksize) != entry[i].crc)
+            {
+              torn[ntorn++] = entry[i].lsector;
+              entry[i].lsector = FTL_LOG_UNMAPPED;
+            }
+        }
+
+      ftl_log_apply(log, seqtab, log->gcbuf, lastpage + 1);
+      log->seq = lastseq + 1;
+
+      /* Continue writing to the most recently written block */
+
+      if (log->blkper - lastend >= 2)
+        {
+          log->curblock = lastpage / log->blkper;
+          log->curpage  = lastend;
+          log->blocks[log->curblock].state = FTL_BLOCK_OPEN;
+        }
+    }
+
+  /* Blocks that will be erased before use get the average erase count */
+
+  for (block = 0; block < log->neraseblocks; block++)
+    {
+      blk = &log->blocks[block];
+      if (blk->state == FTL_BLOCK_UNKNOWN)
+        {
+          blk->erasecount = nknown > 0 ? ecsum / nknown : 0;
+        }
+
+      if (blk->state == FTL_BLOCK_FREE || blk->state == FTL_BLOCK_UNKNOWN)
+        {
+          log->nfree++;
+        }
+    }
+
+  /* Write the current contents of sectors whose most recent copy was torn
+   * again, so that the torn copy cannot win over the previous one later.
+   * The page buffers of the state may be used by the garbage collector
+   * while writing.
+   */
+
+  if (ntorn > 0)
+    {
+      copy = (FAR uint8_t *)kmm_malloc(log->blocksize);
+      if (copy == NULL)
+        {
+          ret = -ENOMEM;
+          goto errout;
+        }
+    }
+
+  for (i = 0; i < ntorn; i++)
+    {
+      if (torn[i] < log->nsectors)
+        {
+          finfo("Recover torn sector %lu\n", (unsigned long)torn[i]);
+
+          ret = ftl_log_readsectors(log, copy, torn[i], 1);
+          if (ret >= 0)
+            {
+              ret = ftl_log_writesectors(log, copy, torn[i], 1);
+            }
+
+          if (ret < 0)
+            {
+              goto errout;
+            }
+        }
+    }
+
+  ret = OK;
+
+errout:
+  if (copy != NULL)
+    {
+      kmm_free(copy);
+    }
+
+  if (torn != NULL)
+    {
+      kmm_free(torn);
+    }
+
+  kmm_free(seqtab);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo,
+                       FAR struct ftl_log_s **logp)
+{
+  FAR struct ftl_log_s *log;
+  uint32_t npages;
+  uint32_t i;
+  int ret;
+
+  DEBUGASSERT(mtd != NULL && geo != NULL && logp != NULL);
+
+  log = (FAR struct ftl_log_s *)kmm_zalloc(sizeof(struct ftl_log_s));
+  if (log == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  log->mtd          = mtd;
+  log->blocksize    = geo->blocksize;
+  log->neraseblocks = geo->neraseblocks;
+  log->blkper       = geo->erasesize / geo->blocksize;
+  log->nentries     = (geo->blocksize - sizeof(struct ftl_log_shdr_s)) /
+                      sizeof(struct ftl_log_entry_s);
+  log->curblock     = -1;
+
+  /* Each block holds a header, then groups of one summary followed by up
+   * to nentries data pages.  The logical size assumes densely packed
+   * blocks, less the open block and the blocks kept in reserve for
+   * garbage collection.  One page per block is left as slack:  A group
+   * needs at least two pages so the last page of a block is often unusable.
+   */
+
+  npages     = log->blkper - 2;
+  log->dense = npages - (npages + log->nentries) / (log->nentries + 1);
+
+  if (log->blkper < 4 || log->nentries < 1 || log->dense < 1 ||
+      log->neraseblocks <= CONFIG_FTL_LOG_NRESERVE + 2)
+    {
+      ferr("ERROR: Unsupported geometry\n");
+      kmm_free(log);
+      return -EINVAL;
+    }
+
+  log->nsectors = (log->neraseblocks - CONFIG_FTL_LOG_NRESERVE - 1) *
+                  log->dense;
+
+  log->map     = (FAR uint32_t *)
+                 kmm_malloc(log->nsectors * sizeof(uint32_t));
+  log->blocks  = (FAR struct ftl_log_block_s *)
+                 kmm_zalloc(log->neraseblocks *
+                            sizeof(struct ftl_log_block_s));
+  log->sumbuf  = (FAR uint8_t *)kmm_malloc(log->blocksize);
+  log->gcbuf   = (FAR uint8_t *)kmm_malloc(log->blocksize);
+  log->pagebuf = (FAR uint8_t *)kmm_malloc(log->blocksize);
+  log->gcsrc   = (FAR uint32_t *)
+                 kmm_malloc(log->nentries * sizeof(uint32_t));
+
+  if (log->map == NULL || log->blocks == NULL || log->sumbuf == NULL ||
+      log->gcbuf == NULL || log->pagebuf == NULL || log->gcsrc == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  for (i = 0; i < log->nsectors; i++)
+    {
+      log->map[i] = FTL_LOG_UNMAPPED;
+    }
+
+  nxsem_init(&log->exclsem, 0, 1);
+
+  ret = ftl_log_scan(log);
+  if (ret < 0)
+    {
+      ferr("ERROR: Scan failed: %d\n", ret);
+      nxsem_destroy(&log->exclsem);
+      goto errout;
+    }
+
+  finfo("%lu sectors, %lu free blocks, max erase count %lu\n",
+        (unsigned long)log->nsectors, (unsigned long)log->nfree,
+        (unsigned long)log->maxerase);
+
+  *logp = log;
+  return OK;
+
+errout:
+  ftl_log_uninitialize(log);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log)
+{
+  if (log->map != NULL)
+    {
+      kmm_free(log->map);
+    }
+
+  if (log->blocks != NULL)
+    {
+      kmm_free(log->blocks);
+    }
+
+  if (log->sumbuf != NULL)
+    {
+      kmm_free(log->sumbuf);
+    }
+
+  if (log->gcbuf != NULL)
+    {
+      kmm_free(log->gcbuf);
+    }
+
+  if (log->pagebuf != NULL)
+    {
+      kmm_free(log->pagebuf);
+    }
+
+  if (log->gcsrc != NULL)
+    {
+      kmm_free(log->gcsrc);
+    }
+
+  kmm_free(log);
+}
+
+/****************************************************************************
+ * Name: ftl_log_nsectors
+ ****************************************************************************/
+
+uint32_t ftl_log_nsectors(FAR struct ftl_log_s *log)
+{
+  return log->nsectors;
+}
+
+/****************************************************************************
+ * Name: ftl_log_read
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startblock, size_t nblocks)
+{
+  int ret;
+
+  if (startblock < 0 || startblock + nblocks > log->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  nxsem_wait_uninterruptible(&log->exclsem);
+  ret = ftl_log_readsectors(log, buffer, startblock, nblocks);
+  nxsem_post(&log->exclsem);
+
+  return ret < 0 ? ret : nblocks;
+}
+
+/****************************************************************************
+ * Name: ftl_log_write
+ ****************************************************************************/
+
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startblock, size_t nblocks)
+{
+  int ret;
+
+  if (startblock < 0 || startblock + nblocks > log->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  nxsem_wait_uninterruptible(&log->exclsem);
+  ret = ftl_log_writesectors(log, buffer, startblock, nblocks);
+  nxsem_post(&log->exclsem);
+
+  return ret < 0 ? ret : nblocks;
+}
+
+#endif /* CONFIG_FTL_LOG */
@@ -0,0 +1,103 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __DRIVERS_MTD_FTL_LOG_H
+#define __DRIVERS_MTD_FTL_LOG_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <nuttx/mtd/mtd.h>
+
+#ifdef CONFIG_FTL_LOG
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct ftl_log_s; /* Opaque state of the log-structured translation layer */
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ *
+ * Description:
+ *   Scan the MTD device and rebuild the logical to physical sector map.
+ *   Blocks that do not carry a valid block header are erased when they are
+ *   first needed, so a blank or foreign device simply appears as an
+ *   unwritten one.
+ *
+ * Input Parameters:
+ *   mtd  - The MTD device
+ *   geo  - The geometry of the MTD device
+ *   logp - The location to return the new instance
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo,
+                       FAR struct ftl_log_s **logp);
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_nsectors
+ *
+ * Description:
+ *   Return the number of logical sectors.  This is smaller than the number
+ *   of R/W blocks of the MTD device because of the block headers, the
+ *   summary pages and the spare erase blocks needed by garbage collection.
+ *
+ ****************************************************************************/
+
+uint32_t ftl_log_nsectors(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_read and ftl_log_write
+ *
+ * Description:
+ *   Read or write logical sectors.  These have the signatures of the
+ *   rwbuffer reload and flush callbacks.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startblock, size_t nblocks);
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startblock, size_t nblocks);
+
+#endif /* CONFIG_FTL_LOG */
+#endif /* __DRIVERS_MTD_FTL_LOG_H */
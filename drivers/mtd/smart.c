@@ -156,6 +156,8 @@
 #define SMART_WEARFLAGS_FORCE_REORG         0x01
 #define SMART_WEARFLAGS_WRITE_NEEDED        0x02
 
+#define SMART_CP_MAGIC              "SMCP"  /* Sector map checkpoint signature */
+
 #define SET_BITMAP(m, n) do { (m)[(n) / 8] |= 1 << ((n) % 8); } while (0)
 #define CLR_BITMAP(m, n) do { (m)[(n) / 8] &= ~(1 << ((n) % 8)); } while (0)
 #define ISSET_BITMAP(m, n) ((m)[(n) / 8] & (1 << ((n) % 8)))
@@ -289,6 +291,11 @@ struct smart_struct_s
   size_t                bytesalloc;
   struct smart_alloc_s  alloc[SMART_MAX_ALLOCS];   /* Array of memory allocations */
 #endif
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+  uint32_t              cpblock;          /* First erase block of the map checkpoint */
+  uint32_t              cpnblocks;        /* Erase blocks reserved for the checkpoint */
+  bool                  cpvalid;          /* The checkpoint on the device is valid */
+#endif
 };
 
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -299,6 +306,31 @@ struct smart_multiroot_device_s
 };
 #endif
 
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+/* The sector map checkpoint occupies the erase blocks at the end of the
+ * device.  This header is in the first MTD block, followed by the sector
+ * map, the release counts and the free counts exactly as they are kept in
+ * RAM.  The header is written last; the state byte is programmed when the
+ * device is first changed after the checkpoint was written or loaded.
+ */
+
+struct smart_cpheader_s
+{
+  uint8_t               magic[4];         /* SMART_CP_MAGIC */
+  uint8_t               state;            /* Erased state while valid */
+  uint8_t               formatversion;    /* Format version on the device */
+  uint8_t               namesize;         /* Length of filenames on this device */
+  uint8_t               reserved;
+  uint16_t              sectorsize;       /* Sector size on device */
+  uint16_t              totalsectors;     /* Total number of sectors on device */
+  uint16_t              neraseblocks;     /* Number of erase blocks */
+  uint16_t              freesectors;      /* Total number of free sectors */
+  uint16_t              releasesectors;   /* Total number of released sectors */
+  uint16_t              reserved2;
+  uint32_t              crc;              /* CRC-32 of the header and the map */
+};
+#endif
+
 /* Format 1 sector header definition */
 
 #if SMART_STATUS_VERSION == 1
@@ -439,6 +471,10 @@ static int smart_relocate_sector(FAR struct smart_struct_s *dev,
 #ifdef CONFIG_MTD_SMART_FSCK
 static int smart_fsck(FAR struct smart_struct_s *dev);
 #endif
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static int smart_cp_invalidate(FAR struct smart_struct_s *dev);
+static int smart_cp_write(FAR struct smart_struct_s *dev);
+#endif
 
 #ifdef CONFIG_SMART_DEV_LOOP
 static ssize_t smart_loop_read(FAR struct file *filep, FAR char *buffer,
@@ -506,7 +542,16 @@ static int smart_open(FAR struct inode *inode)
 static int smart_close(FAR struct inode *inode)
 {
   finfo("Entry\n");
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+  /* Save the sector map so that the next initialization need not scan
+   * the device.
+   */
+
+  return smart_cp_write((FAR struct smart_struct_s *)inode->i_private);
+#else
   return OK;
+#endif
 }
 
 /****************************************************************************
@@ -934,6 +979,16 @@ static ssize_t smart_write(FAR struct inode *inode,
   dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+  /* The first change to the device invalidates the saved sector map */
+
+  ret = smart_cp_invalidate(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
   /* I think maybe we need to lock on a mutex here */
 
   /* Get the aligned block.  Here is is assumed: (1) The number of R/W blocks
@@ -1891,6 +1946,323 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev, uint16_t block,
 }
 #endif
 
+/****************************************************************************
+ * Name: smart_cp_initialize
+ *
+ * Description: Reserves the erase blocks at the end of the device that
+ *              hold the sector map checkpoint.  The size depends only on
+ *              the device geometry, not on the sector size the device is
+ *              formatted with, so that it is the same on every boot.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static void smart_cp_initialize(FAR struct smart_struct_s *dev)
+{
+  uint32_t maxsectors;
+  uint32_t size;
+  uint32_t nblocks;
+
+  /* Reserve room for the map with the smallest possible sector size */
+
+  maxsectors = dev->geo.neraseblocks * (dev->geo.erasesize /
+               (dev->geo.blocksize > 256 ? dev->geo.blocksize : 256));
+  if (maxsectors > 65536)
+    {
+      maxsectors = 65536;
+    }
+
+  size    = dev->geo.blocksize + maxsectors * sizeof(uint16_t) +
+            (dev->geo.neraseblocks << 1);
+  nblocks = (size + dev->geo.erasesize - 1) / dev->geo.erasesize;
+
+  /* The wear level status holds two erase blocks per byte.  Don't leave an
+   * odd number of erase blocks.
+   */
+
+  nblocks = (nblocks + 1) & ~1;
+
+  /* Don't bother with devices that are this small */
+
+  if (nblocks * 4 > dev->geo.neraseblocks)
+    {
+      finfo("Device too small for a sector map checkpoint\n");
+      return;
+    }
+
+  dev->cpnblocks         = nblocks;
+  dev->cpblock           = dev->geo.neraseblocks - nblocks;
+  dev->geo.neraseblocks -= nblocks;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cp_crc
+ *
+ * Description: Calculates the CRC of a checkpoint header and of the sector
+ *              map in RAM.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static uint32_t smart_cp_crc(FAR struct smart_struct_s *dev,
+                             FAR const struct smart_cpheader_s *header)
+{
+  uint32_t crc;
+
+  crc = crc32(&header->formatversion,
+              offsetof(struct smart_cpheader_s, crc) -
+              offsetof(struct smart_cpheader_s, formatversion));
+
+  return crc32part((FAR const uint8_t *)dev->smap,
+                   dev->totalsectors * sizeof(uint16_t) +
+                   (dev->neraseblocks << 1), crc);
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cp_invalidate
+ *
+ * Description: Marks the sector map checkpoint on the device as invalid.
+ *              This must be done before the device is changed.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static int smart_cp_invalidate(FAR struct smart_struct_s *dev)
+{
+  uint8_t state;
+  int ret;
+
+  if (!dev->cpvalid)
+    {
+      return OK;
+    }
+
+  state = (uint8_t)~CONFIG_SMARTFS_ERASEDSTATE;
+  ret = smart_bytewrite(dev, dev->cpblock * dev->geo.erasesize +
+                        offsetof(struct smart_cpheader_s, state), 1, &state);
+  if (ret < 0)
+    {
+      ferr("ERROR: Error %d invalidating the sector map\n", -ret);
+      return ret;
+    }
+
+  dev->cpvalid = false;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cp_write
+ *
+ * Description: Saves the sector map, the free and release counts in the
+ *              checkpoint area if the device has changed since the map was
+ *              last saved or loaded.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static int smart_cp_write(FAR struct smart_struct_s *dev)
+{
+  FAR struct smart_cpheader_s *header;
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  FAR struct smart_allocsector_s *allocsector;
+#endif
+  uint32_t mtdblock;
+  size_t size;
+  size_t nblocks;
+  size_t remaining;
+  int ret;
+
+  if (dev->cpnblocks == 0 || dev->cpvalid ||
+      dev->formatstatus != SMART_FMT_STAT_FORMATTED)
+    {
+      return OK;
+    }
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  /* Sectors that are allocated but not yet written are not on the device.
+   * Save the map as a scan of the device would find it.
+   */
+
+  for (allocsector = dev->allocsector; allocsector != NULL;
+       allocsector = allocsector->next)
+    {
+      dev->smap[allocsector->logical] = 0xffff;
+      dev->freecount[allocsector->physical / dev->sectorsperblk]++;
+      dev->freesectors++;
+    }
+#endif
+
+  ret = MTD_ERASE(dev->mtd, dev->cpblock, dev->cpnblocks);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* Write the map and the counts after the header block */
+
+  mtdblock  = dev->cpblock * (dev->geo.erasesize / dev->geo.blocksize);
+  size      = dev->totalsectors * sizeof(uint16_t) + (dev->neraseblocks << 1);
+  nblocks   = size / dev->geo.blocksize;
+  remaining = size - nblocks * dev->geo.blocksize;
+
+  if (nblocks > 0)
+    {
+      ret = MTD_BWRITE(dev->mtd, mtdblock + 1, nblocks,
+                       (FAR const uint8_t *)dev->smap);
+      if (ret != nblocks)
+        {
+          ret = -EIO;
+          goto errout;
+        }
+    }
+
+  if (remaining > 0)
+    {
+      memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->geo.blocksize);
+      memcpy(dev->rwbuffer,
+             (FAR const uint8_t *)dev->smap + nblocks * dev->geo.blocksize,
+             remaining);
+
+      ret = MTD_BWRITE(dev->mtd, mtdblock + 1 + nblocks, 1,
+                       (FAR const uint8_t *)dev->rwbuffer);
+      if (ret != 1)
+        {
+          ret = -EIO;
+          goto errout;
+        }
+    }
+
+  /* Then the header, which makes the checkpoint valid */
+
+  memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->geo.blocksize);
+  header = (FAR struct smart_cpheader_s *)dev->rwbuffer;
+
+  memcpy(header->magic, SMART_CP_MAGIC, sizeof(header->magic));
+  header->formatversion  = dev->formatversion;
+  header->namesize       = dev->namesize;
+  header->reserved       = 0;
+  header->sectorsize     = dev->sectorsize;
+  header->totalsectors   = dev->totalsectors;
+  header->neraseblocks   = dev->neraseblocks;
+  header->freesectors    = dev->freesectors;
+  header->releasesectors = dev->releasesectors;
+  header->reserved2      = 0;
+  header->crc            = smart_cp_crc(dev, header);
+
+  ret = MTD_BWRITE(dev->mtd, mtdblock, 1, (FAR const uint8_t *)dev->rwbuffer);
+  if (ret != 1)
+    {
+      ret = -EIO;
+      goto errout;
+    }
+
+  dev->cpvalid = true;
+  ret = OK;
+
+errout:
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  for (allocsector = dev->allocsector; allocsector != NULL;
+       allocsector = allocsector->next)
+    {
+      dev->smap[allocsector->logical] = allocsector->physical;
+      dev->freecount[allocsector->physical / dev->sectorsperblk]--;
+      dev->freesectors--;
+    }
+#endif
+
+  if (ret < 0)
+    {
+      ferr("ERROR: Error %d saving the sector map\n", -ret);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_cp_load
+ *
+ * Description: Loads the sector map, the free and release counts and the
+ *              format information from the checkpoint area.  Returns OK if
+ *              the checkpoint is valid and the device need not be scanned.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+static int smart_cp_load(FAR struct smart_struct_s *dev)
+{
+  struct smart_cpheader_s header;
+  size_t size;
+  int ret;
+
+  ret = MTD_READ(dev->mtd, dev->cpblock * dev->geo.erasesize,
+                 sizeof(header), (FAR uint8_t *)&header);
+  if (ret != sizeof(header) ||
+      memcmp(header.magic, SMART_CP_MAGIC, sizeof(header.magic)) != 0 ||
+      header.state != CONFIG_SMARTFS_ERASEDSTATE)
+    {
+      return -ENOENT;
+    }
+
+  if (header.sectorsize < 256 || header.sectorsize < dev->geo.blocksize ||
+      (header.sectorsize & (header.sectorsize - 1)) != 0)
+    {
+      return -EINVAL;
+    }
+
+  ret = smart_setsectorsize(dev, header.sectorsize);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  /* From here on, a checkpoint that cannot be used must not be tried
+   * again once the scan has changed the device.
+   */
+
+  dev->cpvalid = true;
+
+  if (dev->totalsectors != header.totalsectors ||
+      dev->neraseblocks != header.neraseblocks)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  size = dev->totalsectors * sizeof(uint16_t) + (dev->neraseblocks << 1);
+  ret  = MTD_READ(dev->mtd, dev->cpblock * dev->geo.erasesize +
+                  dev->geo.blocksize, size, (FAR uint8_t *)dev->smap);
+  if (ret != size)
+    {
+      ret = -EIO;
+      goto errout;
+    }
+
+  if (smart_cp_crc(dev, &header) != header.crc)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  dev->formatstatus   = SMART_FMT_STAT_FORMATTED;
+  dev->formatversion  = header.formatversion;
+  dev->namesize       = header.namesize;
+  dev->freesectors    = header.freesectors;
+  dev->releasesectors = header.releasesectors;
+
+  finfo("Loaded the sector map checkpoint\n");
+  return OK;
+
+errout:
+  ferr("ERROR: Discarding the sector map checkpoint: %d\n", ret);
+  smart_cp_invalidate(dev);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: smart_scan
  *
@@ -1932,6 +2304,18 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 
   finfo("Entry\n");
 
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+  /* Use the sector map saved on the device if it is still valid */
+
+  if (dev->cpnblocks > 0 && smart_cp_load(dev) == OK)
+    {
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+      smart_read_wearstatus(dev);
+#endif
+      return OK;
+    }
+#endif
+
   /* Find the sector size on the volume by reading headers from
    * sectors of decreasing size.  On a formatted volume, the sector
    * size is saved in the header status byte of search sector, so
@@ -5392,6 +5776,20 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
   dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
+#if defined(CONFIG_MTD_SMART_MAP_CHECKPOINT) && defined(CONFIG_FS_WRITABLE)
+  /* The first change to the device invalidates the saved sector map */
+
+  if (cmd == BIOC_LLFORMAT || cmd == BIOC_ALLOCSECT ||
+      cmd == BIOC_FREESECT || cmd == BIOC_WRITESECT)
+    {
+      ret = smart_cp_invalidate(dev);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* Process the ioctl's we care about first, pass any we don't respond
    * to directly to the underlying MTD device.
    */
@@ -5436,6 +5834,15 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       ret = smart_readsector(dev, arg);
       goto ok_out;
 
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+    case BIOC_FLUSH:
+
+      /* Save the sector map */
+
+      ret = smart_cp_write(dev);
+      goto ok_out;
+#endif
+
 #ifdef CONFIG_FS_WRITABLE
     case BIOC_LLFORMAT:
 
@@ -6091,6 +6498,12 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
           goto errout;
         }
 
+#ifdef CONFIG_MTD_SMART_MAP_CHECKPOINT
+      /* Reserve the erase blocks for the sector map checkpoint */
+
+      smart_cp_initialize(dev);
+#endif
+
       /* Set the sector size to the default for now */
 
       dev->sectorsize = 0;
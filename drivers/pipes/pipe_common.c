@@ -60,6 +60,7 @@
 #include <nuttx/semaphore.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
+#include <nuttx/drivers/drivers.h>
 
 #include "pipe_common.h"
 
@@ -105,35 +106,583 @@ static void pipecommon_semtake(FAR sem_t *sem)
 static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev,
                                   pollevent_t eventset)
 {
-  int i;
-
   if (eventset & POLLERR)
     {
       eventset &= ~(POLLOUT | POLLIN);
     }
 
-  for (i = 0; i < CONFIG_DEV_PIPE_NPOLLWAITERS; i++)
+  poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS, eventset);
+}
+
+/****************************************************************************
+ * Name: pipecommon_copy
+ *
+ * Description:
+ *   Copy data to or from the ring buffer.  The fixed cost of memcpy()
+ *   dominates for the very short transfers that are typical of console
+ *   output through a pipe, so these are copied inline.
+ *
+ ****************************************************************************/
+
+static inline void pipecommon_copy(FAR uint8_t *dest,
+                                   FAR const uint8_t *src, size_t nbytes)
+{
+  if (nbytes < 8)
+    {
+      while (nbytes-- > 0)
+        {
+          *dest++ = *src++;
+        }
+    }
+  else
+    {
+      memcpy(dest, src, nbytes);
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdcontig and pipecommon_wrcontig
+ *
+ * Description:
+ *   Return the number of bytes that can be read from (or written to) the
+ *   ring buffer at the current read (or write) index without wrapping.
+ *   One byte of the buffer is always left free to distinguish a full
+ *   buffer from an empty one.
+ *
+ ****************************************************************************/
+
+static inline size_t pipecommon_rdcontig(FAR struct pipe_dev_s *dev)
+{
+  if (dev->d_wrndx >= dev->d_rdndx)
+    {
+      return dev->d_wrndx - dev->d_rdndx;
+    }
+
+  return dev->d_bufsize - dev->d_rdndx;
+}
+
+static inline size_t pipecommon_wrcontig(FAR struct pipe_dev_s *dev)
+{
+  if (dev->d_wrndx < dev->d_rdndx)
     {
-      FAR struct pollfd *fds = dev->d_fds[i];
+      return dev->d_rdndx - dev->d_wrndx - 1;
+    }
+
+  return dev->d_bufsize - dev->d_wrndx - (dev->d_rdndx == 0 ? 1 : 0);
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdadvance and pipecommon_wradvance
+ *
+ * Description:
+ *   Advance the read (or write) index after a copy of at most the number
+ *   of bytes returned by pipecommon_rdcontig (or pipecommon_wrcontig).
+ *
+ ****************************************************************************/
 
-      if (fds)
+static inline void pipecommon_rdadvance(FAR struct pipe_dev_s *dev,
+                                        size_t nbytes)
+{
+  size_t ndx = dev->d_rdndx + nbytes;
+
+  dev->d_rdndx = ndx >= dev->d_bufsize ? 0 : ndx;
+}
+
+static inline void pipecommon_wradvance(FAR struct pipe_dev_s *dev,
+                                        size_t nbytes)
+{
+  size_t ndx = dev->d_wrndx + nbytes;
+
+  dev->d_wrndx = ndx >= dev->d_bufsize ? 0 : ndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wakeup
+ *
+ * Description:
+ *   Wake up all threads waiting on the semaphore, then notify the poll
+ *   waiters of the event.
+ *
+ ****************************************************************************/
+
+static void pipecommon_wakeup(FAR struct pipe_dev_s *dev, FAR sem_t *sem,
+                              pollevent_t eventset)
+{
+  int sval;
+
+  while (nxsem_getvalue(sem, &sval) == 0 && sval < 0)
+    {
+      nxsem_post(sem);
+    }
+
+  pipecommon_pollnotify(dev, eventset);
+}
+
+/****************************************************************************
+ * Name: pipecommon_unbusy
+ *
+ * Description:
+ *   Clear a PIPE_FLAG_WRBUSY or PIPE_FLAG_RDBUSY reservation and wake up
+ *   the threads that were waiting for it to end.
+ *
+ ****************************************************************************/
+
+static void pipecommon_unbusy(FAR struct pipe_dev_s *dev, uint8_t flag,
+                              FAR sem_t *sem)
+{
+  int sval;
+
+  dev->d_flags &= ~flag;
+
+  while (nxsem_getvalue(sem, &sval) == 0 && sval < 0)
+    {
+      nxsem_post(sem);
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdwait
+ *
+ * Description:
+ *   Take exclusive access to the device and wait until the pipe holds
+ *   data that is not being drained by a splice.
+ *
+ * Returned Value:
+ *   The number of bytes in the pipe, with d_bfsem held.  Zero for end of
+ *   file or a negated errno value, with d_bfsem released.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_rdwait(FAR struct file *filep,
+                                 FAR struct pipe_dev_s *dev)
+{
+  int ret;
+
+  /* Make sure that we have exclusive access to the device structure */
+
+  ret = nxsem_wait(&dev->d_bfsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* If the pipe is empty, then wait for something to be written to it */
+
+  while (dev->d_wrndx == dev->d_rdndx ||
+         (dev->d_flags & PIPE_FLAG_RDBUSY) != 0)
+    {
+      /* If O_NONBLOCK was set, then return EGAIN */
+
+      if (filep->f_oflags & O_NONBLOCK)
         {
-          fds->revents |= eventset & (fds->events | POLLERR | POLLHUP);
+          nxsem_post(&dev->d_bfsem);
+          return -EAGAIN;
+        }
 
-          if ((fds->revents & (POLLOUT | POLLHUP)) == (POLLOUT | POLLHUP))
-            {
-              /* POLLOUT and POLLHUP are mutually exclusive. */
+      /* If there are no writers on the pipe, then return end of file */
+
+      if (dev->d_wrndx == dev->d_rdndx && dev->d_nwriters <= 0)
+        {
+          nxsem_post(&dev->d_bfsem);
+          return 0;
+        }
+
+      /* Otherwise, wait for something to be written to the pipe */
+
+      sched_lock();
+      nxsem_post(&dev->d_bfsem);
+      ret = nxsem_wait(&dev->d_rdsem);
+      sched_unlock();
+
+      if (ret < 0 || (ret = nxsem_wait(&dev->d_bfsem)) < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (dev->d_wrndx > dev->d_rdndx)
+    {
+      return dev->d_wrndx - dev->d_rdndx;
+    }
+
+  return dev->d_bufsize - dev->d_rdndx + dev->d_wrndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wrwait
+ *
+ * Description:
+ *   Take exclusive access to the device and wait until there is free space
+ *   in the pipe that is not being filled by a splice.
+ *
+ * Returned Value:
+ *   The number of free bytes in the pipe, with d_bfsem held.  A negated
+ *   errno value, with d_bfsem released.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_wrwait(FAR struct file *filep,
+                                 FAR struct pipe_dev_s *dev)
+{
+  ssize_t nfree;
+  int ret;
 
-              fds->revents &= ~POLLOUT;
+  if (dev->d_nreaders <= 0)
+    {
+      return -EPIPE;
+    }
+
+  ret = nxsem_wait(&dev->d_bfsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (; ; )
+    {
+      if (dev->d_wrndx < dev->d_rdndx)
+        {
+          nfree = dev->d_rdndx - dev->d_wrndx - 1;
+        }
+      else
+        {
+          nfree = dev->d_bufsize - dev->d_wrndx + dev->d_rdndx - 1;
+        }
+
+      if (nfree > 0 && (dev->d_flags & PIPE_FLAG_WRBUSY) == 0)
+        {
+          return nfree;
+        }
+
+      if (filep->f_oflags & O_NONBLOCK)
+        {
+          nxsem_post(&dev->d_bfsem);
+          return -EAGAIN;
+        }
+
+      sched_lock();
+      nxsem_post(&dev->d_bfsem);
+      ret = nxsem_wait(&dev->d_wrsem);
+      sched_unlock();
+
+      if (ret < 0 || (ret = nxsem_wait(&dev->d_bfsem)) < 0)
+        {
+          return ret;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_splicein
+ *
+ * Description:
+ *   Read from the file or socket descriptor directly into the free space of
+ *   the ring buffer.  At most one read is done per contiguous free region,
+ *   so this returns after a short read.
+ *
+ *   The free space is reserved with PIPE_FLAG_WRBUSY and d_bfsem is
+ *   released while reading, so that the other descriptor may block (or be
+ *   another pipe splicing back into this one) without holding up readers
+ *   of this pipe.  Each read is committed to the ring buffer as it
+ *   completes.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_splicein(FAR struct file *filep,
+                                   FAR struct pipe_dev_s *dev,
+                                   FAR const struct pipe_splice_s *splice)
+{
+  size_t remaining = splice->len;
+  FAR uint8_t *dest;
+  ssize_t nmoved = 0;
+  ssize_t nfree;
+  ssize_t ret;
+  size_t n;
+
+  nfree = pipecommon_wrwait(filep, dev);
+  if (nfree < 0)
+    {
+      return nfree;
+    }
+
+  if (remaining > (size_t)nfree)
+    {
+      remaining = nfree;
+    }
+
+  /* Only this thread may advance d_wrndx until the reservation ends.
+   * Readers only add to the free space, so the reserved space remains
+   * free.
+   */
+
+  dev->d_flags |= PIPE_FLAG_WRBUSY;
+
+  while (remaining > 0)
+    {
+      n = pipecommon_wrcontig(dev);
+      if (n > remaining)
+        {
+          n = remaining;
+        }
+
+      dest = &dev->d_buffer[dev->d_wrndx];
+
+      nxsem_post(&dev->d_bfsem);
+      ret = nx_read(splice->fd, dest, n);
+      pipecommon_semtake(&dev->d_bfsem);
+
+      if (ret <= 0)
+        {
+          if (nmoved == 0)
+            {
+              nmoved = ret;
             }
 
-          if (fds->revents != 0)
+          break;
+        }
+
+      pipecommon_wradvance(dev, ret);
+      pipecommon_wakeup(dev, &dev->d_rdsem, POLLIN);
+
+      nmoved    += ret;
+      remaining -= ret;
+
+      if ((size_t)ret < n)
+        {
+          break;
+        }
+    }
+
+  pipecommon_unbusy(dev, PIPE_FLAG_WRBUSY, &dev->d_wrsem);
+  nxsem_post(&dev->d_bfsem);
+  return nmoved;
+}
+
+/****************************************************************************
+ * Name: pipecommon_spliceout
+ *
+ * Description:
+ *   Write the data in the ring buffer directly to the file or socket
+ *   descriptor.  If 'consume' is false, the data is left in the pipe.
+ *
+ *   The data is reserved with PIPE_FLAG_RDBUSY and d_bfsem is released
+ *   while writing, so that the other descriptor may block (or be another
+ *   pipe splicing back into this one) without holding up writers to this
+ *   pipe.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_spliceout(FAR struct file *filep,
+                                    FAR struct pipe_dev_s *dev,
+                                    FAR const struct pipe_splice_s *splice,
+                                    bool consume)
+{
+  size_t remaining = splice->len;
+  FAR const uint8_t *src;
+  pipe_ndx_t ndx;
+  ssize_t nmoved = 0;
+  ssize_t navail;
+  ssize_t ret;
+  size_t n;
+
+  navail = pipecommon_rdwait(filep, dev);
+  if (navail <= 0)
+    {
+      return navail;
+    }
+
+  if (remaining > (size_t)navail)
+    {
+      remaining = navail;
+    }
+
+  /* Only this thread may advance d_rdndx until the reservation ends.
+   * Writers only append after d_wrndx, so the reserved data is not
+   * overwritten.  A private index walks the data so that PIPEIOC_TEE can
+   * leave it in the pipe.
+   */
+
+  dev->d_flags |= PIPE_FLAG_RDBUSY;
+  ndx = dev->d_rdndx;
+
+  while (remaining > 0)
+    {
+      n = dev->d_bufsize - ndx;
+      if (n > remaining)
+        {
+          n = remaining;
+        }
+
+      src = &dev->d_buffer[ndx];
+
+      nxsem_post(&dev->d_bfsem);
+      ret = nx_write(splice->fd, src, n);
+      pipecommon_semtake(&dev->d_bfsem);
+
+      if (ret <= 0)
+        {
+          if (nmoved == 0)
             {
-              finfo("Report events: %02x\n", fds->revents);
-              nxsem_post(fds->sem);
+              nmoved = ret;
             }
+
+          break;
         }
+
+      ndx = ndx + ret >= dev->d_bufsize ? 0 : ndx + ret;
+      if (consume)
+        {
+          pipecommon_rdadvance(dev, ret);
+          pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
+        }
+
+      nmoved    += ret;
+      remaining -= ret;
+
+      if ((size_t)ret < n)
+        {
+          break;
+        }
+    }
+
+  pipecommon_unbusy(dev, PIPE_FLAG_RDBUSY, &dev->d_rdsem);
+  nxsem_post(&dev->d_bfsem);
+  return nmoved;
+}
+
+/****************************************************************************
+ * Name: pipecommon_splice
+ *
+ * Description:
+ *   Handle the PIPEIOC_SPLICEIN, PIPEIOC_SPLICEOUT and PIPEIOC_TEE ioctl
+ *   commands.
+ *
+ ****************************************************************************/
+
+static int pipecommon_splice(FAR struct file *filep, int cmd,
+                             FAR const struct pipe_splice_s *splice)
+{
+  FAR struct pipe_dev_s *dev = filep->f_inode->i_private;
+  FAR struct file *other;
+  int ret;
+
+  if (splice == NULL)
+    {
+      return -EINVAL;
+    }
+
+  if (splice->len == 0)
+    {
+      return 0;
+    }
+
+  /* A pipe cannot be spliced into itself: the transfer would wait for
+   * its own reservation.
+   */
+
+  if ((unsigned int)splice->fd < CONFIG_NFILE_DESCRIPTORS)
+    {
+      ret = fs_getfilep(splice->fd, &other);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (other->f_inode == filep->f_inode)
+        {
+          return -EINVAL;
+        }
+    }
+
+  if (cmd == PIPEIOC_SPLICEIN)
+    {
+      if ((filep->f_oflags & O_WROK) == 0)
+        {
+          return -EBADF;
+        }
+
+      return pipecommon_splicein(filep, dev, splice);
+    }
+
+  if ((filep->f_oflags & O_RDOK) == 0)
+    {
+      return -EBADF;
+    }
+
+  return pipecommon_spliceout(filep, dev, splice, cmd == PIPEIOC_SPLICEOUT);
+}
+
+/****************************************************************************
+ * Name: pipecommon_setsize
+ *
+ * Description:
+ *   Change the size of the ring buffer, keeping the data that it holds.
+ *   The caller holds d_bfsem.
+ *
+ ****************************************************************************/
+
+static int pipecommon_setsize(FAR struct pipe_dev_s *dev, size_t bufsize)
+{
+  FAR uint8_t *buffer;
+  size_t count;
+  size_t n;
+
+  if (bufsize < 2 || bufsize > CONFIG_DEV_PIPE_MAXSIZE)
+    {
+      return -EINVAL;
+    }
+
+  /* A splice in progress is using the current buffer */
+
+  if ((dev->d_flags & (PIPE_FLAG_WRBUSY | PIPE_FLAG_RDBUSY)) != 0)
+    {
+      return -EBUSY;
+    }
+
+  if (dev->d_buffer == NULL)
+    {
+      dev->d_bufsize = bufsize;
+      return OK;
+    }
+
+  if (dev->d_wrndx >= dev->d_rdndx)
+    {
+      count = dev->d_wrndx - dev->d_rdndx;
     }
+  else
+    {
+      count = dev->d_bufsize - dev->d_rdndx + dev->d_wrndx;
+    }
+
+  /* The buffered data must fit into the new buffer */
+
+  if (count > bufsize - 1)
+    {
+      return -EBUSY;
+    }
+
+  buffer = (FAR uint8_t *)kmm_malloc(bufsize);
+  if (buffer == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Copy the buffered data to the beginning of the new buffer */
+
+  n = pipecommon_rdcontig(dev);
+  memcpy(buffer, &dev->d_buffer[dev->d_rdndx], n);
+  memcpy(buffer + n, dev->d_buffer, count - n);
+
+  kmm_free(dev->d_buffer);
+  dev->d_buffer  = buffer;
+  dev->d_bufsize = bufsize;
+  dev->d_rdndx   = 0;
+  dev->d_wrndx   = count;
+
+  /* There may be more space for waiting writers now */
+
+  pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
+  return OK;
 }
 
 /****************************************************************************
@@ -409,8 +958,8 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
   FAR uint8_t           *start  = (FAR uint8_t *)buffer;
 #endif
   ssize_t                nread  = 0;
-  int                    sval;
-  int                    ret;
+  ssize_t                ret;
+  size_t                 n;
 
   DEBUGASSERT(dev);
 
@@ -419,71 +968,42 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
       return 0;
     }
 
-  /* Make sure that we have exclusive access to the device structure */
+  /* Get exclusive access to the device structure and wait until the pipe
+   * is not empty.
+   */
 
-  ret = nxsem_wait(&dev->d_bfsem);
-  if (ret < 0)
+  ret = pipecommon_rdwait(filep, dev);
+  if (ret <= 0)
     {
       return ret;
     }
 
-  /* If the pipe is empty, then wait for something to be written to it */
-
-  while (dev->d_wrndx == dev->d_rdndx)
-    {
-      /* If O_NONBLOCK was set, then return EGAIN */
-
-      if (filep->f_oflags & O_NONBLOCK)
-        {
-          nxsem_post(&dev->d_bfsem);
-          return -EAGAIN;
-        }
-
-      /* If there are no writers on the pipe, then return end of file */
-
-      if (dev->d_nwriters <= 0)
-        {
-          nxsem_post(&dev->d_bfsem);
-          return 0;
-        }
-
-      /* Otherwise, wait for something to be written to the pipe */
-
-      sched_lock();
-      nxsem_post(&dev->d_bfsem);
-      ret = nxsem_wait(&dev->d_rdsem);
-      sched_unlock();
-
-      if (ret < 0 || (ret = nxsem_wait(&dev->d_bfsem)) < 0)
-        {
-          return ret;
-        }
-    }
-
-  /* Then return whatever is available in the pipe (which is at least one byte) */
+  /* Then return whatever is available in the pipe (which is at least one
+   * byte).  This takes at most two copies, one up to the end of the ring
+   * buffer and one from its beginning.
+   */
 
-  nread = 0;
   while ((size_t)nread < len && dev->d_wrndx != dev->d_rdndx)
     {
-      *buffer++ = dev->d_buffer[dev->d_rdndx];
-      if (++dev->d_rdndx >= dev->d_bufsize)
+      n = pipecommon_rdcontig(dev);
+      if (n > len - nread)
         {
-          dev->d_rdndx = 0;
+          n = len - nread;
         }
 
-      nread++;
-    }
-
-  /* Notify all waiting writers that bytes have been removed from the buffer */
+      pipecommon_copy((FAR uint8_t *)buffer,
+                      &dev->d_buffer[dev->d_rdndx], n);
+      pipecommon_rdadvance(dev, n);
 
-  while (nxsem_getvalue(&dev->d_wrsem, &sval) == 0 && sval < 0)
-    {
-      nxsem_post(&dev->d_wrsem);
+      buffer += n;
+      nread  += n;
     }
 
-  /* Notify all poll/select waiters that they can write to the FIFO */
+  /* Notify all waiting writers and all poll/select waiters that bytes have
+   * been removed from the buffer.
+   */
 
-  pipecommon_pollnotify(dev, POLLOUT);
+  pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
 
   nxsem_post(&dev->d_bfsem);
   pipe_dumpbuffer("From PIPE:", start, nread);
@@ -501,8 +1021,7 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
   FAR struct pipe_dev_s *dev      = inode->i_private;
   ssize_t                nwritten = 0;
   ssize_t                last;
-  int                    nxtwrndx;
-  int                    sval;
+  size_t                 n;
   int                    ret;
 
   DEBUGASSERT(dev);
@@ -554,66 +1073,63 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
   last = 0;
   for (; ; )
     {
-      /* Calculate the write index AFTER the next byte is written */
-
-      nxtwrndx = dev->d_wrndx + 1;
-      if (nxtwrndx >= dev->d_bufsize)
-        {
-          nxtwrndx = 0;
-        }
-
-      /* Would the next write overflow the circular buffer? */
+      /* Copy as much as fits into the free space of the circular buffer.
+       * This takes at most two copies, one up to the end of the buffer and
+       * one from its beginning.
+       */
 
-      if (nxtwrndx != dev->d_rdndx)
+      while ((size_t)nwritten < len &&
+             (dev->d_flags & PIPE_FLAG_WRBUSY) == 0 &&
+             (n = pipecommon_wrcontig(dev)) > 0)
         {
-          /* No... copy the byte */
-
-          dev->d_buffer[dev->d_wrndx] = *buffer++;
-          dev->d_wrndx = nxtwrndx;
+          if (n > len - nwritten)
+            {
+              n = len - nwritten;
+            }
 
-          /* Is the write complete? */
+          pipecommon_copy(&dev->d_buffer[dev->d_wrndx],
+                          (FAR const uint8_t *)buffer, n);
+          pipecommon_wradvance(dev, n);
 
-          nwritten++;
-          if ((size_t)nwritten >= len)
-            {
-              /* Yes.. Notify all of the waiting readers that more data is available */
+          buffer   += n;
+          nwritten += n;
+        }
 
-              while (nxsem_getvalue(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  nxsem_post(&dev->d_rdsem);
-                }
+      /* Is the write complete? */
 
-              /* Notify all poll/select waiters that they can read from the FIFO */
+      if ((size_t)nwritten >= len)
+        {
+          /* Yes.. Notify all of the waiting readers and all poll/select
+           * waiters that more data is available.
+           */
 
-              pipecommon_pollnotify(dev, POLLIN);
+          pipecommon_wakeup(dev, &dev->d_rdsem, POLLIN);
 
-              /* Return the number of bytes written */
+          /* Return the number of bytes written */
 
-              nxsem_post(&dev->d_bfsem);
-              return len;
-            }
+          nxsem_post(&dev->d_bfsem);
+          return len;
         }
       else
         {
-          /* There is not enough room for the next byte.  Was anything written in this pass? */
+          /* There is not enough room for the next byte.  Was anything
+           * written in this pass?
+           */
 
           if (last < nwritten)
             {
-              /* Yes.. Notify all of the waiting readers that more data is available */
-
-              while (nxsem_getvalue(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  nxsem_post(&dev->d_rdsem);
-                }
+              /* Yes.. Notify all of the waiting readers and all poll/select
+               * waiters that more data is available.
+               */
 
-              /* Notify all poll/select waiters that they can read from the FIFO */
-
-              pipecommon_pollnotify(dev, POLLIN);
+              pipecommon_wakeup(dev, &dev->d_rdsem, POLLIN);
             }
 
           last = nwritten;
 
-          /* If O_NONBLOCK was set, then return partial bytes written or EGAIN */
+          /* If O_NONBLOCK was set, then return partial bytes written or
+           * EGAIN
+           */
 
           if (filep->f_oflags & O_NONBLOCK)
             {
@@ -626,7 +1142,9 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
               return nwritten;
             }
 
-          /* There is more to be written.. wait for data to be removed from the pipe */
+          /* There is more to be written.. wait for data to be removed
+           * from the pipe
+           */
 
           sched_lock();
           nxsem_post(&dev->d_bfsem);
@@ -778,10 +1296,32 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
     }
 #endif
 
+  /* The splice commands wait for data or space like read() and write() */
+
+  if (cmd == PIPEIOC_SPLICEIN || cmd == PIPEIOC_SPLICEOUT ||
+      cmd == PIPEIOC_TEE)
+    {
+      return pipecommon_splice(filep, cmd,
+                               (FAR const struct pipe_splice_s *)
+                               ((uintptr_t)arg));
+    }
+
   pipecommon_semtake(&dev->d_bfsem);
 
   switch (cmd)
     {
+      case PIPEIOC_SETSIZE:
+        {
+          ret = pipecommon_setsize(dev, (size_t)arg);
+        }
+        break;
+
+      case PIPEIOC_GETSIZE:
+        {
+          ret = dev->d_bufsize;
+        }
+        break;
+
       case PIPEIOC_POLICY:
         {
           if (arg != 0)
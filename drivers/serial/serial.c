@@ -97,7 +97,7 @@ static void    uart_pollnotify(FAR uart_dev_t *dev, pollevent_t eventset);
 
 /* Write support */
 
-static int     uart_putxmitchar(FAR uart_dev_t *dev, int ch, bool oktoblock);
+static int     uart_waitxmit(FAR uart_dev_t *dev, bool oktoblock);
 static inline ssize_t uart_irqwrite(FAR uart_dev_t *dev, FAR const char *buffer,
                                     size_t buflen);
 static int     uart_tcdrain(FAR uart_dev_t *dev, clock_t timeout);
@@ -161,195 +161,101 @@ static int uart_takesem(FAR sem_t *sem, bool errout)
 
 static void uart_pollnotify(FAR uart_dev_t *dev, pollevent_t eventset)
 {
-  int i;
-
-  for (i = 0; i < CONFIG_SERIAL_NPOLLWAITERS; i++)
-    {
-      struct pollfd *fds = dev->fds[i];
-      if (fds)
-        {
-#ifdef CONFIG_SERIAL_REMOVABLE
-          fds->revents |= ((fds->events | (POLLERR | POLLHUP)) & eventset);
-#else
-          fds->revents |= (fds->events & eventset);
-#endif
-          if (fds->revents != 0)
-            {
-              irqstate_t flags;
-              int semcount;
-
-              finfo("Report events: %02x\n", fds->revents);
-
-              /* Limit the number of times that the semaphore is posted.
-               * The critical section is needed to make the following
-               * operation atomic.
-               */
-
-              flags = enter_critical_section();
-              nxsem_getvalue(fds->sem, &semcount);
-              if (semcount < 1)
-                {
-                  nxsem_post(fds->sem);
-                }
-
-              leave_critical_section(flags);
-            }
-        }
-    }
+  poll_notify(dev->fds, CONFIG_SERIAL_NPOLLWAITERS, eventset);
 }
 
 /************************************************************************************
- * Name: uart_putxmitchar
+ * Name: uart_waitxmit
+ *
+ * Description:
+ *   Wait for the hardware to remove some data from the full TX buffer.
+ *
  ************************************************************************************/
 
-static int uart_putxmitchar(FAR uart_dev_t *dev, int ch, bool oktoblock)
+static int uart_waitxmit(FAR uart_dev_t *dev, bool oktoblock)
 {
   irqstate_t flags;
-  int nexthead;
+  FAR char *span;
   int ret;
 
-#ifdef CONFIG_SMP
-  irqstate_t flags2 = enter_critical_section();
-#endif
-
-  /* Increment to see what the next head pointer will be.  We need to use the "next"
-   * head pointer to determine when the circular buffer would overrun
+  /* The caller has request that we not block for data.  So return the
+   * EAGAIN error to signal this situation.
    */
 
-  nexthead = dev->xmit.head + 1;
-  if (nexthead >= dev->xmit.size)
+  if (!oktoblock)
     {
-      nexthead = 0;
+      return -EAGAIN;
     }
 
-  /* Loop until we are able to add the character to the TX buffer. */
-
-  for (; ; )
-    {
-      /* Check if the TX buffer is full */
-
-      if (nexthead != dev->xmit.tail)
-        {
-          /* No.. not full.  Add the character to the TX buffer and return. */
-
-          dev->xmit.buffer[dev->xmit.head] = ch;
-          dev->xmit.head = nexthead;
-          ret = OK;
-          goto err_out;
-        }
-
-      /* The TX buffer is full.  Should be block, waiting for the hardware
-       * to remove some data from the TX buffer?
-       */
-
-      else if (oktoblock)
-        {
-          /* The following steps must be atomic with respect to serial
-           * interrupt handling.
-           */
+  /* The following steps must be atomic with respect to serial interrupt
+   * handling.
+   */
 
-          flags = enter_critical_section();
+  flags = enter_critical_section();
 
-          /* Check again...  In certain race conditions an interrupt may
-           * have occurred between the test at the top of the loop and
-           * entering the critical section and the TX buffer may no longer
-           * be full.
-           *
-           * NOTE: On certain devices, such as USB CDC/ACM, the entire TX
-           * buffer may have been emptied in this race condition.  In that
-           * case, the logic would hang below waiting for space in the TX
-           * buffer without this test.
-           */
+  /* Check again...  In certain race conditions an interrupt may have
+   * occurred between the caller's test and entering the critical section
+   * and the TX buffer may no longer be full.
+   *
+   * NOTE: On certain devices, such as USB CDC/ACM, the entire TX buffer may
+   * have been emptied in this race condition.  In that case, the logic
+   * would hang below waiting for space in the TX buffer without this test.
+   */
 
-          if (nexthead != dev->xmit.tail)
-            {
-              ret = OK;
-            }
+  if (uart_bufreserve(&dev->xmit, 0, &span) > 0)
+    {
+      ret = OK;
+    }
 
 #ifdef CONFIG_SERIAL_REMOVABLE
-          /* Check if the removable device is no longer connected while we
-           * have interrupts off.  We do not want the transition to occur
-           * as a race condition before we begin the wait.
-           */
+  /* Check if the removable device is no longer connected while we have
+   * interrupts off.  We do not want the transition to occur as a race
+   * condition before we begin the wait.
+   */
 
-          else if (dev->disconnected)
-            {
-              ret = -ENOTCONN;
-            }
+  else if (dev->disconnected)
+    {
+      ret = -ENOTCONN;
+    }
 #endif
-          else
-            {
-              /* Inform the interrupt level logic that we are waiting. */
+  else
+    {
+      /* Inform the interrupt level logic that we are waiting. */
 
-              dev->xmitwaiting = true;
+      dev->xmitwaiting = true;
 
-              /* Wait for some characters to be sent from the buffer with
-               * the TX interrupt enabled.  When the TX interrupt is enabled,
-               * uart_xmitchars() should execute and remove some of the data
-               * from the TX buffer.
-               *
-               * NOTE that interrupts will be re-enabled while we wait for
-               * the semaphore.
-               */
+      /* Wait for some characters to be sent from the buffer with the TX
+       * interrupt enabled.  When the TX interrupt is enabled,
+       * uart_xmitchars() should execute and remove some of the data from
+       * the TX buffer.
+       *
+       * NOTE that interrupts will be re-enabled while we wait for the
+       * semaphore.
+       */
 
 #ifdef CONFIG_SERIAL_TXDMA
-              uart_dmatxavail(dev);
+      uart_dmatxavail(dev);
 #endif
-              uart_enabletxint(dev);
-              ret = uart_takesem(&dev->xmitsem, true);
-              uart_disabletxint(dev);
-            }
+      uart_enabletxint(dev);
+      ret = uart_takesem(&dev->xmitsem, true);
+    }
 
-          leave_critical_section(flags);
+  leave_critical_section(flags);
 
 #ifdef CONFIG_SERIAL_REMOVABLE
-          /* Check if the removable device was disconnected while we were
-           * waiting.
-           */
-
-          if (dev->disconnected)
-            {
-              ret = -ENOTCONN;
-              goto err_out;
-            }
-#endif
-          /* Check if we were awakened by signal. */
-
-          if (ret < 0)
-            {
-              /* A signal received while waiting for the xmit buffer to become
-               * non-full will abort the transfer.
-               */
-
-              ret = -EINTR;
-              goto err_out;
-            }
-        }
-
-      /* The caller has request that we not block for data.  So return the
-       * EAGAIN error to signal this situation.
-       */
+  /* Check if the removable device was disconnected while we were waiting. */
 
-      else
-        {
-          ret = -EAGAIN;
-          goto err_out;
-        }
+  if (dev->disconnected)
+    {
+      return -ENOTCONN;
     }
+#endif
 
-  /* We won't get here.  Some compilers may complain that this code is
-   * unreachable.
+  /* Check if we were awakened by signal.  A signal received while waiting
+   * for the xmit buffer to become non-full will abort the transfer.
    */
 
-  ret = OK;
-
-err_out:
-
-#ifdef CONFIG_SMP
-  leave_critical_section(flags2);
-#endif
-
-  return ret;
+  return ret < 0 ? -EINTR : OK;
 }
 
 /************************************************************************************
@@ -724,7 +630,9 @@ static ssize_t uart_read(FAR struct file *filep, FAR char *buffer, size_t buflen
 #endif
   irqstate_t flags;
   ssize_t recvd = 0;
-  int16_t tail;
+  FAR char *span;
+  size_t nspan;
+  size_t n;
   char ch;
   int ret;
 
@@ -764,74 +672,68 @@ static ssize_t uart_read(FAR struct file *filep, FAR char *buffer, size_t buflen
         }
 #endif
 
-      /* Check if there is more data to return in the circular buffer.
+      /* Check if there is more data to return in the circular buffer and
+       * take as much of the contiguous data at its tail as fits.
        * NOTE: Rx interrupt handling logic may asynchronously increment
        * the head index but must not modify the tail index.  The tail
-       * index is only modified in this function.  Therefore, no
-       * special handshaking is required here.
+       * index is only modified in this function, once per contiguous
+       * span.  Therefore, no special handshaking is required here.
        *
        * The head and tail pointers are 16-bit values.  The only time that
        * the following could be unsafe is if the CPU made two non-atomic
        * 8-bit accesses to obtain the 16-bit head index.
        */
 
-      tail = rxbuf->tail;
-      if (rxbuf->head != tail)
+      nspan = uart_bufpeek(rxbuf, 0, &span);
+      if (nspan > 0)
         {
-          /* Take the next character from the tail of the buffer */
-
-          ch = rxbuf->buffer[tail];
-
-          /* Increment the tail index.  Most operations are done using the
-           * local variable 'tail' so that the final rxbuf->tail update
-           * is atomic.
-           */
-
-          if (++tail >= rxbuf->size)
+          for (n = 0; n < nspan && (size_t)recvd < buflen; )
             {
-              tail = 0;
-            }
-
-          rxbuf->tail = tail;
+              ch = span[n++];
 
 #ifdef CONFIG_SERIAL_TERMIOS
-          /* Do input processing if any is enabled */
+              /* Do input processing if any is enabled */
 
-          if (dev->tc_iflag & (INLCR | IGNCR | ICRNL))
-            {
-              /* \n -> \r or \r -> \n translation? */
-
-              if ((ch == '\n') && (dev->tc_iflag & INLCR))
-                {
-                  ch = '\r';
-                }
-              else if ((ch == '\r') && (dev->tc_iflag & ICRNL))
+              if (dev->tc_iflag & (INLCR | IGNCR | ICRNL))
                 {
-                  ch = '\n';
-                }
+                  /* \n -> \r or \r -> \n translation? */
 
-              /* Discarding \r ? */
+                  if ((ch == '\n') && (dev->tc_iflag & INLCR))
+                    {
+                      ch = '\r';
+                    }
+                  else if ((ch == '\r') && (dev->tc_iflag & ICRNL))
+                    {
+                      ch = '\n';
+                    }
 
-              if ((ch == '\r') & (dev->tc_iflag & IGNCR))
-                {
-                  continue;
+                  /* Discarding \r ? */
+
+                  if ((ch == '\r') & (dev->tc_iflag & IGNCR))
+                    {
+                      continue;
+                    }
                 }
-            }
 
-          /* Specifically not handled:
-           *
-           * All of the local modes; echo, line editing, etc.
-           * Anything to do with break or parity errors.
-           * ISTRIP - we should be 8-bit clean.
-           * IUCLC - Not Posix
-           * IXON/OXOFF - no xon/xoff flow control.
-           */
+              /* Specifically not handled:
+               *
+               * All of the local modes; echo, line editing, etc.
+               * Anything to do with break or parity errors.
+               * ISTRIP - we should be 8-bit clean.
+               * IUCLC - Not Posix
+               * IXON/OXOFF - no xon/xoff flow control.
+               */
 #endif
 
-          /* Store the received character */
+              /* Store the received character */
 
-          *buffer++ = ch;
-          recvd++;
+              *buffer++ = ch;
+              recvd++;
+            }
+
+          /* Remove the characters that were taken from the buffer */
+
+          uart_bufconsume(rxbuf, n);
         }
 
 #ifdef CONFIG_DEV_SERIAL_FULLBLOCKS
@@ -1061,8 +963,14 @@ static ssize_t uart_write(FAR struct file *filep, FAR const char *buffer,
 {
   FAR struct inode *inode    = filep->f_inode;
   FAR uart_dev_t   *dev      = inode->i_private;
-  ssize_t           nwritten = buflen;
+  ssize_t           nwritten;
+  irqstate_t        flags;
+  FAR char         *span;
+  size_t            nspan;
+  size_t            n;
   bool              oktoblock;
+  bool              addcr;
+  bool              crdone;
   int               ret;
   char              ch;
 
@@ -1073,8 +981,6 @@ static ssize_t uart_write(FAR struct file *filep, FAR const char *buffer,
 
   if (up_interrupt_context() || sched_idletask())
     {
-      irqstate_t flags;
-
 #ifdef CONFIG_SERIAL_REMOVABLE
       /* If the removable device is no longer connected, refuse to write to
        * the device.
@@ -1128,103 +1034,130 @@ static ssize_t uart_write(FAR struct file *filep, FAR const char *buffer,
 
   /* Loop while we still have data to copy to the transmit buffer.
    * we add data to the head of the buffer; uart_xmitchars takes the
-   * data from the end of the buffer.
+   * data from the end of the buffer.  The data is copied one contiguous
+   * span of free space at a time and each span is added to the buffer with
+   * a single update of the head index.
    */
 
-  uart_disabletxint(dev);
-  for (; buflen; buflen--)
-    {
-      ch  = *buffer++;
-      ret = OK;
-
-#ifdef CONFIG_SERIAL_TERMIOS
-      /* Do output post-processing */
+  nwritten = 0;
+  crdone   = false;
 
-      if ((dev->tc_oflag & OPOST) != 0)
+  while (buflen > 0)
+    {
+      nspan = uart_bufreserve(&dev->xmit, 0, &span);
+      if (nspan == 0)
         {
-          /* Mapping CR to NL? */
+          /* The TX buffer is full.  Wait for the hardware to remove some
+           * data from the buffer.  This might fail under one of three
+           * conditions:  (1) The wait for buffer space might have been
+           * interrupted by a signal (ret should be -EINTR), (2) if
+           * CONFIG_SERIAL_REMOVABLE is defined, then the serial device
+           * might have been disconnected (with -ENOTCONN), or (3) if
+           * O_NONBLOCK is specified, then -EAGAIN is returned.
+           */
 
-          if ((ch == '\r') && (dev->tc_oflag & OCRNL) != 0)
+          ret = uart_waitxmit(dev, oktoblock);
+          if (ret < 0)
             {
-              ch = '\n';
-            }
+              /* POSIX requires that we return -1 and errno set if no data
+               * was transferred.  Otherwise, we return the number of bytes
+               * in the interrupted transfer.
+               */
 
-          /* Are we interested in newline processing? */
+              if (nwritten == 0)
+                {
+                  nwritten = ret;
+                }
 
-          if ((ch == '\n') && (dev->tc_oflag & (ONLCR | ONLRET)) != 0)
-            {
-              ret = uart_putxmitchar(dev, '\r', oktoblock);
+              break;
             }
 
-          /* Specifically not handled:
-           *
-           * OXTABS - primarily a full-screen terminal optimization
-           * ONOEOT - Unix interoperability hack
-           * OLCUC  - Not specified by POSIX
-           * ONOCR  - low-speed interactive optimization
-           */
+          continue;
         }
 
-#else /* !CONFIG_SERIAL_TERMIOS */
-      /* If this is the console, convert \n -> \r\n */
+#ifdef CONFIG_SMP
+      flags = enter_critical_section();
+#endif
+      uart_disabletxint(dev);
 
-      if (dev->isconsole && ch == '\n')
+      for (n = 0; n < nspan && buflen > 0; )
         {
-          ret = uart_putxmitchar(dev, '\r', oktoblock);
-        }
-#endif
+          ch    = *buffer;
+          addcr = false;
 
-      /* Put the character into the transmit buffer */
+#ifdef CONFIG_SERIAL_TERMIOS
+          /* Do output post-processing */
 
-      if (ret >= 0)
-        {
-          ret = uart_putxmitchar(dev, ch, oktoblock);
-        }
+          if ((dev->tc_oflag & OPOST) != 0)
+            {
+              /* Mapping CR to NL? */
 
-      /* uart_putxmitchar() might return an error under one of two
-       * conditions:  (1) The wait for buffer space might have been
-       * interrupted by a signal (ret should be -EINTR), (2) if
-       * CONFIG_SERIAL_REMOVABLE is defined, then uart_putxmitchar()
-       * might also return if the serial device was disconnected
-       * (with -ENOTCONN), or (3) if O_NONBLOCK is specified, then
-       * then uart_putxmitchar() might return -EAGAIN if the output
-       * TX buffer is full.
-       */
+              if ((ch == '\r') && (dev->tc_oflag & OCRNL) != 0)
+                {
+                  ch = '\n';
+                }
 
-      if (ret < 0)
-        {
-          /* POSIX requires that we return -1 and errno set if no data was
-           * transferred.  Otherwise, we return the number of bytes in the
-           * interrupted transfer.
-           */
+              /* Are we interested in newline processing? */
 
-          if (buflen < (size_t)nwritten)
-            {
-              /* Some data was transferred.  Return the number of bytes that
-               * were successfully transferred.
-               */
+              if ((ch == '\n') && (dev->tc_oflag & (ONLCR | ONLRET)) != 0)
+                {
+                  addcr = true;
+                }
 
-              nwritten -= buflen;
+              /* Specifically not handled:
+               *
+               * OXTABS - primarily a full-screen terminal optimization
+               * ONOEOT - Unix interoperability hack
+               * OLCUC  - Not specified by POSIX
+               * ONOCR  - low-speed interactive optimization
+               */
             }
-          else
+
+#else /* !CONFIG_SERIAL_TERMIOS */
+          /* If this is the console, convert \n -> \r\n */
+
+          if (dev->isconsole && ch == '\n')
             {
-              /* No data was transferred. Return the negated errno value.
-               * The VFS layer will set the errno value appropriately).
-               */
+              addcr = true;
+            }
+#endif
 
-              nwritten = ret;
+          /* Put the inserted CR into the span.  If that fills the span,
+           * remember that it was sent so that the next span starts with
+           * the character itself.
+           */
+
+          if (addcr && !crdone)
+            {
+              span[n++] = '\r';
+              if (n >= nspan)
+                {
+                  crdone = true;
+                  break;
+                }
             }
 
-          break;
+          /* Put the character into the span */
+
+          span[n++] = ch;
+          crdone    = false;
+          buffer++;
+          buflen--;
+          nwritten++;
         }
-    }
 
-  if (dev->xmit.head != dev->xmit.tail)
-    {
+      /* Add the span to the TX buffer and let the hardware send it */
+
+      uart_bufcommit(&dev->xmit, n);
+
 #ifdef CONFIG_SERIAL_TXDMA
       uart_dmatxavail(dev);
 #endif
       uart_enabletxint(dev);
+
+#ifdef CONFIG_SMP
+      leave_critical_section(flags);
+#endif
     }
 
   uart_givesem(&dev->xmit.sem);
@@ -159,20 +159,12 @@ void uart_xmitchars_dma(FAR uart_dev_t *dev)
       return;
     }
 
-  if (dev->xmit.tail < dev->xmit.head)
-    {
-      xfer->buffer  = &dev->xmit.buffer[dev->xmit.tail];
-      xfer->length  = dev->xmit.head - dev->xmit.tail;
-      xfer->nbuffer = NULL;
-      xfer->nlength = 0;
-    }
-  else
-    {
-      xfer->buffer  = &dev->xmit.buffer[dev->xmit.tail];
-      xfer->length  = dev->xmit.size - dev->xmit.tail;
-      xfer->nbuffer = dev->xmit.buffer;
-      xfer->nlength = dev->xmit.head;
-    }
+  /* The data up to the end of the buffer, then the data that wrapped
+   * around to its beginning.
+   */
+
+  xfer->length  = uart_bufpeek(&dev->xmit, 0, &xfer->buffer);
+  xfer->nlength = uart_bufpeek(&dev->xmit, xfer->length, &xfer->nbuffer);
 
   uart_dmasend(dev);
 }
@@ -204,7 +196,7 @@ void uart_xmitchars_done(FAR uart_dev_t *dev)
     {
       /* Move tail for nbytes. */
 
-      txbuf->tail  = (txbuf->tail + nbytes) % txbuf->size;
+      uart_bufconsume(txbuf, nbytes);
     }
 
   /* Reset xmit buffer. */
@@ -325,29 +317,12 @@ void uart_recvchars_dma(FAR uart_dev_t *dev)
       return;
     }
 
-  if (rxbuf->tail <= rxbuf->head)
-    {
-      xfer->buffer  = &rxbuf->buffer[rxbuf->head];
-      xfer->nbuffer = rxbuf->buffer;
+  /* The free space up to the end of the buffer, then the free space at its
+   * beginning.
+   */
 
-      if (rxbuf->tail > 0)
-        {
-          xfer->length  = rxbuf->size - rxbuf->head;
-          xfer->nlength = rxbuf->tail - 1;
-        }
-      else
-        {
-          xfer->length  = rxbuf->size - rxbuf->head - 1;
-          xfer->nlength = 0;
-        }
-    }
-  else
-    {
-      xfer->buffer  = &rxbuf->buffer[rxbuf->head];
-      xfer->length  = rxbuf->tail - rxbuf->head - 1;
-      xfer->nbuffer = NULL;
-      xfer->nlength = 0;
-    }
+  xfer->length  = uart_bufreserve(rxbuf, 0, &xfer->buffer);
+  xfer->nlength = uart_bufreserve(rxbuf, xfer->length, &xfer->nbuffer);
 
   uart_dmareceive(dev);
 }
@@ -383,7 +358,7 @@ void uart_recvchars_done(FAR uart_dev_t *dev)
 
   /* Move head for nbytes. */
 
-  rxbuf->head  = (rxbuf->head + nbytes) % rxbuf->size;
+  uart_bufcommit(rxbuf, nbytes);
   xfer->nbytes = 0;
   xfer->length = xfer->nlength = 0;
 
@@ -55,6 +55,121 @@
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: uart_bufreserve
+ *
+ * Description:
+ *   Return the contiguous free space that begins 'offset' bytes after the
+ *   head index of the circular buffer.  One byte is always left free to
+ *   distinguish a full buffer from an empty one.
+ *
+ ****************************************************************************/
+
+size_t uart_bufreserve(FAR struct uart_buffer_s *buf, size_t offset,
+                       FAR char **span)
+{
+  int16_t head = buf->head;
+  int16_t tail = buf->tail;
+  size_t nfree;
+  size_t pos;
+  size_t n;
+
+  if (head >= tail)
+    {
+      nfree = buf->size - head + tail - 1;
+    }
+  else
+    {
+      nfree = tail - head - 1;
+    }
+
+  if (offset >= nfree)
+    {
+      *span = NULL;
+      return 0;
+    }
+
+  pos = (head + offset) % buf->size;
+  n   = buf->size - pos;
+
+  *span = &buf->buffer[pos];
+  return n < nfree - offset ? n : nfree - offset;
+}
+
+/****************************************************************************
+ * Name: uart_bufcommit
+ *
+ * Description:
+ *   Add 'nbytes' bytes written to the reserved space to the circular buffer.
+ *
+ ****************************************************************************/
+
+void uart_bufcommit(FAR struct uart_buffer_s *buf, size_t nbytes)
+{
+  /* Use a local variable so that the update of the head index is atomic */
+
+  int16_t head = (buf->head + nbytes) % buf->size;
+
+  buf->head = head;
+}
+
+/****************************************************************************
+ * Name: uart_bufpeek
+ *
+ * Description:
+ *   Return the contiguous data that begins 'offset' bytes after the tail
+ *   index of the circular buffer.
+ *
+ ****************************************************************************/
+
+size_t uart_bufpeek(FAR struct uart_buffer_s *buf, size_t offset,
+                    FAR char **span)
+{
+  int16_t head = buf->head;
+  int16_t tail = buf->tail;
+  size_t count;
+  size_t pos;
+  size_t n;
+
+  if (head >= tail)
+    {
+      count = head - tail;
+    }
+  else
+    {
+      count = buf->size - tail + head;
+    }
+
+  if (offset >= count)
+    {
+      *span = NULL;
+      return 0;
+    }
+
+  pos = (tail + offset) % buf->size;
+  n   = buf->size - pos;
+
+  *span = &buf->buffer[pos];
+  return n < count - offset ? n : count - offset;
+}
+
+/****************************************************************************
+ * Name: uart_bufconsume
+ *
+ * Description:
+ *   Remove 'nbytes' bytes from the tail of the circular buffer.
+ *
+ ****************************************************************************/
+
+void uart_bufconsume(FAR struct uart_buffer_s *buf, size_t nbytes)
+{
+  /* Use a local variable so that the update of the tail index is atomic */
+
+  int16_t tail = (buf->tail + nbytes) % buf->size;
+
+  buf->tail = tail;
+}
+
 /****************************************************************************
  * Name: uart_xmitchars
  *
@@ -48,6 +48,7 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <string.h>
+#include <unistd.h>
 #include <poll.h>
 #include <errno.h>
 #include <assert.h>
@@ -55,6 +56,7 @@
 
 #include <nuttx/arch.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/syslog/ramlog.h>
@@ -63,6 +65,24 @@
 
 #ifdef CONFIG_RAMLOG
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_RAMLOG_LOCKLESS) && defined(CONFIG_RAMLOG_SYSLOG)
+#  ifndef CONFIG_RAMLOG_STAGESIZE
+#    define CONFIG_RAMLOG_STAGESIZE 64
+#  endif
+#  ifndef CONFIG_RAMLOG_NSTAGES
+#    define CONFIG_RAMLOG_NSTAGES 4
+#  endif
+#  define RAMLOG_NSTAGES CONFIG_RAMLOG_NSTAGES
+#endif
+
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -74,6 +94,13 @@ struct ramlog_dev_s
 #endif
   volatile uint16_t rl_head;         /* The head index (where data is added) */
   volatile uint16_t rl_tail;         /* The tail index (where data is removed) */
+#ifdef CONFIG_RAMLOG_LOCKLESS
+  volatile uint16_t rl_reserve;      /* The end of the space reserved by writers */
+  volatile uint8_t  rl_nwriters;     /* Number of writers still copying data */
+#ifdef CONFIG_SMP
+  volatile spinlock_t rl_lock;       /* Protects rl_reserve and rl_nwriters */
+#endif
+#endif
   sem_t             rl_exclsem;      /* Enforces mutually exclusive access */
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   sem_t             rl_waitsem;      /* Used to wait for data */
@@ -89,6 +116,20 @@ struct ramlog_dev_s
   FAR struct pollfd *rl_fds[CONFIG_RAMLOG_NPOLLWAITERS];
 };
 
+/* Characters added one at a time by ramlog_putc() are staged per task and
+ * added to the log a line at a time.  A stage is free when it is empty.
+ * The stages are protected by the lock of the system log device.
+ */
+
+#ifdef RAMLOG_NSTAGES
+struct ramlog_stage_s
+{
+  pid_t   rs_pid;                    /* The task that owns the stage */
+  uint8_t rs_len;                    /* Number of characters staged */
+  char    rs_buffer[CONFIG_RAMLOG_STAGESIZE];
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -100,7 +141,8 @@ static int     ramlog_readnotify(FAR struct ramlog_dev_s *priv);
 #endif
 static void    ramlog_pollnotify(FAR struct ramlog_dev_s *priv,
                                  pollevent_t eventset);
-static ssize_t ramlog_addchar(FAR struct ramlog_dev_s *priv, char ch);
+static ssize_t ramlog_addbuf(FAR struct ramlog_dev_s *priv,
+                             FAR const char *buffer, size_t len);
 
 /* Character driver methods */
 
@@ -148,6 +190,13 @@ static struct ramlog_dev_s g_sysdev =
 #endif
   0,                             /* rl_head */
   0,                             /* rl_tail */
+#ifdef CONFIG_RAMLOG_LOCKLESS
+  0,                             /* rl_reserve */
+  0,                             /* rl_nwriters */
+#ifdef CONFIG_SMP
+  SP_UNLOCKED,                   /* rl_lock */
+#endif
+#endif
   SEM_INITIALIZER(1),            /* rl_exclsem */
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   SEM_INITIALIZER(0),            /* rl_waitsem */
@@ -155,6 +204,11 @@ static struct ramlog_dev_s g_sysdev =
   CONFIG_RAMLOG_BUFSIZE,         /* rl_bufsize */
   g_sysbuffer                    /* rl_buffer */
 };
+
+#ifdef RAMLOG_NSTAGES
+static struct ramlog_stage_s g_sysstage[RAMLOG_NSTAGES];
+static uint8_t g_sysevict;       /* The next stage to be evicted */
+#endif
 #endif
 
 /****************************************************************************
@@ -163,6 +217,11 @@ static struct ramlog_dev_s g_sysdev =
 
 /****************************************************************************
  * Name: ramlog_readnotify
+ *
+ * Description:
+ *   Wake up all readers that are waiting for data.  Each waiting reader is
+ *   posted only once, no matter how many writes happen before it runs.
+ *
  ****************************************************************************/
 
 #ifndef CONFIG_RAMLOG_NONBLOCKING
@@ -179,6 +238,7 @@ static int ramlog_readnotify(FAR struct ramlog_dev_s *priv)
       nxsem_post(&priv->rl_waitsem);
     }
 
+  priv->rl_nwaiters = 0;
   leave_critical_section(flags);
 
   /* Return number of notified readers. */
@@ -217,44 +277,322 @@ static void ramlog_pollnotify(FAR struct ramlog_dev_s *priv,
 }
 
 /****************************************************************************
- * Name: ramlog_addchar
+ * Name: ramlog_lock and ramlog_unlock
+ *
+ * Description:
+ *   Protect the head (or reserve) index against concurrent writers.  In the
+ *   lockless configuration, this is held only while space is reserved and
+ *   released, never while data is copied.
+ *
  ****************************************************************************/
 
-static ssize_t ramlog_addchar(FAR struct ramlog_dev_s *priv, char ch)
+static inline irqstate_t ramlog_lock(FAR struct ramlog_dev_s *priv)
 {
-  irqstate_t flags;
-  size_t nexthead;
+#ifdef CONFIG_RAMLOG_LOCKLESS
+  irqstate_t flags = up_irq_save();
+#ifdef CONFIG_SMP
+  spin_lock(&priv->rl_lock);
+#endif
+  return flags;
+#else
+  return enter_critical_section();
+#endif
+}
 
-  /* Disable interrupts (in case we are NOT called from interrupt handler) */
+static inline void ramlog_unlock(FAR struct ramlog_dev_s *priv,
+                                 irqstate_t flags)
+{
+#ifdef CONFIG_RAMLOG_LOCKLESS
+#ifdef CONFIG_SMP
+  spin_unlock(&priv->rl_lock);
+#endif
+  up_irq_restore(flags);
+#else
+  leave_critical_section(flags);
+#endif
+}
 
-  flags = enter_critical_section();
+/****************************************************************************
+ * Name: ramlog_measure
+ *
+ * Description:
+ *   Return the number of bytes that the first 'len' bytes of 'buffer'
+ *   occupy in the log, limited to 'space'.  The number of bytes of
+ *   'buffer' that fit is returned in 'nsrc'.
+ *
+ ****************************************************************************/
+
+static size_t ramlog_measure(FAR const char *buffer, size_t len,
+                             size_t space, FAR size_t *nsrc)
+{
+#ifdef CONFIG_RAMLOG_CRLF
+  size_t nout = 0;
+  size_t i;
 
-  /* Calculate the write index AFTER the next byte is written */
+  /* Carriage returns are dropped and linefeeds are expanded to CR-LF */
 
-  nexthead = priv->rl_head + 1;
-  if (nexthead >= priv->rl_bufsize)
+  for (i = 0; i < len; i++)
     {
-      nexthead = 0;
+      if (buffer[i] == '\r')
+        {
+          continue;
+        }
+
+      if (nout + (buffer[i] == '\n' ? 2 : 1) > space)
+        {
+          break;
+        }
+
+      nout += buffer[i] == '\n' ? 2 : 1;
     }
 
-  /* Would the next write overflow the circular buffer? */
+  *nsrc = i;
+  return nout;
+#else
+  *nsrc = len < space ? len : space;
+  return *nsrc;
+#endif
+}
+
+/****************************************************************************
+ * Name: ramlog_copyin
+ *
+ * Description:
+ *   Copy 'len' bytes of 'buffer' into the circular buffer starting at index
+ *   'head', handling wraparound.
+ *
+ ****************************************************************************/
+
+static void ramlog_copyin(FAR struct ramlog_dev_s *priv, size_t head,
+                          FAR const char *buffer, size_t len)
+{
+#ifdef CONFIG_RAMLOG_CRLF
+  size_t i;
 
-  if (nexthead == priv->rl_tail)
+  for (i = 0; i < len; i++)
     {
-      /* Yes... Return an indication that nothing was saved in the buffer. */
+      if (buffer[i] == '\r')
+        {
+          continue;
+        }
 
-      leave_critical_section(flags);
-      return -EBUSY;
+      if (buffer[i] == '\n')
+        {
+          priv->rl_buffer[head] = '\r';
+          if (++head >= priv->rl_bufsize)
+            {
+              head = 0;
+            }
+        }
+
+      priv->rl_buffer[head] = buffer[i];
+      if (++head >= priv->rl_bufsize)
+        {
+          head = 0;
+        }
+    }
+#else
+  size_t n = priv->rl_bufsize - head;
+
+  if (n >= len)
+    {
+      memcpy(&priv->rl_buffer[head], buffer, len);
+    }
+  else
+    {
+      memcpy(&priv->rl_buffer[head], buffer, n);
+      memcpy(priv->rl_buffer, buffer + n, len - n);
     }
+#endif
+}
+
+/****************************************************************************
+ * Name: ramlog_addlocked and ramlog_addbuf
+ *
+ * Description:
+ *   Add as much of the buffer to the log as will fit.  In the lockless
+ *   configuration, the space for the whole buffer is reserved at once and
+ *   the data is copied with interrupts enabled.  The data becomes visible
+ *   to readers when the last of the concurrent writers has finished.
+ *
+ *   Readers and poll waiters are only notified when the log goes from
+ *   empty to non-empty.
+ *
+ *   ramlog_addlocked() is called with ramlog_lock() held and releases it,
+ *   so that the caller can reserve the space atomically with its own
+ *   bookkeeping.
+ *
+ * Returned Value:
+ *   The number of bytes of the buffer that were added to the log or
+ *   -EBUSY if the log is full.
+ *
+ ****************************************************************************/
 
-  /* No... copy the byte and re-enable interrupts */
+static ssize_t ramlog_addlocked(FAR struct ramlog_dev_s *priv,
+                                irqstate_t flags,
+                                FAR const char *buffer, size_t len)
+{
+  bool wasempty = false;
+  size_t space;
+  size_t nsrc;
+  size_t nout;
+  size_t head;
+  size_t tail;
+
+  /* Get the free space after the head (or the space already reserved).  One
+   * byte is always left empty to distinguish a full from an empty log.
+   */
 
-  priv->rl_buffer[priv->rl_head] = ch;
-  priv->rl_head = nexthead;
-  leave_critical_section(flags);
-  return OK;
+#ifdef CONFIG_RAMLOG_LOCKLESS
+  head = priv->rl_reserve;
+#else
+  head = priv->rl_head;
+#endif
+  tail = priv->rl_tail;
+
+  if (head >= tail)
+    {
+      space = priv->rl_bufsize - head + tail - 1;
+    }
+  else
+    {
+      space = tail - head - 1;
+    }
+
+  nout = ramlog_measure(buffer, len, space, &nsrc);
+  if (nout == 0)
+    {
+      /* The buffer is full and nothing can be saved. */
+
+      ramlog_unlock(priv, flags);
+      return nsrc > 0 ? nsrc : -EBUSY;
+    }
+
+#ifdef CONFIG_RAMLOG_LOCKLESS
+  /* Reserve the space and copy the data without holding the lock */
+
+  priv->rl_reserve = (head + nout) % priv->rl_bufsize;
+  priv->rl_nwriters++;
+  ramlog_unlock(priv, flags);
+
+  ramlog_copyin(priv, head, buffer, nsrc);
+
+  /* The last writer makes all of the reserved data visible */
+
+  flags = ramlog_lock(priv);
+  if (--priv->rl_nwriters == 0)
+    {
+      SP_DMB();
+      wasempty      = (priv->rl_head == priv->rl_tail);
+      priv->rl_head = priv->rl_reserve;
+    }
+
+  ramlog_unlock(priv, flags);
+#else
+  ramlog_copyin(priv, head, buffer, nsrc);
+
+  wasempty      = (head == tail);
+  priv->rl_head = (head + nout) % priv->rl_bufsize;
+  ramlog_unlock(priv, flags);
+#endif
+
+  if (wasempty)
+    {
+#ifndef CONFIG_RAMLOG_NONBLOCKING
+      /* Are there threads waiting for read data? */
+
+      ramlog_readnotify(priv);
+#endif
+
+      /* Notify all poll/select waiters that they can read from the FIFO */
+
+      ramlog_pollnotify(priv, POLLIN);
+    }
+
+  return nsrc;
+}
+
+static ssize_t ramlog_addbuf(FAR struct ramlog_dev_s *priv,
+                             FAR const char *buffer, size_t len)
+{
+  return ramlog_addlocked(priv, ramlog_lock(priv), buffer, len);
 }
 
+/****************************************************************************
+ * Name: ramlog_findstage
+ *
+ * Description:
+ *   Return the stage of the task 'pid' or, if 'alloc' is true and the task
+ *   has nothing staged, a free stage for it.  NULL is returned if there is
+ *   no such stage.  Called with ramlog_lock() held.
+ *
+ ****************************************************************************/
+
+#ifdef RAMLOG_NSTAGES
+static FAR struct ramlog_stage_s *ramlog_findstage(pid_t pid, bool alloc)
+{
+  FAR struct ramlog_stage_s *avail = NULL;
+  int i;
+
+  for (i = 0; i < RAMLOG_NSTAGES; i++)
+    {
+      FAR struct ramlog_stage_s *stage = &g_sysstage[i];
+
+      if (stage->rs_len == 0)
+        {
+          if (avail == NULL)
+            {
+              avail = stage;
+            }
+        }
+      else if (stage->rs_pid == pid)
+        {
+          return stage;
+        }
+    }
+
+  if (alloc && avail != NULL)
+    {
+      avail->rs_pid = pid;
+      return avail;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ramlog_commitstage
+ *
+ * Description:
+ *   Add the characters staged in 'stage' to the log and free the stage.
+ *   Called with ramlog_lock() held and releases it.  The space is reserved
+ *   before the lock is released, so the characters cannot be overtaken by
+ *   later output of the same task.
+ *
+ ****************************************************************************/
+
+static void ramlog_commitstage(FAR struct ramlog_dev_s *priv,
+                               FAR struct ramlog_stage_s *stage,
+                               irqstate_t flags)
+{
+  char buffer[CONFIG_RAMLOG_STAGESIZE];
+  size_t len;
+
+  len = stage->rs_len;
+  memcpy(buffer, stage->rs_buffer, len);
+  stage->rs_len = 0;
+
+  if (len > 0)
+    {
+      ramlog_addlocked(priv, flags, buffer, len);
+    }
+  else
+    {
+      ramlog_unlock(priv, flags);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: ramlog_read
  ****************************************************************************/
@@ -263,8 +601,13 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct ramlog_dev_s *priv;
+#ifndef CONFIG_RAMLOG_NONBLOCKING
+  irqstate_t flags;
+#endif
   ssize_t nread;
-  char ch;
+  size_t head;
+  size_t tail;
+  size_t n;
   int ret;
 
   /* Some sanity checking */
@@ -278,6 +621,15 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
   DEBUGASSERT(!up_interrupt_context());
 
+#ifdef RAMLOG_NSTAGES
+  /* Make partial lines, such as prompts, visible to the reader */
+
+  if (priv == &g_sysdev)
+    {
+      ramlog_flush();
+    }
+#endif
+
   /* Get exclusive access to the rl_tail index */
 
   ret = nxsem_wait(&priv->rl_exclsem);
@@ -290,9 +642,12 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
   for (nread = 0; (size_t)nread < len; )
     {
-      /* Get the next byte from the buffer */
+      /* Get the next contiguous data from the buffer */
 
-      if (priv->rl_head == priv->rl_tail)
+      head = priv->rl_head;
+      tail = priv->rl_tail;
+
+      if (head == tail)
         {
           /* The circular buffer is empty. */
 
@@ -321,10 +676,22 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
           /* Otherwise, wait for something to be written to the circular
            * buffer. Increment the number of waiters so that the ramlog_write()
            * will note that it needs to post the semaphore to wake us up.
+           * Writers only notify when the buffer becomes non-empty, so the
+           * buffer must be checked again in the same critical section in
+           * which the waiter is counted.  The writer resets the count when
+           * it posts the semaphore.
            */
 
+          flags = enter_critical_section();
+          if (priv->rl_head != priv->rl_tail)
+            {
+              leave_critical_section(flags);
+              continue;
+            }
+
           sched_lock();
           priv->rl_nwaiters++;
+          leave_critical_section(flags);
           nxsem_post(&priv->rl_exclsem);
 
           /* We may now be pre-empted!  But that should be okay because we
@@ -333,12 +700,6 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
            */
 
           ret = nxsem_wait(&priv->rl_waitsem);
-
-          /* Interrupts will be disabled when we return.  So the decrementing
-           * rl_nwaiters here is safe.
-           */
-
-          priv->rl_nwaiters--;
           sched_unlock();
 
           /* Did we successfully get the rl_waitsem? */
@@ -375,23 +736,28 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
         }
       else
         {
-          /* The circular buffer is not empty, get the next byte from the
-           * tail index.
+          /* The circular buffer is not empty, copy the data up to the head
+           * index or the end of the buffer, whichever comes first.
            */
 
-          ch = priv->rl_buffer[priv->rl_tail];
+          n = (head > tail ? head : priv->rl_bufsize) - tail;
+          if (n > len - nread)
+            {
+              n = len - nread;
+            }
+
+          memcpy(&buffer[nread], &priv->rl_buffer[tail], n);
+          nread += n;
 
           /* Increment the tail index. */
 
-          if (++priv->rl_tail >= priv->rl_bufsize)
+          tail += n;
+          if (tail >= priv->rl_bufsize)
             {
-              priv->rl_tail = 0;
+              tail = 0;
             }
 
-          /* Add the character to the user buffer. */
-
-          buffer[nread] = ch;
-          nread++;
+          priv->rl_tail = tail;
         }
     }
 
@@ -423,10 +789,8 @@ static ssize_t ramlog_write(FAR struct file *filep, FAR const char *buffer, size
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct ramlog_dev_s *priv;
-  int readers_waken;
   ssize_t nwritten;
-  char ch;
-  int ret;
+  size_t offset;
 
   /* Some sanity checking */
 
@@ -442,40 +806,10 @@ static ssize_t ramlog_write(FAR struct file *filep, FAR const char *buffer, size
    * interrupts.
    */
 
-  for (nwritten = 0; (size_t)nwritten < len; nwritten++)
+  for (offset = 0; offset < len; offset += nwritten)
     {
-      /* Get the next character to output */
-
-      ch = buffer[nwritten];
-
-      /* Ignore carriage returns */
-
-#ifdef CONFIG_RAMLOG_CRLF
-      if (ch == '\r')
-        {
-          continue;
-        }
-
-      /* Pre-pend a carriage before a linefeed */
-
-      if (ch == '\n')
-        {
-          ret = ramlog_addchar(priv, '\r');
-          if (ret < 0)
-            {
-              /* The buffer is full and nothing was saved.  The remaining
-               * data to be written is dropped on the floor.
-               */
-
-              break;
-            }
-        }
-#endif
-
-      /* Then output the character */
-
-      ret = ramlog_addchar(priv, ch);
-      if (ret < 0)
+      nwritten = ramlog_addbuf(priv, &buffer[offset], len - offset);
+      if (nwritten < 0)
         {
           /* The buffer is full and nothing was saved.  The remaining
            * data to be written is dropped on the floor.
@@ -485,35 +819,6 @@ static ssize_t ramlog_write(FAR struct file *filep, FAR const char *buffer, size
         }
     }
 
-  /* Was anything written? */
-
-  if (nwritten > 0)
-    {
-      readers_waken = 0;
-
-#ifndef CONFIG_RAMLOG_NONBLOCKING
-      /* Are there threads waiting for read data? */
-
-      readers_waken = ramlog_readnotify(priv);
-#endif
-
-      /* If there are multiple readers, some of them might block despite
-       * POLLIN because first reader might read all data. Favor readers
-       * and notify poll waiters only if no reader was awaken, even if the
-       * latter may starve.
-       *
-       * This also implies we do not have to make these two notify
-       * operations a critical section.
-       */
-
-      if (readers_waken == 0)
-        {
-          /* Notify all poll/select waiters that they can read from the FIFO */
-
-          ramlog_pollnotify(priv, POLLIN);
-        }
-    }
-
   /* We always have to return the number of bytes requested and NOT the
    * number of bytes that were actually written.  Otherwise, callers
    * probably retry, causing same error condition again.
@@ -553,6 +858,15 @@ int ramlog_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup)
 
   if (setup)
     {
+#ifdef RAMLOG_NSTAGES
+      /* Make partial lines, such as prompts, visible to the poller */
+
+      if (priv == &g_sysdev)
+        {
+          ramlog_flush();
+        }
+
+#endif
       /* This is a request to set up the poll.  Find an available
        * slot for the poll structure reference.
        */
@@ -719,34 +1033,55 @@ void ramlog_syslog_register(void)
 int ramlog_putc(int ch)
 {
   FAR struct ramlog_dev_s *priv = &g_sysdev;
-  int readers_waken = 0;
+  char buffer = ch;
   int ret;
 
-#ifdef CONFIG_RAMLOG_CRLF
-  /* Ignore carriage returns.  But return success. */
-
-  if (ch == '\r')
-    {
-      return ch;
-    }
+#ifdef RAMLOG_NSTAGES
+  FAR struct ramlog_stage_s *stage;
+  irqstate_t flags;
+  pid_t me;
 
-  /* Pre-pend a newline with a carriage return */
+  /* Stage the character in the buffer of the calling task, so that lines
+   * are not split when the task is preempted or migrates to another CPU.
+   * The staged characters are added to the log when a line is complete or
+   * the stage is full.  Interrupt handlers have no task of their own and
+   * add their characters directly.
+   */
 
-  if (ch == '\n')
+  if (!up_interrupt_context())
     {
-      ret = ramlog_addchar(priv, '\r');
-      if (ret < 0)
+      me    = getpid();
+      flags = ramlog_lock(priv);
+
+      while ((stage = ramlog_findstage(me, true)) == NULL)
         {
-          /* The buffer is full and nothing was saved. */
+          /* All of the stages are in use.  Evict one of them. */
 
-          return ret;
+          stage = &g_sysstage[g_sysevict];
+          g_sysevict = (g_sysevict + 1) % RAMLOG_NSTAGES;
+
+          ramlog_commitstage(priv, stage, flags);
+          flags = ramlog_lock(priv);
+        }
+
+      stage->rs_buffer[stage->rs_len++] = ch;
+
+      if (ch == '\n' || stage->rs_len >= CONFIG_RAMLOG_STAGESIZE)
+        {
+          ramlog_commitstage(priv, stage, flags);
+        }
+      else
+        {
+          ramlog_unlock(priv, flags);
         }
+
+      return ch;
     }
 #endif
 
   /* Add the character to the RAMLOG */
 
-  ret = ramlog_addchar(priv, ch);
+  ret = ramlog_addbuf(priv, &buffer, 1);
   if (ret < 0)
     {
       /* The buffer is full and 'ch' was not saved. */
@@ -754,31 +1089,89 @@ int ramlog_putc(int ch)
       return ret;
     }
 
-#ifndef CONFIG_RAMLOG_NONBLOCKING
-  /* Are there threads waiting for read data? */
+  /* Return the character added on success */
 
-  readers_waken = ramlog_readnotify(priv);
+  return ch;
+}
 #endif
 
-  /* If there are multiple readers, some of them might block despite
-   * POLLIN because first reader might read all data. Favor readers
-   * and notify poll waiters only if no reader was awaken, even if the
-   * latter may starve.
-   *
-   * This also implies we do not have to make these two notify
-   * operations a critical section.
-   */
+/****************************************************************************
+ * Name: ramlog_syslog_write
+ *
+ * Description:
+ *   This is the low-level, multiple character, system logging interface.
+ *   The whole buffer is added to the log at once.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_RAMLOG_SYSLOG) && defined(CONFIG_SYSLOG_WRITE)
+ssize_t ramlog_syslog_write(FAR const char *buffer, size_t buflen)
+{
+  FAR struct ramlog_dev_s *priv = &g_sysdev;
+  ssize_t nwritten;
+  size_t offset;
 
-  if (readers_waken == 0)
+#ifdef RAMLOG_NSTAGES
+  FAR struct ramlog_stage_s *stage;
+  irqstate_t flags;
+
+  /* Keep the order with the characters staged by ramlog_putc() */
+
+  if (!up_interrupt_context())
     {
-      /* Notify all poll/select waiters that they can read from the FIFO */
+      flags = ramlog_lock(priv);
+      stage = ramlog_findstage(getpid(), false);
+      if (stage != NULL)
+        {
+          ramlog_commitstage(priv, stage, flags);
+        }
+      else
+        {
+          ramlog_unlock(priv, flags);
+        }
+    }
+#endif
 
-      ramlog_pollnotify(priv, POLLIN);
+  for (offset = 0; offset < buflen; offset += nwritten)
+    {
+      nwritten = ramlog_addbuf(priv, &buffer[offset], buflen - offset);
+      if (nwritten < 0)
+        {
+          /* The buffer is full.  The remaining data is dropped. */
+
+          break;
+        }
     }
 
-  /* Return the character added on success */
+  return buflen;
+}
+#endif
 
-  return ch;
+/****************************************************************************
+ * Name: ramlog_flush
+ *
+ * Description:
+ *   Add the characters staged by ramlog_putc() for all tasks to the log,
+ *   including partial lines.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_SYSLOG
+int ramlog_flush(void)
+{
+#ifdef RAMLOG_NSTAGES
+  FAR struct ramlog_dev_s *priv = &g_sysdev;
+  irqstate_t flags;
+  int i;
+
+  for (i = 0; i < RAMLOG_NSTAGES; i++)
+    {
+      flags = ramlog_lock(priv);
+      ramlog_commitstage(priv, &g_sysstage[i], flags);
+    }
+#endif
+
+  return OK;
 }
 #endif
 
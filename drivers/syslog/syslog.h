@@ -42,6 +42,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdarg.h>
 #include <stdbool.h>
 
 /****************************************************************************
@@ -248,6 +249,56 @@ int syslog_flush_intbuffer(FAR const struct syslog_channel_s *channel,
                            bool force);
 #endif
 
+/****************************************************************************
+ * Name: syslog_defer
+ *
+ * Description:
+ *   Record the format string and the arguments of a message in a binary
+ *   buffer.  The message is formatted later by the deferred SYSLOG worker
+ *   thread.
+ *
+ * Input Parameters:
+ *   ts  - The time stamp of the message (CONFIG_SYSLOG_TIMESTAMP only)
+ *   fmt - The format string
+ *   ap  - The arguments
+ *
+ * Returned Value:
+ *   Zero (OK) is returned if the message was recorded (or dropped because
+ *   the buffer is full).  A negated errno value is returned if the caller
+ *   must format the message itself.
+ *
+ * Assumptions:
+ *   May be called from an interrupt handler.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+struct timespec;
+int syslog_defer(FAR const struct timespec *ts, FAR const IPTR char *fmt,
+                 FAR va_list *ap);
+#endif
+
+/****************************************************************************
+ * Name: syslog_defer_flush
+ *
+ * Description:
+ *   Format all of the deferred messages in the context of the caller.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero (OK) is always returned.
+ *
+ * Assumptions:
+ *   Interrupts may or may not be disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+int syslog_defer_flush(void);
+#endif
+
 /****************************************************************************
  * Name: syslog_putc
  *
@@ -72,7 +72,9 @@
 #ifdef NEED_LOWPUTC
 static int syslog_default_putc(int ch);
 #endif
+#ifndef CONFIG_RAMLOG_SYSLOG
 static int syslog_default_flush(void);
+#endif
 
 /****************************************************************************
  * Public Data
@@ -83,7 +85,10 @@ static const struct syslog_channel_s g_default_channel =
 {
   ramlog_putc,
   ramlog_putc,
-  syslog_default_flush
+  ramlog_flush
+#ifdef CONFIG_SYSLOG_WRITE
+  , ramlog_syslog_write
+#endif
 };
 #elif defined(CONFIG_SYSLOG_RPMSG)
 static const struct syslog_channel_s g_default_channel =
@@ -131,10 +136,12 @@ static int syslog_default_putc(int ch)
 }
 #endif
 
+#ifndef CONFIG_RAMLOG_SYSLOG
 static int syslog_default_flush(void)
 {
   return OK;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -0,0 +1,993 @@
+/****************************************************************************
+ * drivers/syslog/syslog_defer.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/streams.h>
+#include <nuttx/syslog/syslog.h>
+
+#include "syslog.h"
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_ARCH_ROMGETC
+#  error CONFIG_SYSLOG_DEFERRED does not support format strings in ROM
+#endif
+
+#ifndef CONFIG_SYSLOG_DEFERRED_BUFSIZE
+#  define CONFIG_SYSLOG_DEFERRED_BUFSIZE 2048
+#endif
+
+#ifndef CONFIG_SYSLOG_DEFERRED_RECSIZE
+#  define CONFIG_SYSLOG_DEFERRED_RECSIZE 128
+#endif
+
+#ifndef CONFIG_SYSLOG_DEFERRED_PRIORITY
+#  define CONFIG_SYSLOG_DEFERRED_PRIORITY 50
+#endif
+
+#ifndef CONFIG_SYSLOG_DEFERRED_STACKSIZE
+#  define CONFIG_SYSLOG_DEFERRED_STACKSIZE 2048
+#endif
+
+/* The size of a format specification with the '*' arguments expanded */
+
+#define SYSLOG_DEFER_SPECSIZE 24
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The argument type of a conversion specification */
+
+enum syslog_defer_arg_e
+{
+  SYSLOG_ARG_NONE = 0,               /* No argument ("%%") */
+  SYSLOG_ARG_INT,                    /* int (also char and short) */
+  SYSLOG_ARG_LONG,                   /* long */
+#ifdef CONFIG_LIBC_LONG_LONG
+  SYSLOG_ARG_LLONG,                  /* long long */
+#endif
+  SYSLOG_ARG_SIZE,                   /* size_t */
+  SYSLOG_ARG_PTR,                    /* void pointer */
+  SYSLOG_ARG_DOUBLE,                 /* double */
+  SYSLOG_ARG_STRING,                 /* Copy of a string */
+  SYSLOG_ARG_BAD                     /* Not supported */
+};
+
+/* The result of parsing one conversion specification */
+
+struct syslog_defer_spec_s
+{
+  uint8_t ds_type;                   /* See enum syslog_defer_arg_e */
+  uint8_t ds_nstar;                  /* Number of '*' int arguments */
+  bool    ds_starprec;               /* Precision is the last '*' argument */
+  int     ds_prec;                   /* Precision or -1 if none */
+};
+
+/* Each record starts with this header.  It is followed by a copy of the
+ * format string (if dh_fmt is NULL) and then by the arguments in the order
+ * in which they are consumed by the format string.  Records are stored
+ * unaligned in the buffer and are copied out before use.
+ */
+
+struct syslog_defer_hdr_s
+{
+  uint16_t dh_len;                   /* Size of the record with the header */
+  FAR const IPTR char *dh_fmt;       /* The format string or NULL if copied */
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  struct timespec dh_ts;             /* Time when the message was logged */
+#endif
+};
+
+union syslog_defer_rec_u
+{
+  struct syslog_defer_hdr_s hdr;
+  uint8_t buf[CONFIG_SYSLOG_DEFERRED_RECSIZE];
+};
+
+/* One argument value */
+
+union syslog_defer_arg_u
+{
+  int i;
+  long l;
+#ifdef CONFIG_LIBC_LONG_LONG
+  long long ll;
+#endif
+  size_t z;
+  FAR void *p;
+  double d;
+};
+
+/* The circular buffer of records */
+
+struct syslog_defer_s
+{
+  volatile uint16_t sd_head;         /* Where the next record is added */
+  volatile uint16_t sd_tail;         /* Where the next record is removed */
+  volatile uint16_t sd_ndropped;     /* Number of records dropped */
+  volatile bool     sd_ready;        /* The worker thread is running */
+  sem_t             sd_sem;          /* Wakes up the worker thread */
+  uint8_t           sd_buffer[CONFIG_SYSLOG_DEFERRED_BUFSIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED_ROFMT
+/* The bounds of .text and .rodata, provided by the linker script */
+
+extern const uint8_t _stext[];
+extern const uint8_t _etext[];
+#endif
+
+static struct syslog_defer_s g_syslog_defer =
+{
+  0,                                 /* sd_head */
+  0,                                 /* sd_tail */
+  0,                                 /* sd_ndropped */
+  false,                             /* sd_ready */
+  SEM_INITIALIZER(0)                 /* sd_sem */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_defer_parse
+ *
+ * Description:
+ *   Parse the conversion specification that follows a '%' in the format
+ *   string and return a pointer to the first character after it.  This
+ *   must accept the same specifications as lib_vsprintf() and consume the
+ *   same arguments.  Anything that cannot be recorded, such as numbered
+ *   arguments or "%n", is reported as SYSLOG_ARG_BAD.
+ *
+ ****************************************************************************/
+
+static FAR const char *
+syslog_defer_parse(FAR const char *fmt, FAR struct syslog_defer_spec_s *spec)
+{
+  bool size = false;
+  bool prec = false;
+  int nlong = 0;
+
+  spec->ds_nstar    = 0;
+  spec->ds_starprec = false;
+  spec->ds_prec     = -1;
+
+  for (; ; fmt++)
+    {
+      if (*fmt >= '0' && *fmt <= '9')
+        {
+          if (prec)
+            {
+              spec->ds_prec = 10 * spec->ds_prec + *fmt - '0';
+            }
+
+          continue;
+        }
+
+      switch (*fmt)
+        {
+          case '-':
+          case '+':
+          case ' ':
+          case '#':
+          case 'h':
+            continue;
+
+          case '.':
+            prec          = true;
+            spec->ds_prec = 0;
+            continue;
+
+          case '*':
+            spec->ds_nstar++;
+            spec->ds_starprec = prec;
+            continue;
+
+          case 'l':
+            nlong++;
+            continue;
+
+          case 'z':
+            size = true;
+            continue;
+
+          case '%':
+            spec->ds_type = SYSLOG_ARG_NONE;
+            break;
+
+          case 'c':
+            spec->ds_type = SYSLOG_ARG_INT;
+            break;
+
+          case 'd':
+          case 'i':
+          case 'u':
+          case 'o':
+          case 'x':
+          case 'X':
+            if (size)
+              {
+                spec->ds_type = SYSLOG_ARG_SIZE;
+              }
+            else if (nlong == 0)
+              {
+                spec->ds_type = SYSLOG_ARG_INT;
+              }
+#ifdef CONFIG_LIBC_LONG_LONG
+            else if (nlong > 1)
+              {
+                spec->ds_type = SYSLOG_ARG_LLONG;
+              }
+#endif
+            else
+              {
+                spec->ds_type = SYSLOG_ARG_LONG;
+              }
+            break;
+
+          case 'p':
+            spec->ds_type = SYSLOG_ARG_PTR;
+            break;
+
+          case 's':
+          case 'S':
+            spec->ds_type = SYSLOG_ARG_STRING;
+            break;
+
+          case 'e':
+          case 'f':
+          case 'g':
+          case 'E':
+          case 'F':
+          case 'G':
+            spec->ds_type = SYSLOG_ARG_DOUBLE;
+            break;
+
+          default:
+            spec->ds_type = SYSLOG_ARG_BAD;
+            return fmt;
+        }
+
+      return fmt + 1;
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_defer_put and syslog_defer_get
+ *
+ * Description:
+ *   Add an argument value to a record and get it back.
+ *
+ ****************************************************************************/
+
+static int syslog_defer_put(FAR uint8_t *rec, FAR size_t *len,
+                            FAR const void *value, size_t size)
+{
+  if (*len + size > CONFIG_SYSLOG_DEFERRED_RECSIZE)
+    {
+      return -E2BIG;
+    }
+
+  memcpy(&rec[*len], value, size);
+  *len += size;
+  return OK;
+}
+
+static int syslog_defer_get(FAR const uint8_t **arg, FAR const uint8_t *end,
+                            FAR void *value, size_t size)
+{
+  if (*arg + size > end)
+    {
+      return -EINVAL;
+    }
+
+  memcpy(value, *arg, size);
+  *arg += size;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_isconst
+ *
+ * Description:
+ *   Return true if the format string is part of the kernel image and can
+ *   be recorded by reference.  A format string may also be a user-space
+ *   pointer passed through the nx_vsyslog() system call, belong to a
+ *   module that may be unloaded, or be built at run time, so anything
+ *   else is copied into the record.
+ *
+ ****************************************************************************/
+
+static inline bool syslog_defer_isconst(FAR const IPTR char *fmt)
+{
+#ifdef CONFIG_SYSLOG_DEFERRED_ROFMT
+  return (FAR const uint8_t *)fmt >= _stext &&
+         (FAR const uint8_t *)fmt < _etext;
+#else
+  return false;
+#endif
+}
+
+/****************************************************************************
+ * Name: syslog_defer_encode
+ *
+ * Description:
+ *   Record the format string, unless it is part of the kernel image, and
+ *   the arguments that it consumes.  Strings are copied because they may
+ *   not exist any longer when the record is formatted.  String arguments
+ *   are truncated if the record would overflow.
+ *
+ * Returned Value:
+ *   The size of the record or a negated errno value if the message cannot
+ *   be recorded.
+ *
+ ****************************************************************************/
+
+static ssize_t syslog_defer_encode(FAR uint8_t *rec,
+                                   FAR const IPTR char *fmt,
+                                   FAR va_list *ap)
+{
+  struct syslog_defer_spec_s spec;
+  union syslog_defer_arg_u value;
+  FAR const char *str;
+  size_t len = sizeof(struct syslog_defer_hdr_s);
+  size_t maxlen;
+  int prec;
+  int ret;
+
+  if (!syslog_defer_isconst(fmt))
+    {
+      ret = syslog_defer_put(rec, &len, fmt, strlen(fmt) + 1);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  while (*fmt != '\0')
+    {
+      if (*fmt++ != '%')
+        {
+          continue;
+        }
+
+      fmt = syslog_defer_parse(fmt, &spec);
+      if (spec.ds_type == SYSLOG_ARG_BAD)
+        {
+          return -ENOTSUP;
+        }
+
+      /* Width and precision given as arguments */
+
+      prec = spec.ds_prec;
+      while (spec.ds_nstar-- > 0)
+        {
+          value.i = va_arg(*ap, int);
+          ret = syslog_defer_put(rec, &len, &value.i, sizeof(int));
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          prec = value.i;
+        }
+
+      if (!spec.ds_starprec)
+        {
+          prec = spec.ds_prec;
+        }
+
+      switch (spec.ds_type)
+        {
+          case SYSLOG_ARG_INT:
+            value.i = va_arg(*ap, int);
+            ret = syslog_defer_put(rec, &len, &value.i, sizeof(int));
+            break;
+
+          case SYSLOG_ARG_LONG:
+            value.l = va_arg(*ap, long);
+            ret = syslog_defer_put(rec, &len, &value.l, sizeof(long));
+            break;
+
+#ifdef CONFIG_LIBC_LONG_LONG
+          case SYSLOG_ARG_LLONG:
+            value.ll = va_arg(*ap, long long);
+            ret = syslog_defer_put(rec, &len, &value.ll, sizeof(long long));
+            break;
+#endif
+
+          case SYSLOG_ARG_SIZE:
+            value.z = va_arg(*ap, size_t);
+            ret = syslog_defer_put(rec, &len, &value.z, sizeof(size_t));
+            break;
+
+          case SYSLOG_ARG_PTR:
+            value.p = va_arg(*ap, FAR void *);
+            ret = syslog_defer_put(rec, &len, &value.p, sizeof(FAR void *));
+            break;
+
+          case SYSLOG_ARG_DOUBLE:
+            value.d = va_arg(*ap, double);
+            ret = syslog_defer_put(rec, &len, &value.d, sizeof(double));
+            break;
+
+          case SYSLOG_ARG_STRING:
+            str = va_arg(*ap, FAR const char *);
+            if (str == NULL)
+              {
+                str = "(null)";
+              }
+
+            if (len >= CONFIG_SYSLOG_DEFERRED_RECSIZE)
+              {
+                return -E2BIG;
+              }
+
+            maxlen = CONFIG_SYSLOG_DEFERRED_RECSIZE - len - 1;
+            if (prec >= 0 && (size_t)prec < maxlen)
+              {
+                maxlen = prec;
+              }
+
+            maxlen = strnlen(str, maxlen);
+            memcpy(&rec[len], str, maxlen);
+            rec[len + maxlen] = '\0';
+            len += maxlen + 1;
+            ret  = OK;
+            break;
+
+          default:
+            ret = OK;
+            break;
+        }
+
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_spec
+ *
+ * Description:
+ *   Copy the conversion specification from 'start' to 'end' into 'spec',
+ *   replacing each '*' with the recorded argument.
+ *
+ ****************************************************************************/
+
+static int syslog_defer_spec(FAR char *spec, FAR const char *start,
+                             FAR const char *end, FAR const uint8_t **arg,
+                             FAR const uint8_t *argend)
+{
+  size_t len = 0;
+  int value;
+  int ret;
+
+  for (; start < end; start++)
+    {
+      if (len + 12 >= SYSLOG_DEFER_SPECSIZE)
+        {
+          return -E2BIG;
+        }
+
+      if (*start != '*')
+        {
+          spec[len++] = *start;
+          continue;
+        }
+
+      ret = syslog_defer_get(arg, argend, &value, sizeof(int));
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* A negative precision is taken as if it were missing */
+
+      if (value < 0 && len > 0 && spec[len - 1] == '.')
+        {
+          len--;
+          continue;
+        }
+
+      len += snprintf(&spec[len], SYSLOG_DEFER_SPECSIZE - len, "%d", value);
+    }
+
+  spec[len] = '\0';
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_format
+ *
+ * Description:
+ *   Format one record and send the text to the SYSLOG channel.
+ *
+ ****************************************************************************/
+
+static void syslog_defer_format(FAR const uint8_t *rec)
+{
+  struct lib_syslogstream_s stream;
+  struct syslog_defer_spec_s ds;
+  struct syslog_defer_hdr_s hdr;
+  union syslog_defer_arg_u value;
+  FAR const uint8_t *arg;
+  FAR const uint8_t *end;
+  FAR const char *start;
+  FAR const char *fmt;
+  char spec[SYSLOG_DEFER_SPECSIZE];
+  int ret;
+
+  memcpy(&hdr, rec, sizeof(hdr));
+  arg = rec + sizeof(hdr);
+  end = rec + hdr.dh_len;
+
+  /* The copy of the format string precedes the arguments */
+
+  fmt = hdr.dh_fmt;
+  if (fmt == NULL)
+    {
+      fmt  = (FAR const char *)arg;
+      arg += strlen(fmt) + 1;
+    }
+
+  syslogstream_create(&stream);
+
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  /* Pre-pend the message with the time when it was logged */
+
+  lib_sprintf(&stream.public, "[%5d.%06d] ",
+              hdr.dh_ts.tv_sec, hdr.dh_ts.tv_nsec / 1000);
+#endif
+
+#ifdef CONFIG_SYSLOG_PREFIX
+  /* Pre-pend the prefix, if available */
+
+  lib_sprintf(&stream.public, "%s", CONFIG_SYSLOG_PREFIX_STRING);
+#endif
+
+  /* Output the text between the conversions directly and format each
+   * conversion with its recorded argument.
+   */
+
+  while (*fmt != '\0')
+    {
+      if (*fmt != '%')
+        {
+          stream.public.put(&stream.public, *fmt++);
+          continue;
+        }
+
+      start = fmt;
+      fmt   = syslog_defer_parse(fmt + 1, &ds);
+      if (ds.ds_type == SYSLOG_ARG_NONE)
+        {
+          stream.public.put(&stream.public, '%');
+          continue;
+        }
+
+      /* The format string must be the one that was recorded.  Stop if it
+       * does not match the arguments any longer.
+       */
+
+      ret = ds.ds_type == SYSLOG_ARG_BAD ? -EINVAL :
+            syslog_defer_spec(spec, start, fmt, &arg, end);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      switch (ds.ds_type)
+        {
+          case SYSLOG_ARG_INT:
+            ret = syslog_defer_get(&arg, end, &value.i, sizeof(int));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.i);
+              }
+            break;
+
+          case SYSLOG_ARG_LONG:
+            ret = syslog_defer_get(&arg, end, &value.l, sizeof(long));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.l);
+              }
+            break;
+
+#ifdef CONFIG_LIBC_LONG_LONG
+          case SYSLOG_ARG_LLONG:
+            ret = syslog_defer_get(&arg, end, &value.ll, sizeof(long long));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.ll);
+              }
+            break;
+#endif
+
+          case SYSLOG_ARG_SIZE:
+            ret = syslog_defer_get(&arg, end, &value.z, sizeof(size_t));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.z);
+              }
+            break;
+
+          case SYSLOG_ARG_PTR:
+            ret = syslog_defer_get(&arg, end, &value.p, sizeof(FAR void *));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.p);
+              }
+            break;
+
+          case SYSLOG_ARG_DOUBLE:
+            ret = syslog_defer_get(&arg, end, &value.d, sizeof(double));
+            if (ret >= 0)
+              {
+                lib_sprintf(&stream.public, spec, value.d);
+              }
+            break;
+
+          case SYSLOG_ARG_STRING:
+            if (memchr(arg, '\0', end - arg) == NULL)
+              {
+                ret = -EINVAL;
+                break;
+              }
+
+            lib_sprintf(&stream.public, spec, (FAR const char *)arg);
+            arg += strlen((FAR const char *)arg) + 1;
+            break;
+
+          default:
+            break;
+        }
+
+      if (ret < 0)
+        {
+          break;
+        }
+    }
+
+#ifdef CONFIG_SYSLOG_BUFFER
+  /* Flush and destroy the syslog stream buffer */
+
+  syslogstream_destroy(&stream);
+#endif
+}
+
+/****************************************************************************
+ * Name: syslog_defer_copyin and syslog_defer_copyout
+ *
+ * Description:
+ *   Copy data into and out of the circular buffer, handling wraparound.
+ *
+ ****************************************************************************/
+
+static void syslog_defer_copyin(size_t head, FAR const uint8_t *data,
+                                size_t len)
+{
+  size_t n = CONFIG_SYSLOG_DEFERRED_BUFSIZE - head;
+
+  if (n >= len)
+    {
+      memcpy(&g_syslog_defer.sd_buffer[head], data, len);
+    }
+  else
+    {
+      memcpy(&g_syslog_defer.sd_buffer[head], data, n);
+      memcpy(g_syslog_defer.sd_buffer, &data[n], len - n);
+    }
+}
+
+static void syslog_defer_copyout(size_t tail, FAR uint8_t *data,
+                                 size_t len)
+{
+  size_t n = CONFIG_SYSLOG_DEFERRED_BUFSIZE - tail;
+
+  if (n >= len)
+    {
+      memcpy(data, &g_syslog_defer.sd_buffer[tail], len);
+    }
+  else
+    {
+      memcpy(data, &g_syslog_defer.sd_buffer[tail], n);
+      memcpy(&data[n], g_syslog_defer.sd_buffer, len - n);
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_defer_remove
+ *
+ * Description:
+ *   Remove the oldest record from the circular buffer.
+ *
+ * Returned Value:
+ *   The size of the record or zero if the buffer is empty.
+ *
+ ****************************************************************************/
+
+static size_t syslog_defer_remove(FAR uint8_t *rec)
+{
+  irqstate_t flags;
+  size_t tail;
+  uint16_t len = 0;
+
+  flags = enter_critical_section();
+
+  tail = g_syslog_defer.sd_tail;
+  if (tail != g_syslog_defer.sd_head)
+    {
+      syslog_defer_copyout(tail, (FAR uint8_t *)&len, sizeof(len));
+      DEBUGASSERT(len <= CONFIG_SYSLOG_DEFERRED_RECSIZE);
+
+      syslog_defer_copyout(tail, rec, len);
+      g_syslog_defer.sd_tail = (tail + len) % CONFIG_SYSLOG_DEFERRED_BUFSIZE;
+    }
+
+  leave_critical_section(flags);
+  return len;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_drain
+ *
+ * Description:
+ *   Format all of the records in the circular buffer.
+ *
+ ****************************************************************************/
+
+static void syslog_defer_drain(void)
+{
+  union syslog_defer_rec_u rec;
+  irqstate_t flags;
+  unsigned int ndropped;
+
+  while (syslog_defer_remove(rec.buf) > 0)
+    {
+      syslog_defer_format(rec.buf);
+    }
+
+  /* Report the messages that were lost because the buffer was full */
+
+  flags = enter_critical_section();
+  ndropped = g_syslog_defer.sd_ndropped;
+  g_syslog_defer.sd_ndropped = 0;
+  leave_critical_section(flags);
+
+  if (ndropped > 0)
+    {
+      struct lib_syslogstream_s stream;
+
+      syslogstream_create(&stream);
+      lib_sprintf(&stream.public, "[%u messages dropped]\n", ndropped);
+#ifdef CONFIG_SYSLOG_BUFFER
+      syslogstream_destroy(&stream);
+#endif
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_defer_thread
+ *
+ * Description:
+ *   The worker thread that formats the deferred messages.
+ *
+ ****************************************************************************/
+
+static int syslog_defer_thread(int argc, FAR char *argv[])
+{
+  for (; ; )
+    {
+      nxsem_wait_uninterruptible(&g_syslog_defer.sd_sem);
+      syslog_defer_drain();
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_defer
+ *
+ * Description:
+ *   Record a message to be formatted later by the deferred SYSLOG worker
+ *   thread.  The format string and the arguments are saved in a binary
+ *   record; a format string in the kernel image is saved by reference
+ *   with CONFIG_SYSLOG_DEFERRED_ROFMT.  This may be called from an
+ *   interrupt handler.
+ *
+ *   If the buffer is full, the message is dropped and the number of
+ *   dropped messages is reported later.
+ *
+ * Input Parameters:
+ *   ts  - The time stamp of the message (CONFIG_SYSLOG_TIMESTAMP only)
+ *   fmt - The format string
+ *   ap  - The arguments
+ *
+ * Returned Value:
+ *   Zero (OK) is returned if the message was recorded or dropped.  A
+ *   negated errno value is returned if the message must be formatted
+ *   by the caller: The worker thread is not running yet, the format
+ *   string is not supported or the arguments do not fit into a record.
+ *
+ ****************************************************************************/
+
+int syslog_defer(FAR const struct timespec *ts, FAR const IPTR char *fmt,
+                 FAR va_list *ap)
+{
+  union syslog_defer_rec_u rec;
+  irqstate_t flags;
+  ssize_t len;
+  size_t space;
+  size_t head;
+  size_t tail;
+
+  if (!g_syslog_defer.sd_ready)
+    {
+      return -EAGAIN;
+    }
+
+  len = syslog_defer_encode(rec.buf, fmt, ap);
+  if (len < 0)
+    {
+      return len;
+    }
+
+  rec.hdr.dh_len = len;
+  rec.hdr.dh_fmt = syslog_defer_isconst(fmt) ? fmt : NULL;
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  rec.hdr.dh_ts  = *ts;
+#endif
+
+  flags = enter_critical_section();
+
+  /* One byte is left empty to distinguish a full from an empty buffer */
+
+  head = g_syslog_defer.sd_head;
+  tail = g_syslog_defer.sd_tail;
+
+  if (head >= tail)
+    {
+      space = CONFIG_SYSLOG_DEFERRED_BUFSIZE - head + tail - 1;
+    }
+  else
+    {
+      space = tail - head - 1;
+    }
+
+  if (len > space)
+    {
+      if (g_syslog_defer.sd_ndropped < UINT16_MAX)
+        {
+          g_syslog_defer.sd_ndropped++;
+        }
+
+      leave_critical_section(flags);
+      return OK;
+    }
+
+  syslog_defer_copyin(head, rec.buf, len);
+  g_syslog_defer.sd_head = (head + len) % CONFIG_SYSLOG_DEFERRED_BUFSIZE;
+  leave_critical_section(flags);
+
+  /* The worker thread drains the whole buffer when it runs, so it only
+   * needs to be woken up for the first record.
+   */
+
+  if (head == tail)
+    {
+      nxsem_post(&g_syslog_defer.sd_sem);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_flush
+ *
+ * Description:
+ *   Format all of the deferred messages in the context of the caller.
+ *   This is called by syslog_flush() when the system crashes.
+ *
+ ****************************************************************************/
+
+int syslog_defer_flush(void)
+{
+  syslog_defer_drain();
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_defer_start
+ *
+ * Description:
+ *   Start the worker thread that formats the deferred SYSLOG messages.
+ *   Messages are formatted by the caller until the worker thread runs.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int syslog_defer_start(void)
+{
+  int pid;
+
+  /* The semaphore is used for signaling and, hence, should not have
+   * priority inheritance enabled.
+   */
+
+  nxsem_setprotocol(&g_syslog_defer.sd_sem, SEM_PRIO_NONE);
+
+  pid = kthread_create("syslogd", CONFIG_SYSLOG_DEFERRED_PRIORITY,
+                       CONFIG_SYSLOG_DEFERRED_STACKSIZE,
+                       syslog_defer_thread, NULL);
+  if (pid < 0)
+    {
+      return pid;
+    }
+
+  g_syslog_defer.sd_ready = true;
+  return OK;
+}
+
+#endif /* CONFIG_SYSLOG_DEFERRED */
@@ -89,6 +89,14 @@ int syslog_flush(void)
   syslog_flush_intbuffer(g_syslog_channel, true);
 #endif
 
+#ifdef CONFIG_SYSLOG_DEFERRED
+  /* Format any messages that are still waiting for the deferred SYSLOG
+   * worker thread.
+   */
+
+  syslog_defer_flush();
+#endif
+
   /* Then flush all of the buffered output to the SYSLOG device */
 
   DEBUGASSERT(g_syslog_channel->sc_flush != NULL);
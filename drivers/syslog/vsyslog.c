@@ -49,6 +49,8 @@
 #include <nuttx/streams.h>
 #include <nuttx/syslog/syslog.h>
 
+#include "syslog.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -64,6 +66,12 @@
  *   some compilers and passing of structures in the NuttX sycalls does
  *   not work.
  *
+ * Returned Value:
+ *   The number of characters written to the SYSLOG channel.  With
+ *   CONFIG_SYSLOG_DEFERRED, a message that is recorded for the worker
+ *   thread (or dropped because the buffer is full) has not been formatted
+ *   yet and zero is returned instead.
+ *
  ****************************************************************************/
 
 int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
@@ -110,6 +118,31 @@ int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
     }
 #endif
 
+#ifdef CONFIG_SYSLOG_DEFERRED
+  /* Record the message to be formatted later by the deferred SYSLOG worker
+   * thread.  Emergency output and messages that cannot be recorded are
+   * formatted now.
+   */
+
+  if (priority != LOG_EMERG)
+    {
+      va_list copy;
+
+      va_copy(copy, *ap);
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+      ret = syslog_defer(&ts, fmt, &copy);
+#else
+      ret = syslog_defer(NULL, fmt, &copy);
+#endif
+      va_end(copy);
+
+      if (ret >= 0)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* Wrap the low-level output in a stream object and let lib_vsprintf
    * do the work.  NOTE that emergency priority output is handled
    * differently.. it will use the SYSLOG emergency stream.
@@ -63,6 +63,39 @@
 #  define CONFIG_FS_NAIOC 8
 #endif
 
+/* Number of threads in the dedicated AIO worker pool.  Zero selects the
+ * low priority work queue.
+ */
+
+#ifndef CONFIG_FS_AIO_NWORKERS
+#  define CONFIG_FS_AIO_NWORKERS 0
+#endif
+
+#if CONFIG_FS_AIO_NWORKERS > 0
+#  ifndef CONFIG_FS_AIO_WORKER_PRIORITY
+#    define CONFIG_FS_AIO_WORKER_PRIORITY 50
+#  endif
+#  ifndef CONFIG_FS_AIO_WORKER_STACKSIZE
+#    define CONFIG_FS_AIO_WORKER_STACKSIZE 2048
+#  endif
+#  ifndef CONFIG_FS_AIO_MERGESIZE
+#    define CONFIG_FS_AIO_MERGESIZE 0
+#  endif
+#else
+#  undef CONFIG_FS_AIO_MERGESIZE
+#  define CONFIG_FS_AIO_MERGESIZE 0
+#endif
+
+/* With priority inheritance, the low priority work queue is boosted to the
+ * priority of the waiting task.  The AIO worker pool manages the priority
+ * of its threads itself.
+ */
+
+#undef AIO_HAVE_LPBOOST
+#if defined(CONFIG_PRIORITY_INHERITANCE) && CONFIG_FS_AIO_NWORKERS == 0
+#  define AIO_HAVE_LPBOOST
+#endif
+
 #undef AIO_HAVE_PSOCK
 
 #ifdef CONFIG_NET_TCP
@@ -93,6 +126,7 @@ struct aio_container_s
   } u;
   struct work_s aioc_work;         /* Used to defer I/O to the work thread */
   pid_t aioc_pid;                  /* ID of the waiting task */
+  uint8_t aioc_opcode;             /* LIO_READ, LIO_WRITE or LIO_NOP */
 #ifdef CONFIG_PRIORITY_INHERITANCE
   uint8_t aioc_prio;               /* Priority of the waiting task */
 #endif
@@ -234,7 +268,8 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
  * Name: aio_queue
  *
  * Description:
- *   Schedule the asynchronous I/O on the low priority work queue
+ *   Schedule the asynchronous I/O on the low priority work queue or, if
+ *   CONFIG_FS_AIO_NWORKERS is non-zero, on the dedicated AIO worker pool.
  *
  * Input Parameters:
  *   arg - Worker argument.  In this case, a pointer to an instance of
@@ -248,6 +283,24 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
+/****************************************************************************
+ * Name: aio_cancelwork
+ *
+ * Description:
+ *   Remove the asynchronous I/O from the queue it was scheduled on by
+ *   aio_queue(), if it has not been started yet.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container to be removed from the queue
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O was removed from the queue; -ENOENT if it has
+ *   already been started.
+ *
+ ****************************************************************************/
+
+int aio_cancelwork(FAR struct aio_container_s *aioc);
+
 /****************************************************************************
  * Name: aio_signal
  *
@@ -39,26 +39,503 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
 #include <sched.h>
 #include <aio.h>
+#include <assert.h>
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/irq.h>
+#include <nuttx/nuttx.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
 #include <nuttx/wqueue.h>
+#include <nuttx/fs/fs.h>
 
 #include "aio/aio.h"
 
 #ifdef CONFIG_FS_AIO
 
+#if CONFIG_FS_AIO_NWORKERS > 0
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one thread of the dedicated AIO worker pool.
+ * Queued containers are linked through the dq entry of their aioc_work
+ * structure; the worker and arg fields of aioc_work hold the function that
+ * performs the I/O, just as they would on the work queue.
+ */
+
+struct aio_worker_s
+{
+  dq_queue_t queue;             /* Containers waiting for this worker */
+  sem_t sem;                    /* Posted when a container is queued */
+  pid_t pid;                    /* ID of the worker thread */
+#ifdef CONFIG_PRIORITY_INHERITANCE
+  uint8_t prio;                 /* Current priority of the worker thread */
+#endif
+#if CONFIG_FS_AIO_MERGESIZE > 0
+  FAR uint8_t *buffer;          /* Bounce buffer for merged transfers */
+#endif
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The dedicated AIO worker threads.  These are started when the first
+ * asynchronous I/O is queued.
+ */
+
+static struct aio_worker_s g_aio_workers[CONFIG_FS_AIO_NWORKERS];
+static bool g_aio_started;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: aio_worker_select
+ *
+ * Description:
+ *   Select the worker thread for an AIO container.  All I/O to the same
+ *   inode (a device driver or a mountpoint) or to the same socket goes to
+ *   the same worker, so that it is performed in the order in which it was
+ *   queued.  I/O to independent devices is spread across the pool.
+ *
+ ****************************************************************************/
+
+static FAR struct aio_worker_s *
+aio_worker_select(FAR struct aio_container_s *aioc)
+{
+  uintptr_t key;
+
+#ifdef AIO_HAVE_PSOCK
+  if (aioc->aioc_aiocbp->aio_fildes >= CONFIG_NFILE_DESCRIPTORS)
+    {
+      key = (uintptr_t)aioc->u.aioc_psock;
+    }
+  else
+#endif
+    {
+      key = (uintptr_t)aioc->u.aioc_filep->f_inode;
+    }
+
+  /* The low bits of a heap address carry no information */
+
+  key >>= 3;
+  key  ^= key >> 11;
+  return &g_aio_workers[key % CONFIG_FS_AIO_NWORKERS];
+}
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
+/****************************************************************************
+ * Name: aio_worker_setprio
+ *
+ * Description:
+ *   Change the priority of a worker thread if it differs from the current
+ *   one.  The caller must have pre-emption disabled.
+ *
+ ****************************************************************************/
+
+static void aio_worker_setprio(FAR struct aio_worker_s *worker,
+                               uint8_t prio)
+{
+  struct sched_param param;
+
+  if (prio != worker->prio)
+    {
+      param.sched_priority = prio;
+      if (nxsched_setparam(worker->pid, &param) >= 0)
+        {
+          worker->prio = prio;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: aio_worker_reprio
+ *
+ * Description:
+ *   Run the worker thread at the priority of the highest priority client
+ *   with I/O still in its queue, but never below its configured priority.
+ *
+ ****************************************************************************/
+
+static void aio_worker_reprio(FAR struct aio_worker_s *worker)
+{
+  FAR struct aio_container_s *aioc;
+  FAR dq_entry_t *entry;
+  irqstate_t flags;
+  uint8_t prio = CONFIG_FS_AIO_WORKER_PRIORITY;
+
+  sched_lock();
+  flags = enter_critical_section();
+
+  for (entry = worker->queue.head; entry != NULL; entry = entry->flink)
+    {
+      aioc = container_of(entry, struct aio_container_s, aioc_work.dq);
+      if (aioc->aioc_prio > prio)
+        {
+          prio = aioc->aioc_prio;
+        }
+    }
+
+  leave_critical_section(flags);
+
+  aio_worker_setprio(worker, prio);
+  sched_unlock();
+}
+#endif
+
+#if CONFIG_FS_AIO_MERGESIZE > 0
+/****************************************************************************
+ * Name: aio_mergeable
+ *
+ * Description:
+ *   Return true if the container holds a read or write of a file that may
+ *   be merged with an adjacent request.  Writes to files opened with
+ *   O_APPEND do not use the requested offset and are never merged.
+ *
+ ****************************************************************************/
+
+static bool aio_mergeable(FAR struct aio_container_s *aioc)
+{
+  FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
+  int oflags;
+
+#ifdef AIO_HAVE_PSOCK
+  if (aiocbp->aio_fildes >= CONFIG_NFILE_DESCRIPTORS)
+    {
+      return false;
+    }
+#endif
+
+  if (aiocbp->aio_nbytes == 0 ||
+      aiocbp->aio_nbytes >= CONFIG_FS_AIO_MERGESIZE)
+    {
+      return false;
+    }
+
+  if (aioc->aioc_opcode == LIO_READ)
+    {
+      return true;
+    }
+  else if (aioc->aioc_opcode == LIO_WRITE)
+    {
+      oflags = file_fcntl(aioc->u.aioc_filep, F_GETFL);
+      return oflags >= 0 && (oflags & O_APPEND) == 0;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: aio_merge
+ *
+ * Description:
+ *   Remove the requests that directly follow 'first' in the worker queue
+ *   and continue it on the same file, in the same direction and without a
+ *   gap, as long as the combined size fits into the bounce buffer.  The
+ *   removed containers are returned in 'list', 'first' included.  Only
+ *   requests at the head of the queue are taken so that the order of the
+ *   I/O on the device is unchanged.
+ *
+ ****************************************************************************/
+
+static int aio_merge(FAR struct aio_worker_s *worker,
+                     FAR struct aio_container_s *first,
+                     FAR struct aio_container_s **list)
+{
+  FAR struct aio_container_s *aioc;
+  FAR dq_entry_t *entry;
+  irqstate_t flags;
+  size_t total;
+  off_t next;
+  int n = 1;
+
+  list[0] = first;
+  total   = first->aioc_aiocbp->aio_nbytes;
+  next    = first->aioc_aiocbp->aio_offset + total;
+
+  flags = enter_critical_section();
+
+  while (n < CONFIG_FS_NAIOC && (entry = worker->queue.head) != NULL)
+    {
+      aioc = container_of(entry, struct aio_container_s, aioc_work.dq);
+      if (aioc->aioc_opcode != first->aioc_opcode ||
+          aioc->u.aioc_filep != first->u.aioc_filep ||
+          aioc->aioc_aiocbp->aio_offset != next ||
+          total + aioc->aioc_aiocbp->aio_nbytes > CONFIG_FS_AIO_MERGESIZE)
+        {
+          break;
+        }
+
+      dq_remfirst(&worker->queue);
+      aioc->aioc_work.worker = NULL;
+
+      total    += aioc->aioc_aiocbp->aio_nbytes;
+      next     += aioc->aioc_aiocbp->aio_nbytes;
+      list[n++] = aioc;
+    }
+
+  leave_critical_section(flags);
+  return n;
+}
+
+/****************************************************************************
+ * Name: aio_merged_io
+ *
+ * Description:
+ *   Perform a list of adjacent reads or writes as one transfer through the
+ *   bounce buffer of the worker, then complete each request.  A short
+ *   transfer is distributed over the requests in order, so each request
+ *   sees the result that it would have seen if it had been performed
+ *   alone.
+ *
+ ****************************************************************************/
+
+static void aio_merged_io(FAR struct aio_worker_s *worker,
+                          FAR struct aio_container_s **list, int n)
+{
+  FAR struct aiocb *aiocbs[CONFIG_FS_NAIOC];
+  pid_t pids[CONFIG_FS_NAIOC];
+  FAR struct file *filep;
+  FAR uint8_t *buffer = worker->buffer;
+  size_t total = 0;
+  ssize_t nxfrd;
+  size_t nbytes;
+  off_t offset;
+  int opcode;
+  int i;
+
+  /* Capture everything needed from the containers, then free them before
+   * starting the I/O as the single request workers do.
+   */
+
+  filep  = list[0]->u.aioc_filep;
+  opcode = list[0]->aioc_opcode;
+  offset = list[0]->aioc_aiocbp->aio_offset;
+
+  for (i = 0; i < n; i++)
+    {
+      pids[i]   = list[i]->aioc_pid;
+      aiocbs[i] = aioc_decant(list[i]);
+    }
+
+  if (opcode == LIO_WRITE)
+    {
+      for (i = 0; i < n; i++)
+        {
+          memcpy(buffer + total, (FAR const void *)aiocbs[i]->aio_buf,
+                 aiocbs[i]->aio_nbytes);
+          total += aiocbs[i]->aio_nbytes;
+        }
+
+      nxfrd = file_pwrite(filep, buffer, total, offset);
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        {
+          total += aiocbs[i]->aio_nbytes;
+        }
+
+      nxfrd = file_pread(filep, buffer, total, offset);
+    }
+
+  if (nxfrd < 0)
+    {
+      ferr("ERROR: merged transfer failed: %d\n", (int)nxfrd);
+    }
+
+  /* Complete the requests in the order that they were queued */
+
+  for (total = 0, i = 0; i < n; i++)
+    {
+      if (nxfrd < 0)
+        {
+          aiocbs[i]->aio_result = nxfrd;
+        }
+      else
+        {
+          nbytes = aiocbs[i]->aio_nbytes;
+          if (total + nbytes > (size_t)nxfrd)
+            {
+              nbytes = total < (size_t)nxfrd ? (size_t)nxfrd - total : 0;
+            }
+
+          if (opcode == LIO_READ)
+            {
+              memcpy((FAR void *)aiocbs[i]->aio_buf, buffer + total,
+                     nbytes);
+            }
+
+          aiocbs[i]->aio_result = nbytes;
+          total += aiocbs[i]->aio_nbytes;
+        }
+
+      aio_signal(pids[i], aiocbs[i]);
+    }
+}
+#endif /* CONFIG_FS_AIO_MERGESIZE > 0 */
+
+/****************************************************************************
+ * Name: aio_worker
+ *
+ * Description:
+ *   The body of each thread of the AIO worker pool.  The thread waits for
+ *   containers to be queued and performs them in FIFO order.
+ *
+ ****************************************************************************/
+
+static int aio_worker(int argc, FAR char *argv[])
+{
+  FAR struct aio_worker_s *worker;
+  FAR struct aio_container_s *aioc;
+  FAR dq_entry_t *entry;
+  irqstate_t flags;
+  worker_t func;
+#if CONFIG_FS_AIO_MERGESIZE > 0
+  FAR struct aio_container_s *list[CONFIG_FS_NAIOC];
+  int n;
+#endif
+
+  DEBUGASSERT(argc == 2);
+  worker = &g_aio_workers[atoi(argv[1])];
+
+  for (; ; )
+    {
+      nxsem_wait_uninterruptible(&worker->sem);
+
+      for (; ; )
+        {
+          flags = enter_critical_section();
+          entry = dq_remfirst(&worker->queue);
+          if (entry == NULL)
+            {
+              leave_critical_section(flags);
+              break;
+            }
+
+          /* Clearing the worker marks the container as started, it can no
+           * longer be canceled.
+           */
+
+          aioc = container_of(entry, struct aio_container_s, aioc_work.dq);
+          func = aioc->aioc_work.worker;
+          aioc->aioc_work.worker = NULL;
+          leave_critical_section(flags);
+
+#if CONFIG_FS_AIO_MERGESIZE > 0
+          n = 1;
+          if (worker->buffer != NULL && aio_mergeable(aioc))
+            {
+              n = aio_merge(worker, aioc, list);
+            }
+
+          if (n > 1)
+            {
+              aio_merged_io(worker, list, n);
+            }
+          else
+#endif
+            {
+              func(aioc);
+            }
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
+          aio_worker_reprio(worker);
+#endif
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: aio_worker_start
+ *
+ * Description:
+ *   Start the threads of the AIO worker pool.  If a thread cannot be
+ *   created, the remaining threads are started on the next attempt.  The
+ *   caller must have pre-emption disabled.
+ *
+ ****************************************************************************/
+
+static int aio_worker_start(void)
+{
+  FAR struct aio_worker_s *worker;
+  FAR char *argv[2];
+  char arg[8];
+  int i;
+
+  for (i = 0; i < CONFIG_FS_AIO_NWORKERS; i++)
+    {
+      worker = &g_aio_workers[i];
+      if (worker->pid > 0)
+        {
+          continue;
+        }
+
+      if (worker->pid == 0)
+        {
+          /* First attempt: initialize the worker state */
+
+          dq_init(&worker->queue);
+          nxsem_init(&worker->sem, 0, 0);
+          nxsem_setprotocol(&worker->sem, SEM_PRIO_NONE);
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
+          worker->prio = CONFIG_FS_AIO_WORKER_PRIORITY;
+#endif
+#if CONFIG_FS_AIO_MERGESIZE > 0
+          /* Merging is simply not done if the buffer cannot be allocated */
+
+          worker->buffer =
+            (FAR uint8_t *)kmm_malloc(CONFIG_FS_AIO_MERGESIZE);
+#endif
+        }
+
+      snprintf(arg, sizeof(arg), "%d", i);
+      argv[0] = arg;
+      argv[1] = NULL;
+
+      worker->pid = kthread_create("aio", CONFIG_FS_AIO_WORKER_PRIORITY,
+                                   CONFIG_FS_AIO_WORKER_STACKSIZE,
+                                   (main_t)aio_worker,
+                                   (FAR char * const *)argv);
+      if (worker->pid < 0)
+        {
+          ferr("ERROR: kthread_create %d failed: %d\n", i, worker->pid);
+          return worker->pid;
+        }
+    }
+
+  g_aio_started = true;
+  return OK;
+}
+
+#endif /* CONFIG_FS_AIO_NWORKERS > 0 */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
 /****************************************************************************
  * Name: aio_queue
  *
  * Description:
- *   Schedule the asynchronous I/O on the low priority work queue
+ *   Schedule the asynchronous I/O on the low priority work queue or, if
+ *   CONFIG_FS_AIO_NWORKERS is non-zero, on the dedicated AIO worker pool.
  *
  * Input Parameters:
  *   arg - Worker argument.  In this case, a pointer to an instance of
@@ -70,11 +547,61 @@
  *
  ****************************************************************************/
 
+#if CONFIG_FS_AIO_NWORKERS > 0
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
 {
-  int ret;
+  FAR struct aio_worker_s *wkr;
+  irqstate_t flags;
+  int ret = OK;
+
+  /* Prohibit context switches until we complete the queuing */
+
+  sched_lock();
+
+  if (!g_aio_started)
+    {
+      ret = aio_worker_start();
+      if (ret < 0)
+        {
+          FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
+          DEBUGASSERT(aiocbp);
+
+          aiocbp->aio_result = ret;
+          set_errno(-ret);
+          sched_unlock();
+          return ERROR;
+        }
+    }
+
+  wkr = aio_worker_select(aioc);
+
+  flags = enter_critical_section();
+  aioc->aioc_work.worker = worker;
+  aioc->aioc_work.arg    = aioc;
+  dq_addlast(&aioc->aioc_work.dq, &wkr->queue);
+  leave_critical_section(flags);
 
 #ifdef CONFIG_PRIORITY_INHERITANCE
+  /* Make sure that the worker thread is running at at least the priority
+   * of the client.
+   */
+
+  if (aioc->aioc_prio > wkr->prio)
+    {
+      aio_worker_setprio(wkr, aioc->aioc_prio);
+    }
+#endif
+
+  nxsem_post(&wkr->sem);
+  sched_unlock();
+  return ret;
+}
+#else
+int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
+{
+  int ret;
+
+#ifdef AIO_HAVE_LPBOOST
   /* Prohibit context switches until we complete the queuing */
 
   sched_lock();
@@ -94,7 +621,7 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
       FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
       DEBUGASSERT(aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_LPBOOST
       lpwork_restorepriority(aioc->aioc_prio);
 #endif
       aiocbp->aio_result = ret;
@@ -102,12 +629,50 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
       ret = ERROR;
     }
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_HAVE_LPBOOST
   /* Now the low-priority work queue might run at its new priority */
 
   sched_unlock();
 #endif
   return ret;
 }
+#endif
+
+/****************************************************************************
+ * Name: aio_cancelwork
+ *
+ * Description:
+ *   Remove the asynchronous I/O from the queue it was scheduled on by
+ *   aio_queue(), if it has not been started yet.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container to be removed from the queue
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O was removed from the queue; -ENOENT if it has
+ *   already been started.
+ *
+ ****************************************************************************/
+
+int aio_cancelwork(FAR struct aio_container_s *aioc)
+{
+#if CONFIG_FS_AIO_NWORKERS > 0
+  irqstate_t flags;
+  int ret = -ENOENT;
+
+  flags = enter_critical_section();
+  if (aioc->aioc_work.worker != NULL)
+    {
+      dq_rem(&aioc->aioc_work.dq, &aio_worker_select(aioc)->queue);
+      aioc->aioc_work.worker = NULL;
+      ret = OK;
+    }
+
+  leave_critical_section(flags);
+  return ret;
+#else
+  return work_cancel(LPWORK, &aioc->aioc_work);
+#endif
+}
 
 #endif /* CONFIG_FS_AIO */
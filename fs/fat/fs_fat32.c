@@ -71,6 +71,9 @@
  * Private Function Prototypes
  ****************************************************************************/
 
+static void    fat_extentadd(FAR struct fat_file_s *ff, uint32_t fileclus,
+                 uint32_t cluster);
+
 static int     fat_open(FAR struct file *filep, FAR const char *relpath,
                  int oflags, mode_t mode);
 static int     fat_close(FAR struct file *filep);
@@ -161,6 +164,48 @@ const struct mountpt_operations fat_operations =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: fat_extentadd
+ *
+ * Description:
+ *   Record that the cluster with index 'fileclus' in the file is the media
+ *   cluster 'cluster'.  The file remembers one run of contiguous clusters
+ *   so that fat_seek() can start following the chain from there rather
+ *   than from the first cluster of the file.
+ *
+ ****************************************************************************/
+
+static void fat_extentadd(FAR struct fat_file_s *ff, uint32_t fileclus,
+                          uint32_t cluster)
+{
+  uint32_t end = ff->ff_extfileclus + ff->ff_extnclusters;
+
+  if (ff->ff_extnclusters > 0)
+    {
+      /* Is the cluster already in the run? */
+
+      if (fileclus >= ff->ff_extfileclus && fileclus < end)
+        {
+          return;
+        }
+
+      /* Does the cluster extend the run? */
+
+      if (fileclus == end &&
+          cluster == ff->ff_extcluster + ff->ff_extnclusters)
+        {
+          ff->ff_extnclusters++;
+          return;
+        }
+    }
+
+  /* Start a new run */
+
+  ff->ff_extfileclus  = fileclus;
+  ff->ff_extcluster   = cluster;
+  ff->ff_extnclusters = 1;
+}
+
 /****************************************************************************
  * Name: fat_open
  ****************************************************************************/
@@ -592,6 +637,10 @@ static ssize_t fat_read(FAR struct file *filep, FAR char *buffer,
           ff->ff_currentcluster   = cluster;
           ff->ff_currentsector    = fat_cluster2sector(fs, cluster);
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
+
+          fat_extentadd(ff, filep->f_pos /
+                        (fs->fs_fatsecperclus * fs->fs_hwsectorsize),
+                        cluster);
         }
 
 #ifdef CONFIG_FAT_DIRECT_RETRY /* Warning avoidance */
@@ -852,6 +901,10 @@ static ssize_t fat_write(FAR struct file *filep, FAR const char *buffer,
           ff->ff_currentcluster   = cluster;
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
           ff->ff_currentsector    = fat_cluster2sector(fs, cluster);
+
+          fat_extentadd(ff, filep->f_pos /
+                        (fs->fs_fatsecperclus * fs->fs_hwsectorsize),
+                        cluster);
         }
 
 #ifdef CONFIG_FAT_DIRECT_RETRY /* Warning avoidance */
@@ -1151,6 +1204,27 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
        */
 
       clustersize = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
+
+      /* If the cached run of clusters starts before the requested
+       * position, then start from the closest cluster in the run.
+       */
+
+      if (ff->ff_extnclusters > 0)
+        {
+          uint32_t fileclus = position / clustersize;
+
+          if (fileclus >= ff->ff_extfileclus)
+            {
+              fileclus = MIN(fileclus, ff->ff_extfileclus +
+                                       ff->ff_extnclusters - 1);
+
+              cluster       = ff->ff_extcluster +
+                              (fileclus - ff->ff_extfileclus);
+              filep->f_pos  = (off_t)fileclus * clustersize;
+              position     -= filep->f_pos;
+            }
+        }
+
       for (; ; )
         {
           /* Skip over clusters prior to the one containing
@@ -1219,6 +1293,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
 
           /* Otherwise, update the position and continue looking */
 
+          fat_extentadd(ff, filep->f_pos / clustersize + 1, cluster);
           filep->f_pos += clustersize;
           position     -= clustersize;
         }
@@ -1513,6 +1588,9 @@ static int fat_dup(FAR const struct file *oldp, FAR struct file *newp)
   newff->ff_startcluster     = oldff->ff_startcluster;     /* Start cluster of file on media */
   newff->ff_currentsector    = oldff->ff_currentsector;    /* Current sector */
   newff->ff_cachesector      = 0;                          /* Sector in file buffer */
+  newff->ff_extfileclus      = oldff->ff_extfileclus;      /* Cached run of clusters */
+  newff->ff_extcluster       = oldff->ff_extcluster;
+  newff->ff_extnclusters     = oldff->ff_extnclusters;
 
   /* Attach the private date to the struct file instance */
 
@@ -1782,6 +1860,12 @@ static int fat_truncate(FAR struct file *filep, off_t length)
       ndx      = (ff->ff_dirindex & DIRSEC_NDXMASK(fs)) * DIR_SIZE;
       direntry = &fs->fs_buffer[ndx];
 
+      /* The cached run of clusters may include clusters that are about to
+       * be freed.
+       */
+
+      ff->ff_extnclusters = 0;
+
       /* Handle the simple case where we are shrinking the file to zero
        * length.
        */
@@ -2200,7 +2284,8 @@ static int fat_unbind(FAR void *handle, FAR struct inode **blkdriver,
 
   if (fs->fs_buffer)
     {
-      fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
+      fat_io_free(fs->fs_buffer,
+                  CONFIG_FAT_CACHESECTORS * fs->fs_hwsectorsize);
     }
 
   nxsem_destroy(&fs->fs_sem);
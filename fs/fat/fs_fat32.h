@@ -56,6 +56,19 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Configuration ************************************************************/
+
+/* The number of sectors held in the volume sector cache.  One of these is
+ * fs_buffer; the remainder are held in a small write-back LRU cache of
+ * recently used FAT, directory and FSINFO sectors.
+ */
+
+#ifndef CONFIG_FAT_CACHESECTORS
+#  define CONFIG_FAT_CACHESECTORS 1
+#endif
+
+#define FAT_NCACHESLOTS (CONFIG_FAT_CACHESECTORS - 1)
+
 /****************************************************************************
  * These offsets describes the master boot record (MBR).
  *
@@ -867,6 +880,21 @@
  * Public Types
  ****************************************************************************/
 
+/* This structure describes one sector held in the volume sector cache, in
+ * addition to the sector in fs_buffer.  File data sectors are only ever
+ * held clean; their modifications live in the per-file ff_buffer.
+ */
+
+#if FAT_NCACHESLOTS > 0
+struct fat_cacheslot_s
+{
+  off_t    cs_sector;              /* The sector held in the slot (-1: none) */
+  uint32_t cs_age;                 /* Value of fs_cacheclock when last used */
+  bool     cs_dirty;               /* true: cs_buffer is dirty */
+  uint8_t *cs_buffer;              /* The sector data */
+};
+#endif
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a fat32 filesystem.
@@ -885,7 +913,7 @@ struct fat_mountpt_s
   off_t    fs_rootbase;            /* MBR: Cluster no. of 1st cluster of root dir */
   off_t    fs_database;            /* Logical block of start data sectors */
   off_t    fs_fsinfo;              /* MBR: Sector number of FSINFO sector */
-  off_t    fs_currentsector;       /* The sector number buffered in fs_buffer */
+  off_t    fs_currentsector;       /* The sector number buffered in fs_buffer (-1: none) */
   uint32_t fs_nclusters;           /* Maximum number of data clusters */
   uint32_t fs_nfatsects;           /* MBR: Count of sectors occupied by one fat */
   uint32_t fs_fattotsec;           /* MBR: Total count of sectors on the volume */
@@ -901,6 +929,10 @@ struct fat_mountpt_s
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
   uint8_t *fs_buffer;              /* This is an allocated buffer to hold one sector
                                     * from the device */
+#if FAT_NCACHESLOTS > 0
+  uint32_t fs_cacheclock;          /* Incremented each time a slot is used */
+  struct fat_cacheslot_s fs_cache[FAT_NCACHESLOTS];
+#endif
 };
 
 /* This structure represents on open file under the mountpoint.  An instance
@@ -921,6 +953,9 @@ struct fat_file_s
   off_t    ff_startcluster;        /* Start cluster of file on media */
   off_t    ff_currentsector;       /* Current sector being operated on */
   off_t    ff_cachesector;         /* Current sector in the file buffer */
+  uint32_t ff_extfileclus;         /* Extent: Index of the first cluster in the file */
+  uint32_t ff_extcluster;          /* Extent: First cluster of the run on media */
+  uint32_t ff_extnclusters;        /* Extent: Number of contiguous clusters (0: none) */
   uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
 };
 
@@ -67,6 +67,220 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: fat_writesector
+ *
+ * Description:
+ *   Write one sector from the volume sector cache to the media.  Changes to
+ *   a sector in the FAT region are also made in the other FAT copies.
+ *
+ ****************************************************************************/
+
+static int fat_writesector(struct fat_mountpt_s *fs, uint8_t *buffer,
+                           off_t sector)
+{
+  int ret;
+
+  ret = fat_hwwrite(fs, buffer, sector, 1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Does the sector lie in the FAT region? */
+
+  if (sector >= fs->fs_fatbase &&
+      sector < fs->fs_fatbase + fs->fs_nfatsects)
+    {
+      int i;
+
+      /* Yes, then make the change in the FAT copy as well */
+
+      for (i = fs->fs_fatnumfats; i >= 2; i--)
+        {
+          sector += fs->fs_nfatsects;
+          ret = fat_hwwrite(fs, buffer, sector, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_cachevictim
+ *
+ * Description:
+ *   Pick the cache slot that will receive a copy of 'sector':  The slot
+ *   already holding the same sector, an empty slot or else the least
+ *   recently used slot.  A dirty sector evicted from the slot is written
+ *   back first.
+ *
+ ****************************************************************************/
+
+#if FAT_NCACHESLOTS > 0
+static int fat_cachevictim(struct fat_mountpt_s *fs, off_t sector,
+                           FAR struct fat_cacheslot_s **slot)
+{
+  FAR struct fat_cacheslot_s *victim = NULL;
+  FAR struct fat_cacheslot_s *cs;
+  int ret;
+  int i;
+
+  for (i = 0; i < FAT_NCACHESLOTS; i++)
+    {
+      cs = &fs->fs_cache[i];
+      if (cs->cs_sector == sector)
+        {
+          /* A stale copy of the sector (fs_currentsector may have been set
+           * directly to initialize a new sector).  Replace it.
+           */
+
+          victim = cs;
+          break;
+        }
+
+      if (victim == NULL || (victim->cs_sector >= 0 &&
+          (cs->cs_sector < 0 ||
+           (int32_t)(cs->cs_age - victim->cs_age) < 0)))
+        {
+          victim = cs;
+        }
+    }
+
+  if (victim->cs_dirty && victim->cs_sector != sector)
+    {
+      ret = fat_writesector(fs, victim->cs_buffer, victim->cs_sector);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  *slot = victim;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_cachestash
+ *
+ * Description:
+ *   Move the sector in fs_buffer into the cache slots so that fs_buffer
+ *   can be reused for another sector.
+ *
+ ****************************************************************************/
+
+#if FAT_NCACHESLOTS > 0
+static int fat_cachestash(struct fat_mountpt_s *fs)
+{
+  FAR struct fat_cacheslot_s *victim;
+  int ret;
+
+  if (fs->fs_currentsector < 0)
+    {
+      return OK;
+    }
+
+  ret = fat_cachevictim(fs, fs->fs_currentsector, &victim);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  memcpy(victim->cs_buffer, fs->fs_buffer, fs->fs_hwsectorsize);
+  victim->cs_sector = fs->fs_currentsector;
+  victim->cs_dirty  = fs->fs_dirty;
+  victim->cs_age    = ++fs->fs_cacheclock;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_cachedata
+ *
+ * Description:
+ *   Keep a clean copy of a file data sector that was just read from or
+ *   written to the media.  File data is never dirty in the volume cache:
+ *   The per-file ff_buffer remains the only place where it is modified.
+ *
+ ****************************************************************************/
+
+#if FAT_NCACHESLOTS > 0
+static int fat_cachedata(struct fat_mountpt_s *fs, FAR const uint8_t *buffer,
+                         off_t sector)
+{
+  FAR struct fat_cacheslot_s *victim;
+  int ret;
+
+  if (sector == fs->fs_currentsector)
+    {
+      return OK;
+    }
+
+  ret = fat_cachevictim(fs, sector, &victim);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  memcpy(victim->cs_buffer, buffer, fs->fs_hwsectorsize);
+  victim->cs_sector = sector;
+  victim->cs_dirty  = false;
+  victim->cs_age    = ++fs->fs_cacheclock;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_readdata
+ *
+ * Description:
+ *   Read one file data sector into 'buffer', from the volume cache when
+ *   the sector is there and from the media (keeping a copy) otherwise.
+ *
+ ****************************************************************************/
+
+static int fat_readdata(struct fat_mountpt_s *fs, FAR uint8_t *buffer,
+                        off_t sector)
+{
+#if FAT_NCACHESLOTS > 0
+  int ret;
+  int i;
+
+  if (sector == fs->fs_currentsector)
+    {
+      memcpy(buffer, fs->fs_buffer, fs->fs_hwsectorsize);
+      return OK;
+    }
+
+  for (i = 0; i < FAT_NCACHESLOTS; i++)
+    {
+      FAR struct fat_cacheslot_s *cs = &fs->fs_cache[i];
+
+      if (cs->cs_sector == sector)
+        {
+          memcpy(buffer, cs->cs_buffer, fs->fs_hwsectorsize);
+          cs->cs_age = ++fs->fs_cacheclock;
+          return OK;
+        }
+    }
+
+  ret = fat_hwread(fs, buffer, sector, 1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return fat_cachedata(fs, buffer, sector);
+#else
+  return fat_hwread(fs, buffer, sector, 1);
+#endif
+}
+
 /****************************************************************************
  * Name: fat_checkfsinfo
  *
@@ -505,6 +719,9 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
 {
   FAR struct inode *inode;
   struct geometry geo;
+#if FAT_NCACHESLOTS > 0
+  int slot;
+#endif
   int ret;
 
   /* Assume that the mount is successful */
@@ -534,15 +751,33 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   fs->fs_hwsectorsize = geo.geo_sectorsize;
   fs->fs_hwnsectors   = geo.geo_nsectors;
 
-  /* Allocate a buffer to hold one hardware sector */
+  /* Allocate a buffer to hold one hardware sector, followed by the
+   * sectors of the volume sector cache.
+   */
 
-  fs->fs_buffer = (FAR uint8_t *)fat_io_alloc(fs->fs_hwsectorsize);
+  fs->fs_buffer = (FAR uint8_t *)
+    fat_io_alloc(CONFIG_FAT_CACHESECTORS * fs->fs_hwsectorsize);
   if (!fs->fs_buffer)
     {
       ret = -ENOMEM;
       goto errout;
     }
 
+  fs->fs_currentsector = -1;
+
+#if FAT_NCACHESLOTS > 0
+  for (slot = 0; slot < FAT_NCACHESLOTS; slot++)
+    {
+      fs->fs_cache[slot].cs_sector = -1;
+      fs->fs_cache[slot].cs_age    = 0;
+      fs->fs_cache[slot].cs_dirty  = false;
+      fs->fs_cache[slot].cs_buffer = fs->fs_buffer +
+                                     (slot + 1) * fs->fs_hwsectorsize;
+    }
+
+  fs->fs_cacheclock = 0;
+#endif
+
   /* Search FAT boot record on the drive.  First check the MBR at sector
    * zero.  This could be either the boot record or a partition that refers
    * to the boot record.
@@ -670,7 +905,7 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   return OK;
 
 errout_with_buffer:
-  fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
+  fat_io_free(fs->fs_buffer, CONFIG_FAT_CACHESECTORS * fs->fs_hwsectorsize);
   fs->fs_buffer = 0;
 
 errout:
@@ -767,6 +1002,30 @@ int fat_hwwrite(struct fat_mountpt_s *fs, uint8_t *buffer, off_t sector,
                 unsigned int nsectors)
 {
   int ret = -ENODEV;
+
+#if FAT_NCACHESLOTS > 0
+  /* Any cached copies of the sectors are now stale.  Leave only the slot
+   * that is being written back.
+   */
+
+  if (fs)
+    {
+      int i;
+
+      for (i = 0; i < FAT_NCACHESLOTS; i++)
+        {
+          FAR struct fat_cacheslot_s *cs = &fs->fs_cache[i];
+
+          if (cs->cs_buffer != buffer && cs->cs_sector >= sector &&
+              cs->cs_sector < sector + nsectors)
+            {
+              cs->cs_sector = -1;
+              cs->cs_dirty  = false;
+            }
+        }
+    }
+#endif
+
   if (fs && fs->fs_blkdriver)
     {
       struct inode *inode = fs->fs_blkdriver;
@@ -1757,13 +2016,17 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
  * Name: fat_fscacheflush
  *
  * Description:
- *   Flush any dirty sector if fs_buffer as necessary
+ *   Flush any dirty sector if fs_buffer as necessary, and any dirty sectors
+ *   held in the volume sector cache.
  *
  ****************************************************************************/
 
 int fat_fscacheflush(struct fat_mountpt_s *fs)
 {
   int ret;
+#if FAT_NCACHESLOTS > 0
+  int i;
+#endif
 
   /* Check if the fs_buffer is dirty.  In this case, we will write back the
    * contents of fs_buffer.
@@ -1773,36 +2036,36 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
     {
       /* Write the dirty sector */
 
-      ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
+      ret = fat_writesector(fs, fs->fs_buffer, fs->fs_currentsector);
       if (ret < 0)
         {
           return ret;
         }
 
-      /* Does the sector lie in the FAT region? */
+      /* No longer dirty */
 
-      if (fs->fs_currentsector >= fs->fs_fatbase &&
-          fs->fs_currentsector < fs->fs_fatbase + fs->fs_nfatsects)
-        {
-          int i;
+      fs->fs_dirty = false;
+    }
+
+#if FAT_NCACHESLOTS > 0
+  /* Then write back the dirty sectors held in the cache */
 
-          /* Yes, then make the change in the FAT copy as well */
+  for (i = 0; i < FAT_NCACHESLOTS; i++)
+    {
+      FAR struct fat_cacheslot_s *cs = &fs->fs_cache[i];
 
-          for (i = fs->fs_fatnumfats; i >= 2; i--)
+      if (cs->cs_dirty)
+        {
+          ret = fat_writesector(fs, cs->cs_buffer, cs->cs_sector);
+          if (ret < 0)
             {
-              fs->fs_currentsector += fs->fs_nfatsects;
-              ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
-              if (ret < 0)
-                {
-                  return ret;
-                }
+              return ret;
             }
-        }
-
-      /* No longer dirty */
 
-      fs->fs_dirty = false;
+          cs->cs_dirty = false;
+        }
     }
+#endif
 
   return OK;
 }
@@ -1819,6 +2082,9 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
 int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
 {
   int ret;
+#if FAT_NCACHESLOTS > 0
+  int i;
+#endif
 
   /* fs->fs_currentsector holds the current sector that is buffered in
    * fs->fs_buffer. If the requested sector is the same as this sector, then
@@ -1827,6 +2093,39 @@ int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
 
   if (fs->fs_currentsector != sector)
     {
+#if FAT_NCACHESLOTS > 0
+      /* Keep the current sector, dirty or not, in the cache.  fs_buffer
+       * itself does not move:  Callers may hold pointers into it.
+       */
+
+      ret = fat_cachestash(fs);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      fs->fs_dirty = false;
+
+      /* Is the requested sector in the cache? */
+
+      for (i = 0; i < FAT_NCACHESLOTS; i++)
+        {
+          FAR struct fat_cacheslot_s *cs = &fs->fs_cache[i];
+
+          if (cs->cs_sector == sector)
+            {
+              memcpy(fs->fs_buffer, cs->cs_buffer, fs->fs_hwsectorsize);
+              fs->fs_currentsector = sector;
+              fs->fs_dirty         = cs->cs_dirty;
+
+              /* fs_buffer now holds the only copy that counts */
+
+              cs->cs_sector        = -1;
+              cs->cs_dirty         = false;
+              return OK;
+            }
+        }
+#else
       /* We will need to read the new sector.  First, flush the cached
        * sector if it is dirty.
        */
@@ -1836,12 +2135,16 @@ int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
         {
           return ret;
         }
+#endif
 
       /* Then read the specified sector into the cache */
 
       ret = fat_hwread(fs, fs->fs_buffer, sector, 1);
       if (ret < 0)
         {
+          /* fs_buffer no longer holds any valid sector */
+
+          fs->fs_currentsector = -1;
           return ret;
         }
 
@@ -1881,6 +2184,16 @@ int fat_ffcacheflush(struct fat_mountpt_s *fs, struct fat_file_s *ff)
           return ret;
         }
 
+#if FAT_NCACHESLOTS > 0
+      /* Other files reading the sector can now take it from the cache */
+
+      ret = fat_cachedata(fs, ff->ff_buffer, ff->ff_cachesector);
+      if (ret < 0)
+        {
+          return ret;
+        }
+#endif
+
       /* No longer dirty, but still valid */
 
       ff->ff_bflags &= ~FFBUFF_DIRTY;
@@ -1921,7 +2234,7 @@ int fat_ffcacheread(struct fat_mountpt_s *fs, struct fat_file_s *ff, off_t secto
 
       /* Then read the specified sector into the cache */
 
-      ret = fat_hwread(fs, ff->ff_buffer, sector, 1);
+      ret = fat_readdata(fs, ff->ff_buffer, sector);
       if (ret < 0)
         {
           return ret;
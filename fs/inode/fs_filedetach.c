@@ -130,6 +130,10 @@ int file_detach(int fd, FAR struct file *filep)
       return -EBADF;
     }
 
+  /* The descriptor goes away, so it leaves any epoll interest list */
+
+  epoll_fileclose(parent);
+
   /* Duplicate the 'struct file' content into the user-provided file
    * structure.
    */
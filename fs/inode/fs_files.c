@@ -91,6 +91,12 @@ static int _files_close(FAR struct file *filep)
 
   if (inode)
     {
+      /* Remove the descriptor from any epoll interest list while the
+       * driver is still open.
+       */
+
+      epoll_fileclose(filep);
+
       /* Close the file, driver, or mountpoint. */
 
       if (inode->u.i_ops && inode->u.i_ops->close)
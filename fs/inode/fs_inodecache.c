@@ -0,0 +1,189 @@
+/****************************************************************************
+ * fs/inode/fs_inodecache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+
+#ifdef CONFIG_FS_INODE_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if (CONFIG_FS_INODE_CACHE_NSLOTS & (CONFIG_FS_INODE_CACHE_NSLOTS - 1)) != 0
+#  error CONFIG_FS_INODE_CACHE_NSLOTS must be a power of two
+#endif
+
+#define INODE_CACHE_MASK (CONFIG_FS_INODE_CACHE_NSLOTS - 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One cached path segment.  The cache is direct-mapped:  Each (parent,
+ * name) pair can only live in one slot and a new entry simply replaces the
+ * old one.
+ */
+
+struct inode_cache_s
+{
+  FAR struct inode *parent;  /* Parent inode, NULL for the top level */
+  FAR struct inode *node;    /* The inode with the name, NULL: Empty slot */
+  FAR struct inode *peer;    /* The inode to the "left" of 'node' */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct inode_cache_s g_inode_cache[CONFIG_FS_INODE_CACHE_NSLOTS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_slot
+ *
+ * Description:
+ *   Return the slot for the path segment 'name' (terminated by '/' or NUL)
+ *   below 'parent'.
+ *
+ ****************************************************************************/
+
+static FAR struct inode_cache_s *
+inode_cache_slot(FAR struct inode *parent, FAR const char *name)
+{
+  uint32_t hash = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 2);
+
+  /* FNV-1a over the characters of the segment */
+
+  for (; *name != '\0' && *name != '/'; name++)
+    {
+      hash = (hash ^ (uint8_t)*name) * 16777619u;
+    }
+
+  return &g_inode_cache[(hash ^ (hash >> 16)) & INODE_CACHE_MASK];
+}
+
+/****************************************************************************
+ * Name: inode_cache_match
+ *
+ * Description:
+ *   Check if the path segment 'name' is the name of 'node'.
+ *
+ ****************************************************************************/
+
+static bool inode_cache_match(FAR const char *name, FAR struct inode *node)
+{
+  FAR const char *nname = node->i_name;
+
+  while (*nname != '\0' && *nname == *name)
+    {
+      nname++;
+      name++;
+    }
+
+  return *nname == '\0' && (*name == '\0' || *name == '/');
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look up the path segment 'name' below 'parent' in the cache.
+ *
+ * Assumptions:
+ *   The caller holds the g_inode_sem semaphore
+ *
+ ****************************************************************************/
+
+FAR struct inode *inode_cache_lookup(FAR struct inode *parent,
+                                     FAR const char *name,
+                                     FAR struct inode **peer)
+{
+  FAR struct inode_cache_s *slot = inode_cache_slot(parent, name);
+
+  if (slot->node != NULL && slot->parent == parent &&
+      inode_cache_match(name, slot->node))
+    {
+      *peer = slot->peer;
+      return slot->node;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember that the path segment 'name' below 'parent' is 'node' and that
+ *   'peer' is the inode to the left of it.
+ *
+ * Assumptions:
+ *   The caller holds the g_inode_sem semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR struct inode *parent, FAR const char *name,
+                     FAR struct inode *node, FAR struct inode *peer)
+{
+  FAR struct inode_cache_s *slot = inode_cache_slot(parent, name);
+
+  slot->parent = parent;
+  slot->node   = node;
+  slot->peer   = peer;
+}
+
+/****************************************************************************
+ * Name: inode_cache_flush
+ *
+ * Description:
+ *   Forget all cached path segments.  This must be called whenever an inode
+ *   is linked into or unlinked from the tree because that changes the left
+ *   peer of the neighboring inode and may free a cached inode.
+ *
+ * Assumptions:
+ *   The caller holds the g_inode_sem semaphore
+ *
+ ****************************************************************************/
+
+void inode_cache_flush(void)
+{
+  memset(g_inode_cache, 0, sizeof(g_inode_cache));
+}
+
+#endif /* CONFIG_FS_INODE_CACHE */
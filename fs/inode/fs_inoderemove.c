@@ -91,6 +91,10 @@ FAR struct inode *inode_unlink(FAR const char *path)
       node = desc.node;
       DEBUGASSERT(node != NULL);
 
+      /* The cache may refer to the node or have it as the left peer */
+
+      inode_cache_flush();
+
       /* If peer is non-null, then remove the node from the right of
        * of that peer node.
        */
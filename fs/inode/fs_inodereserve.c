@@ -108,6 +108,10 @@ static void inode_insert(FAR struct inode *node,
                          FAR struct inode *peer,
                          FAR struct inode *parent)
 {
+  /* The new node becomes the left peer of the node after it */
+
+  inode_cache_flush();
+
   /* If peer is non-null, then new node simply goes to the right
    * of that peer node.
    */
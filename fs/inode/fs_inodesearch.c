@@ -241,6 +241,9 @@ static int _inode_search(FAR struct inode_search_s *desc)
   FAR struct inode *left    = NULL;
   FAR struct inode *above   = NULL;
   FAR const char   *relpath = NULL;
+#ifdef CONFIG_FS_INODE_CACHE
+  FAR struct inode *cached;
+#endif
   int ret = -ENOENT;
 
   /* Get the search path, skipping over the leading '/'.  The leading '/' is
@@ -273,6 +276,16 @@ static int _inode_search(FAR struct inode_search_s *desc)
       return -ENOSYS;
     }
 
+#ifdef CONFIG_FS_INODE_CACHE
+  /* Skip the walk along the top level if the first segment is cached */
+
+  cached = inode_cache_lookup(NULL, name, &left);
+  if (cached != NULL)
+    {
+      node = cached;
+    }
+#endif
+
   /* Traverse the pseudo file system node tree until either (1) all nodes
    * have been examined without finding the matching node, or (2) the
    * matching node is found.
@@ -318,6 +331,8 @@ static int _inode_search(FAR struct inode_search_s *desc)
            *       below this one
            */
 
+          inode_cache_add(above, name, node, left);
+
           name = inode_nextname(name);
           if (*name == '\0' || INODE_IS_MOUNTPT(node))
             {
@@ -402,6 +417,16 @@ static int _inode_search(FAR struct inode_search_s *desc)
               above = node;
               left  = NULL;
               node  = node->i_child;
+
+#ifdef CONFIG_FS_INODE_CACHE
+              /* Skip the walk along the peers if the segment is cached */
+
+              cached = inode_cache_lookup(above, name, &left);
+              if (cached != NULL)
+                {
+                  node = cached;
+                }
+#endif
             }
         }
     }
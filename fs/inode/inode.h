@@ -226,6 +226,34 @@ void inode_semgive(void);
 
 int inode_search(FAR struct inode_search_s *desc);
 
+/****************************************************************************
+ * Name: inode_cache_lookup, inode_cache_add and inode_cache_flush
+ *
+ * Description:
+ *   A cache of path segments that lets inode_search() skip the walk along
+ *   the list of peers.  inode_cache_lookup() returns the cached inode with
+ *   the name of the path segment 'name' below 'parent' (NULL for the top
+ *   level) and the inode to its left, or NULL if it is not cached.
+ *   inode_cache_flush() must be called whenever the tree changes.
+ *
+ * Assumptions:
+ *   The caller holds the g_inode_sem semaphore
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_CACHE
+FAR struct inode *inode_cache_lookup(FAR struct inode *parent,
+                                     FAR const char *name,
+                                     FAR struct inode **peer);
+void inode_cache_add(FAR struct inode *parent, FAR const char *name,
+                     FAR struct inode *node, FAR struct inode *peer);
+void inode_cache_flush(void);
+#else
+#  define inode_cache_lookup(parent, name, peer) (NULL)
+#  define inode_cache_add(parent, name, node, peer)
+#  define inode_cache_flush()
+#endif
+
 /****************************************************************************
  * Name: inode_find
  *
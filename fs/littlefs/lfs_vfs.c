@@ -50,8 +50,10 @@
 
 #include <nuttx/config.h>
 
+#include <debug.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <nuttx/fs/dirent.h>
@@ -81,6 +83,14 @@ struct littlefs_mountpt_s
   struct mtd_geometry_s geo;
   struct lfs_config_s   cfg;
   lfs_t                 lfs;
+
+  /* Sequential read-ahead, in device blocks */
+
+  FAR uint8_t          *rabuf;     /* Read-ahead buffer (NULL: disabled) */
+  size_t                rasize;    /* Size of rabuf in device blocks */
+  size_t                ravalid;   /* Number of valid blocks in rabuf */
+  off_t                 rablock;   /* First device block in rabuf */
+  off_t                 ranext;    /* Device block following the last read */
 };
 
 /****************************************************************************
@@ -736,6 +746,49 @@ static int littlefs_rewinddir(FAR struct inode *mountpt,
   return ret;
 }
 
+/****************************************************************************
+ * Name: littlefs_bread
+ *
+ * Description: Read device blocks from the MTD or block driver.
+ *
+ ****************************************************************************/
+
+static int littlefs_bread(FAR struct littlefs_mountpt_s *fs, off_t block,
+                          size_t nblocks, FAR void *buffer)
+{
+  FAR struct inode *drv = fs->drv;
+  int ret;
+
+  if (INODE_IS_MTD(drv))
+    {
+      ret = MTD_BREAD(drv->u.i_mtd, block, nblocks, buffer);
+    }
+  else
+    {
+      ret = drv->u.i_bops->read(drv, buffer, block, nblocks);
+    }
+
+  return ret >= 0 ? OK : ret;
+}
+
+/****************************************************************************
+ * Name: littlefs_rainvalidate
+ *
+ * Description: Discard the read-ahead buffer if it overlaps the device
+ *  blocks that are being programmed or erased.
+ *
+ ****************************************************************************/
+
+static void littlefs_rainvalidate(FAR struct littlefs_mountpt_s *fs,
+                                  off_t block, size_t nblocks)
+{
+  if (fs->ravalid > 0 && block < fs->rablock + (off_t)fs->ravalid &&
+      block + (off_t)nblocks > fs->rablock)
+    {
+      fs->ravalid = 0;
+    }
+}
+
 /****************************************************************************
  * Name: littlefs_bind
  *
@@ -753,22 +806,56 @@ static int littlefs_read_block(FAR const struct lfs_config_s *c,
 {
   FAR struct littlefs_mountpt_s *fs = c->context;
   FAR struct mtd_geometry_s *geo = &fs->geo;
-  FAR struct inode *drv = fs->drv;
+  off_t start;
+  size_t nblocks;
+  size_t nread;
   int ret;
 
-  block = (block * c->block_size + off) / geo->blocksize;
-  size  = size / geo->blocksize;
+  start   = ((off_t)block * c->block_size + off) / geo->blocksize;
+  nblocks = size / geo->blocksize;
 
-  if (INODE_IS_MTD(drv))
+  /* Already in the read-ahead buffer? */
+
+  if (fs->ravalid > 0 && start >= fs->rablock &&
+      start + nblocks <= fs->rablock + fs->ravalid)
     {
-      ret = MTD_BREAD(drv->u.i_mtd, block, size, buffer);
+      memcpy(buffer, &fs->rabuf[(start - fs->rablock) * geo->blocksize],
+             size);
+      fs->ranext = start + nblocks;
+      return OK;
     }
-  else
+
+  /* If this read continues the previous one, then read the following
+   * blocks too with the same request.
+   */
+
+  if (fs->rabuf != NULL && start == fs->ranext && nblocks < fs->rasize)
     {
-      ret = drv->u.i_bops->read(drv, buffer, block, size);
+      nread = fs->rasize;
+      if (start + nread > (off_t)(geo->neraseblocks * (geo->erasesize /
+                                                       geo->blocksize)))
+        {
+          nread = geo->neraseblocks * (geo->erasesize / geo->blocksize) -
+                  start;
+        }
+
+      if (nread > nblocks)
+        {
+          fs->ravalid = 0;
+          ret = littlefs_bread(fs, start, nread, fs->rabuf);
+          if (ret >= 0)
+            {
+              fs->rablock = start;
+              fs->ravalid = nread;
+              memcpy(buffer, fs->rabuf, size);
+              fs->ranext = start + nblocks;
+              return OK;
+            }
+        }
     }
 
-  return ret >= 0 ? OK : ret;
+  fs->ranext = start + nblocks;
+  return littlefs_bread(fs, start, nblocks, buffer);
 }
 
 /****************************************************************************
@@ -787,6 +874,8 @@ static int littlefs_write_block(FAR const struct lfs_config_s *c,
   block = (block * c->block_size + off) / geo->blocksize;
   size  = size / geo->blocksize;
 
+  littlefs_rainvalidate(fs, block, size);
+
   if (INODE_IS_MTD(drv))
     {
       ret = MTD_BWRITE(drv->u.i_mtd, block, size, buffer);
@@ -810,6 +899,9 @@ static int littlefs_erase_block(FAR const struct lfs_config_s *c,
   FAR struct inode *drv = fs->drv;
   int ret = OK;
 
+  littlefs_rainvalidate(fs, (off_t)block * c->block_size / fs->geo.blocksize,
+                        c->block_size / fs->geo.blocksize);
+
   if (INODE_IS_MTD(drv))
     {
       FAR struct mtd_geometry_s *geo = &fs->geo;
@@ -844,6 +936,94 @@ static int littlefs_sync_block(FAR const struct lfs_config_s *c)
   return ret == -ENOTTY ? OK : ret;
 }
 
+/****************************************************************************
+ * Name: littlefs_parseopt
+ *
+ * Description: Parse one "name=value" mount option.  Returns true if the
+ *  option has this name; the value is then returned in 'value' or -EINVAL
+ *  in 'ret' if it is malformed.
+ *
+ ****************************************************************************/
+
+static bool littlefs_parseopt(FAR const char *opt, size_t len,
+                              FAR const char *name, FAR lfs_size_t *value,
+                              FAR int *ret)
+{
+  size_t namelen = strlen(name);
+  FAR char *end;
+
+  if (len <= namelen || strncmp(opt, name, namelen) != 0)
+    {
+      return false;
+    }
+
+  *value = strtoul(&opt[namelen], &end, 0);
+  if (end != &opt[len])
+    {
+      *ret = -EINVAL;
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: littlefs_parseopts
+ *
+ * Description: Parse the comma separated mount options:
+ *
+ *   forceformat       - Format the device before mounting
+ *   autoformat        - Format the device if it cannot be mounted
+ *   rcache=<bytes>    - Read cache size (littlefs read_size)
+ *   pcache=<bytes>    - Program cache and file buffer size (prog_size)
+ *   lookahead=<n>     - Number of blocks in the allocator lookahead
+ *   readahead=<n>     - Number of device blocks of sequential read-ahead
+ *
+ ****************************************************************************/
+
+static int littlefs_parseopts(FAR struct littlefs_mountpt_s *fs,
+                              FAR const char *data, FAR bool *forceformat,
+                              FAR bool *autoformat)
+{
+  FAR const char *end;
+  lfs_size_t rasize;
+  size_t len;
+  int ret = OK;
+
+  rasize = fs->rasize;
+
+  while (data != NULL && *data != '\0' && ret == OK)
+    {
+      end = strchr(data, ',');
+      len = end != NULL ? end - data : strlen(data);
+
+      if (len == 11 && strncmp(data, "forceformat", 11) == 0)
+        {
+          *forceformat = true;
+        }
+      else if (len == 10 && strncmp(data, "autoformat", 10) == 0)
+        {
+          *autoformat = true;
+        }
+      else if (!littlefs_parseopt(data, len, "rcache=",
+                                  &fs->cfg.read_size, &ret) &&
+               !littlefs_parseopt(data, len, "pcache=",
+                                  &fs->cfg.prog_size, &ret) &&
+               !littlefs_parseopt(data, len, "lookahead=",
+                                  &fs->cfg.lookahead, &ret) &&
+               !littlefs_parseopt(data, len, "readahead=", &rasize, &ret) &&
+               len > 0)
+        {
+          ferr("ERROR: Unknown mount option: %.*s\n", (int)len, data);
+          ret = -EINVAL;
+        }
+
+      data = end != NULL ? end + 1 : NULL;
+    }
+
+  fs->rasize = rasize;
+  return ret;
+}
+
 /****************************************************************************
  * Name: littlefs_bind
  ****************************************************************************/
@@ -852,6 +1032,9 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
                          FAR void **handle)
 {
   FAR struct littlefs_mountpt_s *fs;
+  bool forceformat = false;
+  bool autoformat = false;
+  lfs_size_t maxlookahead;
   int ret;
 
   /* Open the block driver */
@@ -925,15 +1108,75 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
   fs->cfg.prog        = littlefs_write_block;
   fs->cfg.erase       = littlefs_erase_block;
   fs->cfg.sync        = littlefs_sync_block;
-  fs->cfg.read_size   = fs->geo.blocksize;
-  fs->cfg.prog_size   = fs->geo.blocksize;
+  fs->cfg.read_size   = CONFIG_FS_LITTLEFS_READ_SIZE;
+  fs->cfg.prog_size   = CONFIG_FS_LITTLEFS_PROG_SIZE;
   fs->cfg.block_size  = fs->geo.erasesize;
   fs->cfg.block_count = fs->geo.neraseblocks;
-  fs->cfg.lookahead   = 32 * ((fs->cfg.block_count + 31) / 32);
+  fs->cfg.lookahead   = CONFIG_FS_LITTLEFS_LOOKAHEAD;
+  fs->rasize          = CONFIG_FS_LITTLEFS_READAHEAD;
+
+  /* The mount options override the configured sizes */
+
+  ret = littlefs_parseopts(fs, data, &forceformat, &autoformat);
+  if (ret < 0)
+    {
+      goto errout_with_fs;
+    }
+
+  if (fs->cfg.read_size == 0)
+    {
+      fs->cfg.read_size = fs->geo.blocksize;
+    }
+
+  if (fs->cfg.prog_size == 0)
+    {
+      fs->cfg.prog_size = fs->cfg.read_size;
+    }
+
+  /* The caches must hold whole device blocks and tile the erase block */
+
+  if (fs->cfg.read_size % fs->geo.blocksize != 0 ||
+      fs->cfg.prog_size % fs->cfg.read_size != 0 ||
+      fs->cfg.block_size % fs->cfg.prog_size != 0)
+    {
+      ferr("ERROR: Bad cache sizes: read %u prog %u block %u\n",
+           fs->cfg.read_size, fs->cfg.prog_size, fs->cfg.block_size);
+      ret = -EINVAL;
+      goto errout_with_fs;
+    }
+
+  /* The lookahead is a multiple of 32 blocks and need not be larger than
+   * the device.
+   */
+
+  maxlookahead = 32 * ((fs->cfg.block_count + 31) / 32);
+  if (fs->cfg.lookahead == 0)
+    {
+      fs->cfg.lookahead = maxlookahead;
+      if (fs->cfg.lookahead > 32 * fs->cfg.read_size)
+        {
+          fs->cfg.lookahead = 32 * fs->cfg.read_size;
+        }
+    }
+  else
+    {
+      fs->cfg.lookahead = 32 * ((fs->cfg.lookahead + 31) / 32);
+      if (fs->cfg.lookahead > maxlookahead)
+        {
+          fs->cfg.lookahead = maxlookahead;
+        }
+    }
 
-  if (fs->cfg.lookahead > 32 * fs->cfg.read_size)
+  /* Allocate the read-ahead buffer */
+
+  if (fs->rasize > 0)
     {
-      fs->cfg.lookahead = 32 * fs->cfg.read_size;
+      fs->rabuf = kmm_malloc(fs->rasize * fs->geo.blocksize);
+      if (!fs->rabuf)
+        {
+          ret = -ENOMEM;
+          goto errout_with_fs;
+        }
     }
 
   /* Then get information about the littlefs filesystem on the devices
@@ -942,7 +1185,7 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
 
   /* Force format the device if -o forceformat */
 
-  if (data && strcmp(data, "forceformat") == 0)
+  if (forceformat)
     {
       ret = lfs_format(&fs->lfs, &fs->cfg);
       if (ret < 0)
@@ -956,8 +1199,7 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
     {
       /* Auto format the device if -o autoformat */
 
-      if (ret != LFS_ERR_CORRUPT ||
-          !data || strcmp(data, "autoformat"))
+      if (ret != LFS_ERR_CORRUPT || !autoformat)
         {
           goto errout_with_fs;
         }
@@ -982,6 +1224,11 @@ static int littlefs_bind(FAR struct inode *driver, FAR const void *data,
   return OK;
 
 errout_with_fs:
+  if (fs->rabuf)
+    {
+      kmm_free(fs->rabuf);
+    }
+
   nxsem_destroy(&fs->sem);
   kmm_free(fs);
 errout_with_block:
@@ -1036,6 +1283,11 @@ static int littlefs_unbind(FAR void *handle, FAR struct inode **driver,
 
       /* Release the mountpoint private data */
 
+      if (fs->rabuf)
+        {
+          kmm_free(fs->rabuf);
+        }
+
       nxsem_destroy(&fs->sem);
       kmm_free(fs);
     }
@@ -76,7 +76,9 @@
  *
  *   2. If CONFIG_FS_RAMMAP is defined in the configuration, then mmap() will
  *      support simulation of memory mapped files by copying files whole
- *      into RAM.
+ *      into RAM.  Mappings of the same file share the copy and changes to
+ *      a writable MAP_SHARED mapping are written back by msync() and
+ *      munmap().
  *
  * Input Parameters:
  *   start   A hint at where to map the memory -- ignored.  The address
@@ -207,7 +209,7 @@ FAR void *mmap(FAR void *start, size_t length, int prot, int flags,
        * do much better in the KERNEL build using the MMU.
        */
 
-      return rammap(fd, length, offset);
+      return rammap(fd, length, offset, prot, flags);
 #else
       /* Error out.  The errno value was already set by ioctl() */
 
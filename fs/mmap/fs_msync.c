@@ -0,0 +1,138 @@
+/****************************************************************************
+ * fs/mmap/fs_msync.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <stdint.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/fs/fs.h>
+
+#include "fs_rammap.h"
+
+#ifdef CONFIG_FS_RAMMAP
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: msync
+ *
+ * Description:
+ *   Write the changes made to a writable MAP_SHARED mapping back to the
+ *   mapped file.  All mappings of a file share one copy in memory, so there
+ *   is nothing to invalidate and MS_INVALIDATE is ignored.  The write is
+ *   always synchronous; with MS_SYNC the file is flushed to the media as
+ *   well.
+ *
+ * Input Parameters:
+ *   addr   Start of the range to write back
+ *   len    Length of the range to write back
+ *   flags  MS_ASYNC or MS_SYNC, optionally with MS_INVALIDATE
+ *
+ * Returned Value:
+ *   On success, msync() returns 0, on failure -1, and errno is set
+ *   appropriately.
+ *
+ *     EINVAL
+ *      Both MS_ASYNC and MS_SYNC are set in 'flags'.
+ *     ENOMEM
+ *      The range is not mapped.
+ *
+ ****************************************************************************/
+
+int msync(FAR void *addr, size_t len, int flags)
+{
+  FAR struct fs_mapping_s *mapping;
+  FAR struct fs_rammap_s *map;
+  size_t offset;
+  size_t gapend;
+  int errcode;
+  int ret;
+
+  if ((flags & (MS_ASYNC | MS_SYNC)) == (MS_ASYNC | MS_SYNC))
+    {
+      errcode = EINVAL;
+      goto errout;
+    }
+
+  rammap_initialize();
+  ret = nxsem_wait(&g_rammaps.exclsem);
+  if (ret < 0)
+    {
+      errcode = -ret;
+      goto errout;
+    }
+
+  mapping = rammap_find(addr, NULL);
+  if (mapping == NULL)
+    {
+      ferr("ERROR: Region not found\n");
+      errcode = ENOMEM;
+      goto errout_with_semaphore;
+    }
+
+  /* The whole range must be mapped, possibly by several mappings of the
+   * same region.
+   */
+
+  map    = mapping->region;
+  offset = (uintptr_t)addr - (uintptr_t)map->addr;
+  if (len > map->length - offset ||
+      rammap_gap(map, NULL, offset, offset + len, &gapend) < offset + len)
+    {
+      errcode = ENOMEM;
+      goto errout_with_semaphore;
+    }
+
+  ret = rammap_writeback(map, offset, len);
+  if (ret >= 0 && (flags & MS_SYNC) != 0 &&
+      (map->flags & RAMMAP_SHARED) != 0)
+    {
+      ret = file_fsync(&map->file);
+    }
+
+  if (ret < 0)
+    {
+      errcode = -ret;
+      goto errout_with_semaphore;
+    }
+
+  nxsem_post(&g_rammaps.exclsem);
+  return OK;
+
+errout_with_semaphore:
+  nxsem_post(&g_rammaps.exclsem);
+
+errout:
+  set_errno(errcode);
+  return ERROR;
+}
+
+#endif /* CONFIG_FS_RAMMAP */
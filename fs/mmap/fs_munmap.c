@@ -54,6 +54,164 @@
 
 #ifdef CONFIG_FS_RAMMAP
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: munmap_find
+ *
+ * Description:
+ *   Find the mapping that a range is to be unmapped from.  In the flat
+ *   address space, mappings that share a region may overlap, so the range
+ *   is matched against each mapping as it was recorded:  The mapping must
+ *   contain the whole range, and one that starts at the range (the address
+ *   returned by mmap()) is preferred.
+ *
+ ****************************************************************************/
+
+static FAR struct fs_mapping_s *
+munmap_find(FAR const void *start, size_t length,
+            FAR struct fs_mapping_s **prevp)
+{
+  FAR struct fs_mapping_s *found = NULL;
+  FAR struct fs_mapping_s *prev;
+  FAR struct fs_mapping_s *curr;
+  uintptr_t ustart = (uintptr_t)start;
+
+  for (prev = NULL, curr = g_rammaps.mappings;
+       curr;
+       prev = curr, curr = curr->flink)
+    {
+      if (ustart < (uintptr_t)curr->addr ||
+          ustart - (uintptr_t)curr->addr > curr->length ||
+          length > curr->length - (ustart - (uintptr_t)curr->addr))
+        {
+          continue;
+        }
+
+      if (found == NULL || curr->addr == start)
+        {
+          found  = curr;
+          *prevp = prev;
+          if (curr->addr == start)
+            {
+              break;
+            }
+        }
+    }
+
+  return found;
+}
+
+/****************************************************************************
+ * Name: munmap_writeback
+ *
+ * Description:
+ *   Write back the parts of a range of a region that are being unmapped
+ *   from 'mapping' and that are not covered by any other mapping.
+ *
+ ****************************************************************************/
+
+static int munmap_writeback(FAR struct fs_rammap_s *region,
+                            FAR struct fs_mapping_s *mapping,
+                            size_t offset, size_t end)
+{
+  size_t gapend;
+  int ret;
+
+  if ((region->flags & RAMMAP_SHARED) == 0)
+    {
+      return OK;
+    }
+
+  while ((offset = rammap_gap(region, mapping, offset, end, &gapend)) <
+         end)
+    {
+      ret = rammap_writeback(region, offset, gapend - offset);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      offset = gapend;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: munmap_trim
+ *
+ * Description:
+ *   Free a region that is no longer mapped, or release the unmapped memory
+ *   at its end.  This is a consequence of using kumm_realloc() to simulate
+ *   the unmapping:  Unmapped memory at the beginning or in the middle of
+ *   a region stays allocated until the whole region is freed.
+ *
+ ****************************************************************************/
+
+static void munmap_trim(FAR struct fs_rammap_s *region)
+{
+  FAR struct fs_mapping_s *curr;
+  FAR struct fs_rammap_s *prev;
+  FAR void *newaddr;
+  size_t maxend;
+  size_t mend;
+
+  if (region->crefs == 0)
+    {
+      /* Remove the region from the list */
+
+      if (g_rammaps.head == region)
+        {
+          g_rammaps.head = region->flink;
+        }
+      else
+        {
+          for (prev = g_rammaps.head; prev->flink != region;
+               prev = prev->flink)
+            {
+            }
+
+          prev->flink = region->flink;
+        }
+
+      /* Then release the file and free the region */
+
+      file_close(&region->file);
+      kumm_free(region);
+      return;
+    }
+
+  maxend = 0;
+  for (curr = g_rammaps.mappings; curr; curr = curr->flink)
+    {
+      if (curr->region == region)
+        {
+          mend = (uintptr_t)curr->addr - (uintptr_t)region->addr +
+                 curr->length;
+          if (mend > maxend)
+            {
+              maxend = mend;
+            }
+        }
+    }
+
+  if (maxend < region->length)
+    {
+      newaddr = kumm_realloc(region, sizeof(struct fs_rammap_s) + maxend);
+      DEBUGASSERT(newaddr == (FAR void *)region);
+      UNUSED(newaddr); /* May not be used */
+
+      region->length = maxend;
+      if (region->filelen > maxend)
+        {
+          region->filelen = maxend;
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -93,14 +251,15 @@
  *   2. If CONFIG_FS_RAMMAP is defined in the configuration, then mmap() will
  *      support simulation of memory mapped files by copying files whole
  *      into RAM.  munmap() is required in this case to free the allocated
- *      memory holding the shared copy of the file.
+ *      memory holding the shared copy of the file.  Any part of the range
+ *      may be unmapped.  Memory that is no longer covered by any mapping
+ *      is written back to the file for a writable MAP_SHARED mapping.  The
+ *      end of the copy is released as soon as it is unused, and the whole
+ *      copy when the last mapping that uses it is removed.
  *
  * Input Parameters:
- *   start   The start address of the mapping to delete.  For this
- *           simplified munmap() implementation, the *must* be the start
- *           address of the memory region (the same address returned by
- *           mmap()).
- *   length  The length region to be umapped.
+ *   start   The start address of the range to unmap.
+ *   length  The length of the range to unmap.
  *
  * Returned Value:
  *   On success, munmap() returns 0, on failure -1, and errno is set
@@ -110,71 +269,99 @@
 
 int munmap(FAR void *start, size_t length)
 {
-  FAR struct fs_rammap_s *prev;
-  FAR struct fs_rammap_s *curr;
-  FAR void *newaddr;
-  unsigned int offset;
+  FAR struct fs_mapping_s *prev;
+  FAR struct fs_mapping_s *curr;
+  FAR struct fs_mapping_s *split;
+  FAR struct fs_rammap_s *region;
+  uintptr_t ustart = (uintptr_t)start;
+  uintptr_t uend = ustart + length;
+  uintptr_t mstart;
+  uintptr_t mend;
+  size_t offset;
   int ret;
   int errcode;
 
-  /* Find a region containing this start and length in the list of regions */
+  if (length == 0 || uend < ustart)
+    {
+      errcode = EINVAL;
+      goto errout;
+    }
 
   rammap_initialize();
   ret = nxsem_wait(&g_rammaps.exclsem);
   if (ret < 0)
     {
-      errcode = ret;
+      errcode = -ret;
       goto errout;
     }
 
-  /* Search the list of regions */
-
-  for (prev = NULL, curr = g_rammaps.head; curr; prev = curr, curr = curr->flink)
-    {
-      /* Does this region include any part of the specified range? */
-
-      if ((uintptr_t)start < (uintptr_t)curr->addr + curr->length &&
-          (uintptr_t)start + length >= (uintptr_t)curr->addr)
-        {
-          break;
-        }
-    }
-
-  /* Did we find the region */
+  /* Find the mapping to remove the range from */
 
+  curr = munmap_find(start, length, &prev);
   if (!curr)
     {
-      ferr("ERROR: Region not found\n");
+      ferr("ERROR: Mapping not found\n");
       errcode = EINVAL;
       goto errout_with_semaphore;
     }
 
-  /* Get the offset from the beginning of the region and the actual number
-   * of bytes to "unmap".  All mappings must extend to the end of the region.
-   * There is no support for free a block of memory but leaving a block of
-   * memory at the end.  This is a consequence of using kumm_realloc() to
-   * simulate the unmapping.
-   */
+  region = curr->region;
+  mstart = (uintptr_t)curr->addr;
+  mend   = mstart + curr->length;
 
-  offset = start - curr->addr;
-  if (offset + length < curr->length)
+  /* Unmapping the middle of a mapping leaves two mappings */
+
+  split = NULL;
+  if (ustart > mstart && uend < mend)
     {
-      ferr("ERROR: Cannot umap without unmapping to the end\n");
-      errcode = ENOSYS;
-      goto errout_with_semaphore;
+      split = (FAR struct fs_mapping_s *)
+        kmm_malloc(sizeof(struct fs_mapping_s));
+      if (split == NULL)
+        {
+          errcode = ENOMEM;
+          goto errout_with_semaphore;
+        }
     }
 
-  /* Okay.. the region is beging umapped to the end.  Make sure the length
-   * indicates that.
+  /* The changes to memory that no other mapping uses must reach the file
+   * before the memory is released.
    */
 
-  length = curr->length - offset;
+  offset = ustart - (uintptr_t)region->addr;
+  ret    = munmap_writeback(region, curr, offset, offset + length);
+  if (ret < 0)
+    {
+      if (split != NULL)
+        {
+          kmm_free(split);
+        }
 
-  /* Are we unmapping the entire region (offset == 0)? */
+      errcode = -ret;
+      goto errout_with_semaphore;
+    }
 
-  if (length >= curr->length)
+  if (split != NULL)
     {
-      /* Yes.. remove the mapping from the list */
+      split->region = region;
+      split->addr   = (FAR void *)uend;
+      split->length = mend - uend;
+      split->flink  = curr->flink;
+      curr->flink   = split;
+      curr->length  = ustart - mstart;
+      region->crefs++;
+    }
+  else if (ustart > mstart)
+    {
+      curr->length  = ustart - mstart;
+    }
+  else if (uend < mend)
+    {
+      curr->addr    = (FAR void *)uend;
+      curr->length  = mend - uend;
+    }
+  else
+    {
+      /* The whole mapping is removed */
 
       if (prev)
         {
@@ -182,25 +369,14 @@ int munmap(FAR void *start, size_t length)
         }
       else
         {
-          g_rammaps.head = curr->flink;
+          g_rammaps.mappings = curr->flink;
         }
 
-      /* Then free the region */
-
-      kumm_free(curr);
+      kmm_free(curr);
+      region->crefs--;
     }
 
-  /* No.. We have been asked to "unmap' only a portion of the memory
-   * (offset > 0).
-   */
-
-  else
-    {
-      newaddr = kumm_realloc(curr->addr, sizeof(struct fs_rammap_s) + length);
-      DEBUGASSERT(newaddr == (FAR void *)(curr->addr));
-      UNUSED(newaddr); /* May not be used */
-      curr->length = length;
-    }
+  munmap_trim(region);
 
   nxsem_post(&g_rammaps.exclsem);
   return OK;
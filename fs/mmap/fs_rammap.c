@@ -42,8 +42,9 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 
+#include <stdint.h>
 #include <string.h>
-#include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <debug.h>
 
@@ -90,6 +91,163 @@ void rammap_initialize(void)
     }
 }
 
+/****************************************************************************
+ * Name: rammap_find
+ *
+ * Description:
+ *   Find the live mapping that contains an address.  The caller must hold
+ *   g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+FAR struct fs_mapping_s *rammap_find(FAR const void *addr,
+                                     FAR struct fs_mapping_s **prevp)
+{
+  FAR struct fs_mapping_s *prev;
+  FAR struct fs_mapping_s *curr;
+
+  for (prev = NULL, curr = g_rammaps.mappings;
+       curr;
+       prev = curr, curr = curr->flink)
+    {
+      if ((uintptr_t)addr >= (uintptr_t)curr->addr &&
+          (uintptr_t)addr < (uintptr_t)curr->addr + curr->length)
+        {
+          break;
+        }
+    }
+
+  if (prevp != NULL)
+    {
+      *prevp = prev;
+    }
+
+  return curr;
+}
+
+/****************************************************************************
+ * Name: rammap_gap
+ *
+ * Description:
+ *   Find the first part of a range of a region that is not covered by any
+ *   live mapping.  The caller must hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+size_t rammap_gap(FAR struct fs_rammap_s *region,
+                  FAR struct fs_mapping_s *exclude, size_t offset,
+                  size_t end, FAR size_t *gapend)
+{
+  FAR struct fs_mapping_s *curr;
+  size_t mstart;
+  size_t mend;
+  size_t next;
+  bool covered;
+
+  /* Skip over the mappings that cover the start of the range */
+
+  do
+    {
+      covered = false;
+      for (curr = g_rammaps.mappings; curr; curr = curr->flink)
+        {
+          if (curr == exclude || curr->region != region)
+            {
+              continue;
+            }
+
+          mstart = (uintptr_t)curr->addr - (uintptr_t)region->addr;
+          mend   = mstart + curr->length;
+          if (mstart <= offset && offset < mend)
+            {
+              offset  = mend;
+              covered = true;
+            }
+        }
+    }
+  while (covered && offset < end);
+
+  if (offset >= end)
+    {
+      *gapend = end;
+      return end;
+    }
+
+  /* The gap ends where the next mapping begins */
+
+  next = end;
+  for (curr = g_rammaps.mappings; curr; curr = curr->flink)
+    {
+      if (curr == exclude || curr->region != region)
+        {
+          continue;
+        }
+
+      mstart = (uintptr_t)curr->addr - (uintptr_t)region->addr;
+      if (mstart > offset && mstart < next)
+        {
+          next = mstart;
+        }
+    }
+
+  *gapend = next;
+  return offset;
+}
+
+/****************************************************************************
+ * Name: rammap_writeback
+ *
+ * Description:
+ *   Write part of a MAP_SHARED region back to the file.
+ *
+ ****************************************************************************/
+
+int rammap_writeback(FAR struct fs_rammap_s *map, size_t offset,
+                     size_t length)
+{
+  FAR const uint8_t *wrbuffer;
+  ssize_t nwritten;
+
+  if ((map->flags & RAMMAP_SHARED) == 0 || offset >= map->filelen)
+    {
+      return OK;
+    }
+
+  /* Never extend the file:  Memory beyond the end of the file only holds
+   * zeroes as far as the file is concerned.
+   */
+
+  if (length > map->filelen - offset)
+    {
+      length = map->filelen - offset;
+    }
+
+  wrbuffer = (FAR const uint8_t *)map->addr + offset;
+  offset  += map->offset;
+
+  while (length > 0)
+    {
+      nwritten = file_pwrite(&map->file, wrbuffer, length, offset);
+      if (nwritten < 0)
+        {
+          if (nwritten != -EINTR)
+            {
+              ferr("ERROR: Write back failed: offset=%d errno=%d\n",
+                   (int)offset, (int)nwritten);
+              return (int)nwritten;
+            }
+
+          continue;
+        }
+
+      wrbuffer += nwritten;
+      offset   += nwritten;
+      length   -= nwritten;
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Name: rammmap
  *
@@ -101,11 +259,15 @@ void rammap_initialize(void)
  *   length  The length of the mapping.  For exception #1 above, this length
  *           ignored:  The entire underlying media is always accessible.
  *   offset  The offset into the file to map
+ *   prot    See the PROT_* definitions in sys/mman.h.
+ *   flags   See the MAP_* definitions in sys/mman.h.
  *
  * Returned Value:
  *   On success, rammmap() returns a pointer to the mapped area. On error, the
  *   value MAP_FAILED is returned, and errno is set  appropriately.
  *
+ *     EACCES
+ *       A writable MAP_SHARED mapping of a file not open for writing.
  *     EBADF
  *      'fd' is not a valid file descriptor.
  *     EINVAL
@@ -115,29 +277,122 @@ void rammap_initialize(void)
  *
  ****************************************************************************/
 
-FAR void *rammap(int fd, size_t length, off_t offset)
+FAR void *rammap(int fd, size_t length, off_t offset, int prot, int flags)
 {
+  FAR struct fs_mapping_s *mapping;
   FAR struct fs_rammap_s *map;
+  FAR struct file *filep;
   FAR uint8_t *alloc;
   FAR uint8_t *rdbuffer;
   ssize_t nread;
-  off_t fpos;
+  size_t remaining;
+  uint8_t mapflags;
   int errcode;
   int ret;
 
-  /* There is a major design flaw that I have not yet thought of fix for:
-   * The goal is to have a single region of memory that represents a single
-   * file and can be shared by many threads.  That is, given a filename a
-   * thread should be able to open the file, get a file descriptor, and
-   * call mmap() to get a memory region.  Different file descriptors opened
-   * with the same file path should get the same memory region when mapped.
-   *
-   * The design flaw is that I don't have sufficient knowledge to know that
-   * these different file descriptors map to the same file.  So, for the time
-   * being, a new memory region is created each time that rammap() is called.
-   * Not very useful!
+  if (offset < 0)
+    {
+      errcode = EINVAL;
+      goto errout;
+    }
+
+  ret = fs_getfilep(fd, &filep);
+  if (ret < 0)
+    {
+      errcode = -ret;
+      goto errout;
+    }
+
+  /* A writable private mapping must not see or cause the changes of any
+   * other mapping, so it always gets its own copy of the file.  Only
+   * writable shared mappings are written back.
    */
 
+  mapflags = 0;
+  if ((prot & PROT_WRITE) != 0)
+    {
+      if ((flags & MAP_SHARED) == 0)
+        {
+          mapflags = RAMMAP_EXCLUSIVE;
+        }
+      else if ((filep->f_oflags & O_WROK) == 0)
+        {
+          errcode = EACCES;
+          goto errout;
+        }
+      else
+        {
+          mapflags = RAMMAP_SHARED;
+        }
+    }
+
+  /* Each mapping is recorded separately so that munmap() can tell which
+   * parts of a region are still in use.
+   */
+
+  mapping = (FAR struct fs_mapping_s *)
+    kmm_malloc(sizeof(struct fs_mapping_s));
+  if (mapping == NULL)
+    {
+      errcode = ENOMEM;
+      goto errout;
+    }
+
+  mapping->length = length;
+
+  rammap_initialize();
+  ret = nxsem_wait(&g_rammaps.exclsem);
+  if (ret < 0)
+    {
+      errcode = -ret;
+      goto errout_with_mapping;
+    }
+
+  if (mapflags != RAMMAP_EXCLUSIVE)
+    {
+      for (map = g_rammaps.head; map; map = map->flink)
+        {
+          size_t start;
+          size_t gapend;
+
+          /* A writable, shared mapping needs a region that is written
+           * back.  Read-only mappings may use any region that is not
+           * exclusive.
+           */
+
+          if (map->file.f_inode != filep->f_inode ||
+              (map->flags & RAMMAP_EXCLUSIVE) != 0 ||
+              (mapflags != 0 && (map->flags & RAMMAP_SHARED) == 0) ||
+              offset < map->offset ||
+              offset - map->offset > map->length ||
+              length > map->length - (offset - map->offset))
+            {
+              continue;
+            }
+
+          /* Parts of the region that are no longer mapped were written
+           * back and may be stale now.  Only reuse memory that is still
+           * in use by other mappings.
+           */
+
+          start = offset - map->offset;
+          if (rammap_gap(map, NULL, start, start + length, &gapend) <
+              start + length)
+            {
+              continue;
+            }
+
+          map->crefs++;
+          mapping->region  = map;
+          mapping->addr    = (FAR uint8_t *)map->addr + start;
+          mapping->flink   = g_rammaps.mappings;
+          g_rammaps.mappings = mapping;
+
+          nxsem_post(&g_rammaps.exclsem);
+          return mapping->addr;
+        }
+    }
+
   /* Allocate a region of memory of the specified size */
 
   alloc = (FAR uint8_t *)kumm_malloc(sizeof(struct fs_rammap_s) + length);
@@ -145,7 +400,7 @@ FAR void *rammap(int fd, size_t length, off_t offset)
     {
       ferr("ERROR: Region allocation failed, length: %d\n", (int)length);
       errcode = ENOMEM;
-      goto errout;
+      goto errout_with_semaphore;
     }
 
   /* Initialize the region */
@@ -155,27 +410,30 @@ FAR void *rammap(int fd, size_t length, off_t offset)
   map->addr   = alloc + sizeof(struct fs_rammap_s);
   map->length = length;
   map->offset = offset;
+  map->crefs  = 1;
+  map->flags  = mapflags;
 
-  /* Seek to the specified file offset */
+  /* Keep a private reference to the file.  It identifies the file for
+   * later mappings and is used to write the region back.
+   */
 
-  fpos = lseek(fd, offset,  SEEK_SET);
-  if (fpos == (off_t)-1)
+  ret = file_dup2(filep, &map->file);
+  if (ret < 0)
     {
-      /* Seek failed... errno has already been set, but EINVAL is probably
-       * the correct response.
-       */
-
-      ferr("ERROR: Seek to position %d failed\n", (int)offset);
-      errcode = EINVAL;
+      errcode = -ret;
       goto errout_with_region;
     }
 
-  /* Read the file data into the memory region */
+  /* Read the file data into the memory region.  This does not change the
+   * file position of the caller.
+   */
 
-  rdbuffer = map->addr;
-  while (length > 0)
+  rdbuffer  = map->addr;
+  remaining = length;
+  while (remaining > 0)
     {
-      nread = nx_read(fd, rdbuffer, length);
+      nread = file_pread(&map->file, rdbuffer, remaining,
+                         offset + (rdbuffer - (FAR uint8_t *)map->addr));
       if (nread < 0)
         {
           /* Handle the special case where the read was interrupted by a
@@ -190,8 +448,10 @@ FAR void *rammap(int fd, size_t length, off_t offset)
                    (int)offset, (int)nread);
 
               errcode = (int)-nread;
-              goto errout_with_region;
+              goto errout_with_file;
             }
+
+          continue;
         }
 
       /* Check for end of file. */
@@ -203,33 +463,42 @@ FAR void *rammap(int fd, size_t length, off_t offset)
 
       /* Increment number of bytes read */
 
-      rdbuffer += nread;
-      length   -= nread;
+      rdbuffer  += nread;
+      remaining -= nread;
     }
 
   /* Zero any memory beyond the amount read from the file */
 
-  memset(rdbuffer, 0, length);
+  memset(rdbuffer, 0, remaining);
+  map->filelen = length - remaining;
 
-  /* Add the buffer to the list of regions */
-
-  rammap_initialize();
-  ret = nxsem_wait(&g_rammaps.exclsem);
-  if (ret < 0)
-    {
-      errcode = -ret;
-      goto errout_with_region;
-    }
+  /* Add the buffer to the list of regions and the mapping to the list of
+   * mappings.
+   */
 
   map->flink  = g_rammaps.head;
   g_rammaps.head = map;
 
+  mapping->region  = map;
+  mapping->addr    = map->addr;
+  mapping->flink   = g_rammaps.mappings;
+  g_rammaps.mappings = mapping;
+
   nxsem_post(&g_rammaps.exclsem);
   return map->addr;
 
+errout_with_file:
+  file_close(&map->file);
+
 errout_with_region:
   kumm_free(alloc);
 
+errout_with_semaphore:
+  nxsem_post(&g_rammaps.exclsem);
+
+errout_with_mapping:
+  kmm_free(mapping);
+
 errout:
   set_errno(errcode);
   return MAP_FAILED;
@@ -45,10 +45,23 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <nuttx/fs/fs.h>
 #include <nuttx/semaphore.h>
 
 #ifdef CONFIG_FS_RAMMAP
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Values of the fs_rammap_s flags field */
+
+#define RAMMAP_SHARED    (1 << 0)  /* Written back to the file (MAP_SHARED) */
+#define RAMMAP_EXCLUSIVE (1 << 1)  /* Not shared with other mappings */
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -62,12 +75,17 @@
  * This copied file has many of the properties of a standard memory mapped
  * file except:
  *
- * - All of the file must be present in memory.  This limits the size of
- *   files that may be memory mapped (especially on MCUs with no significant
- *   RAM resources).
- * - All mapped files are read-only.  You can write to the in-memory image,
- *   but the file contents will not change.
+ * - All of the mapped region must be present in memory.  This limits the
+ *   size of files that may be memory mapped (especially on MCUs with no
+ *   significant RAM resources).
+ * - Changes to a MAP_SHARED region reach the file only when msync() is
+ *   called or the region is unmapped.  Changes made with write() are not
+ *   seen by existing mappings.
  * - There are not access privileges.
+ *
+ * A region is shared by all mappings of the same file that fall inside of
+ * it, except for writable MAP_PRIVATE mappings which always get a copy of
+ * their own.
  */
 
 struct fs_rammap_s
@@ -76,6 +94,23 @@ struct fs_rammap_s
   FAR void           *addr;        /* Start of allocated memory */
   size_t              length;      /* Length of region */
   off_t               offset;      /* File offset */
+  size_t              filelen;     /* Length of region backed by the file */
+  struct file         file;        /* Mapped file, holds a reference */
+  uint16_t            crefs;       /* Number of mappings of the region */
+  uint8_t             flags;       /* See RAMMAP_* definitions */
+};
+
+/* This structure describes one live mapping:  The address range returned
+ * by one call to mmap(), less whatever munmap() has removed from it since.
+ * A partial munmap() may trim a mapping or split it in two.
+ */
+
+struct fs_mapping_s
+{
+  struct fs_mapping_s *flink;      /* Implements a singly linked list */
+  FAR struct fs_rammap_s *region;  /* The region holding the memory */
+  FAR void           *addr;        /* Start of the mapping */
+  size_t              length;      /* Length of the mapping */
 };
 
 /* This structure defines all "mapped" files */
@@ -85,6 +120,7 @@ struct fs_allmaps_s
   bool                initialized; /* True: This structure has been initialized */
   sem_t               exclsem;     /* Provides exclusive access the list */
   struct fs_rammap_s *head;        /* List of mapped files */
+  struct fs_mapping_s *mappings;   /* List of live mappings */
 };
 
 /****************************************************************************
@@ -126,11 +162,15 @@ void rammap_initialize(void);
  *   length  The length of the mapping.  For exception #1 above, this length
  *           ignored:  The entire underlying media is always accessible.
  *   offset  The offset into the file to map
+ *   prot    See the PROT_* definitions in sys/mman.h.
+ *   flags   See the MAP_* definitions in sys/mman.h.
  *
  * Returned Value:
  *   On success, rammmap() returns a pointer to the mapped area. On error, the
  *   value MAP_FAILED is returned, and errno is set  appropriately.
  *
+ *     EACCES
+ *       A writable MAP_SHARED mapping of a file not open for writing.
  *     EBADF
  *      'fd' is not a valid file descriptor.
  *     EINVAL
@@ -140,7 +180,70 @@ void rammap_initialize(void);
  *
  ****************************************************************************/
 
-FAR void *rammap(int fd, size_t length, off_t offset);
+FAR void *rammap(int fd, size_t length, off_t offset, int prot, int flags);
+
+/****************************************************************************
+ * Name: rammap_find
+ *
+ * Description:
+ *   Find the live mapping that contains an address.  The caller must hold
+ *   g_rammaps.exclsem.
+ *
+ * Input Parameters:
+ *   addr  - The address to look up
+ *   prevp - Location to return the preceding mapping in the list
+ *
+ * Returned Value:
+ *   The mapping or NULL if the address is not mapped.
+ *
+ ****************************************************************************/
+
+FAR struct fs_mapping_s *rammap_find(FAR const void *addr,
+                                     FAR struct fs_mapping_s **prevp);
+
+/****************************************************************************
+ * Name: rammap_gap
+ *
+ * Description:
+ *   Find the first part of a range of a region that is not covered by any
+ *   live mapping.  The caller must hold g_rammaps.exclsem.
+ *
+ * Input Parameters:
+ *   region  - The region
+ *   exclude - A mapping to ignore, or NULL
+ *   offset  - Start of the range, from the start of the region
+ *   end     - End of the range, from the start of the region
+ *   gapend  - Location to return the end of the gap
+ *
+ * Returned Value:
+ *   The start of the gap, or 'end' if the whole range is mapped.
+ *
+ ****************************************************************************/
+
+size_t rammap_gap(FAR struct fs_rammap_s *region,
+                  FAR struct fs_mapping_s *exclude, size_t offset,
+                  size_t end, FAR size_t *gapend);
+
+/****************************************************************************
+ * Name: rammap_writeback
+ *
+ * Description:
+ *   Write part of a MAP_SHARED region back to the file.  Nothing is written
+ *   for other regions or for the part of a region that lies beyond the end
+ *   of the file as it was when the region was mapped.
+ *
+ * Input Parameters:
+ *   map    - The region
+ *   offset - Offset of the data from the start of the region
+ *   length - Number of bytes to write back
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int rammap_writeback(FAR struct fs_rammap_s *map, size_t offset,
+                     size_t length);
 
 #endif /* CONFIG_FS_RAMMAP */
 #endif /* __FS_MMAP_RAMMAP_H */
@@ -185,6 +185,18 @@
 
 #define NXFFS_NERASED             128
 
+/* Inode lookup acceleration */
+
+#if defined(CONFIG_NXFFS_LOOKUP_INDEX) || defined(CONFIG_NXFFS_LOOKUP_FILTER)
+#  define NXFFS_HAVE_INDEX        1
+#endif
+
+/* Returned by nxffs_index_find() when the index cannot decide and the
+ * FLASH must be scanned.
+ */
+
+#define NXFFS_INDEX_SCAN          1
+
 /* Quasi-standard definitions */
 
 #ifndef MIN
@@ -284,6 +296,32 @@ struct nxffs_wrfile_s
   uint32_t                  crc;        /* Accumulated data block CRC */
 };
 
+/* The RAM inode index.  It is valid only if it describes every valid inode
+ * on the volume; otherwise it must be rebuilt by scanning the FLASH.
+ */
+
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+struct nxffs_ientry_s
+{
+  off_t                     hoffset;    /* FLASH offset to the inode header */
+  uint32_t                  hash;       /* Hash of the inode name */
+};
+
+struct nxffs_index_s
+{
+  FAR struct nxffs_ientry_s *entries;   /* Entries in FLASH offset order */
+  uint16_t                  nentries;   /* Number of entries in use */
+  uint16_t                  nalloc;     /* Number of entries allocated */
+  bool                      valid;      /* True: Index is complete */
+};
+#elif defined(CONFIG_NXFFS_LOOKUP_FILTER)
+struct nxffs_index_s
+{
+  uint8_t                   bits[(CONFIG_NXFFS_FILTER_NBITS + 7) / 8];
+  bool                      valid;      /* True: Filter holds every name */
+};
+#endif
+
 /* This structure represents the overall state of on NXFFS instance. */
 
 struct nxffs_volume_s
@@ -302,6 +340,9 @@ struct nxffs_volume_s
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
+#ifdef NXFFS_HAVE_INDEX
+  struct nxffs_index_s      index;     /* Accelerates inode lookup by name */
+#endif
 };
 
 /* This structure describes the state of the blocks on the NXFFS volume */
@@ -640,6 +681,93 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
 int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
                     FAR struct nxffs_entry_s *entry);
 
+/****************************************************************************
+ * Name: nxffs_index_reset, nxffs_index_invalidate, and nxffs_index_release
+ *
+ * Description:
+ *   nxffs_index_reset() empties the inode index and marks it valid.  The
+ *   caller must then add every valid inode on the volume, as nxffs_limits()
+ *   does while it scans the volume at mount time.
+ *
+ *   nxffs_index_invalidate() discards the index when inodes may have moved
+ *   (packing or reformatting).  It is rebuilt by the next lookup.
+ *
+ *   nxffs_index_release() also frees the memory held by the index.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef NXFFS_HAVE_INDEX
+void nxffs_index_reset(FAR struct nxffs_volume_s *volume);
+void nxffs_index_invalidate(FAR struct nxffs_volume_s *volume);
+void nxffs_index_release(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_index_reset(v)
+#  define nxffs_index_invalidate(v)
+#  define nxffs_index_release(v)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_index_add and nxffs_index_remove
+ *
+ * Description:
+ *   Record that a valid inode header was written at 'hoffset', or that the
+ *   inode header at 'hoffset' was marked deleted.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   name    - The name of the inode
+ *   hoffset - FLASH offset to the inode header
+ *
+ * Returned Value:
+ *   None.  If memory cannot be allocated, the index is invalidated.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef NXFFS_HAVE_INDEX
+void nxffs_index_add(FAR struct nxffs_volume_s *volume,
+                     FAR const char *name, off_t hoffset);
+void nxffs_index_remove(FAR struct nxffs_volume_s *volume, off_t hoffset);
+#else
+#  define nxffs_index_add(v,n,o)
+#  define nxffs_index_remove(v,o)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_index_find
+ *
+ * Description:
+ *   Use the index to find the inode with the provided name.  Called only
+ *   from nxffs_findinode().
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   name   - The name of the inode to find
+ *   entry  - The location to return information about the inode.
+ *
+ * Returned Value:
+ *   Zero if the inode was found, -ENOENT if it does not exist, or
+ *   NXFFS_INDEX_SCAN if the FLASH must be scanned to find out.  Other
+ *   negated errno values report a failure to read the FLASH.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef NXFFS_HAVE_INDEX
+int nxffs_index_find(FAR struct nxffs_volume_s *volume, FAR const char *name,
+                     FAR struct nxffs_entry_s *entry);
+#endif
+
 /****************************************************************************
  * Name: nxffs_inodeend
  *
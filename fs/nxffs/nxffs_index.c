@@ -0,0 +1,418 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_index.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+
+#include "nxffs.h"
+
+#ifdef NXFFS_HAVE_INDEX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Number of index entries added when the table is grown */
+
+#define NXFFS_INDEX_INCR 16
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_index_hash
+ *
+ * Description:
+ *   Hash an inode name (FNV-1a).
+ *
+ ****************************************************************************/
+
+static uint32_t nxffs_index_hash(FAR const char *name)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*name != '\0')
+    {
+      hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+
+  return hash;
+}
+
+#ifdef CONFIG_NXFFS_LOOKUP_FILTER
+/****************************************************************************
+ * Name: nxffs_filter_bit1 and nxffs_filter_bit2
+ *
+ * Description:
+ *   The two filter bits that are set for a name hash.
+ *
+ ****************************************************************************/
+
+static inline unsigned int nxffs_filter_bit1(uint32_t hash)
+{
+  return hash % CONFIG_NXFFS_FILTER_NBITS;
+}
+
+static inline unsigned int nxffs_filter_bit2(uint32_t hash)
+{
+  return ((hash >> 16) | (hash << 16)) % CONFIG_NXFFS_FILTER_NBITS;
+}
+
+/****************************************************************************
+ * Name: nxffs_filter_add
+ *
+ * Description:
+ *   Set the filter bits of a name hash.
+ *
+ ****************************************************************************/
+
+static void nxffs_filter_add(FAR struct nxffs_index_s *index, uint32_t hash)
+{
+  unsigned int bit1 = nxffs_filter_bit1(hash);
+  unsigned int bit2 = nxffs_filter_bit2(hash);
+
+  index->bits[bit1 >> 3] |= 1 << (bit1 & 7);
+  index->bits[bit2 >> 3] |= 1 << (bit2 & 7);
+}
+
+/****************************************************************************
+ * Name: nxffs_filter_find
+ *
+ * Description:
+ *   Return -ENOENT if the name is certainly not on the volume, otherwise
+ *   NXFFS_INDEX_SCAN.
+ *
+ ****************************************************************************/
+
+static int nxffs_filter_find(FAR struct nxffs_index_s *index, uint32_t hash)
+{
+  unsigned int bit1 = nxffs_filter_bit1(hash);
+  unsigned int bit2 = nxffs_filter_bit2(hash);
+
+  if ((index->bits[bit1 >> 3] & (1 << (bit1 & 7))) == 0 ||
+      (index->bits[bit2 >> 3] & (1 << (bit2 & 7))) == 0)
+    {
+      return -ENOENT;
+    }
+
+  return NXFFS_INDEX_SCAN;
+}
+#endif
+
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+/****************************************************************************
+ * Name: nxffs_table_add
+ *
+ * Description:
+ *   Insert an inode in the index table, growing the table if necessary.
+ *   The index is invalidated if the table cannot be grown.
+ *
+ ****************************************************************************/
+
+static void nxffs_table_add(FAR struct nxffs_volume_s *volume,
+                            uint32_t hash, off_t hoffset)
+{
+  FAR struct nxffs_index_s *index = &volume->index;
+  FAR struct nxffs_ientry_s *entries;
+  int i;
+
+  if (index->nentries >= index->nalloc)
+    {
+      if (index->nalloc > UINT16_MAX - NXFFS_INDEX_INCR)
+        {
+          nxffs_index_invalidate(volume);
+          return;
+        }
+
+      entries = (FAR struct nxffs_ientry_s *)
+        kmm_realloc(index->entries, (index->nalloc + NXFFS_INDEX_INCR) *
+                                    sizeof(struct nxffs_ientry_s));
+      if (entries == NULL)
+        {
+          /* Fall back to scanning the FLASH until the next rebuild */
+
+          ferr("ERROR: Failed to grow the inode index\n");
+          nxffs_index_invalidate(volume);
+          return;
+        }
+
+      index->entries = entries;
+      index->nalloc += NXFFS_INDEX_INCR;
+    }
+
+  /* New inodes are normally written at the end of the volume, so keep the
+   * table in FLASH offset order with a short search from the end.
+   */
+
+  for (i = index->nentries;
+       i > 0 && index->entries[i - 1].hoffset > hoffset;
+       i--)
+    {
+      index->entries[i] = index->entries[i - 1];
+    }
+
+  index->entries[i].hoffset = hoffset;
+  index->entries[i].hash    = hash;
+  index->nentries++;
+}
+
+/****************************************************************************
+ * Name: nxffs_table_find
+ *
+ * Description:
+ *   Look up a name in the index table.  Returns OK with the inode entry,
+ *   -ENOENT if the name is not on the volume, NXFFS_INDEX_SCAN if the
+ *   index turned out to be stale, or another negated errno value on a
+ *   FLASH read failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_table_find(FAR struct nxffs_volume_s *volume,
+                            FAR const char *name, uint32_t hash,
+                            FAR struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_index_s *index = &volume->index;
+  FAR struct nxffs_ientry_s *ientry;
+  int ret;
+  int i;
+
+  for (i = 0; i < index->nentries; i++)
+    {
+      ientry = &index->entries[i];
+      if (ientry->hash != hash)
+        {
+          continue;
+        }
+
+      /* The header at this offset must be the valid inode that was
+       * indexed.  Otherwise, the index is stale.
+       */
+
+      ret = nxffs_nextentry(volume, ientry->hoffset, entry);
+      if (ret < 0 && ret != -ENOENT && ret != -ENOSPC)
+        {
+          return ret;
+        }
+
+      if (ret < 0 || entry->hoffset != ientry->hoffset)
+        {
+          ferr("ERROR: Stale index entry at %ld\n", (long)ientry->hoffset);
+          if (ret == OK)
+            {
+              nxffs_freeentry(entry);
+            }
+
+          nxffs_index_invalidate(volume);
+          return NXFFS_INDEX_SCAN;
+        }
+
+      if (strcmp(name, entry->name) == 0)
+        {
+          return OK;
+        }
+
+      nxffs_freeentry(entry);
+    }
+
+  return -ENOENT;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxffs_index_build
+ *
+ * Description:
+ *   Rebuild the index by scanning all inodes on the volume.
+ *
+ ****************************************************************************/
+
+static int nxffs_index_build(FAR struct nxffs_volume_s *volume)
+{
+  struct nxffs_entry_s entry;
+  off_t offset;
+  int ret;
+
+  nxffs_index_reset(volume);
+
+  for (offset = volume->inoffset; ; )
+    {
+      ret = nxffs_nextentry(volume, offset, &entry);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      nxffs_index_add(volume, entry.name, entry.hoffset);
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+    }
+
+  /* -ENOENT and -ENOSPC just mean that the end of the data was reached */
+
+  if (ret != -ENOENT && ret != -ENOSPC)
+    {
+      nxffs_index_invalidate(volume);
+      return ret;
+    }
+
+  return volume->index.valid ? OK : -ENOMEM;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_index_reset
+ ****************************************************************************/
+
+void nxffs_index_reset(FAR struct nxffs_volume_s *volume)
+{
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  volume->index.nentries = 0;
+#else
+  memset(volume->index.bits, 0, sizeof(volume->index.bits));
+#endif
+  volume->index.valid = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_invalidate
+ ****************************************************************************/
+
+void nxffs_index_invalidate(FAR struct nxffs_volume_s *volume)
+{
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  volume->index.nentries = 0;
+#endif
+  volume->index.valid = false;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_release
+ ****************************************************************************/
+
+void nxffs_index_release(FAR struct nxffs_volume_s *volume)
+{
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  if (volume->index.entries != NULL)
+    {
+      kmm_free(volume->index.entries);
+      volume->index.entries = NULL;
+      volume->index.nalloc  = 0;
+    }
+#endif
+
+  nxffs_index_invalidate(volume);
+}
+
+/****************************************************************************
+ * Name: nxffs_index_add
+ ****************************************************************************/
+
+void nxffs_index_add(FAR struct nxffs_volume_s *volume,
+                     FAR const char *name, off_t hoffset)
+{
+  FAR struct nxffs_index_s *index = &volume->index;
+  uint32_t hash;
+
+  if (!index->valid)
+    {
+      return;
+    }
+
+  hash = nxffs_index_hash(name);
+
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  nxffs_table_add(volume, hash, hoffset);
+#else
+  nxffs_filter_add(index, hash);
+#endif
+}
+
+/****************************************************************************
+ * Name: nxffs_index_remove
+ ****************************************************************************/
+
+void nxffs_index_remove(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  FAR struct nxffs_index_s *index = &volume->index;
+  int i;
+
+  for (i = 0; i < index->nentries; i++)
+    {
+      if (index->entries[i].hoffset == hoffset)
+        {
+          index->nentries--;
+          memmove(&index->entries[i], &index->entries[i + 1],
+                  (index->nentries - i) * sizeof(struct nxffs_ientry_s));
+          return;
+        }
+    }
+#endif
+
+  /* Bits cannot be removed from the filter.  The name remains a (harmless)
+   * false positive until the filter is rebuilt.
+   */
+}
+
+/****************************************************************************
+ * Name: nxffs_index_find
+ ****************************************************************************/
+
+int nxffs_index_find(FAR struct nxffs_volume_s *volume, FAR const char *name,
+                     FAR struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_index_s *index = &volume->index;
+  uint32_t hash;
+  int ret;
+
+  if (!index->valid)
+    {
+      ret = nxffs_index_build(volume);
+      if (ret < 0)
+        {
+          finfo("Index rebuild failed: %d\n", -ret);
+          return NXFFS_INDEX_SCAN;
+        }
+    }
+
+  hash = nxffs_index_hash(name);
+
+#ifdef CONFIG_NXFFS_LOOKUP_INDEX
+  return nxffs_table_find(volume, name, hash, entry);
+#else
+  return nxffs_filter_find(index, hash);
+#endif
+}
+
+#endif /* NXFFS_HAVE_INDEX */
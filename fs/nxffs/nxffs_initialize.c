@@ -313,6 +313,7 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   ferr("ERROR: Failed to calculate file system limits: %d\n", -ret);
 
 errout_with_buffer:
+  nxffs_index_release(volume);
   kmm_free(volume->pack);
 errout_with_cache:
   kmm_free(volume->cache);
@@ -357,6 +358,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
   int nerased;
   int ret;
 
+  /* The inode index is rebuilt from the inodes found by this scan */
+
+  nxffs_index_reset(volume);
+
   /* Get the offset to the first valid block on the FLASH */
 
   block = 0;
@@ -399,6 +404,7 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
 
       volume->inoffset = entry.hoffset;
       finfo("First inode at offset %d\n", volume->inoffset);
+      nxffs_index_add(volume, entry.name, entry.hoffset);
 
       /* Discard this entry and set the next offset. */
 
@@ -410,14 +416,25 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
 
   if (!noinodes)
     {
-      while (nxffs_nextentry(volume, offset, &entry) == OK)
+      while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK)
         {
+          nxffs_index_add(volume, entry.name, entry.hoffset);
+
           /* Discard the entry and guess the next offset. */
 
           offset = nxffs_inodeend(volume, &entry);
           nxffs_freeentry(&entry);
         }
 
+      /* Any failure other than reaching the end of the data means that some
+       * inodes may have been missed.
+       */
+
+      if (ret != -ENOENT && ret != -ENOSPC)
+        {
+          nxffs_index_invalidate(volume);
+        }
+
       finfo("Last inode before offset %d\n", offset);
     }
 
@@ -378,6 +378,16 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
   off_t offset;
   int ret;
 
+#ifdef NXFFS_HAVE_INDEX
+  /* Let the index answer if it can */
+
+  ret = nxffs_index_find(volume, name, entry);
+  if (ret != NXFFS_INDEX_SCAN)
+    {
+      return ret;
+    }
+#endif
+
   /* Start with the first valid inode that was discovered when the volume
    * was created (or modified after the last file system re-packing).
    */
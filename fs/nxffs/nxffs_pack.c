@@ -1278,6 +1278,10 @@ int nxffs_pack(FAR struct nxffs_volume_s *volume)
   int i;
   int ret = OK;
 
+  /* Inodes are about to move.  The index is rebuilt by the next lookup. */
+
+  nxffs_index_invalidate(volume);
+
   /* Get the offset to the first valid inode entry */
 
   wrfile = NULL;
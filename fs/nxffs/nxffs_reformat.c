@@ -281,6 +281,10 @@ int nxffs_reformat(FAR struct nxffs_volume_s *volume)
 {
   int ret;
 
+  /* Any inodes known to the index are about to be erased */
+
+  nxffs_index_invalidate(volume);
+
   /* Erase and reformat the entire volume */
 
   ret = nxffs_format(volume);
@@ -275,6 +275,11 @@ static ssize_t iobinfo_read(FAR struct file *filep, FAR char *buffer,
 {
   FAR struct iobinfo_file_s *iobfile;
   FAR struct iob_userstats_s *userstats;
+#ifdef CONFIG_IOB_PERCPU_CACHE
+  struct iob_cachestats_s cachestats;
+  unsigned long nallocs;
+  unsigned long hitrate;
+#endif
   size_t linesize;
   size_t copysize;
   size_t totalsize;
@@ -352,6 +357,67 @@ static ssize_t iobinfo_read(FAR struct file *filep, FAR char *buffer,
       totalsize += copysize;
     }
 
+#ifdef CONFIG_IOB_PERCPU_CACHE
+  /* Then the statistics of each per-CPU cache */
+
+  if (totalsize < buflen)
+    {
+      buffer    += copysize;
+      buflen    -= copysize;
+
+      linesize   = snprintf(iobfile->line, IOBINFO_LINELEN,
+                            "\n%-8s%12s%12s%12s%12s%6s\n",
+                            "CACHE", "HITS", "MISSES", "FREES", "SPILLS",
+                            "HIT%");
+
+      copysize   = procfs_memcpy(iobfile->line, linesize, buffer, buflen,
+                                 &offset);
+      totalsize += copysize;
+    }
+
+  for (i = 0; iob_getcachestats(i, &cachestats) >= 0; i++)
+    {
+      if (totalsize < buflen)
+        {
+          buffer    += copysize;
+          buflen    -= copysize;
+
+          /* Avoid overflow of hits * 100 without 64-bit arithmetic */
+
+          nallocs    = (unsigned long)cachestats.hits + cachestats.misses;
+          if (nallocs >= 100)
+            {
+              hitrate = cachestats.hits / (nallocs / 100);
+            }
+          else if (nallocs > 0)
+            {
+              hitrate = (cachestats.hits * 100) / nallocs;
+            }
+          else
+            {
+              hitrate = 0;
+            }
+
+          if (hitrate > 100)
+            {
+              hitrate = 100;
+            }
+
+          linesize   = snprintf(iobfile->line, IOBINFO_LINELEN,
+                                "cpu%-5d%12lu%12lu%12lu%12lu%5lu%%\n", i,
+                                (unsigned long)cachestats.hits,
+                                (unsigned long)cachestats.misses,
+                                (unsigned long)cachestats.frees,
+                                (unsigned long)cachestats.spills,
+                                hitrate);
+
+          copysize   = procfs_memcpy(iobfile->line, linesize, buffer, buflen,
+                                     &offset);
+          totalsize += copysize;
+        }
+    }
+#endif
+
   /* Update the file offset */
 
   filep->f_pos += totalsize;
@@ -66,10 +66,6 @@
 #  warning CONFIG_FS_TMPFS_DIRECTORY_FREEGUARD needs to be > ALLOCGUARD
 #endif
 
-#if CONFIG_FS_TMPFS_FILE_FREEGUARD <= CONFIG_FS_TMPFS_FILE_ALLOCGUARD
-#  warning CONFIG_FS_TMPFS_FILE_FREEGUARD needs to be > ALLOCGUARD
-#endif
-
 #define tmpfs_lock_file(tfo) \
            (tmpfs_lock_object((FAR struct tmpfs_object_s *)tfo))
 #define tmpfs_lock_directory(tdo) \
@@ -93,8 +89,9 @@ static void tmpfs_lock_object(FAR struct tmpfs_object_s *to);
 static void tmpfs_unlock_object(FAR struct tmpfs_object_s *to);
 static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s **tdo,
               unsigned int nentries);
-static int  tmpfs_realloc_file(FAR struct tmpfs_file_s **tfo,
+static int  tmpfs_resize_file(FAR struct tmpfs_file_s *tfo,
               size_t newsize);
+static void tmpfs_free_file(FAR struct tmpfs_file_s *tfo);
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_find_dirent(FAR struct tmpfs_directory_s *tdo,
@@ -360,72 +357,118 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s **tdo,
 }
 
 /****************************************************************************
- * Name: tmpfs_realloc_file
+ * Name: tmpfs_resize_file
+ *
+ * Description:
+ *   Change the size of the file.  Growing the file only grows the table of
+ *   chunks; the chunks themselves are allocated when data is written to
+ *   them.  Shrinking the file frees the chunks beyond the new end of the
+ *   file and zeroes the tail of the new last chunk.
+ *
  ****************************************************************************/
 
-static int tmpfs_realloc_file(FAR struct tmpfs_file_s **tfo,
-                              size_t newsize)
+static int tmpfs_resize_file(FAR struct tmpfs_file_s *tfo,
+                             size_t newsize)
 {
-  FAR struct tmpfs_file_s *oldtfo = *tfo;
-  FAR struct tmpfs_file_s *newtfo;
-  size_t objsize;
-  size_t allocsize;
-  size_t delta;
+  FAR uint8_t **newtable;
+  unsigned int nchunks;
+  unsigned int ntable;
+  unsigned int i;
+  size_t offset;
 
-  /* Check if the current allocation is sufficient */
+  nchunks = (newsize + TMPFS_CHUNKSIZE - 1) / TMPFS_CHUNKSIZE;
 
-  objsize = SIZEOF_TMPFS_FILE(newsize);
+  if (nchunks > tfo->tfo_ntable)
+    {
+      /* Double the size of the table to keep the number of reallocations
+       * low for a file that keeps growing.  The table is small compared to
+       * the data that it refers to.
+       */
 
-  /* Are we growing or shrinking the object? */
+      ntable = tfo->tfo_ntable < 4 ? 4 : 2 * tfo->tfo_ntable;
+      if (ntable < nchunks)
+        {
+          ntable = nchunks;
+        }
 
-  if (objsize <= oldtfo->tfo_alloc)
+      newtable = (FAR uint8_t **)
+        kmm_realloc(tfo->tfo_chunks, ntable * sizeof(FAR uint8_t *));
+      if (newtable == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      memset(&newtable[tfo->tfo_ntable], 0,
+             (ntable - tfo->tfo_ntable) * sizeof(FAR uint8_t *));
+
+      tfo->tfo_alloc += (ntable - tfo->tfo_ntable) * sizeof(FAR uint8_t *);
+      tfo->tfo_chunks = newtable;
+      tfo->tfo_ntable = ntable;
+    }
+  else if (newsize < tfo->tfo_size)
     {
-      /* Shrinking ... Shrink unconditionally if the size is shrinking to
-       * zero.
+      /* Free the chunks beyond the new end of the file */
+
+      for (i = nchunks; i < tfo->tfo_nchunks; i++)
+        {
+          if (tfo->tfo_chunks[i] != NULL)
+            {
+              kmm_free(tfo->tfo_chunks[i]);
+              tfo->tfo_chunks[i] = NULL;
+              tfo->tfo_alloc    -= TMPFS_CHUNKSIZE;
+            }
+        }
+
+      /* Zero the tail of the last chunk so that the file reads back zeroes
+       * if it grows again.
        */
 
-      if (newsize > 0)
+      offset = newsize % TMPFS_CHUNKSIZE;
+      if (offset != 0 && tfo->tfo_chunks[nchunks - 1] != NULL)
         {
-          /* Otherwise, don't realloc unless the object has shrunk by a
-           * lot.
-           */
+          memset(tfo->tfo_chunks[nchunks - 1] + offset, 0,
+                 TMPFS_CHUNKSIZE - offset);
+        }
 
-          delta = oldtfo->tfo_alloc - objsize;
-          if (delta <= CONFIG_FS_TMPFS_FILE_FREEGUARD)
-            {
-              /* Hasn't shrunk enough.. Return doing nothing for now */
+      /* Release the table when the file becomes empty */
 
-              oldtfo->tfo_size = newsize;
-              return OK;
-            }
+      if (nchunks == 0)
+        {
+          kmm_free(tfo->tfo_chunks);
+          tfo->tfo_alloc -= tfo->tfo_ntable * sizeof(FAR uint8_t *);
+          tfo->tfo_chunks = NULL;
+          tfo->tfo_ntable = 0;
         }
     }
 
-  /* Added some additional amount to the new size to account frequent
-   * reallocations.
-   */
+  tfo->tfo_nchunks = nchunks;
+  tfo->tfo_size    = newsize;
+  return OK;
+}
 
-  allocsize = objsize + CONFIG_FS_TMPFS_FILE_ALLOCGUARD;
+/****************************************************************************
+ * Name: tmpfs_free_file
+ ****************************************************************************/
 
-  /* Realloc the file object */
+static void tmpfs_free_file(FAR struct tmpfs_file_s *tfo)
+{
+  unsigned int i;
 
-  newtfo = (FAR struct tmpfs_file_s *)kmm_realloc(oldtfo, allocsize);
-  if (newtfo == NULL)
+  for (i = 0; i < tfo->tfo_nchunks; i++)
     {
-      return -ENOMEM;
+      if (tfo->tfo_chunks[i] != NULL)
+        {
+          kmm_free(tfo->tfo_chunks[i]);
+        }
     }
 
-  /* Adjust the reference in the parent directory entry */
-
-  DEBUGASSERT(newtfo->tfo_dirent);
-  newtfo->tfo_dirent->tde_object = (FAR struct tmpfs_object_s *)newtfo;
-
-  /* Return the new address of the reallocated file object */
+  if (tfo->tfo_chunks != NULL)
+    {
+      kmm_free(tfo->tfo_chunks);
+    }
 
-  newtfo->tfo_alloc = allocsize;
-  newtfo->tfo_size  = newsize;
-  *tfo              = newtfo;
-  return OK;
+  nxsem_destroy(&tfo->tfo_exclsem.ts_sem);
+  kmm_free(tfo);
 }
 
 /****************************************************************************
@@ -463,8 +506,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
 
   if (tfo->tfo_refs == 1 && (tfo->tfo_flags & TFO_FLAG_UNLINKED) != 0)
     {
-      nxsem_destroy(&tfo->tfo_exclsem.ts_sem);
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
     }
 
   /* Otherwise, just decrement the reference count on the file object */
@@ -610,12 +652,12 @@ static int tmpfs_add_dirent(FAR struct tmpfs_directory_s **tdo,
 static FAR struct tmpfs_file_s *tmpfs_alloc_file(void)
 {
   FAR struct tmpfs_file_s *tfo;
-  size_t allocsize;
 
-  /* Create a new zero length file object */
+  /* Create a new zero length file object.  No data chunks are allocated
+   * until the file is written.
+   */
 
-  allocsize = SIZEOF_TMPFS_FILE(CONFIG_FS_TMPFS_FILE_ALLOCGUARD);
-  tfo = (FAR struct tmpfs_file_s *)kmm_malloc(allocsize);
+  tfo = (FAR struct tmpfs_file_s *)kmm_malloc(sizeof(struct tmpfs_file_s));
   if (tfo == NULL)
     {
       return NULL;
@@ -625,11 +667,14 @@ static FAR struct tmpfs_file_s *tmpfs_alloc_file(void)
    * locked with one reference count.
    */
 
-  tfo->tfo_alloc = allocsize;
-  tfo->tfo_type  = TMPFS_REGULAR;
-  tfo->tfo_refs  = 1;
-  tfo->tfo_flags = 0;
-  tfo->tfo_size  = 0;
+  tfo->tfo_alloc   = sizeof(struct tmpfs_file_s);
+  tfo->tfo_type    = TMPFS_REGULAR;
+  tfo->tfo_refs    = 1;
+  tfo->tfo_flags   = 0;
+  tfo->tfo_size    = 0;
+  tfo->tfo_nchunks = 0;
+  tfo->tfo_ntable  = 0;
+  tfo->tfo_chunks  = NULL;
 
   tfo->tfo_exclsem.ts_holder = getpid();
   tfo->tfo_exclsem.ts_count  = 1;
@@ -745,8 +790,7 @@ static int tmpfs_create_file(FAR struct tmpfs_s *fs,
   /* Error exits */
 
 errout_with_file:
-  nxsem_destroy(&newtfo->tfo_exclsem.ts_sem);
-  kmm_free(newtfo);
+  tmpfs_free_file(newtfo);
 
 errout_with_parent:
   parent->tdo_refs--;
@@ -1267,8 +1311,16 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
 
   /* Free the object now */
 
-  nxsem_destroy(&to->to_exclsem.ts_sem);
-  kmm_free(to);
+  if (to->to_type == TMPFS_REGULAR)
+    {
+      tmpfs_free_file((FAR struct tmpfs_file_s *)to);
+    }
+  else
+    {
+      nxsem_destroy(&to->to_exclsem.ts_sem);
+      kmm_free(to);
+    }
+
   return TMPFS_DELETED;
 }
 
@@ -1420,7 +1472,7 @@ static int tmpfs_open(FAR struct file *filep, FAR const char *relpath,
 
           if (tfo->tfo_size > 0)
             {
-              ret = tmpfs_realloc_file(&tfo, 0);
+              ret = tmpfs_resize_file(tfo, 0);
               if (ret < 0)
                 {
                   goto errout_with_filelock;
@@ -1535,7 +1587,7 @@ static int tmpfs_close(FAR struct file *filep)
        * have any other references.
        */
 
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
       return OK;
     }
 
@@ -1553,9 +1605,13 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
                           size_t buflen)
 {
   FAR struct tmpfs_file_s *tfo;
+  FAR uint8_t *chunk;
   ssize_t nread;
   off_t startpos;
   off_t endpos;
+  off_t pos;
+  size_t offset;
+  size_t ncopy;
 
   finfo("filep: %p buffer: %p buflen: %lu\n",
         filep, buffer, (unsigned long)buflen);
@@ -1575,15 +1631,41 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
   nread    = buflen;
   endpos   = startpos + buflen;
 
-  if (endpos > tfo->tfo_size)
+  if (startpos >= tfo->tfo_size)
+    {
+      endpos = startpos;
+      nread  = 0;
+    }
+  else if (endpos > tfo->tfo_size)
     {
       endpos = tfo->tfo_size;
       nread  = endpos - startpos;
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the memory object to the user buffer, one chunk at a
+   * time.
+   */
+
+  for (pos = startpos; pos < endpos; pos += ncopy, buffer += ncopy)
+    {
+      offset = pos % TMPFS_CHUNKSIZE;
+      ncopy  = TMPFS_CHUNKSIZE - offset;
+      if (ncopy > endpos - pos)
+        {
+          ncopy = endpos - pos;
+        }
+
+      chunk = tfo->tfo_chunks[pos / TMPFS_CHUNKSIZE];
+      if (chunk != NULL)
+        {
+          memcpy(buffer, chunk + offset, ncopy);
+        }
+      else
+        {
+          memset(buffer, 0, ncopy);
+        }
+    }
 
-  memcpy(buffer, &tfo->tfo_data[startpos], nread);
   filep->f_pos += nread;
 
   /* Release the lock on the file */
@@ -1600,9 +1682,14 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
                            size_t buflen)
 {
   FAR struct tmpfs_file_s *tfo;
+  FAR uint8_t **chunkp;
   ssize_t nwritten;
   off_t startpos;
   off_t endpos;
+  off_t pos;
+  size_t oldsize;
+  size_t offset;
+  size_t ncopy;
   int ret;
 
   finfo("filep: %p buffer: %p buflen: %lu\n",
@@ -1620,25 +1707,70 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
   /* Handle attempts to write beyond the end of the file */
 
   startpos = filep->f_pos;
-  nwritten = buflen;
   endpos   = startpos + buflen;
+  oldsize  = tfo->tfo_size;
 
   if (endpos > tfo->tfo_size)
     {
-      /* Reallocate the file to handle the write past the end of the file. */
+      /* Extend the file to handle the write past the end of the file. */
 
-      ret = tmpfs_realloc_file(&tfo, (size_t)endpos);
+      ret = tmpfs_resize_file(tfo, (size_t)endpos);
       if (ret < 0)
         {
           goto errout_with_lock;
         }
+    }
+
+  /* Copy data from the user buffer to the memory object, one chunk at a
+   * time, allocating the chunks that have not been written before.
+   */
+
+  for (pos = startpos; pos < endpos; pos += ncopy, buffer += ncopy)
+    {
+      offset = pos % TMPFS_CHUNKSIZE;
+      ncopy  = TMPFS_CHUNKSIZE - offset;
+      if (ncopy > endpos - pos)
+        {
+          ncopy = endpos - pos;
+        }
+
+      chunkp = &tfo->tfo_chunks[pos / TMPFS_CHUNKSIZE];
+      if (*chunkp == NULL)
+        {
+          *chunkp = (FAR uint8_t *)kmm_malloc(TMPFS_CHUNKSIZE);
+          if (*chunkp == NULL)
+            {
+              break;
+            }
+
+          tfo->tfo_alloc += TMPFS_CHUNKSIZE;
+
+          /* Zero the parts of the new chunk that are not written */
+
+          memset(*chunkp, 0, offset);
+          memset(*chunkp + offset + ncopy, 0,
+                 TMPFS_CHUNKSIZE - offset - ncopy);
+        }
 
-      filep->f_priv = tfo;
+      memcpy(*chunkp + offset, buffer, ncopy);
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Out of memory?  Then report a short write, or the failure if nothing
+   * was written, and trim the file to what was really written.
+   */
+
+  nwritten = pos - startpos;
+  if (pos < endpos)
+    {
+      tmpfs_resize_file(tfo, nwritten > 0 && pos > oldsize ?
+                             (size_t)pos : oldsize);
+      if (nwritten == 0)
+        {
+          ret = -ENOMEM;
+          goto errout_with_lock;
+        }
+    }
 
-  memcpy(&tfo->tfo_data[startpos], buffer, nwritten);
   filep->f_pos += nwritten;
 
   /* Release the lock on the file */
@@ -1729,15 +1861,18 @@ static int tmpfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
   DEBUGASSERT(tfo != NULL);
 
-  /* Only one ioctl command is supported */
+  /* Only one ioctl command is supported.  The file data is contiguous in
+   * memory only if the file fits into one chunk.
+   */
 
-  if (cmd == FIOC_MMAP && ppv != NULL)
+  if (cmd == FIOC_MMAP && ppv != NULL && tfo->tfo_nchunks == 1 &&
+      tfo->tfo_chunks[0] != NULL)
     {
       /* Return the address on the media corresponding to the start of
        * the file.
        */
 
-      *ppv = (FAR void *)tfo->tfo_data;
+      *ppv = (FAR void *)tfo->tfo_chunks[0];
       return OK;
     }
 
@@ -1840,31 +1975,16 @@ static int tmpfs_truncate(FAR struct file *filep, off_t length)
   oldsize = tfo->tfo_size;
   if (oldsize != length)
     {
-      /* The size is changing.. up or down.  Reallocate the file memory. */
-
-      ret = tmpfs_realloc_file(&tfo, (size_t)length);
-      if (ret < 0)
-        {
-          goto errout_with_lock;
-        }
-
-      filep->f_priv = tfo;
-
-      /* If the size has increased, then we need to zero the newly added
-       * memory.
+      /* The size is changing.. up or down.  Chunks beyond the end of the
+       * file are freed.  The newly added part of a growing file reads as
+       * zeroes without allocating memory.
        */
 
-      if (length > oldsize)
-        {
-          memset(&tfo->tfo_data[oldsize], 0, length - oldsize);
-        }
-
-      ret = OK;
+      ret = tmpfs_resize_file(tfo, (size_t)length);
     }
 
   /* Release the lock on the file */
 
-errout_with_lock:
   tmpfs_unlock_file(tfo);
   return ret;
 }
@@ -2267,8 +2387,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
 
   else
     {
-      nxsem_destroy(&tfo->tfo_exclsem.ts_sem);
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
     }
 
   /* Release the reference and lock on the parent directory */
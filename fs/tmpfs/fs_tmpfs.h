@@ -58,6 +58,14 @@
 
 #define TFO_FLAG_UNLINKED (1 << 0)  /* Bit 0: File is unlinked */
 
+/* The size of one chunk of file data */
+
+#ifndef CONFIG_FS_TMPFS_FILE_CHUNKSIZE
+#  define CONFIG_FS_TMPFS_FILE_CHUNKSIZE 1024
+#endif
+
+#define TMPFS_CHUNKSIZE CONFIG_FS_TMPFS_FILE_CHUNKSIZE
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -150,14 +158,20 @@ struct tmpfs_file_s
   uint8_t  tfo_type;     /* See enum tmpfs_objtype_e */
   uint8_t  tfo_refs;     /* Reference count */
 
-  /* Remaining fields are unique to a directory object */
+  /* Remaining fields are unique to a file object */
 
   uint8_t  tfo_flags;    /* See TFO_FLAG_* definitions */
   size_t   tfo_size;     /* Valid file size */
-  uint8_t  tfo_data[1];  /* File data starts here */
-};
+  unsigned int tfo_nchunks; /* Number of chunks covering tfo_size */
+  unsigned int tfo_ntable;  /* Number of entries in tfo_chunks[] */
 
-#define SIZEOF_TMPFS_FILE(n) (sizeof(struct tmpfs_file_s) + (n) - 1)
+  /* File data is held in chunks of CONFIG_FS_TMPFS_FILE_CHUNKSIZE bytes.
+   * A NULL chunk reads as zeroes.  Bytes of the last chunk beyond the end
+   * of the file are always zero.
+   */
+
+  FAR uint8_t **tfo_chunks;
+};
 
 /* This structure represents one instance of a TMPFS file system */
 
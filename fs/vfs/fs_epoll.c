@@ -42,12 +42,575 @@
 #include <sys/epoll.h>
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
 #include <poll.h>
+#include <queue.h>
+#include <assert.h>
 #include <errno.h>
-#include <string.h>
 #include <debug.h>
 
+#include <nuttx/nuttx.h>
+#include <nuttx/irq.h>
+#include <nuttx/clock.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/cancelpt.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Bits in struct epoll_node_s flags */
+
+#define EPOLL_NODE_QUEUED    (1 << 0) /* Node is in the ready queue */
+#define EPOLL_NODE_REARM     (1 << 1) /* Node is in the re-arm list */
+#define EPOLL_NODE_DISABLED  (1 << 2) /* EPOLLONESHOT event was reported */
+#define EPOLL_NODE_SOCKET    (1 << 3) /* Node refers to a socket */
+
+/* The poll events that may be requested through epoll_ctl() */
+
+#define EPOLL_POLLEVENTS     (POLLIN | POLLOUT | POLLERR | POLLHUP)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct epoll_head_s;
+
+/* One registered descriptor.  The embedded pollfd remains set up with the
+ * driver for as long as the descriptor is registered, so readiness is
+ * reported through epoll_callback() instead of being re-polled on each
+ * call to epoll_wait().
+ *
+ * The node refers to the file (or socket) structure of the descriptor in
+ * the task group's descriptor list, without holding a reference of its
+ * own.  When the descriptor is closed, epoll_fileclose() (or
+ * epoll_sockclose()) removes the registration before the driver is
+ * closed, so the poll setup is always removed from the right driver
+ * instance and a re-used descriptor number starts out unregistered.
+ */
+
+struct epoll_node_s
+{
+  dq_entry_t               rdnode;  /* Link in the ready queue */
+  sq_entry_t               ranode;  /* Link in the re-arm list */
+  FAR struct epoll_head_s *eph;     /* The containing epoll instance */
+  struct epoll_event       ev;      /* Requested events and user data */
+  struct pollfd            pfd;     /* Persistent poll setup */
+  uint8_t                  flags;   /* See EPOLL_NODE_* definitions */
+  union
+  {
+    FAR struct file       *filep;   /* The open file */
+#ifdef CONFIG_NET
+    FAR struct socket     *psock;   /* The socket */
+#endif
+  } u;
+};
+
+struct epoll_head_s
+{
+  FAR struct epoll_head_s *flink;    /* Next instance in g_epoll_heads */
+  int                      size;     /* Number of nodes */
+  int                      occupied; /* Number of registered descriptors */
+  bool                     waiting;  /* A waiter is blocked on sem */
+  sem_t                    lock;     /* Protects the interest list */
+  sem_t                    sem;      /* Wakes up epoll_wait() */
+  dq_queue_t               rdlist;   /* Nodes with pending events */
+  sq_queue_t               ralist;   /* Level-triggered nodes to re-arm */
+  FAR struct epoll_node_s *nodes;    /* Interest list (size entries) */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* All epoll instances, so that closed descriptors can be unregistered */
+
+static FAR struct epoll_head_s *g_epoll_heads;
+static sem_t g_epoll_sem = SEM_INITIALIZER(1);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_head
+ ****************************************************************************/
+
+static inline FAR struct epoll_head_s *epoll_head(int epfd)
+{
+  /* REVISIT: This will not work on machines where:
+   * sizeof(struct epoll_head_s *) > sizeof(int)
+   */
+
+  return (FAR struct epoll_head_s *)((intptr_t)epfd);
+}
+
+/****************************************************************************
+ * Name: epoll_attach
+ *
+ * Description:
+ *   Bind a node to the file or socket structure behind descriptor 'fd'.
+ *
+ ****************************************************************************/
+
+static int epoll_attach(FAR struct epoll_node_s *epn, int fd)
+{
+  FAR struct file *filep;
+  int ret;
+
+  if ((unsigned int)fd >= CONFIG_NFILE_DESCRIPTORS)
+    {
+#ifdef CONFIG_NET
+      if ((unsigned int)fd < (CONFIG_NFILE_DESCRIPTORS +
+                              CONFIG_NSOCKET_DESCRIPTORS))
+        {
+          FAR struct socket *psock = sockfd_socket(fd);
+
+          if (psock == NULL || psock->s_crefs <= 0)
+            {
+              return -EBADF;
+            }
+
+          epn->u.psock = psock;
+          epn->flags  |= EPOLL_NODE_SOCKET;
+          return OK;
+        }
+      else
+#endif
+        {
+          return -EBADF;
+        }
+    }
+
+  ret = fs_getfilep(fd, &filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (filep->f_inode == NULL)
+    {
+      return -EBADF;
+    }
+
+  epn->u.filep = filep;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: epoll_key
+ *
+ * Description:
+ *   Return the file or socket structure that a node is bound to.
+ *
+ ****************************************************************************/
+
+static inline FAR void *epoll_key(FAR struct epoll_node_s *epn)
+{
+#ifdef CONFIG_NET
+  if ((epn->flags & EPOLL_NODE_SOCKET) != 0)
+    {
+      return epn->u.psock;
+    }
+#endif
+
+  return epn->u.filep;
+}
+
+/****************************************************************************
+ * Name: epoll_fdsetup
+ *
+ * Description:
+ *   Configure (or unconfigure) the persistent poll setup of the file or
+ *   socket referenced by a node.
+ *
+ ****************************************************************************/
+
+static int epoll_fdsetup(FAR struct epoll_node_s *epn, bool setup)
+{
+#ifdef CONFIG_NET
+  if ((epn->flags & EPOLL_NODE_SOCKET) != 0)
+    {
+      return psock_poll(epn->u.psock, &epn->pfd, setup);
+    }
+#endif
+
+  return file_poll(epn->u.filep, &epn->pfd, setup);
+}
+
+/****************************************************************************
+ * Name: epoll_callback
+ *
+ * Description:
+ *   Poll notification callback, called through poll_notify() by the driver
+ *   when events are pending on a registered descriptor.  The node is
+ *   appended to the ready queue and the waiter, if any, is awakened.  This
+ *   may run in interrupt context.
+ *
+ ****************************************************************************/
+
+static void epoll_callback(FAR struct pollfd *fds)
+{
+  FAR struct epoll_node_s *epn = (FAR struct epoll_node_s *)fds->arg;
+  FAR struct epoll_head_s *eph;
+  irqstate_t flags;
+
+  DEBUGASSERT(epn != NULL && epn->eph != NULL);
+  eph = epn->eph;
+
+  flags = enter_critical_section();
+  if ((epn->flags & EPOLL_NODE_QUEUED) == 0)
+    {
+      dq_addlast(&epn->rdnode, &eph->rdlist);
+      epn->flags |= EPOLL_NODE_QUEUED;
+
+      /* Only post the semaphore if there is somebody to awaken.  Otherwise
+       * the event will be found in the ready queue on the next call to
+       * epoll_wait().
+       */
+
+      if (eph->waiting)
+        {
+          eph->waiting = false;
+          nxsem_post(&eph->sem);
+        }
+    }
+
+  leave_critical_section(flags);
+}
+
+/****************************************************************************
+ * Name: epoll_find
+ ****************************************************************************/
+
+static FAR struct epoll_node_s *epoll_find(FAR struct epoll_head_s *eph,
+                                           int fd)
+{
+  int i;
+
+  for (i = 0; i < eph->size; i++)
+    {
+      if (eph->nodes[i].pfd.fd == fd)
+        {
+          return &eph->nodes[i];
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: epoll_setup
+ *
+ * Description:
+ *   Install the persistent poll setup for a node.  If the descriptor is
+ *   already ready, the driver will report it immediately through
+ *   epoll_callback().
+ *
+ ****************************************************************************/
+
+static int epoll_setup(FAR struct epoll_node_s *epn)
+{
+  epn->pfd.events  = (pollevent_t)(epn->ev.events & EPOLL_POLLEVENTS);
+  epn->pfd.revents = 0;
+  epn->pfd.priv    = NULL;
+  epn->pfd.sem     = &epn->eph->sem;
+  epn->pfd.cb      = epoll_callback;
+  epn->pfd.arg     = epn;
+
+  return epoll_fdsetup(epn, true);
+}
+
+/****************************************************************************
+ * Name: epoll_teardown
+ *
+ * Description:
+ *   Remove the persistent poll setup of a node and remove the node from
+ *   the ready queue and re-arm list.
+ *
+ ****************************************************************************/
+
+static int epoll_teardown(FAR struct epoll_node_s *epn)
+{
+  FAR struct epoll_head_s *eph = epn->eph;
+  irqstate_t flags;
+  int ret;
+
+  ret = epoll_fdsetup(epn, false);
+
+  flags = enter_critical_section();
+  if ((epn->flags & EPOLL_NODE_QUEUED) != 0)
+    {
+      dq_rem(&epn->rdnode, &eph->rdlist);
+    }
+
+  if ((epn->flags & EPOLL_NODE_REARM) != 0)
+    {
+      sq_rem(&epn->ranode, &eph->ralist);
+    }
+
+  epn->flags      &= EPOLL_NODE_SOCKET;
+  epn->pfd.revents = 0;
+  leave_critical_section(flags);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: epoll_release
+ *
+ * Description:
+ *   Unregister the node bound to the file or socket structure 'key' from
+ *   every epoll instance.  Called when the descriptor is being closed.
+ *
+ ****************************************************************************/
+
+static void epoll_release(FAR void *key)
+{
+  FAR struct epoll_head_s *eph;
+  FAR struct epoll_node_s *epn;
+  int i;
+
+  /* Nothing to do (and no need to lock) if there is no epoll instance */
+
+  if (g_epoll_heads == NULL)
+    {
+      return;
+    }
+
+  nxsem_wait_uninterruptible(&g_epoll_sem);
+  for (eph = g_epoll_heads; eph != NULL; eph = eph->flink)
+    {
+      nxsem_wait_uninterruptible(&eph->lock);
+      for (i = 0; i < eph->size; i++)
+        {
+          epn = &eph->nodes[i];
+          if (epn->pfd.fd >= 0 && epoll_key(epn) == key)
+            {
+              epoll_teardown(epn);
+              epn->pfd.fd = -1;
+              eph->occupied--;
+            }
+        }
+
+      nxsem_post(&eph->lock);
+    }
+
+  nxsem_post(&g_epoll_sem);
+}
+
+/****************************************************************************
+ * Name: epoll_rearm
+ *
+ * Description:
+ *   Level-triggered descriptors that were reported by the previous call to
+ *   epoll_wait() may still be ready, but the driver will not notify again
+ *   until its state changes.  Re-evaluate only those descriptors by
+ *   tearing down and re-installing their poll setup.
+ *
+ ****************************************************************************/
+
+static void epoll_rearm(FAR struct epoll_head_s *eph)
+{
+  FAR struct epoll_node_s *epn;
+  FAR sq_entry_t *node;
+  irqstate_t flags;
+  bool queued;
+
+  for (; ; )
+    {
+      flags = enter_critical_section();
+      node  = sq_remfirst(&eph->ralist);
+      if (node == NULL)
+        {
+          leave_critical_section(flags);
+          break;
+        }
+
+      epn         = container_of(node, struct epoll_node_s, ranode);
+      epn->flags &= ~EPOLL_NODE_REARM;
+      queued      = (epn->flags & EPOLL_NODE_QUEUED) != 0;
+      leave_critical_section(flags);
+
+      /* Nothing to do if the driver has already reported new events */
+
+      if (!queued)
+        {
+          epoll_teardown(epn);
+          if (epoll_setup(epn) < 0)
+            {
+              /* The driver refused the poll setup.  Report the error. */
+
+              epn->pfd.revents = POLLERR;
+              epoll_callback(&epn->pfd);
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: epoll_scan
+ *
+ * Description:
+ *   Not all drivers report events through poll_notify(); some still post
+ *   the semaphore directly.  When the waiter is awakened but the ready
+ *   queue is empty, find the nodes with pending events the slow way.
+ *
+ ****************************************************************************/
+
+static void epoll_scan(FAR struct epoll_head_s *eph)
+{
+  FAR struct epoll_node_s *epn;
+  irqstate_t flags;
+  int i;
+
+  for (i = 0; i < eph->size; i++)
+    {
+      epn = &eph->nodes[i];
+
+      flags = enter_critical_section();
+      if (epn->pfd.fd >= 0 && epn->pfd.revents != 0 &&
+          (epn->flags & EPOLL_NODE_QUEUED) == 0)
+        {
+          dq_addlast(&epn->rdnode, &eph->rdlist);
+          epn->flags |= EPOLL_NODE_QUEUED;
+        }
+
+      leave_critical_section(flags);
+    }
+}
+
+/****************************************************************************
+ * Name: epoll_harvest
+ *
+ * Description:
+ *   Move up to maxevents pending events from the ready queue to the
+ *   caller's event array.
+ *
+ ****************************************************************************/
+
+static int epoll_harvest(FAR struct epoll_head_s *eph,
+                         FAR struct epoll_event *evs, int maxevents)
+{
+  FAR struct epoll_node_s *epn;
+  FAR dq_entry_t *node;
+  pollevent_t revents;
+  irqstate_t flags;
+  int nevents = 0;
+
+  flags = enter_critical_section();
+  while (nevents < maxevents &&
+         (node = dq_remfirst(&eph->rdlist)) != NULL)
+    {
+      epn = container_of(node, struct epoll_node_s, rdnode);
+      epn->flags &= ~EPOLL_NODE_QUEUED;
+
+      revents = epn->pfd.revents;
+      epn->pfd.revents = 0;
+
+      if (revents == 0 || (epn->flags & EPOLL_NODE_DISABLED) != 0)
+        {
+          continue;
+        }
+
+      evs[nevents].events = revents;
+      evs[nevents].data   = epn->ev.data;
+      nevents++;
+
+      if ((epn->ev.events & EPOLLONESHOT) != 0)
+        {
+          epn->flags |= EPOLL_NODE_DISABLED;
+        }
+      else if ((epn->ev.events & EPOLLET) == 0 &&
+               (epn->flags & EPOLL_NODE_REARM) == 0)
+        {
+          sq_addlast(&epn->ranode, &eph->ralist);
+          epn->flags |= EPOLL_NODE_REARM;
+        }
+    }
+
+  leave_critical_section(flags);
+  return nevents;
+}
+
+/****************************************************************************
+ * Name: epoll_sleep
+ *
+ * Description:
+ *   Wait for epoll_callback() (or a driver posting the semaphore directly)
+ *   to signal that events may be pending, or for the timeout to expire.
+ *
+ * Returned Value:
+ *   Zero (OK) if awakened, -ETIMEDOUT on a timeout, or another negated
+ *   errno value on failure.
+ *
+ ****************************************************************************/
+
+static int epoll_sleep(FAR struct epoll_head_s *eph, clock_t start,
+                       int timeout)
+{
+  irqstate_t flags;
+  clock_t ticks;
+  clock_t elapsed;
+  int ret;
+
+  /* Don't sleep if an event arrived since the ready queue was checked */
+
+  flags = enter_critical_section();
+  if (!dq_empty(&eph->rdlist))
+    {
+      leave_critical_section(flags);
+      return OK;
+    }
+
+  eph->waiting = true;
+
+  if (timeout == 0)
+    {
+      ret = nxsem_trywait(&eph->sem);
+      if (ret < 0)
+        {
+          ret = -ETIMEDOUT;
+        }
+    }
+  else if (timeout > 0)
+    {
+      /* Round timeout up to next full tick as is done by poll() */
+
+#if (MSEC_PER_TICK * USEC_PER_MSEC) != USEC_PER_TICK && \
+    defined(CONFIG_HAVE_LONG_LONG)
+      ticks = (((unsigned long long)timeout * USEC_PER_MSEC) +
+               (USEC_PER_TICK - 1)) /
+              USEC_PER_TICK;
+#else
+      ticks = ((unsigned int)timeout + (MSEC_PER_TICK - 1)) /
+              MSEC_PER_TICK;
+#endif
+
+      elapsed = clock_systimer() - start;
+      if (elapsed >= ticks)
+        {
+          ret = -ETIMEDOUT;
+        }
+      else
+        {
+          ret = nxsem_tickwait(&eph->sem, start, ticks);
+        }
+    }
+  else
+    {
+      ret = nxsem_wait(&eph->sem);
+    }
+
+  eph->waiting = false;
+  leave_critical_section(flags);
+  return ret;
+}
 
 /****************************************************************************
  * Public Functions
@@ -57,26 +620,68 @@
  * Name: epoll_create
  *
  * Description:
+ *   Create an epoll instance that can monitor up to 'size' descriptors.
  *
  * Input Parameters:
+ *   size - The maximum number of descriptors in the interest list.
  *
  * Returned Value:
+ *   On success, the epoll handle is returned.  On error, -1 (ERROR) is
+ *   returned and errno is set appropriately.
  *
  ****************************************************************************/
 
 int epoll_create(int size)
 {
-  FAR struct epoll_head *eph =
-    (FAR struct epoll_head *)kmm_malloc(sizeof(struct epoll_head));
+  FAR struct epoll_head_s *eph;
+  int i;
+
+  if (size <= 0)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  eph = (FAR struct epoll_head_s *)kmm_zalloc(sizeof(struct epoll_head_s));
+  if (eph == NULL)
+    {
+      set_errno(ENOMEM);
+      return ERROR;
+    }
+
+  eph->nodes = (FAR struct epoll_node_s *)
+    kmm_zalloc(sizeof(struct epoll_node_s) * size);
+  if (eph->nodes == NULL)
+    {
+      kmm_free(eph);
+      set_errno(ENOMEM);
+      return ERROR;
+    }
 
   eph->size = size;
-  eph->occupied = 0;
-  eph->evs = kmm_malloc(sizeof(struct epoll_event) * eph->size);
+  for (i = 0; i < size; i++)
+    {
+      eph->nodes[i].eph    = eph;
+      eph->nodes[i].pfd.fd = -1;
+    }
 
-  /* REVISIT: This will not work on machines where:
-   * sizeof(struct epoll_head *) > sizeof(int)
+  dq_init(&eph->rdlist);
+  sq_init(&eph->ralist);
+
+  nxsem_init(&eph->lock, 0, 1);
+
+  /* This semaphore is used for signaling and, hence, should not have
+   * priority inheritance enabled.
    */
 
+  nxsem_init(&eph->sem, 0, 0);
+  nxsem_setprotocol(&eph->sem, SEM_PRIO_NONE);
+
+  nxsem_wait_uninterruptible(&g_epoll_sem);
+  eph->flink    = g_epoll_heads;
+  g_epoll_heads = eph;
+  nxsem_post(&g_epoll_sem);
+
   return (int)((intptr_t)eph);
 }
 
@@ -84,22 +689,45 @@ int epoll_create(int size)
  * Name: epoll_close
  *
  * Description:
+ *   Tear down all registrations and free the epoll instance.
  *
  * Input Parameters:
+ *   epfd - The epoll handle returned by epoll_create().
  *
  * Returned Value:
+ *   None
  *
  ****************************************************************************/
 
 void epoll_close(int epfd)
 {
-  /* REVISIT: This will not work on machines where:
-   * sizeof(struct epoll_head *) > sizeof(int)
-   */
+  FAR struct epoll_head_s *eph = epoll_head(epfd);
+  FAR struct epoll_head_s **pp;
+  int i;
+
+  nxsem_wait_uninterruptible(&g_epoll_sem);
+  for (pp = &g_epoll_heads; *pp != NULL; pp = &(*pp)->flink)
+    {
+      if (*pp == eph)
+        {
+          *pp = eph->flink;
+          break;
+        }
+    }
+
+  nxsem_post(&g_epoll_sem);
 
-  FAR struct epoll_head *eph = (FAR struct epoll_head *)((intptr_t)epfd);
+  for (i = 0; i < eph->size; i++)
+    {
+      if (eph->nodes[i].pfd.fd >= 0)
+        {
+          epoll_teardown(&eph->nodes[i]);
+        }
+    }
 
-  kmm_free(eph->evs);
+  nxsem_destroy(&eph->sem);
+  nxsem_destroy(&eph->lock);
+  kmm_free(eph->nodes);
   kmm_free(eph);
 }
 
@@ -107,128 +735,284 @@ void epoll_close(int epfd)
  * Name: epoll_ctl
  *
  * Description:
+ *   Add, modify or remove a descriptor in the interest list.  Adding a
+ *   descriptor installs a poll setup with its driver that persists until
+ *   the descriptor is removed with EPOLL_CTL_DEL, the descriptor is
+ *   closed, or the epoll instance is closed.  No reference is held on the
+ *   underlying file or socket, so closing the descriptor closes it as
+ *   usual and silently removes it from the interest list.
  *
  * Input Parameters:
+ *   epfd - The epoll handle returned by epoll_create().
+ *   op   - EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL.
+ *   fd   - The file or socket descriptor.
+ *   ev   - The events of interest and the user data to return with them.
+ *          EPOLLET and EPOLLONESHOT may be included in the events.
  *
  * Returned Value:
+ *   Zero (OK) on success.  On error, -1 (ERROR) is returned and errno is
+ *   set appropriately.
  *
  ****************************************************************************/
 
-int epoll_ctl(int epfd, int op, int fd, struct epoll_event *ev)
+int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
 {
-  /* REVISIT: This will not work on machines where:
-   * sizeof(struct epoll_head *) > sizeof(int)
-   */
+  FAR struct epoll_head_s *eph = epoll_head(epfd);
+  FAR struct epoll_node_s *epn;
+  int ret;
 
-  FAR struct epoll_head *eph = (FAR struct epoll_head *)((intptr_t)epfd);
+  if (fd < 0 || (op != EPOLL_CTL_DEL && ev == NULL))
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  ret = nxsem_wait_uninterruptible(&eph->lock);
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      return ERROR;
+    }
+
+  epn = epoll_find(eph, fd);
 
   switch (op)
     {
       case EPOLL_CTL_ADD:
-        finfo("%08x CTL ADD(%d): fd=%d ev=%08x\n",
+        finfo("%08x CTL ADD(%d): fd=%d ev=%08" PRIx32 "\n",
               epfd, eph->occupied, fd, ev->events);
 
-        eph->evs[eph->occupied].events = ev->events | POLLERR | POLLHUP;
-        eph->evs[eph->occupied++].data.fd = fd;
-        return 0;
+        if (epn != NULL)
+          {
+            ret = -EEXIST;
+            break;
+          }
+
+        epn = epoll_find(eph, -1);
+        if (epn == NULL)
+          {
+            ret = -ENOMEM;
+            break;
+          }
+
+        epn->ev     = *ev;
+        epn->flags  = 0;
+
+        ret = epoll_attach(epn, fd);
+        if (ret < 0)
+          {
+            break;
+          }
+
+        epn->pfd.fd = fd;
+
+        ret = epoll_setup(epn);
+        if (ret < 0)
+          {
+            epn->pfd.fd = -1;
+            break;
+          }
+
+        eph->occupied++;
+        break;
 
       case EPOLL_CTL_DEL:
-        {
-          int i;
+        finfo("%08x CTL DEL(%d): fd=%d\n", epfd, eph->occupied, fd);
 
-          for (i = 0; i < eph->occupied; i++)
-            {
-              if (eph->evs[i].data.fd == fd)
-                {
-                  if (i != eph->occupied - 1)
-                    {
-                      memmove(&eph->evs[i], &eph->evs[i + 1],
-                              eph->occupied - i);
-                    }
-
-                  eph->occupied--;
-                  return 0;
-                }
-            }
+        if (epn == NULL)
+          {
+            ret = -ENOENT;
+            break;
+          }
 
-          return -ENOENT;
-        }
+        epoll_teardown(epn);
+        epn->pfd.fd = -1;
+        eph->occupied--;
+        break;
 
       case EPOLL_CTL_MOD:
-        {
-          int i;
+        finfo("%08x CTL MOD(%d): fd=%d ev=%08" PRIx32 "\n",
+              epfd, eph->occupied, fd, ev->events);
 
-          finfo("%08x CTL MOD(%d): fd=%d ev=%08x\n",
-                epfd, eph->occupied, fd, ev->events);
+        if (epn == NULL)
+          {
+            ret = -ENOENT;
+            break;
+          }
 
-          for (i = 0; i < eph->occupied; i++)
-            {
-              if (eph->evs[i].data.fd == fd)
-                {
-                  eph->evs[i].events = ev->events | POLLERR | POLLHUP;
-                  return 0;
-                }
-            }
+        /* Re-install the poll setup.  This also re-arms a descriptor that
+         * was disabled after an EPOLLONESHOT event.
+         */
 
-          return -ENOENT;
-        }
+        epoll_teardown(epn);
+        epn->ev = *ev;
+
+        ret = epoll_setup(epn);
+        if (ret < 0)
+          {
+            epn->pfd.fd = -1;
+            eph->occupied--;
+          }
+
+        break;
+
+      default:
+        ret = -EINVAL;
+        break;
     }
 
-  return -EINVAL;
+  nxsem_post(&eph->lock);
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      return ERROR;
+    }
+
+  return OK;
 }
 
 /****************************************************************************
  * Name: epoll_wait
  *
  * Description:
+ *   Wait for events on the descriptors in the interest list.  Only the
+ *   descriptors that the drivers have reported as ready are examined, so
+ *   the cost does not depend on the size of the interest list.
  *
  * Input Parameters:
+ *   epfd      - The epoll handle returned by epoll_create().
+ *   evs       - The location to return the events.
+ *   maxevents - The maximum number of events to return.
+ *   timeout   - Upper limit on the time to wait in milliseconds.  A
+ *               negative value means an infinite timeout.
  *
  * Returned Value:
+ *   The number of events returned in evs, or zero if the timeout expired
+ *   with no events.  On error, -1 (ERROR) is returned and errno is set
+ *   appropriately.
  *
  ****************************************************************************/
 
 int epoll_wait(int epfd, FAR struct epoll_event *evs, int maxevents,
                int timeout)
 {
-  /* REVISIT: This will not work on machines where:
-   * sizeof(struct epoll_head *) > sizeof(int)
-   */
+  FAR struct epoll_head_s *eph = epoll_head(epfd);
+  clock_t start;
+  int nevents;
+  int ret;
 
-  FAR struct epoll_head *eph = (FAR struct epoll_head *)((intptr_t)epfd);
-  int counter;
-  int rc;
-  int i;
+  if (evs == NULL || maxevents <= 0)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  /* epoll_wait() is a cancellation point */
+
+  enter_cancellation_point();
+
+  ret = nxsem_wait(&eph->lock);
+  if (ret < 0)
+    {
+      goto errout;
+    }
 
-  rc = poll((FAR struct pollfd *)eph->evs, eph->occupied, timeout);
+  epoll_rearm(eph);
 
-  if (rc <= 0)
+  start   = clock_systimer();
+  nevents = epoll_harvest(eph, evs, maxevents);
+
+  while (nevents == 0)
     {
-      if (rc < 0)
+      /* Allow the interest list to be modified while we are waiting */
+
+      nxsem_post(&eph->lock);
+      ret = epoll_sleep(eph, start, timeout);
+
+      if (ret < 0)
         {
-          ferr("ERROR: %08x poll fail: %d for %d, %d msecs\n",
-               epfd, rc, eph->occupied, timeout);
+          if (ret != -ETIMEDOUT)
+            {
+              goto errout;
+            }
+
+          /* Return zero in the event of a timeout, unless an event
+           * arrived just as the timeout expired.
+           */
 
-          for (i = 0; i < eph->occupied; i++)
+          ret = nxsem_wait_uninterruptible(&eph->lock);
+          if (ret < 0)
             {
-              ferr("  %02d: fd=%d\n", i, eph->evs[i].data.fd);
+              goto errout;
             }
-        }
 
-      return rc;
-    }
+          nevents = epoll_harvest(eph, evs, maxevents);
+          break;
+        }
 
-  /* Iterate over non NULL event fds */
+      ret = nxsem_wait_uninterruptible(&eph->lock);
+      if (ret < 0)
+        {
+          goto errout;
+        }
 
-  for (i = 0, counter = 0; i < rc && counter < eph->size; counter++)
-    {
-      if (eph->evs[counter].revents != 0)
+      nevents = epoll_harvest(eph, evs, maxevents);
+      if (nevents == 0)
         {
-          evs[i].data.fd = eph->evs[counter].data.fd;
-          evs[i].events  = eph->evs[counter].revents;
-          i += 1;
+          epoll_scan(eph);
+          nevents = epoll_harvest(eph, evs, maxevents);
         }
     }
 
-  return i;
+  nxsem_post(&eph->lock);
+  leave_cancellation_point();
+  return nevents;
+
+errout:
+  leave_cancellation_point();
+  set_errno(-ret);
+  return ERROR;
+}
+
+/****************************************************************************
+ * Name: epoll_fileclose
+ *
+ * Description:
+ *   Remove an open file from the interest list of every epoll instance.
+ *   Called by the file system before the file is closed.
+ *
+ * Input Parameters:
+ *   filep - The file structure in the task group's descriptor list.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void epoll_fileclose(FAR struct file *filep)
+{
+  epoll_release(filep);
+}
+
+/****************************************************************************
+ * Name: epoll_sockclose
+ *
+ * Description:
+ *   Remove a socket from the interest list of every epoll instance.
+ *   Called by the network before the socket is closed.
+ *
+ * Input Parameters:
+ *   psock - The socket structure in the task group's socket list.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET
+void epoll_sockclose(FAR struct socket *psock)
+{
+  epoll_release(psock);
 }
+#endif
@@ -44,6 +44,7 @@
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
+#include <debug.h>
 
 #include <nuttx/clock.h>
 #include <nuttx/semaphore.h>
@@ -139,6 +140,8 @@ static inline int poll_setup(FAR struct pollfd *fds, nfds_t nfds,
       fds[i].sem     = sem;
       fds[i].revents = 0;
       fds[i].priv    = NULL;
+      fds[i].cb      = NULL;
+      fds[i].arg     = NULL;
 
       /* Check for invalid descriptors. "If the value of fd is less than 0,
        * events shall be ignored, and revents shall be set to 0 in that entry
@@ -294,6 +297,67 @@ static inline int poll_teardown(FAR struct pollfd *fds, nfds_t nfds,
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: poll_notify
+ *
+ * Description:
+ *   Notify the poll waiters that the events in eventset have occurred.  The
+ *   events of interest are merged into revents of each non-NULL pollfd in
+ *   the array and, if any event is pending, the waiter is notified either
+ *   through its notification callback (if one was provided, as is done by
+ *   epoll) or by posting its semaphore.
+ *
+ *   This function may be called from interrupt handlers.
+ *
+ * Input Parameters:
+ *   afds     - An array of pointers to struct pollfd; NULL entries are
+ *              ignored.
+ *   nfds     - The number of entries in afds.
+ *   eventset - The set of events that have occurred.  This may be zero if
+ *              the caller has already updated revents.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void poll_notify(FAR struct pollfd **afds, int nfds, pollevent_t eventset)
+{
+  FAR struct pollfd *fds;
+  int i;
+
+  DEBUGASSERT(afds != NULL && nfds >= 1);
+
+  for (i = 0; i < nfds; i++)
+    {
+      fds = afds[i];
+      if (fds != NULL)
+        {
+          fds->revents |= eventset & (fds->events | POLLERR | POLLHUP);
+          if ((fds->revents & (POLLOUT | POLLHUP)) == (POLLOUT | POLLHUP))
+            {
+              /* POLLOUT and POLLHUP are mutually exclusive. */
+
+              fds->revents &= ~POLLOUT;
+            }
+
+          if (fds->revents != 0)
+            {
+              finfo("Report events: %02x\n", fds->revents);
+
+              if (fds->cb != NULL)
+                {
+                  fds->cb(fds);
+                }
+              else if (fds->sem != NULL)
+                {
+                  nxsem_post(fds->sem);
+                }
+            }
+        }
+    }
+}
+
 /****************************************************************************
  * Name: file_poll
  *
@@ -345,11 +409,7 @@ int file_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup)
         {
           if (setup)
             {
-              fds->revents |= (fds->events & (POLLIN | POLLOUT));
-              if (fds->revents != 0)
-                {
-                  nxsem_post(fds->sem);
-                }
+              poll_notify(&fds, 1, POLLIN | POLLOUT);
             }
 
           ret = OK;
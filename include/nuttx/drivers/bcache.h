@@ -0,0 +1,99 @@
+/****************************************************************************
+ * include/nuttx/drivers/bcache.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_DRIVERS_BCACHE_H
+#define __INCLUDE_NUTTX_DRIVERS_BCACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: bcache_register
+ *
+ * Description:
+ *   Create a cached block device on top of an existing block driver.  The
+ *   new block driver holds recently used sectors of the underlying device
+ *   in an LRU cache, reads ahead when it detects sequential access, and
+ *   collects writes which are written back in contiguous runs after a
+ *   delay, on BIOC_FLUSH, when the cache needs space, or when the last
+ *   reference is closed.
+ *
+ *   Any file system can use the cache by mounting the new device instead
+ *   of the underlying one.  The underlying device must not be accessed
+ *   directly while the cache is registered.
+ *
+ * Input Parameters:
+ *   blkdev   - The path to the underlying block driver
+ *   cachedev - The path of the cached block driver to create
+ *   nblocks  - The number of sectors to hold in the cache.  Zero selects
+ *              CONFIG_DRVR_BCACHE_NBLOCKS.
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int bcache_register(FAR const char *blkdev, FAR const char *cachedev,
+                    size_t nblocks);
+
+/****************************************************************************
+ * Name: bcache_unregister
+ *
+ * Description:
+ *   Remove a cached block device created by bcache_register().  Dirty
+ *   sectors are written back and the underlying device is closed when the
+ *   last reference to the cached device is released.
+ *
+ * Input Parameters:
+ *   cachedev - The path of the cached block driver
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int bcache_unregister(FAR const char *cachedev);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_DRVR_BCACHE */
+#endif /* __INCLUDE_NUTTX_DRIVERS_BCACHE_H */
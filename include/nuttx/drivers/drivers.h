@@ -45,6 +45,24 @@
 #include <sys/types.h>
 #include <stdbool.h>
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef CONFIG_PIPES
+/* This is the argument of the PIPEIOC_SPLICEIN, PIPEIOC_SPLICEOUT and
+ * PIPEIOC_TEE ioctl commands.  Data is moved between the ring buffer of the
+ * pipe and the file or socket descriptor 'fd' without passing through a
+ * user buffer.
+ */
+
+struct pipe_splice_s
+{
+  int    fd;                 /* File or socket descriptor at the other end */
+  size_t len;                /* Maximum number of bytes to move */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
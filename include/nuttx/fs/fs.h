@@ -49,6 +49,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <semaphore.h>
+#include <poll.h>
 
 #ifdef CONFIG_FS_NAMED_SEMAPHORES
 #  include <nuttx/semaphore.h>
@@ -1272,6 +1273,51 @@ int file_fcntl(FAR struct file *filep, int cmd, ...);
 
 int file_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup);
 
+/****************************************************************************
+ * Name: poll_notify
+ *
+ * Description:
+ *   Notify the poll waiters that the events in eventset have occurred.
+ *   Drivers should use this in place of posting fds->sem directly so that
+ *   waiters that registered a notification callback (such as epoll) are
+ *   informed without rescanning their descriptors.
+ *
+ * Input Parameters:
+ *   afds     - An array of pointers to struct pollfd; NULL entries are
+ *              ignored.
+ *   nfds     - The number of entries in afds.
+ *   eventset - The set of events that have occurred.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void poll_notify(FAR struct pollfd **afds, int nfds, pollevent_t eventset);
+
+/****************************************************************************
+ * Name: epoll_fileclose and epoll_sockclose
+ *
+ * Description:
+ *   Remove a file or socket that is being closed from the interest list of
+ *   every epoll instance.  These must be called before the driver or the
+ *   connection is closed.
+ *
+ * Input Parameters:
+ *   filep - The file structure in the task group's descriptor list.
+ *   psock - The socket structure in the task group's socket list.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void epoll_fileclose(FAR struct file *filep);
+#ifdef CONFIG_NET
+struct socket;
+void epoll_sockclose(FAR struct socket *psock);
+#endif
+
 /****************************************************************************
  * Name: file_fstat
  *
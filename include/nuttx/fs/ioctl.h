@@ -386,6 +386,27 @@
                                              *       (default)
                                              *     1=fre when empty
                                              * OUT: None */
+#define PIPEIOC_SETSIZE   _PIPEIOC(0x0002)  /* Resize the ring buffer
+                                             * IN: unsigned long integer
+                                             *     New size in bytes, at
+                                             *     most
+                                             *     CONFIG_DEV_PIPE_MAXSIZE
+                                             * OUT: None */
+#define PIPEIOC_GETSIZE   _PIPEIOC(0x0003)  /* Get the ring buffer size
+                                             * IN: None
+                                             * OUT: Size in bytes */
+#define PIPEIOC_SPLICEIN  _PIPEIOC(0x0004)  /* Read from a file or socket
+                                             * directly into the pipe
+                                             * IN: struct pipe_splice_s *
+                                             * OUT: Bytes moved */
+#define PIPEIOC_SPLICEOUT _PIPEIOC(0x0005)  /* Write pipe data directly to
+                                             * a file or socket
+                                             * IN: struct pipe_splice_s *
+                                             * OUT: Bytes moved */
+#define PIPEIOC_TEE       _PIPEIOC(0x0006)  /* Like PIPEIOC_SPLICEOUT but
+                                             * the data stays in the pipe
+                                             * IN: struct pipe_splice_s *
+                                             * OUT: Bytes copied */
 
 /* RTC driver ioctl definitions *********************************************/
 
@@ -230,6 +230,18 @@ struct iob_userstats_s
   int totalproduced;
 };
 
+#ifdef CONFIG_IOB_PERCPU_CACHE
+/* Statistics for one per-CPU IOB cache */
+
+struct iob_cachestats_s
+{
+  uint32_t hits;     /* Allocations served from the cache */
+  uint32_t misses;   /* Allocations that required a refill */
+  uint32_t frees;    /* IOBs freed into the cache */
+  uint32_t spills;   /* Batches spilled to the global free list */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -265,6 +277,33 @@ FAR struct iob_s *iob_alloc(bool throttled, enum iob_user_e consumerid);
 
 FAR struct iob_s *iob_tryalloc(bool throttled, enum iob_user_e consumerid);
 
+/****************************************************************************
+ * Name: iob_alloc_chain
+ *
+ * Description:
+ *   Allocate 'nbufs' I/O buffers linked together through io_flink,
+ *   waiting for them as necessary.  This is intended for drivers that
+ *   refill several receive descriptors at once.  If called from an
+ *   interrupt handler, this behaves like iob_tryalloc_chain().
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_alloc_chain(int nbufs, bool throttled,
+                                  enum iob_user_e consumerid);
+
+/****************************************************************************
+ * Name: iob_tryalloc_chain
+ *
+ * Description:
+ *   Try to allocate 'nbufs' I/O buffers linked together through io_flink
+ *   without waiting.  The buffers are taken from the free list in a single
+ *   critical section.  Either all 'nbufs' buffers or none are allocated.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_tryalloc_chain(int nbufs, bool throttled,
+                                     enum iob_user_e consumerid);
+
 /****************************************************************************
  * Name: iob_navail
  *
@@ -356,7 +395,7 @@ int iob_notifier_teardown(int key);
  *
  * Description:
  *   Free an entire buffer chain, starting at the beginning of the I/O
- *   buffer chain
+ *   buffer chain.  The whole chain is returned to the free list at once.
  *
  ****************************************************************************/
 
@@ -601,5 +640,26 @@ void iob_dump(FAR const char *msg, FAR struct iob_s *iob, unsigned int len,
 FAR struct iob_userstats_s * iob_getuserstats(enum iob_user_e userid);
 #endif
 
+/****************************************************************************
+ * Name: iob_getcachestats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of the per-CPU IOB cache of 'cpu'.
+ *
+ * Input Parameters:
+ *   cpu   - The CPU index
+ *   stats - Location to return the statistics
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -EINVAL if 'cpu' has no cache.
+ *
+ ****************************************************************************/
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO) && \
+    defined(CONFIG_IOB_PERCPU_CACHE)
+int iob_getcachestats(int cpu, FAR struct iob_cachestats_s *stats);
+#endif
+
 #endif /* CONFIG_MM_IOB */
 #endif /* _INCLUDE_NUTTX_MM_IOB_H */
@@ -47,6 +47,10 @@
 #include <string.h>
 #include <semaphore.h>
 
+#if defined(CONFIG_MM_QUICKLIST) && defined(CONFIG_SMP)
+#  include <nuttx/spinlock.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -232,6 +236,45 @@ struct mm_freenode_s
 #define CHECK_FREENODE_SIZE \
   DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+#ifdef CONFIG_MM_QUICKLIST
+/* A chunk in a quick list.  The chunk remains marked as allocated; the
+ * link is kept in the user data area.
+ */
+
+struct mm_quicknode_s
+{
+  mmsize_t size;                    /* Size of this chunk */
+  mmsize_t preceding;               /* Size of the preceding chunk */
+  FAR struct mm_quicknode_s *flink; /* Supports a singly linked list */
+};
+
+/* Quick lists hold chunks of up to MM_QUICK_MAXCHUNK bytes, one list for
+ * each multiple of MM_MIN_CHUNK.
+ */
+
+#define MM_QUICK_MAXCHUNK \
+  MM_ALIGN_UP(CONFIG_MM_QUICKLIST_MAXSIZE + SIZEOF_MM_ALLOCNODE)
+#define MM_QUICK_NLISTS  (MM_QUICK_MAXCHUNK >> MM_MIN_SHIFT)
+#define MM_QUICK_NDX(s)  (((s) >> MM_MIN_SHIFT) - 1)
+
+#ifdef CONFIG_SMP
+#  define MM_QUICK_NCACHES CONFIG_SMP_NCPUS
+#else
+#  define MM_QUICK_NCACHES 1
+#endif
+
+/* One set of quick lists.  There is one per CPU */
+
+struct mm_quickcache_s
+{
+#ifdef CONFIG_SMP
+  spinlock_t lock;                  /* Needed only to flush from another CPU */
+#endif
+  FAR struct mm_quicknode_s *head[MM_QUICK_NLISTS];
+  uint8_t count[MM_QUICK_NLISTS];
+};
+#endif
+
 /* This describes one heap (possibly with multiple regions) */
 
 struct mm_heap_s
@@ -263,6 +306,14 @@ struct mm_heap_s
    */
 
   struct mm_freenode_s mm_nodelist[MM_NNODES];
+
+#ifdef CONFIG_MM_QUICKLIST
+  /* Recently freed small chunks that may be re-allocated without searching
+   * the node list.
+   */
+
+  struct mm_quickcache_s mm_quick[MM_QUICK_NCACHES];
+#endif
 };
 
 /****************************************************************************
@@ -378,6 +429,16 @@ FAR void *kmm_malloc(size_t size);
 /* Functions contained in mm_free.c *****************************************/
 
 void mm_free(FAR struct mm_heap_s *heap, FAR void *mem);
+void mm_freechunk(FAR struct mm_heap_s *heap, FAR void *mem);
+
+/* Functions contained in mm_quicklist.c ************************************/
+
+#ifdef CONFIG_MM_QUICKLIST
+void mm_quickinitialize(FAR struct mm_heap_s *heap);
+FAR void *mm_quickalloc(FAR struct mm_heap_s *heap, size_t alignsize);
+bool mm_quickfree(FAR struct mm_heap_s *heap, FAR void *mem);
+bool mm_quickflush(FAR struct mm_heap_s *heap);
+#endif
 
 /* Functions contained in kmm_free.c ****************************************/
 
@@ -321,6 +321,11 @@ void net_initialize(void);
  *                       momentarily to wait for an IOB to become
  *                       available.
  *
+ * There are no per-device or per-connection locks:  This one lock protects
+ * the network devices, the connection structures and their lists, the
+ * devif callbacks and the I/O buffer throttling.  The device poll loops,
+ * packet input and the socket send/receive paths all run with it held.
+ *
  ****************************************************************************/
 
 /****************************************************************************
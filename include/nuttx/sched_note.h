@@ -66,6 +66,10 @@
 #  define CONFIG_SCHED_NOTE_BUFSIZE 2048
 #endif
 
+#if !defined(CONFIG_SCHED_NOTE_OVERWRITE) && !defined(CONFIG_SCHED_NOTE_DROP)
+#  define CONFIG_SCHED_NOTE_OVERWRITE 1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -348,6 +352,29 @@ ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen);
 ssize_t sched_note_size(void);
 #endif
 
+/****************************************************************************
+ * Name: sched_note_read
+ *
+ * Description:
+ *   Remove as many complete notes as will fit from the instrumentation
+ *   buffers and return them back-to-back in the user buffer.
+ *
+ * Input Parameters:
+ *   buffer - Location to return the notes
+ *   buflen - The length of the user provided buffer.
+ *
+ * Returned Value:
+ *   The number of bytes returned.  Zero is returned only if the buffers
+ *   are empty.  -EFBIG is returned if the first note does not fit into the
+ *   user buffer; that note is then discarded.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_INSTRUMENTATION_BUFFER) && \
+    defined(CONFIG_SCHED_NOTE_GET)
+ssize_t sched_note_read(FAR uint8_t *buffer, size_t buflen);
+#endif
+
 /****************************************************************************
  * Name: note_register
  *
@@ -443,6 +443,45 @@ void uart_datasent(FAR uart_dev_t *dev);
 void uart_connected(FAR uart_dev_t *dev, bool connected);
 #endif
 
+/************************************************************************************
+ * Name: uart_bufreserve and uart_bufcommit
+ *
+ * Description:
+ *   Chunked access to the producer side of a circular buffer.  uart_bufreserve()
+ *   returns, in 'span', the start of the contiguous free space that begins 'offset'
+ *   bytes after the head index and returns its length.  Zero is returned if the
+ *   buffer has no free space at that offset.  uart_bufcommit() then makes 'nbytes'
+ *   bytes written there visible to the consumer with a single update of the head
+ *   index.
+ *
+ *   Only the producer may call these functions; the consumer may concurrently
+ *   remove data from the buffer.
+ *
+ ************************************************************************************/
+
+size_t uart_bufreserve(FAR struct uart_buffer_s *buf, size_t offset,
+                       FAR char **span);
+void uart_bufcommit(FAR struct uart_buffer_s *buf, size_t nbytes);
+
+/************************************************************************************
+ * Name: uart_bufpeek and uart_bufconsume
+ *
+ * Description:
+ *   Chunked access to the consumer side of a circular buffer.  uart_bufpeek()
+ *   returns, in 'span', the start of the contiguous data that begins 'offset' bytes
+ *   after the tail index and returns its length.  Zero is returned if the buffer
+ *   holds no data at that offset.  uart_bufconsume() then releases 'nbytes' bytes
+ *   to the producer with a single update of the tail index.
+ *
+ *   Only the consumer may call these functions; the producer may concurrently add
+ *   data to the buffer.
+ *
+ ************************************************************************************/
+
+size_t uart_bufpeek(FAR struct uart_buffer_s *buf, size_t offset,
+                    FAR char **span);
+void uart_bufconsume(FAR struct uart_buffer_s *buf, size_t nbytes);
+
 /************************************************************************************
  * Name: uart_xmitchars_dma
  *
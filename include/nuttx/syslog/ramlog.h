@@ -79,6 +79,13 @@
  * provided:
  *
  * CONFIG_RAMLOG_BUFSIZE - Size of the console RAM log.  Default: 1024
+ * CONFIG_RAMLOG_LOCKLESS - Reserve space for a whole message at once and
+ *   copy the message without holding the lock.
+ * CONFIG_RAMLOG_STAGESIZE - With CONFIG_RAMLOG_LOCKLESS, the size of the
+ *   per-task buffer in which ramlog_putc() collects a line.  Default: 64
+ * CONFIG_RAMLOG_NSTAGES - With CONFIG_RAMLOG_LOCKLESS, the number of tasks
+ *   that can stage partial lines at the same time.  When all are in use,
+ *   one staged line is added to the log to make room.  Default: 4
  */
 
 #if defined(CONFIG_RAMLOG_SYSLOG) && !defined(CONFIG_SYSLOG_DEVPATH)
@@ -154,6 +161,31 @@ void ramlog_syslog_register(void);
 int ramlog_putc(int ch);
 #endif
 
+/****************************************************************************
+ * Name: ramlog_syslog_write
+ *
+ * Description:
+ *   This is the low-level, multiple character, system logging interface.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_RAMLOG_SYSLOG) && defined(CONFIG_SYSLOG_WRITE)
+ssize_t ramlog_syslog_write(FAR const char *buffer, size_t buflen);
+#endif
+
+/****************************************************************************
+ * Name: ramlog_flush
+ *
+ * Description:
+ *   Add the characters staged by ramlog_putc() for all tasks to the log,
+ *   including partial lines.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_SYSLOG
+int ramlog_flush(void);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
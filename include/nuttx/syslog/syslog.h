@@ -186,6 +186,28 @@ int syslog_initialize(void);
 #  define syslog_initialize()
 #endif
 
+/****************************************************************************
+ * Name: syslog_defer_start
+ *
+ * Description:
+ *   Start the worker thread that formats the SYSLOG messages recorded by
+ *   the deferred SYSLOG (CONFIG_SYSLOG_DEFERRED).  This is called after the
+ *   work queues are started.  Until then, SYSLOG messages are formatted by
+ *   the caller.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_DEFERRED
+int syslog_defer_start(void);
+#endif
+
 /****************************************************************************
  * Name: syslog_file_channel
  *
@@ -266,6 +288,12 @@ int syslog_flush(void);
  *   some compilers and passing of structures in the NuttX sycalls does
  *   not work.
  *
+ * Returned Value:
+ *   The number of characters written to the SYSLOG channel.  With
+ *   CONFIG_SYSLOG_DEFERRED, a message that is recorded for the worker
+ *   thread (or dropped because the buffer is full) has not been formatted
+ *   yet and zero is returned instead.
+ *
  ****************************************************************************/
 
 int nx_vsyslog(int priority, FAR const IPTR char *src, FAR va_list *ap);
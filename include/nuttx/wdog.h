@@ -147,6 +147,11 @@ struct wdog_s
   uint8_t            flags;      /* See WDOGF_* definitions above */
   uint8_t            argc;       /* The number of parameters to pass */
   wdparm_t           parm[CONFIG_MAX_WDOGPARMS];
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  FAR struct wdog_s *prev;       /* Support for doubly linked wheel slots */
+  uint32_t           expire;     /* Expiration time in wheel ticks */
+  uint8_t            slot;       /* Wheel slot that holds the watchdog */
+#endif
 };
 
 /* Watchdog 'handle' */
@@ -40,6 +40,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
+#include <stdint.h>
 #include <poll.h>
 
 /****************************************************************************
@@ -50,6 +53,22 @@
 #define EPOLL_CTL_DEL 2 /* Remove a file descriptor from the interface.  */
 #define EPOLL_CTL_MOD 3 /* Change file descriptor epoll_event structure.  */
 
+/* Input flags that modify how events are reported.  These do not overlap
+ * any of the poll events.
+ *
+ *   EPOLLONESHOT
+ *     Report at most one event for the descriptor.  After an event has been
+ *     returned by epoll_wait(), the descriptor is disabled until it is
+ *     re-armed with EPOLL_CTL_MOD.
+ *   EPOLLET
+ *     Edge-triggered.  Events are reported only when the driver signals a
+ *     change of state; a descriptor that remains ready is not reported
+ *     again by subsequent epoll_wait() calls.
+ */
+
+#define EPOLLONESHOT  (1u << 30)
+#define EPOLLET       (1u << 31)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -78,33 +97,43 @@ enum EPOLL_EVENTS
 
 typedef union poll_data
 {
+  FAR void    *ptr;      /* Caller-defined pointer */
   int          fd;       /* The descriptor being polled */
+  uint32_t     u32;      /* Caller-defined 32-bit value */
+#ifdef CONFIG_HAVE_LONG_LONG
+  uint64_t     u64;      /* Caller-defined 64-bit value */
+#endif
 } epoll_data_t;
 
 struct epoll_event
 {
-  epoll_data_t data;
-  FAR sem_t   *sem;      /* Pointer to semaphore used to post output event */
-  pollevent_t  events;   /* The input event flags */
-  pollevent_t  revents;  /* The output event flags */
-  FAR void    *priv;     /* For use by drivers */
-};
-
-struct epoll_head
-{
-  int size;
-  int occupied;
-  FAR struct epoll_event *evs;
+  uint32_t     events;   /* The input event flags (or output events) */
+  epoll_data_t data;     /* Returned as provided by epoll_ctl() */
 };
 
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
 
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
 int epoll_create(int size);
-int epoll_ctl(int epfd, int op, int fd, struct epoll_event *ev);
-int epoll_wait(int epfd, struct epoll_event *evs, int maxevents, int timeout);
+int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev);
+int epoll_wait(int epfd, FAR struct epoll_event *evs, int maxevents,
+               int timeout);
 
 void epoll_close(int epfd);
 
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
 #endif /* __INCLUDE_SYS_EPOLL_H */
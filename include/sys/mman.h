@@ -170,13 +170,14 @@ int mlockall(int flags);
 FAR void *mmap(FAR void *start, size_t length, int prot, int flags, int fd,
                off_t offset);
 int mprotect(FAR void *addr, size_t len, int prot);
-int msync(FAR void *addr, size_t len, int flags);
 int munlock(FAR const void *addr, size_t len);
 int munlockall(void);
 
 #ifdef CONFIG_FS_RAMMAP
+int msync(FAR void *addr, size_t len, int flags);
 int munmap(FAR void *start, size_t length);
 #else
+#  define msync(addr, len, flags) (0)
 #  define munmap(start, length)
 #endif
 
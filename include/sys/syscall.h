@@ -371,7 +371,8 @@
 
 #ifdef CONFIG_FS_RAMMAP
 #  define SYS_munmap                   (__SYS_filedesc + 16)
-#  define __SYS_link                   (__SYS_filedesc + 17)
+#  define SYS_msync                    (__SYS_filedesc + 17)
+#  define __SYS_link                   (__SYS_filedesc + 18)
 #else
 #  define __SYS_link                   (__SYS_filedesc + 16)
 #endif
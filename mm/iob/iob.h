@@ -44,8 +44,12 @@
 
 #include <debug.h>
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <nuttx/mm/iob.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 
 #ifdef CONFIG_MM_IOB
 
@@ -83,6 +87,42 @@
 #endif
 #endif /* CONFIG_DEBUG_FEATURES && CONFIG_IOB_DEBUG */
 
+/* Per-CPU IOB caches */
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+#  ifdef CONFIG_SMP
+#    define IOB_NCACHES      CONFIG_SMP_NCPUS
+#  else
+#    define IOB_NCACHES      1
+#  endif
+
+/* The number of IOBs moved between a cache and the global free list */
+
+#  define IOB_CACHE_BATCH    (CONFIG_IOB_PERCPU_DEPTH / 2)
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+/* A cache of free IOBs for one CPU.  Only the owning CPU allocates from or
+ * frees to the cache, with local interrupts disabled.  In SMP, the
+ * spinlock protects against a flush from another CPU.  The cache lock is
+ * never held while entering the global critical section.
+ */
+
+struct iob_cache_s
+{
+#ifdef CONFIG_SMP
+  spinlock_t lock;                /* Protects against remote flushes */
+#endif
+  FAR struct iob_s *head;         /* List of cached, free IOBs */
+  uint16_t count;                 /* Number of IOBs in the list */
+  struct iob_cachestats_s stats;  /* Hit/miss statistics */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -115,10 +155,103 @@ extern sem_t g_throttle_sem;  /* Counts available I/O buffers when throttled */
 extern sem_t g_qentry_sem;    /* Counts free I/O buffer queue containers */
 #endif
 
+#ifdef CONFIG_IOB_PERCPU_CACHE
+/* The per-CPU IOB caches */
+
+extern struct iob_cache_s g_iob_cache[IOB_NCACHES];
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: iob_tryalloc_batch
+ *
+ * Description:
+ *   Take up to 'nbufs' IOBs from the global free list in one critical
+ *   section.  The IOBs are returned as a list linked through io_flink but
+ *   are otherwise not initialized.  If 'partial' is false, either all
+ *   'nbufs' IOBs or none are taken.
+ *
+ * Returned Value:
+ *   The number of IOBs taken.
+ *
+ ****************************************************************************/
+
+int iob_tryalloc_batch(FAR struct iob_s **list, int nbufs, bool throttled,
+                       bool partial);
+
+/****************************************************************************
+ * Name: iob_free_batch
+ *
+ * Description:
+ *   Return a list of IOBs, linked through io_flink, to the global free (or
+ *   committed) list in one critical section.  The IOBs are accounted to
+ *   'producerid' unless it is IOBUSER_UNKNOWN.
+ *
+ ****************************************************************************/
+
+void iob_free_batch(FAR struct iob_s *list, enum iob_user_e producerid);
+
+/****************************************************************************
+ * Name: iob_cache_initialize
+ *
+ * Description:
+ *   Initialize the per-CPU IOB caches.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+void iob_cache_initialize(void);
+#endif
+
+/****************************************************************************
+ * Name: iob_cache_alloc
+ *
+ * Description:
+ *   Take an IOB from the cache of the current CPU, refilling the cache from
+ *   the global free list if it is empty.  The IOB is not initialized.
+ *
+ * Returned Value:
+ *   The IOB or NULL if neither the cache nor the free list has one.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+FAR struct iob_s *iob_cache_alloc(bool throttled);
+#endif
+
+/****************************************************************************
+ * Name: iob_cache_free
+ *
+ * Description:
+ *   Put an IOB in the cache of the current CPU, spilling part of the cache
+ *   to the global free list if it is full.
+ *
+ * Returned Value:
+ *   True if the IOB was taken; false if it must be freed to the global
+ *   free list because the global free list is empty (someone may be
+ *   waiting for it).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+bool iob_cache_free(FAR struct iob_s *iob);
+#endif
+
+/****************************************************************************
+ * Name: iob_cache_flush
+ *
+ * Description:
+ *   Return the IOBs held in the caches of all CPUs to the global free list.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+void iob_cache_flush(void);
+#endif
+
 /****************************************************************************
  * Name: iob_alloc_qentry
  *
@@ -99,6 +99,94 @@ static FAR struct iob_s *iob_alloc_committed(enum iob_user_e consumerid)
   return iob;
 }
 
+/****************************************************************************
+ * Name: iob_tryalloc_internal
+ *
+ * Description:
+ *   Try to allocate an I/O buffer by taking the buffer at the head of the
+ *   global free list without waiting for a buffer to become free.
+ *
+ ****************************************************************************/
+
+static FAR struct iob_s *iob_tryalloc_internal(bool throttled,
+                                               enum iob_user_e consumerid)
+{
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+#if CONFIG_IOB_THROTTLE > 0
+  FAR sem_t *sem;
+#endif
+
+#if CONFIG_IOB_THROTTLE > 0
+  /* Select the semaphore count to check. */
+
+  sem = (throttled ? &g_throttle_sem : &g_iob_sem);
+#endif
+
+  /* We don't know what context we are called from so we use extreme measures
+   * to protect the free list:  We disable interrupts very briefly.
+   */
+
+  flags = enter_critical_section();
+
+#if CONFIG_IOB_THROTTLE > 0
+  /* If there are free I/O buffers for this allocation */
+
+  if (sem->semcount > 0)
+#endif
+    {
+      /* Take the I/O buffer from the head of the free list */
+
+      iob = g_iob_freelist;
+      if (iob != NULL)
+        {
+          /* Remove the I/O buffer from the free list and decrement the
+           * counting semaphore(s) that tracks the number of available
+           * IOBs.
+           */
+
+          g_iob_freelist = iob->io_flink;
+
+          /* Take a semaphore count.  Note that we cannot do this in
+           * in the orthodox way by calling nxsem_wait() or nxsem_trywait()
+           * because this function may be called from an interrupt
+           * handler. Fortunately we know at at least one free buffer
+           * so a simple decrement is all that is needed.
+           */
+
+          g_iob_sem.semcount--;
+          DEBUGASSERT(g_iob_sem.semcount >= 0);
+
+#if CONFIG_IOB_THROTTLE > 0
+          /* The throttle semaphore is a little more complicated because
+           * it can be negative!  Decrementing is still safe, however.
+           */
+
+          g_throttle_sem.semcount--;
+          DEBUGASSERT(g_throttle_sem.semcount >= -CONFIG_IOB_THROTTLE);
+#endif
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
+          iob_stats_onalloc(consumerid);
+#endif
+
+          leave_critical_section(flags);
+
+          /* Put the I/O buffer in a known state */
+
+          iob->io_flink  = NULL; /* Not in a chain */
+          iob->io_len    = 0;    /* Length of the data in the entry */
+          iob->io_offset = 0;    /* Offset to the beginning of data */
+          iob->io_pktlen = 0;    /* Total length of the packet */
+          return iob;
+        }
+    }
+
+  leave_critical_section(flags);
+  return NULL;
+}
+
 /****************************************************************************
  * Name: iob_allocwait
  *
@@ -124,6 +212,21 @@ static FAR struct iob_s *iob_allocwait(bool throttled,
   sem = &g_iob_sem;
 #endif
 
+#ifdef CONFIG_IOB_PERCPU_CACHE
+  /* Try the cache of this CPU first.  If that fails, return any IOBs held
+   * in the caches to the free list before we consider waiting.  This must
+   * be done outside of the critical section.
+   */
+
+  iob = iob_tryalloc(throttled, consumerid);
+  if (iob != NULL)
+    {
+      return iob;
+    }
+
+  iob_cache_flush();
+#endif
+
   /* The following must be atomic; interrupt must be disabled so that there
    * is no conflict with interrupt level I/O buffer allocations.  This is
    * not as bad as it sounds because interrupts will be re-enabled while
@@ -136,7 +239,7 @@ static FAR struct iob_s *iob_allocwait(bool throttled,
    * decremented atomically.
    */
 
-  iob = iob_tryalloc(throttled, consumerid);
+  iob = iob_tryalloc_internal(throttled, consumerid);
   while (ret == OK && iob == NULL)
     {
       /* If not successful, then the semaphore count was less than or equal
@@ -162,7 +265,7 @@ static FAR struct iob_s *iob_allocwait(bool throttled,
                */
 
               nxsem_post(sem);
-              iob = iob_tryalloc(throttled, consumerid);
+              iob = iob_tryalloc_internal(throttled, consumerid);
             }
 
           /* REVISIT: I think this logic should be moved inside of
@@ -231,78 +334,108 @@ FAR struct iob_s *iob_alloc(bool throttled, enum iob_user_e consumerid)
 
 FAR struct iob_s *iob_tryalloc(bool throttled, enum iob_user_e consumerid)
 {
+#ifdef CONFIG_IOB_PERCPU_CACHE
   FAR struct iob_s *iob;
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
   irqstate_t flags;
-#if CONFIG_IOB_THROTTLE > 0
-  FAR sem_t *sem;
 #endif
 
-#if CONFIG_IOB_THROTTLE > 0
-  /* Select the semaphore count to check. */
+  /* Try the cache of this CPU first */
 
-  sem = (throttled ? &g_throttle_sem : &g_iob_sem);
+  iob = iob_cache_alloc(throttled);
+  if (iob != NULL)
+    {
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
+      flags = enter_critical_section();
+      iob_stats_onalloc(consumerid);
+      leave_critical_section(flags);
 #endif
 
-  /* We don't know what context we are called from so we use extreme measures
-   * to protect the free list:  We disable interrupts very briefly.
-   */
-
-  flags = enter_critical_section();
-
-#if CONFIG_IOB_THROTTLE > 0
-  /* If there are free I/O buffers for this allocation */
+      /* Put the I/O buffer in a known state */
 
-  if (sem->semcount > 0)
+      iob->io_flink  = NULL; /* Not in a chain */
+      iob->io_len    = 0;    /* Length of the data in the entry */
+      iob->io_offset = 0;    /* Offset to the beginning of data */
+      iob->io_pktlen = 0;    /* Total length of the packet */
+      return iob;
+    }
 #endif
-    {
-      /* Take the I/O buffer from the head of the free list */
 
-      iob = g_iob_freelist;
-      if (iob != NULL)
-        {
-          /* Remove the I/O buffer from the free list and decrement the
-           * counting semaphore(s) that tracks the number of available
-           * IOBs.
-           */
+  return iob_tryalloc_internal(throttled, consumerid);
+}
 
-          g_iob_freelist = iob->io_flink;
+/****************************************************************************
+ * Name: iob_tryalloc_batch
+ *
+ * Description:
+ *   Take up to 'nbufs' IOBs from the global free list in one critical
+ *   section.  The IOBs are returned as a list linked through io_flink but
+ *   are otherwise not initialized.  If 'partial' is false, either all
+ *   'nbufs' IOBs or none are taken.
+ *
+ * Returned Value:
+ *   The number of IOBs taken.
+ *
+ ****************************************************************************/
 
-          /* Take a semaphore count.  Note that we cannot do this in
-           * in the orthodox way by calling nxsem_wait() or nxsem_trywait()
-           * because this function may be called from an interrupt
-           * handler. Fortunately we know at at least one free buffer
-           * so a simple decrement is all that is needed.
-           */
+int iob_tryalloc_batch(FAR struct iob_s **list, int nbufs, bool throttled,
+                       bool partial)
+{
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+  int navail;
+  int i;
 
-          g_iob_sem.semcount--;
-          DEBUGASSERT(g_iob_sem.semcount >= 0);
+  *list = NULL;
 
-#if CONFIG_IOB_THROTTLE > 0
-          /* The throttle semaphore is a little more complicated because
-           * it can be negative!  Decrementing is still safe, however.
-           */
+  flags = enter_critical_section();
 
-          g_throttle_sem.semcount--;
-          DEBUGASSERT(g_throttle_sem.semcount >= -CONFIG_IOB_THROTTLE);
-#endif
+  /* How many may we take?  The semaphore count is the number of IOBs in
+   * the free list unless there are waiters, in which case the free list is
+   * empty.
+   */
 
-#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
-    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
-          iob_stats_onalloc(consumerid);
+#if CONFIG_IOB_THROTTLE > 0
+  navail = throttled ? g_throttle_sem.semcount : g_iob_sem.semcount;
+#else
+  navail = g_iob_sem.semcount;
 #endif
 
+  if (navail < nbufs)
+    {
+      if (!partial || navail <= 0)
+        {
           leave_critical_section(flags);
+          return 0;
+        }
 
-          /* Put the I/O buffer in a known state */
+      nbufs = navail;
+    }
 
-          iob->io_flink  = NULL; /* Not in a chain */
-          iob->io_len    = 0;    /* Length of the data in the entry */
-          iob->io_offset = 0;    /* Offset to the beginning of data */
-          iob->io_pktlen = 0;    /* Total length of the packet */
-          return iob;
-        }
+  for (i = 0; i < nbufs && g_iob_freelist != NULL; i++)
+    {
+      /* Remove the I/O buffer from the free list and take a count from the
+       * semaphore(s) just as iob_tryalloc() does.
+       */
+
+      iob            = g_iob_freelist;
+      g_iob_freelist = iob->io_flink;
+      iob->io_flink  = *list;
+      *list          = iob;
+
+      g_iob_sem.semcount--;
+      DEBUGASSERT(g_iob_sem.semcount >= 0);
+
+#if CONFIG_IOB_THROTTLE > 0
+      g_throttle_sem.semcount--;
+      DEBUGASSERT(g_throttle_sem.semcount >= -CONFIG_IOB_THROTTLE);
+#endif
     }
 
   leave_critical_section(flags);
-  return NULL;
+
+  DEBUGASSERT(partial || i == nbufs);
+  return i;
 }
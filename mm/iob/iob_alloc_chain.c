@@ -0,0 +1,154 @@
+/****************************************************************************
+ * mm/iob/iob_alloc_chain.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <assert.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/sched.h>
+#include <nuttx/mm/iob.h>
+
+#include "iob.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_tryalloc_chain
+ *
+ * Description:
+ *   Try to allocate 'nbufs' I/O buffers linked together through io_flink
+ *   without waiting.  The buffers are taken from the free list in a single
+ *   critical section.  Either all 'nbufs' buffers or none are allocated.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_tryalloc_chain(int nbufs, bool throttled,
+                                     enum iob_user_e consumerid)
+{
+  FAR struct iob_s *chain;
+  FAR struct iob_s *iob;
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
+  irqstate_t flags;
+#endif
+  int ntaken;
+
+  if (nbufs <= 0)
+    {
+      return NULL;
+    }
+
+  ntaken = iob_tryalloc_batch(&chain, nbufs, throttled, false);
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+  if (ntaken == 0)
+    {
+      /* Some of the free IOBs may be held in the per-CPU caches */
+
+      iob_cache_flush();
+      ntaken = iob_tryalloc_batch(&chain, nbufs, throttled, false);
+    }
+#endif
+
+  if (ntaken == 0)
+    {
+      return NULL;
+    }
+
+  /* Put the I/O buffers in a known state */
+
+  for (iob = chain; iob != NULL; iob = iob->io_flink)
+    {
+      iob->io_len    = 0;    /* Length of the data in the entry */
+      iob->io_offset = 0;    /* Offset to the beginning of data */
+      iob->io_pktlen = 0;    /* Total length of the packet */
+    }
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
+  flags = enter_critical_section();
+  while (ntaken-- > 0)
+    {
+      iob_stats_onalloc(consumerid);
+    }
+
+  leave_critical_section(flags);
+#endif
+
+  return chain;
+}
+
+/****************************************************************************
+ * Name: iob_alloc_chain
+ *
+ * Description:
+ *   Allocate 'nbufs' I/O buffers linked together through io_flink,
+ *   waiting for them as necessary.  This is intended for drivers that
+ *   refill several receive descriptors at once.  If called from an
+ *   interrupt handler, this behaves like iob_tryalloc_chain().
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_alloc_chain(int nbufs, bool throttled,
+                                  enum iob_user_e consumerid)
+{
+  FAR struct iob_s *chain;
+  FAR struct iob_s *iob;
+  int i;
+
+  DEBUGASSERT(nbufs <= CONFIG_IOB_NBUFFERS);
+
+  /* Try to get all of the buffers at once */
+
+  chain = iob_tryalloc_chain(nbufs, throttled, consumerid);
+  if (chain != NULL || nbufs <= 0 ||
+      up_interrupt_context() || sched_idletask())
+    {
+      return chain;
+    }
+
+  /* There are not enough free buffers right now.  Collect them one at a
+   * time, waiting as necessary.
+   */
+
+  for (i = 0; i < nbufs; i++)
+    {
+      iob = iob_alloc(throttled, consumerid);
+      if (iob == NULL)
+        {
+          iob_free_chain(chain, consumerid);
+          return NULL;
+        }
+
+      iob->io_flink = chain;
+      chain         = iob;
+    }
+
+  return chain;
+}
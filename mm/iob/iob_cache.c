@@ -0,0 +1,305 @@
+/****************************************************************************
+ * mm/iob/iob_cache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
+#include <nuttx/mm/iob.h>
+
+#include "iob.h"
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+#  define iob_cache_lock(c)    spin_lock(&(c)->lock)
+#  define iob_cache_unlock(c)  spin_unlock(&(c)->lock)
+#else
+#  define iob_cache_lock(c)
+#  define iob_cache_unlock(c)
+#endif
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* The per-CPU IOB caches */
+
+struct iob_cache_s g_iob_cache[IOB_NCACHES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_cache_this
+ *
+ * Description:
+ *   Return the cache of the current CPU.  Local interrupts must be disabled
+ *   so that the caller cannot migrate to another CPU.
+ *
+ ****************************************************************************/
+
+static inline FAR struct iob_cache_s *iob_cache_this(void)
+{
+#ifdef CONFIG_SMP
+  return &g_iob_cache[up_cpu_index()];
+#else
+  return &g_iob_cache[0];
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_cache_initialize
+ *
+ * Description:
+ *   Initialize the per-CPU IOB caches.
+ *
+ ****************************************************************************/
+
+void iob_cache_initialize(void)
+{
+  int i;
+
+  memset(g_iob_cache, 0, sizeof(g_iob_cache));
+
+#ifdef CONFIG_SMP
+  for (i = 0; i < IOB_NCACHES; i++)
+    {
+      spin_initialize(&g_iob_cache[i].lock, SP_UNLOCKED);
+    }
+#else
+  UNUSED(i);
+#endif
+}
+
+/****************************************************************************
+ * Name: iob_cache_alloc
+ *
+ * Description:
+ *   Take an IOB from the cache of the current CPU, refilling the cache from
+ *   the global free list if it is empty.  The IOB is not initialized.
+ *
+ * Returned Value:
+ *   The IOB or NULL if neither the cache nor the free list has one.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_cache_alloc(bool throttled)
+{
+  FAR struct iob_cache_s *cache;
+  FAR struct iob_s *list;
+  FAR struct iob_s *tail;
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+  int nbufs;
+
+#if CONFIG_IOB_THROTTLE > 0
+  /* Cached IOBs are not counted by the semaphores.  Make sure that a
+   * throttled allocation does not dip into the reserve through the cache.
+   */
+
+  if (throttled && g_throttle_sem.semcount <= 0)
+    {
+      return NULL;
+    }
+#endif
+
+  flags = up_irq_save();
+  cache = iob_cache_this();
+
+  iob_cache_lock(cache);
+  iob = cache->head;
+  if (iob != NULL)
+    {
+      cache->head = iob->io_flink;
+      cache->count--;
+      cache->stats.hits++;
+      iob_cache_unlock(cache);
+      up_irq_restore(flags);
+      return iob;
+    }
+
+  cache->stats.misses++;
+  iob_cache_unlock(cache);
+
+  /* The cache is empty.  Refill it with a batch from the global free list.
+   * The cache lock must not be held while doing that.  Nothing can be added
+   * to the cache meanwhile because local interrupts are disabled and only
+   * this CPU ever adds to its cache.
+   */
+
+  nbufs = iob_tryalloc_batch(&list, IOB_CACHE_BATCH, throttled, true);
+  if (nbufs > 0)
+    {
+      /* Keep the first IOB for the caller and cache the rest */
+
+      iob  = list;
+      list = iob->io_flink;
+
+      if (list != NULL)
+        {
+          for (tail = list; tail->io_flink != NULL; tail = tail->io_flink)
+            {
+            }
+
+          iob_cache_lock(cache);
+          tail->io_flink = cache->head;
+          cache->head    = list;
+          cache->count  += nbufs - 1;
+          iob_cache_unlock(cache);
+        }
+    }
+
+  up_irq_restore(flags);
+  return iob;
+}
+
+/****************************************************************************
+ * Name: iob_cache_free
+ *
+ * Description:
+ *   Put an IOB in the cache of the current CPU, spilling part of the cache
+ *   to the global free list if it is full.
+ *
+ * Returned Value:
+ *   True if the IOB was taken; false if it must be freed to the global
+ *   free list because the global free list (or its unreserved part) is
+ *   empty and someone may be waiting for it.
+ *
+ ****************************************************************************/
+
+bool iob_cache_free(FAR struct iob_s *iob)
+{
+  FAR struct iob_cache_s *cache;
+  FAR struct iob_s *spill = NULL;
+  FAR struct iob_s *tail;
+  irqstate_t flags;
+  int i;
+
+  /* If the free list is empty, there may be a thread waiting for this IOB
+   * or for an IOB notification.  Likewise, if the unreserved part of the
+   * free list is empty, a throttled allocator may be waiting for it.  Don't
+   * hide the IOB in the cache.  These tests are not atomic, but at worst
+   * one IOB is cached that would be better freed; the next free will then
+   * see the waiter.
+   */
+
+  if (g_iob_sem.semcount <= 0)
+    {
+      return false;
+    }
+
+#if CONFIG_IOB_THROTTLE > 0
+  if (g_throttle_sem.semcount <= 0)
+    {
+      return false;
+    }
+#endif
+
+  flags = up_irq_save();
+  cache = iob_cache_this();
+
+  iob_cache_lock(cache);
+  if (cache->count >= CONFIG_IOB_PERCPU_DEPTH)
+    {
+      /* The cache is full.  Detach a batch to return to the free list */
+
+      spill = cache->head;
+      for (i = 1, tail = spill; i < IOB_CACHE_BATCH; i++)
+        {
+          tail = tail->io_flink;
+        }
+
+      cache->head    = tail->io_flink;
+      tail->io_flink = NULL;
+      cache->count  -= IOB_CACHE_BATCH;
+      cache->stats.spills++;
+    }
+
+  iob->io_flink = cache->head;
+  cache->head   = iob;
+  cache->count++;
+  cache->stats.frees++;
+  iob_cache_unlock(cache);
+
+  up_irq_restore(flags);
+
+  if (spill != NULL)
+    {
+      iob_free_batch(spill, IOBUSER_UNKNOWN);
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: iob_cache_flush
+ *
+ * Description:
+ *   Return the IOBs held in the caches of all CPUs to the global free list.
+ *
+ ****************************************************************************/
+
+void iob_cache_flush(void)
+{
+  FAR struct iob_cache_s *cache;
+  FAR struct iob_s *list;
+  irqstate_t flags;
+  int i;
+
+  for (i = 0; i < IOB_NCACHES; i++)
+    {
+      cache = &g_iob_cache[i];
+
+      flags = up_irq_save();
+      iob_cache_lock(cache);
+
+      list         = cache->head;
+      cache->head  = NULL;
+      cache->count = 0;
+
+      iob_cache_unlock(cache);
+      up_irq_restore(flags);
+
+      if (list != NULL)
+        {
+          iob_free_batch(list, IOBUSER_UNKNOWN);
+        }
+    }
+}
+
+#endif /* CONFIG_IOB_PERCPU_CACHE */
@@ -77,6 +77,95 @@
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: iob_free_batch
+ *
+ * Description:
+ *   Return a list of IOBs, linked through io_flink, to the global free (or
+ *   committed) list in one critical section.  The IOBs are accounted to
+ *   'producerid' unless it is IOBUSER_UNKNOWN.
+ *
+ ****************************************************************************/
+
+void iob_free_batch(FAR struct iob_s *list, enum iob_user_e producerid)
+{
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+#ifdef CONFIG_IOB_NOTIFIER
+  int16_t navail;
+#endif
+
+  /* We don't know what context we are called from so we use extreme
+   * measures to protect the free list:  We disable interrupts very briefly.
+   */
+
+  flags = enter_critical_section();
+
+  while (list != NULL)
+    {
+      iob  = list;
+      list = iob->io_flink;
+
+      /* Which list?  If there is a task waiting for an IOB, then put
+       * the IOB on either the free list or on the committed list where
+       * it is reserved for that allocation (and not available to
+       * iob_tryalloc()).
+       */
+
+      if (g_iob_sem.semcount < 0)
+        {
+          iob->io_flink   = g_iob_committed;
+          g_iob_committed = iob;
+        }
+      else
+        {
+          iob->io_flink   = g_iob_freelist;
+          g_iob_freelist  = iob;
+        }
+
+      /* Signal that an IOB is available.  If there is a thread blocked,
+       * waiting for an IOB, this will wake up exactly one thread.  The
+       * semaphore count will correctly indicated that the awakened task
+       * owns an IOB and should find it in the committed list.
+       */
+
+      nxsem_post(&g_iob_sem);
+      DEBUGASSERT(g_iob_sem.semcount <= CONFIG_IOB_NBUFFERS);
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
+      if (producerid != IOBUSER_UNKNOWN)
+        {
+          iob_stats_onfree(producerid);
+        }
+#endif
+
+#if CONFIG_IOB_THROTTLE > 0
+      nxsem_post(&g_throttle_sem);
+      DEBUGASSERT(g_throttle_sem.semcount <=
+                  (CONFIG_IOB_NBUFFERS - CONFIG_IOB_THROTTLE));
+#endif
+
+#ifdef CONFIG_IOB_NOTIFIER
+      /* Check if the IOB was claimed by a thread that is blocked waiting
+       * for an IOB.
+       */
+
+      navail = iob_navail(false);
+      if (navail > 0 && (navail & IOB_MASK) == 0)
+        {
+          /* Signal any threads that have requested a signal notification
+           * when an IOB becomes available.
+           */
+
+          iob_notifier_signal();
+        }
+#endif
+    }
+
+  leave_critical_section(flags);
+}
+
 /****************************************************************************
  * Name: iob_free
  *
@@ -90,9 +179,10 @@ FAR struct iob_s *iob_free(FAR struct iob_s *iob,
                            enum iob_user_e producerid)
 {
   FAR struct iob_s *next = iob->io_flink;
+#if defined(CONFIG_IOB_PERCPU_CACHE) && \
+    !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
+    defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
   irqstate_t flags;
-#ifdef CONFIG_IOB_NOTIFIER
-  int16_t navail;
 #endif
 
   iobinfo("iob=%p io_pktlen=%u io_len=%u next=%p\n",
@@ -128,68 +218,26 @@ FAR struct iob_s *iob_free(FAR struct iob_s *iob,
               next, next->io_pktlen, next->io_len);
     }
 
-  /* Free the I/O buffer by adding it to the head of the free or the
-   * committed list. We don't know what context we are called from so
-   * we use extreme measures to protect the free list:  We disable
-   * interrupts very briefly.
-   */
-
-  flags = enter_critical_section();
-
-  /* Which list?  If there is a task waiting for an IOB, then put
-   * the IOB on either the free list or on the committed list where
-   * it is reserved for that allocation (and not available to
-   * iob_tryalloc()).
-   */
+#ifdef CONFIG_IOB_PERCPU_CACHE
+  /* Try to keep the I/O buffer in the cache of this CPU */
 
-  if (g_iob_sem.semcount < 0)
-    {
-      iob->io_flink   = g_iob_committed;
-      g_iob_committed = iob;
-    }
-  else
+  if (iob_cache_free(iob))
     {
-      iob->io_flink   = g_iob_freelist;
-      g_iob_freelist  = iob;
-    }
-
-  /* Signal that an IOB is available.  If there is a thread blocked,
-   * waiting for an IOB, this will wake up exactly one thread.  The
-   * semaphore count will correctly indicated that the awakened task
-   * owns an IOB and should find it in the committed list.
-   */
-
-  nxsem_post(&g_iob_sem);
-  DEBUGASSERT(g_iob_sem.semcount <= CONFIG_IOB_NBUFFERS);
-
 #if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
     defined(CONFIG_MM_IOB) && !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
-  iob_stats_onfree(producerid);
+      flags = enter_critical_section();
+      iob_stats_onfree(producerid);
+      leave_critical_section(flags);
 #endif
 
-#if CONFIG_IOB_THROTTLE > 0
-  nxsem_post(&g_throttle_sem);
-  DEBUGASSERT(g_throttle_sem.semcount <=
-              (CONFIG_IOB_NBUFFERS - CONFIG_IOB_THROTTLE));
-#endif
-
-#ifdef CONFIG_IOB_NOTIFIER
-  /* Check if the IOB was claimed by a thread that is blocked waiting
-   * for an IOB.
-   */
-
-  navail = iob_navail(false);
-  if (navail > 0 && (navail & IOB_MASK) == 0)
-    {
-      /* Signal any threads that have requested a signal notification
-       * when an IOB becomes available.
-       */
-
-      iob_notifier_signal();
+      return next;
     }
 #endif
 
-  leave_critical_section(flags);
+  /* Return the I/O buffer to the global free list */
+
+  iob->io_flink = NULL;
+  iob_free_batch(iob, producerid);
 
   /* And return the I/O buffer after the one that was freed */
 
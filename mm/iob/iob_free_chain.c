@@ -53,18 +53,31 @@
  *
  * Description:
  *   Free an entire buffer chain, starting at the beginning of the I/O
- *   buffer chain
+ *   buffer chain.  The whole chain is returned to the free list at once.
  *
  ****************************************************************************/
 
 void iob_free_chain(FAR struct iob_s *iob, enum iob_user_e producerid)
 {
+#ifdef CONFIG_IOB_PERCPU_CACHE
   FAR struct iob_s *next;
 
-  /* Free each IOB in the chain -- one at a time to keep the count straight */
+  /* Free each IOB in the chain so that the per-CPU cache can absorb them.
+   * Whatever the cache cannot hold is spilled to the free list in batches.
+   */
 
   for (; iob; iob = next)
     {
       next = iob_free(iob, producerid);
     }
+#else
+  /* The chain is already linked through io_flink; return it to the free
+   * list in a single critical section.
+   */
+
+  if (iob != NULL)
+    {
+      iob_free_batch(iob, producerid);
+    }
+#endif
 }
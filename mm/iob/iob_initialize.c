@@ -154,6 +154,10 @@ void iob_initialize(void)
       nxsem_init(&g_qentry_sem, 0, CONFIG_IOB_NCHAINS);
 #endif
 
+#ifdef CONFIG_IOB_PERCPU_CACHE
+      iob_cache_initialize();
+#endif
+
       initialized = true;
     }
 }
@@ -42,10 +42,14 @@
 #include <sys/types.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <debug.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/mm/iob.h>
 
+#include "iob.h"
+
 #if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS) && \
     !defined(CONFIG_FS_PROCFS_EXCLUDE_IOBINFO)
 
@@ -129,5 +133,49 @@ FAR struct iob_userstats_s * iob_getuserstats(enum iob_user_e userid)
   return &g_iobuserstats[userid];
 }
 
+/****************************************************************************
+ * Name: iob_getcachestats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of the per-CPU IOB cache of 'cpu'.
+ *
+ * Input Parameters:
+ *   cpu   - The CPU index
+ *   stats - Location to return the statistics
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -EINVAL if 'cpu' has no cache.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_IOB_PERCPU_CACHE
+int iob_getcachestats(int cpu, FAR struct iob_cachestats_s *stats)
+{
+  FAR struct iob_cache_s *cache;
+  irqstate_t flags;
+
+  if (cpu < 0 || cpu >= IOB_NCACHES)
+    {
+      return -EINVAL;
+    }
+
+  cache = &g_iob_cache[cpu];
+
+  flags = up_irq_save();
+#ifdef CONFIG_SMP
+  spin_lock(&cache->lock);
+#endif
+
+  memcpy(stats, &cache->stats, sizeof(struct iob_cachestats_s));
+
+#ifdef CONFIG_SMP
+  spin_unlock(&cache->lock);
+#endif
+  up_irq_restore(flags);
+
+  return OK;
+}
+#endif
+
 #endif /* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS &&
         * !CONFIG_FS_PROCFS_EXCLUDE_IOBINFO */
@@ -59,10 +59,6 @@
 
 void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 {
-  FAR struct mm_freenode_s *node;
-  FAR struct mm_freenode_s *prev;
-  FAR struct mm_freenode_s *next;
-
   minfo("Freeing %p\n", mem);
 
   /* Protect against attempts to free a NULL reference */
@@ -72,6 +68,33 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
       return;
     }
 
+#ifdef CONFIG_MM_QUICKLIST
+  /* Keep small chunks in the quick lists if there is room */
+
+  if (mm_quickfree(heap, mem))
+    {
+      return;
+    }
+#endif
+
+  mm_freechunk(heap, mem);
+}
+
+/****************************************************************************
+ * Name: mm_freechunk
+ *
+ * Description:
+ *   Returns a chunk of memory to the list of free nodes as with mm_free(),
+ *   but bypassing the quick lists.
+ *
+ ****************************************************************************/
+
+void mm_freechunk(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+  FAR struct mm_freenode_s *node;
+  FAR struct mm_freenode_s *prev;
+  FAR struct mm_freenode_s *next;
+
   /* We need to hold the MM semaphore while we muck with the
    * nodelist.
    */
@@ -75,6 +75,14 @@ int mm_mallinfo(FAR struct mm_heap_s *heap, FAR struct mallinfo *info)
 
   DEBUGASSERT(info);
 
+#ifdef CONFIG_MM_QUICKLIST
+  /* Chunks in the quick lists look allocated.  Return them to the heap so
+   * that the statistics reflect the real usage.
+   */
+
+  mm_quickflush(heap);
+#endif
+
   /* Visit each region */
 
 #if CONFIG_MM_REGIONS > 1
@@ -92,10 +92,27 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
   DEBUGASSERT(alignsize >= MM_MIN_CHUNK);
   DEBUGASSERT(alignsize >= SIZEOF_MM_FREENODE);
 
+#ifdef CONFIG_MM_QUICKLIST
+  /* Try the quick list for chunks of this size first */
+
+  ret = mm_quickalloc(heap, alignsize);
+  if (ret != NULL)
+    {
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+      memset(ret, 0xaa, alignsize - SIZEOF_MM_ALLOCNODE);
+#endif
+      return ret;
+    }
+#endif
+
   /* We need to hold the MM semaphore while we muck with the nodelist. */
 
   mm_takesemaphore(heap);
 
+#ifdef CONFIG_MM_QUICKLIST
+retry:
+#endif
+
   /* Get the location in the node list to start the search. Special case
    * really big allocations
    */
@@ -188,6 +205,17 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
       ret = (void *)((FAR char *)node + SIZEOF_MM_ALLOCNODE);
     }
 
+#ifdef CONFIG_MM_QUICKLIST
+  /* If there is no chunk large enough, then return the chunks held in the
+   * quick lists to the heap and try again.
+   */
+
+  else if (mm_quickflush(heap))
+    {
+      goto retry;
+    }
+#endif
+
   DEBUGASSERT(ret == NULL || mm_heapmember(heap, ret));
   mm_givesemaphore(heap);
 
@@ -0,0 +1,265 @@
+/****************************************************************************
+ * mm/mm_heap/mm_quicklist.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
+#include <nuttx/mm/mm.h>
+
+#ifdef CONFIG_MM_QUICKLIST
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_quicklock and mm_quickunlock
+ *
+ * Description:
+ *   Get exclusive access to the quick lists of the current CPU.  Local
+ *   interrupts are disabled so that the caller can neither be preempted
+ *   nor migrate to another CPU.  In SMP, the spinlock protects against a
+ *   flush from another CPU.
+ *
+ ****************************************************************************/
+
+static inline FAR struct mm_quickcache_s *
+mm_quicklock(FAR struct mm_heap_s *heap, FAR irqstate_t *flags)
+{
+  FAR struct mm_quickcache_s *cache;
+
+  *flags = up_irq_save();
+
+#ifdef CONFIG_SMP
+  cache = &heap->mm_quick[up_cpu_index()];
+  spin_lock(&cache->lock);
+#else
+  cache = &heap->mm_quick[0];
+#endif
+
+  return cache;
+}
+
+static inline void mm_quickunlock(FAR struct mm_quickcache_s *cache,
+                                  irqstate_t flags)
+{
+#ifdef CONFIG_SMP
+  spin_unlock(&cache->lock);
+#endif
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_quickinitialize
+ *
+ * Description:
+ *   Initialize the quick lists of a heap.
+ *
+ ****************************************************************************/
+
+void mm_quickinitialize(FAR struct mm_heap_s *heap)
+{
+  int i;
+
+  memset(heap->mm_quick, 0, sizeof(heap->mm_quick));
+
+#ifdef CONFIG_SMP
+  for (i = 0; i < MM_QUICK_NCACHES; i++)
+    {
+      spin_initialize(&heap->mm_quick[i].lock, SP_UNLOCKED);
+    }
+#else
+  UNUSED(i);
+#endif
+}
+
+/****************************************************************************
+ * Name: mm_quickalloc
+ *
+ * Description:
+ *   Take a chunk of exactly 'alignsize' bytes from the quick lists of the
+ *   current CPU.
+ *
+ * Returned Value:
+ *   The user memory of the chunk or NULL if there is no such chunk.
+ *
+ ****************************************************************************/
+
+FAR void *mm_quickalloc(FAR struct mm_heap_s *heap, size_t alignsize)
+{
+  FAR struct mm_quickcache_s *cache;
+  FAR struct mm_quicknode_s *node;
+  irqstate_t flags;
+  int ndx;
+
+  if (alignsize > MM_QUICK_MAXCHUNK)
+    {
+      return NULL;
+    }
+
+  ndx   = MM_QUICK_NDX(alignsize);
+  cache = mm_quicklock(heap, &flags);
+
+  node = cache->head[ndx];
+  if (node != NULL)
+    {
+      cache->head[ndx] = node->flink;
+      cache->count[ndx]--;
+    }
+
+  mm_quickunlock(cache, flags);
+
+  if (node == NULL)
+    {
+      return NULL;
+    }
+
+  DEBUGASSERT(node->size == alignsize &&
+              (node->preceding & MM_ALLOC_BIT) != 0);
+  return (FAR char *)node + SIZEOF_MM_ALLOCNODE;
+}
+
+/****************************************************************************
+ * Name: mm_quickfree
+ *
+ * Description:
+ *   Put the chunk of 'mem' in the quick lists of the current CPU if it is
+ *   small enough and the list has room.
+ *
+ * Returned Value:
+ *   True if the chunk was taken, false if it must be freed to the heap.
+ *
+ ****************************************************************************/
+
+bool mm_quickfree(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+  FAR struct mm_quickcache_s *cache;
+  FAR struct mm_quicknode_s *node;
+  irqstate_t flags;
+  bool ret = false;
+  int ndx;
+
+  node = (FAR struct mm_quicknode_s *)
+         ((FAR char *)mem - SIZEOF_MM_ALLOCNODE);
+  DEBUGASSERT((node->preceding & MM_ALLOC_BIT) != 0);
+
+  if (node->size > MM_QUICK_MAXCHUNK)
+    {
+      return false;
+    }
+
+  ndx   = MM_QUICK_NDX(node->size);
+  cache = mm_quicklock(heap, &flags);
+
+  if (cache->count[ndx] < CONFIG_MM_QUICKLIST_DEPTH)
+    {
+      node->flink      = cache->head[ndx];
+      cache->head[ndx] = node;
+      cache->count[ndx]++;
+      ret              = true;
+    }
+
+  mm_quickunlock(cache, flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: mm_quickflush
+ *
+ * Description:
+ *   Return the chunks in the quick lists of all CPUs to the heap so that
+ *   they can be coalesced with their neighbors.
+ *
+ * Returned Value:
+ *   True if any chunk was returned to the heap.
+ *
+ ****************************************************************************/
+
+bool mm_quickflush(FAR struct mm_heap_s *heap)
+{
+  FAR struct mm_quickcache_s *cache;
+  FAR struct mm_quicknode_s *chain = NULL;
+  FAR struct mm_quicknode_s *node;
+  FAR struct mm_quicknode_s *next;
+  irqstate_t flags;
+  int i;
+  int j;
+
+  /* Detach the chunks from all of the lists */
+
+  for (i = 0; i < MM_QUICK_NCACHES; i++)
+    {
+      cache = &heap->mm_quick[i];
+
+      flags = up_irq_save();
+#ifdef CONFIG_SMP
+      spin_lock(&cache->lock);
+#endif
+
+      for (j = 0; j < MM_QUICK_NLISTS; j++)
+        {
+          for (node = cache->head[j]; node != NULL; node = next)
+            {
+              next        = node->flink;
+              node->flink = chain;
+              chain       = node;
+            }
+
+          cache->head[j]  = NULL;
+          cache->count[j] = 0;
+        }
+
+#ifdef CONFIG_SMP
+      spin_unlock(&cache->lock);
+#endif
+      up_irq_restore(flags);
+    }
+
+  /* Then free them to the heap */
+
+  if (chain == NULL)
+    {
+      return false;
+    }
+
+  for (node = chain; node != NULL; node = next)
+    {
+      next = node->flink;
+      mm_freechunk(heap, (FAR char *)node + SIZEOF_MM_ALLOCNODE);
+    }
+
+  return true;
+}
+
+#endif /* CONFIG_MM_QUICKLIST */
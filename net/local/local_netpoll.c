@@ -129,6 +129,26 @@ errout:
 }
 #endif
 
+/****************************************************************************
+ * Name: local_inout_pollnotify
+ *
+ * Description:
+ *   Notification callback of the shadow pollfds used when both POLLIN and
+ *   POLLOUT are requested.  Forward the events to the caller's pollfd so
+ *   that its own callback (e.g. epoll) or semaphore is used.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_LOCAL_STREAM
+static void local_inout_pollnotify(FAR struct pollfd *shadowfds)
+{
+  FAR struct pollfd *fds = (FAR struct pollfd *)shadowfds->arg;
+
+  DEBUGASSERT(fds != NULL);
+  poll_notify(&fds, 1, shadowfds->revents);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -152,7 +172,7 @@ void local_accept_pollnotify(FAR struct local_conn_s *conn,
           if (fds->revents != 0)
             {
               ninfo("Report events: %02x\n", fds->revents);
-              nxsem_post(fds->sem);
+              poll_notify(&fds, 1, 0);
             }
         }
     }
@@ -230,13 +250,19 @@ int local_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
                 }
             }
 
-          shadowfds[0].fd     = 1; /* Does not matter */
-          shadowfds[0].sem    = fds->sem;
-          shadowfds[0].events = fds->events & ~POLLOUT;
+          shadowfds[0].fd      = 1; /* Does not matter */
+          shadowfds[0].sem     = fds->sem;
+          shadowfds[0].events  = fds->events & ~POLLOUT;
+          shadowfds[0].revents = 0;
+          shadowfds[0].cb      = local_inout_pollnotify;
+          shadowfds[0].arg     = fds;
 
-          shadowfds[1].fd     = 0; /* Does not matter */
-          shadowfds[1].sem    = fds->sem;
-          shadowfds[1].events = fds->events & ~POLLIN;
+          shadowfds[1].fd      = 0; /* Does not matter */
+          shadowfds[1].sem     = fds->sem;
+          shadowfds[1].events  = fds->events & ~POLLIN;
+          shadowfds[1].revents = 0;
+          shadowfds[1].cb      = local_inout_pollnotify;
+          shadowfds[1].arg     = fds;
 
           net_unlock();
 
@@ -303,8 +329,7 @@ int local_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
   return ret;
 
 pollerr:
-  fds->revents |= POLLERR;
-  nxsem_post(fds->sem);
+  poll_notify(&fds, 1, POLLERR);
   return OK;
 }
 
@@ -47,6 +47,7 @@
 #include <debug.h>
 #include <assert.h>
 
+#include <nuttx/fs/fs.h>
 #include <nuttx/net/net.h>
 
 #include "socket/socket.h"
@@ -85,6 +86,12 @@ int psock_close(FAR struct socket *psock)
       return -EBADF;
     }
 
+  /* Remove the socket from any epoll interest list while it is still
+   * connected.
+   */
+
+  epoll_sockclose(psock);
+
   /* We perform the close operation only if this is the last count on
    * the socket. (actually, I think the socket crefs only takes the values
    * 0 and 1 right now).
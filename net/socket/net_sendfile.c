@@ -128,7 +128,7 @@ ssize_t net_sendfile(int outfd, FAR struct file *infile, FAR off_t *offset,
 
   /* Verify that the sockfd corresponds to valid, allocated socket */
 
-  if (psock != NULL || psock->s_crefs <= 0)
+  if (psock == NULL || psock->s_crefs <= 0)
     {
       nerr("ERROR: Invalid socket\n");
       _SO_SETERRNO(psock, EBADF);
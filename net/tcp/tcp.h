@@ -265,6 +265,21 @@ struct tcp_conn_s
   uint8_t    keepretries; /* Number of retries attempted */
 #endif
 
+#ifdef CONFIG_NET_TCP_CONNHASH
+  /* Hash table membership (see tcp_conn.c)
+   *
+   *   hnode     - Link in the hash of active connections, keyed by the
+   *               local and remote ports and the remote address.
+   *   pnode     - Link in the hash of bound connections, keyed by the local
+   *               port.
+   *   hashflags - Indicates the hash tables that the connection is in.
+   */
+
+  dq_entry_t hnode;
+  dq_entry_t pnode;
+  uint8_t    hashflags;
+#endif
+
   /* connevents is a list of callbacks for each socket the uses this
    * connection (there can be more that one in the event that the the socket
    * was dup'ed).  It is used with the network monitor to handle
@@ -54,6 +54,7 @@
 
 #include <arch/irq.h>
 
+#include <nuttx/nuttx.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev.h>
@@ -71,6 +72,25 @@
 #define IPv4BUF ((struct ipv4_hdr_s *)&dev->d_buf[NET_LL_HDRLEN(dev)])
 #define IPv6BUF ((struct ipv6_hdr_s *)&dev->d_buf[NET_LL_HDRLEN(dev)])
 
+#ifdef CONFIG_NET_TCP_CONNHASH
+/* Bits in struct tcp_conn_s hashflags */
+
+#  define TCP_HASH_ACTIVE  (1 << 0) /* Connection is in g_tcp_activehash[] */
+#  define TCP_HASH_PORT    (1 << 1) /* Connection is in g_tcp_porthash[] */
+
+/* Get the connection from a link in one of the hash tables */
+
+#  define ACTIVE2CONN(n)   container_of(n, struct tcp_conn_s, hnode)
+#  define PORT2CONN(n)     container_of(n, struct tcp_conn_s, pnode)
+#else
+#  define ACTIVE2CONN(n)   ((FAR struct tcp_conn_s *)(n))
+
+#  define tcp_hash_active(c)
+#  define tcp_hash_port(c)
+#  define tcp_unhash_port(c)
+#  define tcp_unhash(c)
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -91,10 +111,157 @@ static dq_queue_t g_active_tcp_connections;
 
 static uint16_t g_last_tcp_port;
 
+#ifdef CONFIG_NET_TCP_CONNHASH
+/* Active connections hashed by local port, remote port and remote address
+ * and bound connections hashed by local port.
+ */
+
+static dq_queue_t g_tcp_activehash[CONFIG_NET_TCP_CONNHASH_SIZE];
+static dq_queue_t g_tcp_porthash[CONFIG_NET_TCP_CONNHASH_SIZE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_porthash, tcp_ipv4_hash, and tcp_ipv6_hash
+ *
+ * Description:
+ *   Return the hash bucket index for a local port number or for the
+ *   (local port, remote port, remote address) of an active connection.
+ *   Port numbers and addresses are in network byte order.  The local
+ *   address is not part of the key because a connection may be bound to
+ *   the wildcard address.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_CONNHASH
+static inline unsigned int tcp_hashfold(uint32_t hash)
+{
+  hash ^= hash >> 16;
+  hash ^= hash >> 8;
+  return hash % CONFIG_NET_TCP_CONNHASH_SIZE;
+}
+
+static inline unsigned int tcp_porthash(uint16_t portno)
+{
+  return tcp_hashfold(portno);
+}
+
+#ifdef CONFIG_NET_IPv4
+static inline unsigned int tcp_ipv4_hash(uint16_t lport, uint16_t rport,
+                                         in_addr_t raddr)
+{
+  return tcp_hashfold((uint32_t)raddr ^ ((uint32_t)lport << 16) ^ rport);
+}
+#endif
+
+#ifdef CONFIG_NET_IPv6
+static inline unsigned int tcp_ipv6_hash(uint16_t lport, uint16_t rport,
+                                         const net_ipv6addr_t raddr)
+{
+  uint32_t hash = ((uint32_t)lport << 16) ^ rport;
+  int i;
+
+  for (i = 0; i < 8; i += 2)
+    {
+      hash ^= ((uint32_t)raddr[i] << 16) | raddr[i + 1];
+    }
+
+  return tcp_hashfold(hash);
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_activehash
+ *
+ * Description:
+ *   Return the active connection hash bucket for the connection.
+ *
+ ****************************************************************************/
+
+static FAR dq_queue_t *tcp_activehash(FAR struct tcp_conn_s *conn)
+{
+  unsigned int ndx;
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (conn->domain == PF_INET)
+#endif
+    {
+      ndx = tcp_ipv4_hash(conn->lport, conn->rport, conn->u.ipv4.raddr);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      ndx = tcp_ipv6_hash(conn->lport, conn->rport, conn->u.ipv6.raddr);
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+  return &g_tcp_activehash[ndx];
+}
+
+/****************************************************************************
+ * Name: tcp_hash_active, tcp_hash_port, tcp_unhash_port, and tcp_unhash
+ *
+ * Description:
+ *   Add or remove a connection to/from the hash tables.  A connection is
+ *   added to the active hash when it is added to the list of active
+ *   connections and to the port hash whenever it is assigned a local port.
+ *   The key fields must not be modified while the connection is hashed.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+static void tcp_hash_active(FAR struct tcp_conn_s *conn)
+{
+  DEBUGASSERT((conn->hashflags & TCP_HASH_ACTIVE) == 0);
+
+  dq_addlast(&conn->hnode, tcp_activehash(conn));
+  conn->hashflags |= TCP_HASH_ACTIVE;
+}
+
+static void tcp_unhash_port(FAR struct tcp_conn_s *conn)
+{
+  if ((conn->hashflags & TCP_HASH_PORT) != 0)
+    {
+      dq_rem(&conn->pnode, &g_tcp_porthash[tcp_porthash(conn->lport)]);
+      conn->hashflags &= ~TCP_HASH_PORT;
+    }
+}
+
+static void tcp_hash_port(FAR struct tcp_conn_s *conn)
+{
+  /* The connection may be re-bound to a different port */
+
+  tcp_unhash_port(conn);
+
+  if (conn->lport != 0)
+    {
+      dq_addlast(&conn->pnode, &g_tcp_porthash[tcp_porthash(conn->lport)]);
+      conn->hashflags |= TCP_HASH_PORT;
+    }
+}
+
+static void tcp_unhash(FAR struct tcp_conn_s *conn)
+{
+  if ((conn->hashflags & TCP_HASH_ACTIVE) != 0)
+    {
+      dq_rem(&conn->hnode, tcp_activehash(conn));
+      conn->hashflags &= ~TCP_HASH_ACTIVE;
+    }
+
+  tcp_unhash_port(conn);
+}
+#endif /* CONFIG_NET_TCP_CONNHASH */
+
 /****************************************************************************
  * Name: tcp_ipv4_listener
  *
@@ -108,10 +275,37 @@ static uint16_t g_last_tcp_port;
  ****************************************************************************/
 
 #ifdef CONFIG_NET_IPv4
+static inline bool tcp_ipv4_portmatch(FAR struct tcp_conn_s *conn,
+                                      in_addr_t ipaddr, uint16_t portno)
+{
+  /* Check if this connection is open and the local port assignment
+   * matches the requested port number.
+   *
+   * If there are multiple interface devices, then the local IP address of
+   * the connection must also match.  INADDR_ANY is a special case:  There
+   * can only be instance of a port number with INADDR_ANY.
+   */
+
+  return conn->tcpstateflags != TCP_CLOSED && conn->lport == portno &&
+         (net_ipv4addr_cmp(conn->u.ipv4.laddr, ipaddr) ||
+          net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY));
+}
+
 static inline FAR struct tcp_conn_s *tcp_ipv4_listener(in_addr_t ipaddr,
                                                        uint16_t portno)
 {
   FAR struct tcp_conn_s *conn;
+#ifdef CONFIG_NET_TCP_CONNHASH
+  FAR dq_entry_t *node;
+
+  /* Only the connections bound to this port need to be examined */
+
+  for (node = dq_peek(&g_tcp_porthash[tcp_porthash(portno)]);
+       node != NULL;
+       node = dq_next(node))
+    {
+      conn = PORT2CONN(node);
+#else
   int i;
 
   /* Check if this port number is in use by any active UIP TCP connection */
@@ -119,26 +313,13 @@ static inline FAR struct tcp_conn_s *tcp_ipv4_listener(in_addr_t ipaddr,
   for (i = 0; i < CONFIG_NET_TCP_CONNS; i++)
     {
       conn = &g_tcp_connections[i];
+#endif
 
-      /* Check if this connection is open and the local port assignment
-       * matches the requested port number.
-       */
-
-      if (conn->tcpstateflags != TCP_CLOSED && conn->lport == portno)
+      if (tcp_ipv4_portmatch(conn, ipaddr, portno))
         {
-          /* If there are multiple interface devices, then the local IP
-           * address of the connection must also match.  INADDR_ANY is a
-           * special case:  There can only be instance of a port number
-           * with INADDR_ANY.
-           */
-
-          if (net_ipv4addr_cmp(conn->u.ipv4.laddr, ipaddr) ||
-              net_ipv4addr_cmp(conn->u.ipv4.laddr, INADDR_ANY))
-            {
-              /* The port number is in use, return the connection */
+          /* The port number is in use, return the connection */
 
-              return conn;
-            }
+          return conn;
         }
     }
 
@@ -159,10 +340,39 @@ static inline FAR struct tcp_conn_s *tcp_ipv4_listener(in_addr_t ipaddr,
  ****************************************************************************/
 
 #ifdef CONFIG_NET_IPv6
+static inline bool tcp_ipv6_portmatch(FAR struct tcp_conn_s *conn,
+                                      const net_ipv6addr_t ipaddr,
+                                      uint16_t portno)
+{
+  /* Check if this connection is open and the local port assignment
+   * matches the requested port number.
+   *
+   * If there are multiple interface devices, then the local IP address of
+   * the connection must also match.  The IPv6 unspecified address is a
+   * special case:  There can only be one instance of a port number with
+   * the unspecified address.
+   */
+
+  return conn->tcpstateflags != TCP_CLOSED && conn->lport == portno &&
+         (net_ipv6addr_cmp(conn->u.ipv6.laddr, ipaddr) ||
+          net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr));
+}
+
 static inline FAR struct tcp_conn_s *
 tcp_ipv6_listener(const net_ipv6addr_t ipaddr, uint16_t portno)
 {
   FAR struct tcp_conn_s *conn;
+#ifdef CONFIG_NET_TCP_CONNHASH
+  FAR dq_entry_t *node;
+
+  /* Only the connections bound to this port need to be examined */
+
+  for (node = dq_peek(&g_tcp_porthash[tcp_porthash(portno)]);
+       node != NULL;
+       node = dq_next(node))
+    {
+      conn = PORT2CONN(node);
+#else
   int i;
 
   /* Check if this port number is in use by any active UIP TCP connection */
@@ -170,26 +380,13 @@ tcp_ipv6_listener(const net_ipv6addr_t ipaddr, uint16_t portno)
   for (i = 0; i < CONFIG_NET_TCP_CONNS; i++)
     {
       conn = &g_tcp_connections[i];
+#endif
 
-      /* Check if this connection is open and the local port assignment
-       * matches the requested port number.
-       */
-
-      if (conn->tcpstateflags != TCP_CLOSED && conn->lport == portno)
+      if (tcp_ipv6_portmatch(conn, ipaddr, portno))
         {
-          /* If there are multiple interface devices, then the local IP
-           * address of the connection must also match.  The IPv6
-           * unspecified address is a special case:  There can only be
-           * one instance of a port number with the unspecified address.
-           */
+          /* The port number is in use, return the connection */
 
-          if (net_ipv6addr_cmp(conn->u.ipv6.laddr, ipaddr) ||
-              net_ipv6addr_cmp(conn->u.ipv6.laddr, g_ipv6_unspecaddr))
-            {
-              /* The port number is in use, return the connection */
-
-              return conn;
-            }
+          return conn;
         }
     }
 
@@ -323,15 +520,27 @@ static inline FAR struct tcp_conn_s *
 {
   FAR struct ipv4_hdr_s *ip = IPv4BUF;
   FAR struct tcp_conn_s *conn;
+  FAR dq_entry_t *node;
   in_addr_t srcipaddr;
   in_addr_t destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = net_ip4addr_conv32(ip->srcipaddr);
   destipaddr = net_ip4addr_conv32(ip->destipaddr);
 
-  while (conn)
+#ifdef CONFIG_NET_TCP_CONNHASH
+  /* Only the active connections in the same hash bucket can match */
+
+  node = dq_peek(&g_tcp_activehash[tcp_ipv4_hash(tcp->destport,
+                                                 tcp->srcport,
+                                                 srcipaddr)]);
+#else
+  node = dq_peek(&g_active_tcp_connections);
+#endif
+
+  for (; node != NULL; node = dq_next(node))
     {
+      conn = ACTIVE2CONN(node);
+
       /* Find an open connection matching the TCP input. The following
        * checks are performed:
        *
@@ -356,19 +565,13 @@ static inline FAR struct tcp_conn_s *
            net_ipv4addr_cmp(destipaddr, conn->u.ipv4.laddr)) &&
           net_ipv4addr_cmp(srcipaddr, conn->u.ipv4.raddr))
         {
-          /* Matching connection found.. break out of the loop and return a
-           * reference to it.
-           */
+          /* Matching connection found.. return a reference to it. */
 
-          break;
+          return conn;
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct tcp_conn_s *)conn->node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -390,15 +593,27 @@ static inline FAR struct tcp_conn_s *
 {
   FAR struct ipv6_hdr_s *ip = IPv6BUF;
   FAR struct tcp_conn_s *conn;
+  FAR dq_entry_t *node;
   net_ipv6addr_t *srcipaddr;
   net_ipv6addr_t *destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = (net_ipv6addr_t *)ip->srcipaddr;
   destipaddr = (net_ipv6addr_t *)ip->destipaddr;
 
-  while (conn)
+#ifdef CONFIG_NET_TCP_CONNHASH
+  /* Only the active connections in the same hash bucket can match */
+
+  node = dq_peek(&g_tcp_activehash[tcp_ipv6_hash(tcp->destport,
+                                                 tcp->srcport,
+                                                 *srcipaddr)]);
+#else
+  node = dq_peek(&g_active_tcp_connections);
+#endif
+
+  for (; node != NULL; node = dq_next(node))
     {
+      conn = ACTIVE2CONN(node);
+
       /* Find an open connection matching the TCP input. The following
        * checks are performed:
        *
@@ -423,19 +638,13 @@ static inline FAR struct tcp_conn_s *
            net_ipv6addr_cmp(*destipaddr, conn->u.ipv6.laddr)) &&
           net_ipv6addr_cmp(*srcipaddr, conn->u.ipv6.raddr))
         {
-          /* Matching connection found.. break out of the loop and return a
-           * reference to it.
-           */
+          /* Matching connection found.. return a reference to it. */
 
-          break;
+          return conn;
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct tcp_conn_s *)conn->node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -480,6 +689,7 @@ static inline int tcp_ipv4_bind(FAR struct tcp_conn_s *conn,
 
   conn->lport = htons(port);
   net_ipv4addr_copy(conn->u.ipv4.laddr, addr->sin_addr.s_addr);
+  tcp_hash_port(conn);
 
   /* Find the device that can receive packets on the network associated with
    * this local address.
@@ -494,6 +704,7 @@ static inline int tcp_ipv4_bind(FAR struct tcp_conn_s *conn,
 
       /* Back out the local address setting */
 
+      tcp_unhash_port(conn);
       conn->lport = 0;
       net_ipv4addr_copy(conn->u.ipv4.laddr, INADDR_ANY);
       return ret;
@@ -547,6 +758,7 @@ static inline int tcp_ipv6_bind(FAR struct tcp_conn_s *conn,
 
   conn->lport = htons(port);
   net_ipv6addr_copy(conn->u.ipv6.laddr, addr->sin6_addr.in6_u.u6_addr16);
+  tcp_hash_port(conn);
 
   /* Find the device that can receive packets on the network
    * associated with this local address.
@@ -561,6 +773,7 @@ static inline int tcp_ipv6_bind(FAR struct tcp_conn_s *conn,
 
       /* Back out the local address setting */
 
+      tcp_unhash_port(conn);
       conn->lport = 0;
       net_ipv6addr_copy(conn->u.ipv6.laddr, g_ipv6_unspecaddr);
       return ret;
@@ -593,6 +806,14 @@ void tcp_initialize(void)
   dq_init(&g_free_tcp_connections);
   dq_init(&g_active_tcp_connections);
 
+#ifdef CONFIG_NET_TCP_CONNHASH
+  for (i = 0; i < CONFIG_NET_TCP_CONNHASH_SIZE; i++)
+    {
+      dq_init(&g_tcp_activehash[i]);
+      dq_init(&g_tcp_porthash[i]);
+    }
+#endif
+
   /* Now initialize each connection structure */
 
   for (i = 0; i < CONFIG_NET_TCP_CONNS; i++)
@@ -774,6 +995,10 @@ void tcp_free(FAR struct tcp_conn_s *conn)
       dq_rem(&conn->node, &g_active_tcp_connections);
     }
 
+  /* Remove the connection from the hash tables */
+
+  tcp_unhash(conn);
+
   /* Release any read-ahead buffers attached to the connection */
 
   iob_free_queue(&conn->readahead, IOBUSER_NET_TCP_READAHEAD);
@@ -1033,6 +1258,8 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
        */
 
       dq_addlast(&conn->node, &g_active_tcp_connections);
+      tcp_hash_active(conn);
+      tcp_hash_port(conn);
     }
 
   return conn;
@@ -1266,6 +1493,8 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
   /* And, finally, put the connection structure into the active list. */
 
   dq_addlast(&conn->node, &g_active_tcp_connections);
+  tcp_hash_active(conn);
+  tcp_hash_port(conn);
   ret = OK;
 
 errout_with_lock:
@@ -45,6 +45,7 @@
 #include <poll.h>
 #include <debug.h>
 
+#include <nuttx/fs/fs.h>
 #include <nuttx/net/net.h>
 #include <nuttx/semaphore.h>
 
@@ -122,14 +123,19 @@ static uint16_t tcp_poll_eventhandler(FAR struct net_driver_s *dev,
 
       if (eventset != 0)
         {
-          /* Stop further callbacks */
+          /* Stop further callbacks unless the waiter registered a
+           * notification callback:  Such waiters (epoll) keep the poll
+           * setup in place across multiple events.
+           */
 
-          info->cb->flags   = 0;
-          info->cb->priv    = NULL;
-          info->cb->event   = NULL;
+          if (info->fds->cb == NULL)
+            {
+              info->cb->flags = 0;
+              info->cb->priv  = NULL;
+              info->cb->event = NULL;
+            }
 
-          info->fds->revents |= eventset;
-          nxsem_post(info->fds->sem);
+          poll_notify(&info->fds, 1, eventset);
         }
     }
 
@@ -176,8 +182,7 @@ static inline void tcp_iob_work(FAR void *arg)
            * exceptional event.
            */
 
-          fds->revents |= (POLLERR | POLLHUP);
-          nxsem_post(fds->sem);
+          poll_notify(&fds, 1, POLLERR | POLLHUP);
         }
     }
 
@@ -194,8 +199,7 @@ static inline void tcp_iob_work(FAR void *arg)
         {
           /* Yes.. then signal the poll logic */
 
-          fds->revents |= POLLWRNORM;
-          nxsem_post(fds->sem);
+          poll_notify(&fds, 1, POLLWRNORM);
         }
       else
         {
@@ -371,7 +375,7 @@ int tcp_pollsetup(FAR struct socket *psock, FAR struct pollfd *fds)
     {
       /* Yes.. then signal the poll logic */
 
-      nxsem_post(fds->sem);
+      poll_notify(&fds, 1, 0);
     }
 
 #if defined(CONFIG_NET_TCP_WRITE_BUFFERS) && defined(CONFIG_IOB_NOTIFIER)
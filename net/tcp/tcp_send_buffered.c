@@ -64,6 +64,7 @@
 #include <arch/irq.h>
 #include <nuttx/net/net.h>
 #include <nuttx/mm/iob.h>
+#include <nuttx/fs/fs.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/arp.h>
 #include <nuttx/net/tcp.h>
@@ -871,6 +872,145 @@ static inline void send_txnotify(FAR struct socket *psock,
 #endif /* CONFIG_NET_IPv6 */
 }
 
+/****************************************************************************
+ * Name: send_setupcb
+ *
+ * Description:
+ *   Allocate (if necessary) and set up the socket's send callback so that
+ *   psock_send_eventhandler() will drain conn->write_q.
+ *
+ * Input Parameters:
+ *   psock - Socket state structure
+ *   conn  - The TCP connection structure
+ *
+ * Returned Value:
+ *   OK on success; -ENOMEM if no callback structure could be allocated.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+static int send_setupcb(FAR struct socket *psock,
+                        FAR struct tcp_conn_s *conn)
+{
+  if (psock->s_sndcb == NULL)
+    {
+      psock->s_sndcb = tcp_callback_alloc(conn);
+      if (psock->s_sndcb == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  /* Set up the callback in the connection */
+
+  psock->s_sndcb->flags = (TCP_ACKDATA | TCP_REXMIT | TCP_POLL |
+                           TCP_DISCONN_EVENTS);
+  psock->s_sndcb->priv  = (FAR void *)psock;
+  psock->s_sndcb->event = psock_send_eventhandler;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sendfile_fill
+ *
+ * Description:
+ *   Read file data directly into the I/O buffer chain of a write buffer.
+ *   The chain is extended with IOBs as long as they are available without
+ *   waiting; the first IOB is always provided by the write buffer itself.
+ *
+ * Input Parameters:
+ *   wrb    - The write buffer to fill.  It must not yet be queued.
+ *   infile - The file to read from, positioned at the first byte to send
+ *   count  - The maximum number of bytes to read
+ *
+ * Returned Value:
+ *   The number of bytes placed in the write buffer (zero at end of file)
+ *   or a negated errno value if nothing could be read.
+ *
+ * Assumptions:
+ *   The network is NOT locked; the file system may block.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SENDFILE
+static ssize_t sendfile_fill(FAR struct tcp_wrbuffer_s *wrb,
+                             FAR struct file *infile, size_t count)
+{
+  FAR struct iob_s *head = TCP_WBIOB(wrb);
+  FAR struct iob_s *prev = NULL;
+  FAR struct iob_s *iob  = head;
+  size_t total = 0;
+  size_t chunk;
+  ssize_t nread;
+
+  /* The packet length of an I/O buffer chain is limited to 16-bits */
+
+  if (count > UINT16_MAX)
+    {
+      count = UINT16_MAX;
+    }
+
+  while (total < count)
+    {
+      chunk = IOB_FREESPACE(iob);
+      if (chunk == 0)
+        {
+          FAR struct iob_s *next;
+
+          /* Don't wait for more IOBs here:  Whatever we already hold would
+           * never be released.  Just send what we have.
+           */
+
+          next = iob_tryalloc(false, IOBUSER_NET_TCP_WRITEBUFFER);
+          if (next == NULL)
+            {
+              break;
+            }
+
+          iob->io_flink = next;
+          prev          = iob;
+          iob           = next;
+          chunk         = IOB_FREESPACE(iob);
+        }
+
+      if (chunk > count - total)
+        {
+          chunk = count - total;
+        }
+
+      nread = file_read(infile, &iob->io_data[iob->io_offset + iob->io_len],
+                        chunk);
+      if (nread <= 0)
+        {
+          if (total == 0)
+            {
+              return nread;
+            }
+
+          /* Report the error (if any) on the next call */
+
+          break;
+        }
+
+      iob->io_len     += nread;
+      head->io_pktlen += nread;
+      total           += nread;
+    }
+
+  /* Don't leave an empty IOB at the tail of the chain */
+
+  if (iob != head && iob->io_len == 0)
+    {
+      prev->io_flink = NULL;
+      iob_free(iob, IOBUSER_NET_TCP_WRITEBUFFER);
+    }
+
+  return total;
+}
+#endif /* CONFIG_NET_SENDFILE */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -1025,14 +1165,8 @@ ssize_t psock_tcp_send(FAR struct socket *psock, FAR const void *buf,
 
       /* Allocate resources to receive a callback */
 
-      if (psock->s_sndcb == NULL)
-        {
-          psock->s_sndcb = tcp_callback_alloc(conn);
-        }
-
-      /* Test if the callback has been allocated */
-
-      if (psock->s_sndcb == NULL)
+      ret = send_setupcb(psock, conn);
+      if (ret < 0)
         {
           /* A buffer allocation error occurred */
 
@@ -1041,13 +1175,6 @@ ssize_t psock_tcp_send(FAR struct socket *psock, FAR const void *buf,
           goto errout_with_wrb;
         }
 
-      /* Set up the callback in the connection */
-
-      psock->s_sndcb->flags = (TCP_ACKDATA | TCP_REXMIT | TCP_POLL |
-                               TCP_DISCONN_EVENTS);
-      psock->s_sndcb->priv  = (FAR void *)psock;
-      psock->s_sndcb->event = psock_send_eventhandler;
-
       /* Initialize the write buffer */
 
       TCP_WBSEQNO(wrb) = (unsigned)-1;
@@ -1092,16 +1219,25 @@ ssize_t psock_tcp_send(FAR struct socket *psock, FAR const void *buf,
           unsigned int count;
           int blresult;
 
-          /* iob_copyin might wait for buffers to be freed, but if network is
-           * locked this might never happen, since network driver is also locked,
-           * therefore we need to break the lock
+          /* Try to copy the data without waiting first.  That normally
+           * succeeds and the network lock can be kept.
            */
 
-          blresult = net_breaklock(&count);
-          result = TCP_WBCOPYIN(wrb, (FAR uint8_t *)buf, len);
-          if (blresult >= 0)
+          result = TCP_WBTRYCOPYIN(wrb, (FAR uint8_t *)buf, len);
+          if (result == -ENOMEM)
             {
-              net_restorelock(count);
+              /* iob_copyin might wait for buffers to be freed, but if
+               * network is locked this might never happen, since network
+               * driver is also locked, therefore we need to break the lock.
+               * The copy starts over, overwriting the data already copied.
+               */
+
+              blresult = net_breaklock(&count);
+              result = TCP_WBCOPYIN(wrb, (FAR uint8_t *)buf, len);
+              if (blresult >= 0)
+                {
+                  net_restorelock(count);
+                }
             }
         }
 
@@ -1212,4 +1348,199 @@ int psock_tcp_cansend(FAR struct socket *psock)
   return OK;
 }
 
+/****************************************************************************
+ * Name: tcp_sendfile
+ *
+ * Description:
+ *   The tcp_sendfile() call may be used only when the INET socket is in a
+ *   connected state (so that the intended recipient is known).
+ *
+ *   With write buffering enabled, the file data is read directly into the
+ *   I/O buffer chains of TCP write buffers which are then queued on the
+ *   connection exactly like data from psock_tcp_send().  There is no
+ *   intermediate copy and the TCP window is filled from the write queue.
+ *
+ * Input Parameters:
+ *   psock    An instance of the internal socket structure.
+ *   infile   The file to send from
+ *   offset   If not NULL, the file offset to start from.  It is updated on
+ *            return and the file position of 'infile' is left unchanged.
+ *   count    The number of bytes to send
+ *
+ * Returned Value:
+ *   On success, returns the number of bytes queued for sending.  On  error,
+ *   a negated errno value is returned.  See sendfile() for a list
+ *   appropriate error return values.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SENDFILE
+ssize_t tcp_sendfile(FAR struct socket *psock, FAR struct file *infile,
+                     FAR off_t *offset, size_t count)
+{
+  FAR struct tcp_conn_s *conn;
+  FAR struct tcp_wrbuffer_s *wrb;
+  off_t startpos = 0;
+  size_t sent = 0;
+  ssize_t nread;
+  bool nonblock;
+  int ret = OK;
+
+  if (psock->s_type != SOCK_STREAM || !_SS_ISCONNECTED(psock->s_flags))
+    {
+      nerr("ERROR: Not connected\n");
+      return -ENOTCONN;
+    }
+
+  /* Make sure that we have the IP address mapping */
+
+  conn = (FAR struct tcp_conn_s *)psock->s_conn;
+  DEBUGASSERT(conn);
+
+#if defined(CONFIG_NET_ARP_SEND) || defined(CONFIG_NET_ICMPv6_NEIGHBOR)
+#ifdef CONFIG_NET_ARP_SEND
+#ifdef CONFIG_NET_ICMPv6_NEIGHBOR
+  if (psock->s_domain == PF_INET)
+#endif
+    {
+      /* Make sure that the IP address mapping is in the ARP table */
+
+      ret = arp_send(conn->u.ipv4.raddr);
+    }
+#endif /* CONFIG_NET_ARP_SEND */
+
+#ifdef CONFIG_NET_ICMPv6_NEIGHBOR
+#ifdef CONFIG_NET_ARP_SEND
+  else
+#endif
+    {
+      /* Make sure that the IP address mapping is in the Neighbor Table */
+
+      ret = icmpv6_neighbor(conn->u.ipv6.raddr);
+    }
+#endif /* CONFIG_NET_ICMPv6_NEIGHBOR */
+
+  /* Did we successfully get the address mapping? */
+
+  if (ret < 0)
+    {
+      nerr("ERROR: Not reachable\n");
+      return -ENETUNREACH;
+    }
+#endif /* CONFIG_NET_ARP_SEND || CONFIG_NET_ICMPv6_NEIGHBOR */
+
+  /* If an offset was provided, start there and restore the file position
+   * when we are finished.
+   */
+
+  if (offset != NULL)
+    {
+      startpos = file_seek(infile, 0, SEEK_CUR);
+      if (startpos < 0)
+        {
+          return startpos;
+        }
+
+      ret = file_seek(infile, *offset, SEEK_SET);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  nonblock = _SS_ISNONBLOCK(psock->s_flags);
+
+  while (sent < count)
+    {
+      /* Allocate a write buffer.  Careful, the network will be momentarily
+       * unlocked here.
+       */
+
+      net_lock();
+      if (nonblock)
+        {
+          wrb = tcp_wrbuffer_tryalloc();
+        }
+      else
+        {
+          wrb = tcp_wrbuffer_alloc();
+        }
+
+      if (wrb == NULL)
+        {
+          nerr("ERROR: Failed to allocate write buffer\n");
+          net_unlock();
+          ret = nonblock ? -EAGAIN : -ENOMEM;
+          break;
+        }
+
+      net_unlock();
+
+      /* The write buffer is ours alone until it is queued, so it can be
+       * filled from the file system without holding the network lock.
+       */
+
+      nread = sendfile_fill(wrb, infile, count - sent);
+
+      net_lock();
+      if (nread <= 0)
+        {
+          tcp_wrbuffer_release(wrb);
+          net_unlock();
+          ret = nread;
+          break;
+        }
+
+      /* The connection may have been lost while the network was unlocked */
+
+      if (!_SS_ISCONNECTED(psock->s_flags))
+        {
+          tcp_wrbuffer_release(wrb);
+          net_unlock();
+          ret = -ENOTCONN;
+          break;
+        }
+
+      ret = send_setupcb(psock, conn);
+      if (ret < 0)
+        {
+          nerr("ERROR: Failed to allocate callback\n");
+          tcp_wrbuffer_release(wrb);
+          net_unlock();
+          ret = nonblock ? -EAGAIN : -ENOMEM;
+          break;
+        }
+
+      TCP_WBSEQNO(wrb) = (unsigned)-1;
+      TCP_WBNRTX(wrb)  = 0;
+
+      TCP_WBDUMP("I/O buffer chain", wrb, TCP_WBPKTLEN(wrb), 0);
+
+      sq_addlast(&wrb->wb_node, &conn->write_q);
+      ninfo("Queued WRB=%p pktlen=%u write_q(%p,%p)\n",
+            wrb, TCP_WBPKTLEN(wrb),
+            conn->write_q.head, conn->write_q.tail);
+
+      /* Notify the device driver of the availability of TX data */
+
+      send_txnotify(psock, conn);
+      net_unlock();
+
+      sent += nread;
+    }
+
+  if (offset != NULL)
+    {
+      *offset += sent;
+      file_seek(infile, startpos, SEEK_SET);
+    }
+
+  /* Report a partial transfer as success; the error will recur on the
+   * next call.
+   */
+
+  return sent > 0 ? (ssize_t)sent : (ssize_t)ret;
+}
+#endif /* CONFIG_NET_SENDFILE */
+
 #endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_WRITE_BUFFERS */
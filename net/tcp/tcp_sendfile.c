@@ -71,7 +71,7 @@
 #include "tcp/tcp.h"
 
 #if defined(CONFIG_NET_SENDFILE) && defined(CONFIG_NET_TCP) && \
-    defined(NET_TCP_HAVE_STACK)
+    defined(NET_TCP_HAVE_STACK) && !defined(CONFIG_NET_TCP_WRITE_BUFFERS)
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -451,6 +451,7 @@ ssize_t tcp_sendfile(FAR struct socket *psock, FAR struct file *infile,
 {
   FAR struct tcp_conn_s *conn;
   struct sendfile_s state;
+  off_t startpos;
   int ret;
 
   /* If this is an un-connected socket, then return ENOTCONN */
@@ -497,6 +498,17 @@ ssize_t tcp_sendfile(FAR struct socket *psock, FAR struct file *infile,
     }
 #endif /* CONFIG_NET_ARP_SEND || CONFIG_NET_ICMPv6_NEIGHBOR */
 
+  /* The event handler repositions the file for each packet.  Remember
+   * where it was so that the position can be restored (if an offset was
+   * given) or advanced (if not) when we are done.
+   */
+
+  startpos = file_seek(infile, 0, SEEK_CUR);
+  if (startpos < 0)
+    {
+      return startpos;
+    }
+
   /* Initialize the state structure.  This is done with the network
    * locked because we don't want anything to happen until we are
    * ready.
@@ -513,7 +525,7 @@ ssize_t tcp_sendfile(FAR struct socket *psock, FAR struct file *infile,
   nxsem_setprotocol(&state.snd_sem, SEM_PRIO_NONE);
 
   state.snd_sock    = psock;                /* Socket descriptor to use */
-  state.snd_foffset = offset ? *offset : 0; /* Input file offset */
+  state.snd_foffset = offset ? *offset : startpos; /* Input file offset */
   state.snd_flen    = count;                /* Number of bytes to send */
   state.snd_file    = infile;               /* File to read from */
 
@@ -587,12 +599,30 @@ errout_locked:
 
   if (ret < 0)
     {
+      file_seek(infile, startpos, SEEK_SET);
       return ret;
     }
+
+  if (offset != NULL)
+    {
+      if (state.snd_sent > 0)
+        {
+          *offset += state.snd_sent;
+        }
+
+      file_seek(infile, startpos, SEEK_SET);
+    }
+  else if (state.snd_sent > 0)
+    {
+      file_seek(infile, startpos + state.snd_sent, SEEK_SET);
+    }
   else
     {
-      return state.snd_sent;
+      file_seek(infile, startpos, SEEK_SET);
     }
+
+  return state.snd_sent;
 }
 
-#endif /* CONFIG_NET_SENDFILE && CONFIG_NET_TCP && NET_TCP_HAVE_STACK */
+#endif /* CONFIG_NET_SENDFILE && CONFIG_NET_TCP && NET_TCP_HAVE_STACK &&
+        * !CONFIG_NET_TCP_WRITE_BUFFERS */
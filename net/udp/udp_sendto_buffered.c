@@ -721,17 +721,27 @@ ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
           unsigned int count;
           int blresult;
 
-          /* iob_copyin might wait for buffers to be freed, but if
-           * network is locked this might never happen, since network
-           * driver is also locked, therefore we need to break the lock
+          /* Try to copy the data without waiting first.  That normally
+           * succeeds and the network lock can be kept.
            */
 
-          blresult = net_breaklock(&count);
-          ret = iob_copyin(wrb->wb_iob, (FAR uint8_t *)buf, len, 0, false,
-                           IOBUSER_NET_SOCK_UDP);
-          if (blresult >= 0)
+          ret = iob_trycopyin(wrb->wb_iob, (FAR uint8_t *)buf, len, 0,
+                              false, IOBUSER_NET_SOCK_UDP);
+          if (ret == -ENOMEM)
             {
-              net_restorelock(count);
+              /* iob_copyin might wait for buffers to be freed, but if
+               * network is locked this might never happen, since network
+               * driver is also locked, therefore we need to break the lock.
+               * The copy starts over, overwriting the data already copied.
+               */
+
+              blresult = net_breaklock(&count);
+              ret = iob_copyin(wrb->wb_iob, (FAR uint8_t *)buf, len, 0,
+                               false, IOBUSER_NET_SOCK_UDP);
+              if (blresult >= 0)
+                {
+                  net_restorelock(count);
+                }
             }
         }
 
@@ -41,8 +41,123 @@
 #include <nuttx/config.h>
 #ifdef CONFIG_NET
 
+#include <stdint.h>
+
 #include "utils/utils.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The accumulator is wide enough that a packet of up to 64 KiB can be
+ * summed without intermediate carry folding.  With a 64-bit accumulator,
+ * 32-bit words are summed; otherwise 16-bit words are.
+ */
+
+#ifdef CONFIG_HAVE_LONG_LONG
+typedef uint64_t chksum_acc_t;
+typedef uint32_t chksum_word_t;
+#else
+typedef uint32_t chksum_acc_t;
+typedef uint16_t chksum_word_t;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: chksum_fold
+ *
+ * Description:
+ *   Fold the accumulator into a 16-bit one's complement sum.
+ *
+ ****************************************************************************/
+
+#if !defined(CONFIG_NET_ARCH_CHKSUM) && !defined(CONFIG_NET_ARCH_CHKSUM_CORE)
+static inline uint16_t chksum_fold(chksum_acc_t acc)
+{
+  while ((acc >> 16) != 0)
+    {
+      acc = (acc & 0xffff) + (acc >> 16);
+    }
+
+  return (uint16_t)acc;
+}
+
+/****************************************************************************
+ * Name: chksum_even
+ *
+ * Description:
+ *   Return the one's complement sum of the 16-bit big-endian words of a
+ *   buffer that starts on an even address, in host byte order.  Native
+ *   words are summed and the result is byte swapped at the end if needed;
+ *   this is valid for the one's complement sum (RFC1071).
+ *
+ ****************************************************************************/
+
+static uint16_t chksum_even(FAR const uint8_t *data, unsigned int len)
+{
+  chksum_acc_t acc = 0;
+  uint16_t sum;
+
+  /* Sum 16-bit words until the data is aligned for the wide loads */
+
+  while (len >= 2 && ((uintptr_t)data & (sizeof(chksum_word_t) - 1)) != 0)
+    {
+      acc  += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
+    }
+
+  /* Then sum wide words, four at a time */
+
+  while (len >= 4 * sizeof(chksum_word_t))
+    {
+      FAR const chksum_word_t *wp = (FAR const chksum_word_t *)data;
+
+      acc  += (chksum_acc_t)wp[0] + wp[1] + wp[2] + wp[3];
+      data += 4 * sizeof(chksum_word_t);
+      len  -= 4 * sizeof(chksum_word_t);
+    }
+
+  while (len >= sizeof(chksum_word_t))
+    {
+      acc  += *(FAR const chksum_word_t *)data;
+      data += sizeof(chksum_word_t);
+      len  -= sizeof(chksum_word_t);
+    }
+
+  /* And the remaining 16-bit words and odd byte.  The odd byte is the most
+   * significant byte of a big-endian word padded with zero.
+   */
+
+  while (len >= 2)
+    {
+      acc  += *(FAR const uint16_t *)data;
+      data += 2;
+      len  -= 2;
+    }
+
+  if (len > 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      acc += (uint16_t)data[0] << 8;
+#else
+      acc += data[0];
+#endif
+    }
+
+  sum = chksum_fold(acc);
+
+#ifdef CONFIG_ENDIAN_BIG
+  return sum;
+#else
+  return (uint16_t)((sum << 8) | (sum >> 8));
+#endif
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -66,43 +181,37 @@
  *
  ****************************************************************************/
 
-#ifndef CONFIG_NET_ARCH_CHKSUM
+#if !defined(CONFIG_NET_ARCH_CHKSUM) && !defined(CONFIG_NET_ARCH_CHKSUM_CORE)
 uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
 {
-  FAR const uint8_t *dataptr;
-  FAR const uint8_t *last_byte;
+  uint32_t total = sum;
   uint16_t t;
 
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  while (dataptr < last_byte)
+  if (len == 0)
     {
-      /* At least two more bytes */
-
-      t = ((uint16_t)dataptr[0] << 8) + dataptr[1];
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
-
-      dataptr += 2;
+      return sum;
     }
 
-  if (dataptr == last_byte)
+  if (((uintptr_t)data & 1) == 0)
     {
-      t = (dataptr[0] << 8) + 0;
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
+      total += chksum_even(data, len);
     }
+  else
+    {
+      /* The first byte is the most significant byte of the first word.
+       * The rest of the data is aligned, but framed as byte swapped words;
+       * swap the sum back.
+       */
 
-  /* Return sum in host byte order. */
+      t      = chksum_even(data + 1, len - 1);
+      total += ((uint16_t)data[0] << 8) + (uint16_t)((t << 8) | (t >> 8));
+    }
 
-  return sum;
+  /* Fold the carries and return sum in host byte order. */
+
+  total = (total & 0xffff) + (total >> 16);
+  total = (total & 0xffff) + (total >> 16);
+  return (uint16_t)total;
 }
 #endif /* CONFIG_NET_ARCH_CHKSUM */
 
@@ -64,9 +64,14 @@
  * Private Data
  ****************************************************************************/
 
-static sem_t        g_netlock;
-static pid_t        g_holder = NO_HOLDER;
-static unsigned int g_count  = 0;
+/* g_holder and g_count are modified only by the thread that holds
+ * g_netlock.  Any other thread can only see a PID that is not its own in
+ * g_holder, so the holder test needs no critical section.
+ */
+
+static sem_t                 g_netlock;
+static volatile pid_t        g_holder = NO_HOLDER;
+static volatile unsigned int g_count  = 0;
 
 /****************************************************************************
  * Private Functions
@@ -194,9 +199,6 @@ void net_lockinitialize(void)
 
 int net_lock(void)
 {
-#ifdef CONFIG_SMP
-  irqstate_t flags = enter_critical_section();
-#endif
   pid_t me = getpid();
   int ret = OK;
 
@@ -222,9 +224,6 @@ int net_lock(void)
         }
     }
 
-#ifdef CONFIG_SMP
-  leave_critical_section(flags);
-#endif
   return ret;
 }
 
@@ -244,9 +243,6 @@ int net_lock(void)
 
 void net_unlock(void)
 {
-#ifdef CONFIG_SMP
-  irqstate_t flags = enter_critical_section();
-#endif
   DEBUGASSERT(g_holder == getpid() && g_count > 0);
 
   /* If the count would go to zero, then release the semaphore */
@@ -265,10 +261,6 @@ void net_unlock(void)
 
       g_count--;
     }
-
-#ifdef CONFIG_SMP
-  leave_critical_section(flags);
-#endif
 }
 
 /****************************************************************************
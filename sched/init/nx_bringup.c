@@ -57,6 +57,7 @@
 #include <nuttx/kthread.h>
 #include <nuttx/userspace.h>
 #include <nuttx/binfmt/binfmt.h>
+#include <nuttx/syslog/syslog.h>
 
 #ifdef CONFIG_PAGING
 # include "paging/paging.h"
@@ -454,6 +455,12 @@ int nx_bringup(void)
 
   nx_workqueues();
 
+#ifdef CONFIG_SYSLOG_DEFERRED
+  /* Start the worker thread that formats the deferred SYSLOG output */
+
+  syslog_defer_start();
+#endif
+
   /* Once the operating system has been initialized, the system must be
    * started by spawning the user initialization thread of execution.  This
    * will be the first user-mode thread.
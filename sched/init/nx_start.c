@@ -142,6 +142,18 @@ volatile dq_queue_t g_readytorun;
 
 volatile dq_queue_t g_assignedtasks[CONFIG_SMP_NCPUS];
 
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+/* With CONFIG_SMP_READYTORUN_PERCPU, the unassigned ready-to-run tasks are
+ * kept in per-CPU lists instead of in g_readytorun.
+ */
+
+volatile dq_queue_t g_cpureadytorun[CONFIG_SMP_NCPUS];
+
+/* The number of tasks in each of the per-CPU ready-to-run lists */
+
+volatile uint16_t g_cpureadytorunlen[CONFIG_SMP_NCPUS];
+#endif
+
 /* g_running_tasks[] holds a references to the running task for each cpu.
  * It is valid only when up_interrupt_context() returns true.
  */
@@ -261,10 +273,17 @@ const struct tasklist_s g_tasklisttable[NUM_TASK_STATES] =
     TLIST_ATTR_PRIORITIZED
   },
 #ifdef CONFIG_SMP
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+  {                                              /* TSTATE_TASK_READYTORUN */
+    g_cpureadytorun,
+    TLIST_ATTR_PRIORITIZED | TLIST_ATTR_INDEXED
+  },
+#else
   {                                              /* TSTATE_TASK_READYTORUN */
     &g_readytorun,
     TLIST_ATTR_PRIORITIZED
   },
+#endif
   {                                              /* TSTATE_TASK_ASSIGNED */
     g_assignedtasks,
     TLIST_ATTR_PRIORITIZED | TLIST_ATTR_INDEXED | TLIST_ATTR_RUNNABLE
@@ -430,6 +449,9 @@ void nx_start(void)
   for (i = 0; i < CONFIG_SMP_NCPUS; i++)
     {
       dq_init(&g_assignedtasks[i]);
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+      dq_init(&g_cpureadytorun[i]);
+#endif
     }
 #endif
 
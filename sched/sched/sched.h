@@ -209,6 +209,23 @@ extern volatile dq_queue_t g_readytorun;
 
 extern volatile dq_queue_t g_assignedtasks[CONFIG_SMP_NCPUS];
 
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+/* With CONFIG_SMP_READYTORUN_PERCPU, the g_readytorun list is replaced with
+ * one list per CPU.  These hold the same ready-to-run, unassigned tasks;
+ * the tcb->cpu field of such a task identifies the list that holds it.
+ * A CPU that needs a new task may take one from any of these lists if the
+ * task's affinity mask permits.
+ */
+
+extern volatile dq_queue_t g_cpureadytorun[CONFIG_SMP_NCPUS];
+
+/* g_cpureadytorunlen[] holds the number of tasks in each of those lists so
+ * that the lists can be compared without walking them.
+ */
+
+extern volatile uint16_t g_cpureadytorunlen[CONFIG_SMP_NCPUS];
+#endif
+
 /* g_running_tasks[] holds a references to the running task for each cpu.
  * It is valid only when up_interrupt_context() returns true.
  */
@@ -469,6 +486,32 @@ FAR struct tcb_s *this_task(void);
 
 int  sched_cpu_select(cpu_set_t affinity);
 int  sched_cpu_pause(FAR struct tcb_s *tcb);
+FAR struct tcb_s *sched_cpu_nexttask(int cpu);
+
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+FAR dq_queue_t *sched_cpu_readytorun(FAR struct tcb_s *tcb);
+void sched_readytorun_topending(void);
+void sched_pending_toreadytorun(void);
+
+/* Account for a task added to or removed from the ready-to-run list of
+ * CPU tcb->cpu.
+ */
+
+#  define sched_cpu_enqueued(t) (g_cpureadytorunlen[(t)->cpu]++)
+#  define sched_cpu_dequeued(t) (g_cpureadytorunlen[(t)->cpu]--)
+#else
+#  define sched_cpu_enqueued(t)
+#  define sched_cpu_dequeued(t)
+#  define sched_cpu_readytorun(t) ((FAR dq_queue_t *)&g_readytorun)
+#  define sched_readytorun_topending() \
+     sched_mergeprioritized((FAR dq_queue_t *)&g_readytorun, \
+                            (FAR dq_queue_t *)&g_pendingtasks, \
+                            TSTATE_TASK_PENDING)
+#  define sched_pending_toreadytorun() \
+     sched_mergeprioritized((FAR dq_queue_t *)&g_pendingtasks, \
+                            (FAR dq_queue_t *)&g_readytorun, \
+                            TSTATE_TASK_READYTORUN)
+#endif
 
 irqstate_t sched_tasklist_lock(void);
 void sched_tasklist_unlock(irqstate_t lock);
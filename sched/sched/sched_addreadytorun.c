@@ -257,12 +257,14 @@ bool sched_addreadytorun(FAR struct tcb_s *btcb)
       /* The new btcb was added either (1) in the middle of the assigned
        * task list (the btcb->cpu field is already valid) or (2) was
        * added to the ready-to-run list (the btcb->cpu field does not
-       * matter).  Either way, it won't be running.
+       * matter unless there are per-CPU ready-to-run lists).  Either way,
+       * it won't be running.
        *
        * Add the task to the ready-to-run (but not running) task list
        */
 
-      sched_addprioritized(btcb, (FAR dq_queue_t *)&g_readytorun);
+      sched_addprioritized(btcb, sched_cpu_readytorun(btcb));
+      sched_cpu_enqueued(btcb);
 
       btcb->task_state = TSTATE_TASK_READYTORUN;
       doswitch         = false;
@@ -398,7 +400,8 @@ bool sched_addreadytorun(FAR struct tcb_s *btcb)
               else
                 {
                   next->task_state = TSTATE_TASK_READYTORUN;
-                  tasklist         = (FAR dq_queue_t *)&g_readytorun;
+                  tasklist         = sched_cpu_readytorun(next);
+                  sched_cpu_enqueued(next);
                 }
 
               sched_addprioritized(next, tasklist);
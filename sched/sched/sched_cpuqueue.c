@@ -0,0 +1,257 @@
+/****************************************************************************
+ * sched/sched/sched_cpuqueue.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sched.h>
+#include <queue.h>
+#include <assert.h>
+
+#include <nuttx/sched.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+
+/****************************************************************************
+ * Name: sched_cpu_eligible
+ *
+ * Description:
+ *   Return the first task in the ready-to-run list of 'queue' that may run
+ *   on 'cpu'.  The affinity is checked because it may have changed since
+ *   the task was queued.
+ *
+ ****************************************************************************/
+
+static FAR struct tcb_s *sched_cpu_eligible(int queue, int cpu)
+{
+  FAR struct tcb_s *tcb;
+
+  for (tcb = (FAR struct tcb_s *)g_cpureadytorun[queue].head;
+       tcb != NULL && !CPU_ISSET(cpu, &tcb->affinity);
+       tcb = (FAR struct tcb_s *)tcb->flink);
+
+  return tcb;
+}
+
+#endif /* CONFIG_SMP_READYTORUN_PERCPU */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_cpu_nexttask
+ *
+ * Description:
+ *   Return the highest priority ready-to-run, unassigned task that may run
+ *   on 'cpu'.  The task is not removed from its list.
+ *
+ *   With CONFIG_SMP_READYTORUN_PERCPU, the list of 'cpu' is preferred.  A
+ *   task queued on another CPU is taken over (stolen) if its affinity mask
+ *   includes 'cpu' and it has a strictly higher priority, or if 'cpu' has
+ *   nothing else to run.  When several other CPUs hold a task of the same
+ *   priority, the task is stolen from the longest list.
+ *
+ * Input Parameters:
+ *   cpu - The CPU that needs a new task to run
+ *
+ * Returned Value:
+ *   The selected TCB or NULL if there is no eligible task.
+ *
+ * Assumptions:
+ *   Called from within a critical section with the task lists locked.
+ *
+ ****************************************************************************/
+
+FAR struct tcb_s *sched_cpu_nexttask(int cpu)
+{
+  FAR struct tcb_s *tcb;
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+  FAR struct tcb_s *best;
+  int bestlen = -1;
+  int len;
+  int i;
+
+  /* Search the list of this CPU first */
+
+  best = sched_cpu_eligible(cpu, cpu);
+
+  /* Then look for a task to steal from the lists of the other CPUs */
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      if (i == cpu)
+        {
+          continue;
+        }
+
+      tcb = sched_cpu_eligible(i, cpu);
+      if (tcb == NULL)
+        {
+          continue;
+        }
+
+      if (best == NULL || tcb->sched_priority > best->sched_priority)
+        {
+          best    = tcb;
+          bestlen = -1;
+        }
+      else if (tcb->sched_priority == best->sched_priority &&
+               best->cpu != cpu)
+        {
+          /* Equal priority on two other CPUs:  Balance the load by
+           * stealing from the longer list.
+           */
+
+          if (bestlen < 0)
+            {
+              bestlen = g_cpureadytorunlen[best->cpu];
+            }
+
+          len = g_cpureadytorunlen[i];
+          if (len > bestlen)
+            {
+              best    = tcb;
+              bestlen = len;
+            }
+        }
+    }
+
+  return best;
+
+#else
+  /* Search for the highest priority task that can run on this CPU. */
+
+  for (tcb = (FAR struct tcb_s *)g_readytorun.head;
+       tcb != NULL && !CPU_ISSET(cpu, &tcb->affinity);
+       tcb = (FAR struct tcb_s *)tcb->flink);
+
+  return tcb;
+#endif
+}
+
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+
+/****************************************************************************
+ * Name: sched_cpu_readytorun
+ *
+ * Description:
+ *   Return the per-CPU ready-to-run list that should receive 'tcb'.  This
+ *   is the list of the CPU that the task last ran on, if the affinity mask
+ *   still permits, or the list of the first permitted CPU otherwise.
+ *   tcb->cpu is updated to identify the selected list.
+ *
+ * Input Parameters:
+ *   tcb - The TCB to be queued
+ *
+ * Returned Value:
+ *   The selected ready-to-run list.
+ *
+ * Assumptions:
+ *   Called from within a critical section with the task lists locked.
+ *
+ ****************************************************************************/
+
+FAR dq_queue_t *sched_cpu_readytorun(FAR struct tcb_s *tcb)
+{
+  int cpu = tcb->cpu;
+
+  if (cpu >= CONFIG_SMP_NCPUS || !CPU_ISSET(cpu, &tcb->affinity))
+    {
+      for (cpu = 0;
+           cpu < CONFIG_SMP_NCPUS && !CPU_ISSET(cpu, &tcb->affinity);
+           cpu++);
+
+      DEBUGASSERT(cpu < CONFIG_SMP_NCPUS);
+      tcb->cpu = cpu;
+    }
+
+  return (FAR dq_queue_t *)&g_cpureadytorun[cpu];
+}
+
+/****************************************************************************
+ * Name: sched_readytorun_topending
+ *
+ * Description:
+ *   Move all unassigned ready-to-run tasks to the g_pendingtasks list.
+ *
+ * Assumptions:
+ *   Called from within a critical section.
+ *
+ ****************************************************************************/
+
+void sched_readytorun_topending(void)
+{
+  irqstate_t lock = sched_tasklist_lock();
+  int cpu;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      sched_mergeprioritized((FAR dq_queue_t *)&g_cpureadytorun[cpu],
+                             (FAR dq_queue_t *)&g_pendingtasks,
+                             TSTATE_TASK_PENDING);
+      g_cpureadytorunlen[cpu] = 0;
+    }
+
+  sched_tasklist_unlock(lock);
+}
+
+/****************************************************************************
+ * Name: sched_pending_toreadytorun
+ *
+ * Description:
+ *   Move all tasks in the g_pendingtasks list to the per-CPU ready-to-run
+ *   lists.
+ *
+ * Assumptions:
+ *   Called from within a critical section.
+ *
+ ****************************************************************************/
+
+void sched_pending_toreadytorun(void)
+{
+  irqstate_t lock = sched_tasklist_lock();
+  FAR struct tcb_s *tcb;
+
+  while ((tcb = (FAR struct tcb_s *)
+                dq_remfirst((FAR dq_queue_t *)&g_pendingtasks)) != NULL)
+    {
+      sched_addprioritized(tcb, sched_cpu_readytorun(tcb));
+      sched_cpu_enqueued(tcb);
+      tcb->task_state = TSTATE_TASK_READYTORUN;
+    }
+
+  sched_tasklist_unlock(lock);
+}
+
+#endif /* CONFIG_SMP_READYTORUN_PERCPU */
+#endif /* CONFIG_SMP */
@@ -272,9 +272,7 @@ int sched_lock(void)
        * unlocked and sched_mergepending() is called.
        */
 
-      sched_mergeprioritized((FAR dq_queue_t *)&g_readytorun,
-                             (FAR dq_queue_t *)&g_pendingtasks,
-                             TSTATE_TASK_PENDING);
+      sched_readytorun_topending();
     }
 
   return OK;
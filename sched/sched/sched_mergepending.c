@@ -255,9 +255,7 @@ bool sched_mergepending(void)
                * move them back to the pending task list.
                */
 
-              sched_mergeprioritized((FAR dq_queue_t *)&g_readytorun,
-                                     (FAR dq_queue_t *)&g_pendingtasks,
-                                     TSTATE_TASK_PENDING);
+              sched_readytorun_topending();
 
               /* And return with the scheduler locked and tasks in the
                * pending task list.
@@ -284,9 +282,7 @@ bool sched_mergepending(void)
        * tasks in the pending task list to the ready-to-run task list.
        */
 
-      sched_mergeprioritized((FAR dq_queue_t *)&g_pendingtasks,
-                             (FAR dq_queue_t *)&g_readytorun,
-                             TSTATE_TASK_READYTORUN);
+      sched_pending_toreadytorun();
     }
 
 errout_with_lock:
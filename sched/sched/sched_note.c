@@ -40,7 +40,9 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
+#include <sched.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -57,14 +59,52 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* The head and tail of a buffer are free-running byte positions.  The
+ * buffer index is the position modulo the buffer size, which is only
+ * continuous across the wraparound of the position if the buffer size is a
+ * power of two.
+ */
+
+#if (CONFIG_SCHED_NOTE_BUFSIZE & (CONFIG_SCHED_NOTE_BUFSIZE - 1)) != 0
+#  error CONFIG_SCHED_NOTE_BUFSIZE must be a power of two
+#endif
+
+#define NOTE_MASK (CONFIG_SCHED_NOTE_BUFSIZE - 1)
+
+/* Without SMP, the producer cannot be interrupted by the reader and no
+ * memory barriers are needed.
+ */
+
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
+/* Each CPU has its own buffer with CONFIG_SCHED_NOTE_PERCPU */
+
+#ifdef CONFIG_SCHED_NOTE_PERCPU
+#  define NOTE_NBUFFERS CONFIG_SMP_NCPUS
+#else
+#  define NOTE_NBUFFERS 1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/* A note buffer has a single producer and a single consumer:  ni_head (and
+ * ni_first) are only modified by note_add() and ni_tail only by the reader.
+ * The producer runs with local interrupts disabled, on the owning CPU with
+ * CONFIG_SCHED_NOTE_PERCPU or under g_note_lock otherwise.  Readers are
+ * serialized with each other but never block the producer.
+ */
+
 struct note_info_s
 {
-  volatile unsigned int ni_head;
-  volatile unsigned int ni_tail;
+  volatile unsigned int ni_head;  /* Position of the next note added */
+  volatile unsigned int ni_tail;  /* Position of the next note read */
+#ifdef CONFIG_SCHED_NOTE_OVERWRITE
+  volatile unsigned int ni_first; /* Position of the oldest note retained */
+#endif
   uint8_t ni_buffer[CONFIG_SCHED_NOTE_BUFSIZE];
 };
 
@@ -92,42 +132,20 @@ static void note_add(FAR const uint8_t *note, uint8_t notelen);
  * Private Data
  ****************************************************************************/
 
-static struct note_info_s g_note_info;
+static struct note_info_s g_note_info[NOTE_NBUFFERS];
 
-#ifdef CONFIG_SMP
+#if defined(CONFIG_SMP) && !defined(CONFIG_SCHED_NOTE_PERCPU)
 static volatile spinlock_t g_note_lock;
 #endif
 
-/****************************************************************************
- * Private Functions
- ****************************************************************************/
+#if defined(CONFIG_SMP) && defined(CONFIG_SCHED_NOTE_GET)
+static volatile spinlock_t g_note_rdlock;
+#endif
 
 /****************************************************************************
- * Name: note_next
- *
- * Description:
- *   Return the circular buffer index at offset from the specified index
- *   value, handling wraparound
- *
- * Input Parameters:
- *   ndx - Old circular buffer index
- *
- * Returned Value:
- *   New circular buffer index
- *
+ * Private Functions
  ****************************************************************************/
 
-static inline unsigned int note_next(unsigned int ndx, unsigned int offset)
-{
-  ndx += offset;
-  if (ndx >= CONFIG_SCHED_NOTE_BUFSIZE)
-    {
-      ndx -= CONFIG_SCHED_NOTE_BUFSIZE;
-    }
-
-  return ndx;
-}
-
 /****************************************************************************
  * Name: note_common
  *
@@ -203,31 +221,70 @@ void note_spincommon(FAR struct tcb_s *tcb, FAR volatile spinlock_t *spinlock,
 #endif
 
 /****************************************************************************
- * Name: note_length
+ * Name: note_oldest
  *
  * Description:
- *   Length of data currently in circular buffer.
+ *   Return the position of the oldest unread note in the buffer.  With
+ *   CONFIG_SCHED_NOTE_OVERWRITE, notes that the reader has not yet removed
+ *   may have been overwritten by the producer.
  *
  * Input Parameters:
- *   None
+ *   ni - The note buffer
  *
  * Returned Value:
- *   Length of data currently in circular buffer.
+ *   The position of the oldest unread note
  *
  ****************************************************************************/
 
-#if defined(CONFIG_SCHED_NOTE_GET) || defined(CONFIG_DEBUG_ASSERTIONS)
-static unsigned int note_length(void)
+static inline unsigned int note_oldest(FAR struct note_info_s *ni)
 {
-  unsigned int head = g_note_info.ni_head;
-  unsigned int tail = g_note_info.ni_tail;
+  unsigned int tail = ni->ni_tail;
 
-  if (tail > head)
+#ifdef CONFIG_SCHED_NOTE_OVERWRITE
+  unsigned int first = ni->ni_first;
+
+  if ((int)(first - tail) > 0)
     {
-      head += CONFIG_SCHED_NOTE_BUFSIZE;
+      tail = first;
     }
+#endif
+
+  return tail;
+}
+
+/****************************************************************************
+ * Name: note_copy
+ *
+ * Description:
+ *   Copy data out of the circular buffer, handling wraparound.
+ *
+ * Input Parameters:
+ *   ni     - The note buffer
+ *   buffer - Location to return the data
+ *   pos    - Buffer position of the data
+ *   len    - Number of bytes to copy
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-  return head - tail;
+#ifdef CONFIG_SCHED_NOTE_GET
+static void note_copy(FAR struct note_info_s *ni, FAR uint8_t *buffer,
+                      unsigned int pos, unsigned int len)
+{
+  unsigned int ndx = pos & NOTE_MASK;
+  unsigned int n   = CONFIG_SCHED_NOTE_BUFSIZE - ndx;
+
+  if (n >= len)
+    {
+      memcpy(buffer, &ni->ni_buffer[ndx], len);
+    }
+  else
+    {
+      memcpy(buffer, &ni->ni_buffer[ndx], n);
+      memcpy(buffer + n, ni->ni_buffer, len - n);
+    }
 }
 #endif
 
@@ -235,64 +292,114 @@ static unsigned int note_length(void)
  * Name: note_remove
  *
  * Description:
- *   Remove the variable length note from the tail of the circular buffer
+ *   Remove the next note from the tail of the note buffer, optionally
+ *   copying it to a user buffer.
  *
  * Input Parameters:
- *   None
+ *   ni     - The note buffer
+ *   buffer - Location to return the note.  If NULL, the note is only
+ *            measured and not removed.
+ *   buflen - The length of the user provided buffer.  If the note does not
+ *            fit, it is removed without being copied.
  *
  * Returned Value:
- *   None
+ *   The non-zero length of the note or zero if the buffer is empty.
+ *   -EFBIG is returned if the note did not fit into the user buffer.
  *
  * Assumptions:
- *   We are within a critical section.
+ *   The caller holds the reader lock.  The producer may add notes
+ *   concurrently.
  *
  ****************************************************************************/
 
-static void note_remove(void)
+#ifdef CONFIG_SCHED_NOTE_GET
+static ssize_t note_remove(FAR struct note_info_s *ni, FAR uint8_t *buffer,
+                           size_t buflen)
 {
-  FAR struct note_common_s *note;
+  unsigned int head;
   unsigned int tail;
-  unsigned int length;
+  unsigned int notelen;
+
+  for (; ; )
+    {
+      /* The head must be read before the data that it covers */
+
+      head = ni->ni_head;
+      SP_DMB();
+
+      tail = note_oldest(ni);
+      if (tail == head)
+        {
+          return 0;
+        }
 
-  /* Get the tail index of the circular buffer */
+      notelen = ni->ni_buffer[tail & NOTE_MASK];
+      if (buffer != NULL && notelen <= buflen && notelen <= head - tail)
+        {
+          note_copy(ni, buffer, tail, notelen);
+        }
 
-  tail = g_note_info.ni_tail;
-  DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
+#ifdef CONFIG_SCHED_NOTE_OVERWRITE
+      /* If the producer has overwritten the note while it was being read,
+       * then start over with the oldest note that remains.
+       */
 
-  /* Get the length of the note at the tail index */
+      SP_DMB();
+      if ((int)(ni->ni_first - tail) > 0)
+        {
+          continue;
+        }
+#endif
 
-  note   = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  length = note->nc_length;
-  DEBUGASSERT(length <= note_length());
+      DEBUGASSERT(notelen >= sizeof(struct note_common_s) &&
+                  notelen <= head - tail);
 
-  /* Increment the tail index to remove the entire note from the circular
-   * buffer.
-   */
+      if (buffer != NULL)
+        {
+          /* The note must be copied out before its space is released to
+           * the producer.
+           */
+
+          SP_DMB();
+          ni->ni_tail = tail + notelen;
+          if (notelen > buflen)
+            {
+              return -EFBIG;
+            }
+        }
 
-  g_note_info.ni_tail = note_next(tail, length);
+      return notelen;
+    }
 }
+#endif
 
 /****************************************************************************
  * Name: note_add
  *
  * Description:
- *   Add the variable length note to the head of the circular buffer
+ *   Add the variable length note to the head of the note buffer of this
+ *   CPU.  If the buffer is full, older notes are overwritten or the new
+ *   note is dropped, depending on the configuration.
  *
  * Input Parameters:
- *   None
+ *   note    - The note to add
+ *   notelen - The length of the note
  *
  * Returned Value:
  *   None
  *
- * Assumptions:
- *   We are within a critical section.
- *
  ****************************************************************************/
 
 static void note_add(FAR const uint8_t *note, uint8_t notelen)
 {
+  FAR struct note_info_s *ni;
+  irqstate_t flags;
   unsigned int head;
-  unsigned int next;
+  unsigned int ndx;
+  unsigned int n;
+#ifdef CONFIG_SCHED_NOTE_OVERWRITE
+  unsigned int first;
+#endif
 
 #ifdef CONFIG_SMP
   /* Ignore notes that are not in the set of monitored CPUs */
@@ -305,47 +412,102 @@ static void note_add(FAR const uint8_t *note, uint8_t notelen)
     }
 #endif
 
-#ifdef CONFIG_SMP
-  irqstate_t flags = up_irq_save();
+  DEBUGASSERT(note != NULL && notelen <= CONFIG_SCHED_NOTE_BUFSIZE);
+
+  flags = up_irq_save();
+
+#ifdef CONFIG_SCHED_NOTE_PERCPU
+  ni = &g_note_info[this_cpu()];
+#else
+  ni = &g_note_info[0];
+#  ifdef CONFIG_SMP
   spin_lock_wo_note(&g_note_lock);
+#  endif
 #endif
 
-  /* Get the index to the head of the circular buffer */
+  head = ni->ni_head;
 
-  DEBUGASSERT(note != NULL && notelen < CONFIG_SCHED_NOTE_BUFSIZE);
-  head = g_note_info.ni_head;
-
-  /* Loop until all bytes have been transferred to the circular buffer */
+#ifdef CONFIG_SCHED_NOTE_OVERWRITE
+  /* Discard the oldest notes until there is space for the new note.  The
+   * new start of the buffer must be visible to the reader before any of
+   * the discarded data is overwritten.
+   */
 
-  while (notelen > 0)
+  first = note_oldest(ni);
+  while (CONFIG_SCHED_NOTE_BUFSIZE - (head - first) < notelen)
     {
-      /* Get the next head index.  Would it collide with the current tail
-       * index?
-       */
+      first += ni->ni_buffer[first & NOTE_MASK];
+    }
 
-      next = note_next(head, 1);
-      if (next == g_note_info.ni_tail)
-        {
-          /* Yes, then remove the note at the tail index */
+  if (first != ni->ni_first)
+    {
+      ni->ni_first = first;
+      SP_DMB();
+    }
+#else
+  /* Drop the new note if the buffer is full */
 
-          note_remove();
-        }
+  if (CONFIG_SCHED_NOTE_BUFSIZE - (head - ni->ni_tail) < notelen)
+    {
+      goto errout_with_lock;
+    }
+#endif
 
-      /* Save the next byte at the head index */
+  /* Copy the note into the buffer, handling wraparound */
 
-      g_note_info.ni_buffer[head] = *note++;
+  ndx = head & NOTE_MASK;
+  n   = CONFIG_SCHED_NOTE_BUFSIZE - ndx;
 
-      head = next;
-      notelen--;
+  if (n >= notelen)
+    {
+      memcpy(&ni->ni_buffer[ndx], note, notelen);
+    }
+  else
+    {
+      memcpy(&ni->ni_buffer[ndx], note, n);
+      memcpy(ni->ni_buffer, note + n, notelen - n);
     }
 
-  g_note_info.ni_head = head;
+  /* Then make the note visible to the reader */
 
-#ifdef CONFIG_SMP
+  SP_DMB();
+  ni->ni_head = head + notelen;
+
+#ifndef CONFIG_SCHED_NOTE_OVERWRITE
+errout_with_lock:
+#endif
+#if defined(CONFIG_SMP) && !defined(CONFIG_SCHED_NOTE_PERCPU)
   spin_unlock_wo_note(&g_note_lock);
+#endif
   up_irq_restore(flags);
+}
+
+#ifdef CONFIG_SCHED_NOTE_GET
+/****************************************************************************
+ * Name: note_rdlock and note_rdunlock
+ *
+ * Description:
+ *   Serialize the readers of the note buffers.  This does not affect the
+ *   producers.
+ *
+ ****************************************************************************/
+
+static inline void note_rdlock(void)
+{
+  sched_lock();
+#ifdef CONFIG_SMP
+  spin_lock_wo_note(&g_note_rdlock);
+#endif
+}
+
+static inline void note_rdunlock(void)
+{
+#ifdef CONFIG_SMP
+  spin_unlock_wo_note(&g_note_rdlock);
 #endif
+  sched_unlock();
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -595,6 +757,8 @@ void sched_note_spinabort(FAR struct tcb_s *tcb, FAR volatile void *spinlock)
  * Description:
  *   Remove the next note from the tail of the circular buffer.  The note
  *   is also removed from the circular buffer to make room for further notes.
+ *   With CONFIG_SCHED_NOTE_PERCPU, the note is taken from the buffer of the
+ *   lowest numbered CPU that has notes.
  *
  * Input Parameters:
  *   buffer - Location to return the next note
@@ -610,69 +774,18 @@ void sched_note_spinabort(FAR struct tcb_s *tcb, FAR volatile void *spinlock)
 #ifdef CONFIG_SCHED_NOTE_GET
 ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen)
 {
-  FAR struct note_common_s *note;
-  irqstate_t flags;
-  unsigned int remaining;
-  unsigned int tail;
-  ssize_t notelen;
-  size_t circlen;
+  ssize_t notelen = 0;
+  int i;
 
   DEBUGASSERT(buffer != NULL);
-  flags = enter_critical_section();
+  note_rdlock();
 
-  /* Verify that the circular buffer is not empty */
-
-  circlen = note_length();
-  if (circlen <= 0)
+  for (i = 0; i < NOTE_NBUFFERS && notelen == 0; i++)
     {
-      notelen = 0;
-      goto errout_with_csection;
+      notelen = note_remove(&g_note_info[i], buffer, buflen);
     }
 
-  /* Get the index to the tail of the circular buffer */
-
-  tail    = g_note_info.ni_tail;
-  DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
-
-  /* Get the length of the note at the tail index */
-
-  note    = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
-
-  /* Is the user buffer large enough to hold the note? */
-
-  if (buflen < notelen)
-    {
-      /* Remove the large note so that we do not get constipated. */
-
-      note_remove();
-
-      /* and return an error */
-
-      notelen = -EFBIG;
-      goto errout_with_csection;
-    }
-
-  /* Loop until the note has been transferred to the user buffer */
-
-  remaining = (unsigned int)notelen;
-  while (remaining > 0)
-    {
-      /* Copy the next byte at the tail index */
-
-      *buffer++ = g_note_info.ni_buffer[tail];
-
-      /* Adjust indices and counts */
-
-      tail = note_next(tail, 1);
-      remaining--;
-    }
-
-  g_note_info.ni_tail = tail;
-
-errout_with_csection:
-  leave_critical_section(flags);
+  note_rdunlock();
   return notelen;
 }
 #endif
@@ -695,37 +808,98 @@ errout_with_csection:
 #ifdef CONFIG_SCHED_NOTE_GET
 ssize_t sched_note_size(void)
 {
-  FAR struct note_common_s *note;
-  irqstate_t flags;
-  unsigned int tail;
-  ssize_t notelen;
-  size_t circlen;
-
-  flags = enter_critical_section();
+  ssize_t notelen = 0;
+  int i;
 
-  /* Verify that the circular buffer is not empty */
+  note_rdlock();
 
-  circlen = note_length();
-  if (circlen <= 0)
+  for (i = 0; i < NOTE_NBUFFERS && notelen == 0; i++)
     {
-      notelen = 0;
-      goto errout_with_csection;
+      notelen = note_remove(&g_note_info[i], NULL, 0);
     }
 
-  /* Get the index to the tail of the circular buffer */
+  note_rdunlock();
+  return notelen;
+}
+#endif
 
-  tail = g_note_info.ni_tail;
-  DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
+/****************************************************************************
+ * Name: sched_note_read
+ *
+ * Description:
+ *   Remove as many complete notes as will fit from the note buffers and
+ *   return them back-to-back in the user buffer.  With
+ *   CONFIG_SCHED_NOTE_PERCPU, the notes of the CPUs are interleaved one
+ *   note at a time; notes from the same CPU are always returned in order.
+ *
+ * Input Parameters:
+ *   buffer - Location to return the notes
+ *   buflen - The length of the user provided buffer.
+ *
+ * Returned Value:
+ *   The number of bytes returned.  Zero is returned only if the buffers
+ *   are empty.  -EFBIG is returned if the first note does not fit into the
+ *   user buffer; that note is then discarded.
+ *
+ ****************************************************************************/
 
-  /* Get the length of the note at the tail index */
+#ifdef CONFIG_SCHED_NOTE_GET
+ssize_t sched_note_read(FAR uint8_t *buffer, size_t buflen)
+{
+  FAR struct note_info_s *ni;
+  ssize_t notelen;
+  ssize_t retlen = 0;
+  bool more;
+  int i;
 
-  note    = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
+  DEBUGASSERT(buffer != NULL);
+  note_rdlock();
 
-errout_with_csection:
-  leave_critical_section(flags);
-  return notelen;
+  do
+    {
+      more = false;
+
+      for (i = 0; i < NOTE_NBUFFERS; i++)
+        {
+          ni = &g_note_info[i];
+
+          /* Leave a note that does not fit in the buffer for the next
+           * read, unless nothing could be returned at all.
+           */
+
+          notelen = note_remove(ni, NULL, 0);
+          if (notelen == 0 || (notelen > buflen && retlen > 0))
+            {
+              continue;
+            }
+
+          notelen = note_remove(ni, buffer, buflen);
+          if (notelen <= 0)
+            {
+              /* The note was replaced by a larger one in the meantime and
+               * has been dropped.  Report that only if nothing was read.
+               */
+
+              if (retlen == 0)
+                {
+                  retlen = notelen;
+                  goto errout_with_lock;
+                }
+
+              continue;
+            }
+
+          retlen += notelen;
+          buffer += notelen;
+          buflen -= notelen;
+          more    = true;
+        }
+    }
+  while (more);
+
+errout_with_lock:
+  note_rdunlock();
+  return retlen;
 }
 #endif
 
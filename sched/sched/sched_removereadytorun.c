@@ -216,9 +216,7 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
            * CPU.
            */
 
-          for (rtrtcb = (FAR struct tcb_s *)g_readytorun.head;
-               rtrtcb != NULL && !CPU_ISSET(cpu, &rtrtcb->affinity);
-               rtrtcb = (FAR struct tcb_s *)rtrtcb->flink);
+          rtrtcb = sched_cpu_nexttask(cpu);
         }
 
       /* Did we find a task in the g_readytorun list?  Which task should
@@ -230,20 +228,19 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
 
       if (rtrtcb != NULL && rtrtcb->sched_priority >= nxttcb->sched_priority)
         {
-          FAR struct tcb_s *tmptcb;
-
-          /* The TCB at the head of the ready to run list has the higher
-           * priority.  Remove that task from the head of the g_readytorun
-           * list and add to the head of the g_assignedtasks[cpu] list.
+          /* The TCB from the ready to run list has the higher priority.
+           * Remove that task from the ready-to-run list that holds it and
+           * add to the head of the g_assignedtasks[cpu] list.
            */
 
-          tmptcb = (FAR struct tcb_s *)
-            dq_remfirst((FAR dq_queue_t *)&g_readytorun);
+          dq_rem((FAR dq_entry_t *)rtrtcb,
+                 TLIST_HEAD(TSTATE_TASK_READYTORUN, rtrtcb->cpu));
+          sched_cpu_dequeued(rtrtcb);
 
-          dq_addfirst((FAR dq_entry_t *)tmptcb, tasklist);
+          dq_addfirst((FAR dq_entry_t *)rtrtcb, tasklist);
 
-          tmptcb->cpu = cpu;
-          nxttcb = tmptcb;
+          rtrtcb->cpu = cpu;
+          nxttcb = rtrtcb;
         }
 
       /* Will pre-emption be disabled after the switch?  If the lockcount is
@@ -329,6 +326,10 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
        */
 
       dq_rem((FAR dq_entry_t *)rtcb, tasklist);
+      if (rtcb->task_state == TSTATE_TASK_READYTORUN)
+        {
+          sched_cpu_dequeued(rtcb);
+        }
     }
 
   /* Since the TCB is no longer in any list, it is now invalid */
@@ -133,6 +133,31 @@ int nxsched_setaffinity(pid_t pid, size_t cpusetsize,
    * First... is the task in an assigned task list?
    */
 
+#ifdef CONFIG_SMP_READYTORUN_PERCPU
+  /* With per-CPU ready-to-run lists, unassigned tasks are queued on a CPU
+   * too.  If that CPU is no longer permitted, move the task to the list of
+   * a permitted CPU.  This cannot cause a context switch because the task
+   * stays unassigned.
+   */
+
+  if (tcb->task_state == TSTATE_TASK_READYTORUN)
+    {
+      if ((tcb->affinity & (1 << tcb->cpu)) == 0)
+        {
+          irqstate_t lock = sched_tasklist_lock();
+
+          dq_rem((FAR dq_entry_t *)tcb,
+                 (FAR dq_queue_t *)&g_cpureadytorun[tcb->cpu]);
+          sched_cpu_dequeued(tcb);
+
+          sched_addprioritized(tcb, sched_cpu_readytorun(tcb));
+          sched_cpu_enqueued(tcb);
+
+          sched_tasklist_unlock(lock);
+        }
+    }
+  else
+#endif
   if (tcb->task_state >= FIRST_ASSIGNED_STATE &&
       tcb->task_state <= LAST_ASSIGNED_STATE)
     {
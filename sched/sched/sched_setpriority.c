@@ -88,9 +88,7 @@ static FAR struct tcb_s *nxsched_nexttcb(FAR struct tcb_s *tcb)
     {
       /* Search for the highest priority task that can run on this CPU. */
 
-      for (rtrtcb = (FAR struct tcb_s *)g_readytorun.head;
-           rtrtcb != NULL && !CPU_ISSET(cpu, &rtrtcb->affinity);
-           rtrtcb = (FAR struct tcb_s *)rtrtcb->flink);
+      rtrtcb = sched_cpu_nexttask(cpu);
 
       /* Return the TCB from the readyt-to-run list if it is the next
        * highest priority task.
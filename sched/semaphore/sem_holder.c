@@ -88,12 +88,23 @@ static inline FAR struct semholder_s *nxsem_allocholder(sem_t *sem)
 
   /* Check if the "built-in" holder is being used.  We have this built-in
    * holder to optimize for the simplest case where semaphores are only
-   * used to implement mutexes.
+   * used to implement mutexes:  A mutex never needs more than the built-in
+   * holder and never touches the global pool.
+   *
+   * The built-in holder is never linked into the holder list.  Otherwise,
+   * the semaphore would point into itself and the list would be corrupted
+   * if a held semaphore were moved (for example, by kmm_realloc() of the
+   * structure that contains it).
    */
 
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
-  pholder = g_freeholders;
-  if (pholder != NULL)
+  if (sem->holder.htcb == NULL)
+    {
+      pholder          = &sem->holder;
+      pholder->flink   = NULL;
+      pholder->counts  = 0;
+    }
+  else if ((pholder = g_freeholders) != NULL)
     {
       /* Remove the holder from the free list an put it into the semaphore's
        * holder list
@@ -139,8 +150,15 @@ static FAR struct semholder_s *nxsem_findholder(sem_t *sem,
   FAR struct semholder_s *pholder;
 
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
-  /* Try to find the holder in the list of holders associated with this
-   * semaphore
+  /* Check the built-in holder first */
+
+  if (sem->holder.htcb == htcb)
+    {
+      return &sem->holder;
+    }
+
+  /* Then try to find the holder in the list of holders associated with
+   * this semaphore
    */
 
   for (pholder = sem->hhead; pholder != NULL; pholder = pholder->flink)
@@ -209,6 +227,13 @@ static inline void nxsem_freeholder(sem_t *sem,
   pholder->counts = 0;
 
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
+  /* The built-in holder is not in the list */
+
+  if (pholder == &sem->holder)
+    {
+      return;
+    }
+
   /* Search the list for the matching holder */
 
   for (prev = NULL, curr = sem->hhead;
@@ -236,24 +261,6 @@ static inline void nxsem_freeholder(sem_t *sem,
 #endif
 }
 
-/****************************************************************************
- * Name: nxsem_findandfreeholder
- ****************************************************************************/
-
-static inline void nxsem_findandfreeholder(sem_t *sem, FAR struct tcb_s *htcb)
-{
-  FAR struct semholder_s *pholder = nxsem_findholder(sem, htcb);
-
-  /* When no more counts are held, remove the holder from the list.  The
-   * count was decremented in nxsem_releaseholder.
-   */
-
-  if (pholder != NULL && pholder->counts <= 0)
-    {
-      nxsem_freeholder(sem, pholder);
-    }
-}
-
 /****************************************************************************
  * Name: nxsem_foreachholder
  ****************************************************************************/
@@ -267,6 +274,13 @@ static int nxsem_foreachholder(FAR sem_t *sem, holderhandler_t handler,
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
   FAR struct semholder_s *next;
 
+  /* The built-in holder first */
+
+  if (sem->holder.htcb != NULL)
+    {
+      ret = handler(&sem->holder, sem, arg);
+    }
+
   for (pholder = sem->hhead; pholder && ret == 0; pholder = next)
     {
       /* In case this holder gets deleted */
@@ -660,39 +674,6 @@ static int nxsem_restoreholderprioA(FAR struct semholder_s *pholder,
   return 0;
 }
 
-/****************************************************************************
- * Name: nxsem_restoreholderprioB
- *
- * Description:
- *   Reprioritize only the currently executing task
- *
- ****************************************************************************/
-
-static int nxsem_restoreholderprioB(FAR struct semholder_s *pholder,
-                                    FAR sem_t *sem, FAR void *arg)
-{
-  FAR struct tcb_s *rtcb = this_task();
-
-  if (pholder->htcb == rtcb)
-    {
-      /* The running task has given up a count on the semaphore */
-
-#if CONFIG_SEM_PREALLOCHOLDERS == 0
-      /* In the case where there are only 2 holders. This step
-       * is necessary to insure we have space. Release the holder
-       * if all counts have been given up. before reprioritizing
-       * causes a context switch.
-       */
-
-      nxsem_findandfreeholder(sem, rtcb);
-#endif
-      nxsem_restoreholderprio(rtcb, sem, arg);
-      return 1;
-    }
-
-  return 0;
-}
-
 /****************************************************************************
  * Name: nxsem_restorebaseprio_irq
  *
@@ -790,6 +771,13 @@ static inline void nxsem_restorebaseprio_task(FAR struct tcb_s *stcb,
                                               FAR sem_t *sem)
 {
   FAR struct tcb_s *rtcb = this_task();
+  FAR struct semholder_s *pholder;
+
+  /* Look up the entry of the currently executing task once.  It is needed
+   * both to restore its priority and to release the entry below.
+   */
+
+  pholder = nxsem_findholder(sem, rtcb);
 
   /* Perform the following actions only if a new thread was given a count.
    * The thread that received the count should be the highest priority
@@ -805,15 +793,31 @@ static inline void nxsem_restorebaseprio_task(FAR struct tcb_s *stcb,
        * However, we cannot drop the priority of the currently running
        * thread -- because that will cause it to be suspended.
        *
-       * So, do this in two passes.  First, reprioritizing all holders
-       * except for the running thread.
+       * So, first reprioritize all holders except for the running thread.
        */
 
       nxsem_foreachholder(sem, nxsem_restoreholderprioA, stcb);
 
-      /* Now, find an reprioritize only the ready to run task */
+      /* Now reprioritize only the running task */
 
-      nxsem_foreachholder(sem, nxsem_restoreholderprioB, stcb);
+      if (pholder != NULL)
+        {
+#if CONFIG_SEM_PREALLOCHOLDERS == 0
+          /* In the case where there are only 2 holders. This step
+           * is necessary to insure we have space. Release the holder
+           * if all counts have been given up. before reprioritizing
+           * causes a context switch.
+           */
+
+          if (pholder->counts <= 0)
+            {
+              nxsem_freeholder(sem, pholder);
+              pholder = NULL;
+            }
+#endif
+
+          nxsem_restoreholderprio(rtcb, sem, stcb);
+        }
     }
 
   /* If there are no tasks waiting for available counts, then all holders
@@ -832,7 +836,10 @@ static inline void nxsem_restorebaseprio_task(FAR struct tcb_s *stcb,
    * counts, then we need to remove it from the list of holders.
    */
 
-  nxsem_findandfreeholder(sem, rtcb);
+  if (pholder != NULL && pholder->counts <= 0)
+    {
+      nxsem_freeholder(sem, pholder);
+    }
 }
 
 /****************************************************************************
@@ -908,13 +915,14 @@ void nxsem_destroyholder(FAR sem_t *sem)
    */
 
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
-  if (sem->hhead != NULL)
+  if (sem->hhead != NULL || sem->holder.htcb != NULL)
     {
       /* There may be an issue if there are multiple holders of
        * the semaphore.
        */
 
-      DEBUGASSERT(sem->hhead->flink == NULL);
+      DEBUGASSERT(sem->hhead == NULL || sem->holder.htcb == NULL);
+      DEBUGASSERT(sem->hhead == NULL || sem->hhead->flink == NULL);
       nxsem_foreachholder(sem, nxsem_recoverholders, NULL);
     }
 
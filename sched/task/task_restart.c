@@ -151,6 +151,10 @@ int task_restart(pid_t pid)
 
 #ifdef CONFIG_SMP
   tasklist = TLIST_HEAD(tcb->cmn.task_state, tcb->cmn.cpu);
+  if (tcb->cmn.task_state == TSTATE_TASK_READYTORUN)
+    {
+      sched_cpu_dequeued(&tcb->cmn);
+    }
 #else
   tasklist = TLIST_HEAD(tcb->cmn.task_state);
 #endif
@@ -144,9 +144,15 @@ int nxtask_terminate(pid_t pid, bool nonblocking)
 
   cpu = sched_cpu_pause(dtcb);
 
-  /* Get the task list associated with the thread's state and CPU */
+  /* Get the task list associated with the thread's state and CPU.  If the
+   * thread is not running, then tcb->cpu still indexes its list.
+   */
 
-  tasklist = TLIST_HEAD(dtcb->task_state, cpu);
+  tasklist = TLIST_HEAD(dtcb->task_state, cpu < 0 ? dtcb->cpu : cpu);
+  if (dtcb->task_state == TSTATE_TASK_READYTORUN)
+    {
+      sched_cpu_dequeued(dtcb);
+    }
 #else
   /* In the non-SMP case, we can be assured that the task to be terminated
    * is not running.  get the task list associated with the task state.
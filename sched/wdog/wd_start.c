@@ -71,6 +71,51 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: wd_callout
+ *
+ * Description:
+ *   Execute the function of a watchdog that has been removed from the set
+ *   of active watchdogs.
+ *
+ * Input Parameters:
+ *   wdog - The expired watchdog
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static inline void wd_callout(FAR struct wdog_s *wdog)
+{
+  /* Indicate that the watchdog is no longer active. */
+
+  WDOG_CLRACTIVE(wdog);
+
+  /* Execute the watchdog function */
+
+  up_setpicbase(wdog->picbase);
+
+#if CONFIG_MAX_WDOGPARMS == 0
+  wdog->func(0);
+#elif CONFIG_MAX_WDOGPARMS == 1
+  wdog->func((int)wdog->argc,
+             wdog->parm[0]);
+#elif CONFIG_MAX_WDOGPARMS == 2
+  wdog->func((int)wdog->argc,
+             wdog->parm[0], wdog->parm[1]);
+#elif CONFIG_MAX_WDOGPARMS == 3
+  wdog->func((int)wdog->argc,
+             wdog->parm[0], wdog->parm[1], wdog->parm[2]);
+#elif CONFIG_MAX_WDOGPARMS == 4
+  wdog->func((int)wdog->argc,
+             wdog->parm[0], wdog->parm[1], wdog->parm[2],
+             wdog->parm[3]);
+#else
+#  error Missing support
+#endif
+}
+
 /****************************************************************************
  * Name: wd_expiration
  *
@@ -90,6 +135,15 @@ static inline void wd_expiration(void)
 {
   FAR struct wdog_s *wdog;
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  /* Run all of the watchdogs that expire at the current wheel time */
+
+  while ((wdog = wd_wheel_expire()) != NULL)
+    {
+      wd_callout(wdog);
+    }
+
+#else
   /* Check if the watchdog at the head of the list is ready to run */
 
   if (((FAR struct wdog_s *)g_wdactivelist.head)->lag <= 0)
@@ -114,34 +168,12 @@ static inline void wd_expiration(void)
               ((FAR struct wdog_s *)g_wdactivelist.head)->lag += wdog->lag;
             }
 
-          /* Indicate that the watchdog is no longer active. */
-
-          WDOG_CLRACTIVE(wdog);
-
           /* Execute the watchdog function */
 
-          up_setpicbase(wdog->picbase);
-
-#if CONFIG_MAX_WDOGPARMS == 0
-          wdog->func(0);
-#elif CONFIG_MAX_WDOGPARMS == 1
-          wdog->func((int)wdog->argc,
-                     wdog->parm[0]);
-#elif CONFIG_MAX_WDOGPARMS == 2
-          wdog->func((int)wdog->argc,
-                     wdog->parm[0], wdog->parm[1]);
-#elif CONFIG_MAX_WDOGPARMS == 3
-          wdog->func((int)wdog->argc,
-                     wdog->parm[0], wdog->parm[1], wdog->parm[2]);
-#elif CONFIG_MAX_WDOGPARMS == 4
-          wdog->func((int)wdog->argc,
-                     wdog->parm[0], wdog->parm[1], wdog->parm[2],
-                     wdog->parm[3]);
-#else
-#  error Missing support
-#endif
+          wd_callout(wdog);
         }
     }
+#endif
 }
 
 /****************************************************************************
@@ -185,10 +217,12 @@ static inline void wd_expiration(void)
 int wd_start(WDOG_ID wdog, int32_t delay, wdentry_t wdentry,  int argc, ...)
 {
   va_list ap;
+#ifndef CONFIG_WDOG_TIMERWHEEL
   FAR struct wdog_s *curr;
   FAR struct wdog_s *prev;
   FAR struct wdog_s *next;
   int32_t now;
+#endif
   irqstate_t flags;
   int i;
 
@@ -253,6 +287,21 @@ int wd_start(WDOG_ID wdog, int32_t delay, wdentry_t wdentry,  int argc, ...)
   sched_timer_cancel();
 #endif
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+#ifdef CONFIG_SCHED_TICKLESS
+  if (wd_wheel_empty())
+    {
+      /* Update clock tickbase */
+
+      g_wdtickbase = clock_systimer();
+    }
+#endif
+
+  /* Drop the watchdog into the slot for its expiration time */
+
+  wd_wheel_insert(wdog, delay);
+
+#else
   /* Do the easy case first -- when the watchdog timer queue is empty. */
 
   if (g_wdactivelist.head == NULL)
@@ -343,9 +392,13 @@ int wd_start(WDOG_ID wdog, int32_t delay, wdentry_t wdentry,  int argc, ...)
         }
     }
 
-  /* Put the lag into the watchdog structure and mark it as active. */
+  /* Put the lag into the watchdog structure. */
 
   wdog->lag = delay;
+#endif
+
+  /* Mark the watchdog as active. */
+
   WDOG_SETACTIVE(wdog);
 
 #ifdef CONFIG_SCHED_TICKLESS
@@ -389,7 +442,9 @@ int wd_start(WDOG_ID wdog, int32_t delay, wdentry_t wdentry,  int argc, ...)
 #ifdef CONFIG_SCHED_TICKLESS
 unsigned int wd_timer(int ticks)
 {
+#ifndef CONFIG_WDOG_TIMERWHEEL
   FAR struct wdog_s *wdog;
+#endif
 #ifdef CONFIG_SMP
   irqstate_t flags;
 #endif
@@ -409,6 +464,25 @@ unsigned int wd_timer(int ticks)
   flags = enter_critical_section();
 #endif
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  /* Step the wheel through the interval, stopping at each tick where
+   * watchdogs expire.
+   */
+
+  while (ticks > 0)
+    {
+      decr          = wd_wheel_advance(ticks);
+      ticks        -= decr;
+      g_wdtickbase += decr;
+
+      wd_expiration();
+    }
+
+  /* Return the delay until the wheel needs attention again */
+
+  ret = wd_wheel_nextdelay();
+
+#else
   /* Check if there are any active watchdogs to process */
 
   while (g_wdactivelist.head != NULL && ticks > 0)
@@ -448,6 +522,7 @@ unsigned int wd_timer(int ticks)
 
   ret = g_wdactivelist.head ?
           ((FAR struct wdog_s *)g_wdactivelist.head)->lag : 0;
+#endif
 
 #ifdef CONFIG_SMP
   leave_critical_section(flags);
@@ -476,6 +551,13 @@ void wd_timer(void)
   flags = enter_critical_section();
 #endif
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  /* Advance the wheel by one tick and run the watchdogs that expire */
+
+  wd_wheel_advance(1);
+  wd_expiration();
+
+#else
   /* Check if there are any active watchdogs to process */
 
   if (g_wdactivelist.head)
@@ -488,6 +570,7 @@ void wd_timer(void)
 
       wd_expiration();
     }
+#endif
 
 #ifdef CONFIG_SMP
   leave_critical_section(flags);
@@ -0,0 +1,422 @@
+/****************************************************************************
+ * sched/wdog/wd_wheel.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <assert.h>
+
+#include <nuttx/wdog.h>
+
+#include "wdog/wdog.h"
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The range of delays that can be held in the wheel */
+
+#define WDOG_WHEEL_RANGE   ((uint32_t)1 << (WDOG_WHEEL_BITS * WDOG_WHEEL_NLEVELS))
+
+/* The number of bits to shift the wheel time to get the slot index at a
+ * level.
+ */
+
+#define WDOG_WHEEL_SHIFT(l) (WDOG_WHEEL_BITS * (l))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Each slot holds a doubly linked list of watchdogs.  Watchdogs are added
+ * at the tail so that watchdogs with the same expiration time run in the
+ * order that they were started, as with the sorted list.
+ */
+
+struct wd_slot_s
+{
+  FAR struct wdog_s *head;
+  FAR struct wdog_s *tail;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The slots of all levels.  Level 0 holds the watchdogs that expire within
+ * the next WDOG_WHEEL_NSLOTS ticks, one slot per tick.  Each slot of level
+ * n spans WDOG_WHEEL_NSLOTS**n ticks; its watchdogs are redistributed to
+ * the lower levels when the wheel time reaches the start of the slot.
+ */
+
+static struct wd_slot_s g_wdwheel[WDOG_WHEEL_NLEVELS * WDOG_WHEEL_NSLOTS];
+
+/* The current wheel time, in ticks.  This is advanced by wd_timer() and
+ * wraps around.
+ */
+
+static uint32_t g_wdnow;
+
+/* The number of watchdogs in the wheel */
+
+static unsigned int g_wdnactive;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_slot_add and wd_slot_remove
+ ****************************************************************************/
+
+static inline void wd_slot_add(FAR struct wdog_s *wdog, unsigned int slot)
+{
+  FAR struct wd_slot_s *ws = &g_wdwheel[slot];
+
+  wdog->slot = slot;
+  wdog->next = NULL;
+  wdog->prev = ws->tail;
+
+  if (ws->tail != NULL)
+    {
+      ws->tail->next = wdog;
+    }
+  else
+    {
+      ws->head = wdog;
+    }
+
+  ws->tail = wdog;
+}
+
+static inline void wd_slot_remove(FAR struct wdog_s *wdog)
+{
+  FAR struct wd_slot_s *ws = &g_wdwheel[wdog->slot];
+
+  if (wdog->prev != NULL)
+    {
+      wdog->prev->next = wdog->next;
+    }
+  else
+    {
+      ws->head = wdog->next;
+    }
+
+  if (wdog->next != NULL)
+    {
+      wdog->next->prev = wdog->prev;
+    }
+  else
+    {
+      ws->tail = wdog->prev;
+    }
+
+  wdog->next = NULL;
+  wdog->prev = NULL;
+}
+
+/****************************************************************************
+ * Name: wd_place
+ *
+ * Description:
+ *   Put the watchdog into the slot that corresponds to its expiration time
+ *   relative to the current wheel time.  Delays beyond the range of the
+ *   wheel are placed in the last slot that can be reached; the watchdog is
+ *   placed again when that slot is redistributed.
+ *
+ ****************************************************************************/
+
+static void wd_place(FAR struct wdog_s *wdog)
+{
+  uint32_t expire = wdog->expire;
+  uint32_t delta  = expire - g_wdnow;
+  int level = 0;
+
+  if ((int32_t)delta <= 0)
+    {
+      /* Already due: Use the current level 0 slot */
+
+      expire = g_wdnow;
+    }
+  else
+    {
+      if (delta >= WDOG_WHEEL_RANGE)
+        {
+          delta  = WDOG_WHEEL_RANGE - 1;
+          expire = g_wdnow + delta;
+        }
+
+      while (level < WDOG_WHEEL_NLEVELS - 1 &&
+             delta >= ((uint32_t)1 << WDOG_WHEEL_SHIFT(level + 1)))
+        {
+          level++;
+        }
+    }
+
+  wd_slot_add(wdog, level * WDOG_WHEEL_NSLOTS +
+                    ((expire >> WDOG_WHEEL_SHIFT(level)) & WDOG_WHEEL_MASK));
+}
+
+/****************************************************************************
+ * Name: wd_cascade
+ *
+ * Description:
+ *   Redistribute the higher-level slots that start at the current wheel
+ *   time.  Higher levels are processed first so that their watchdogs can
+ *   fall through to the lowest level in one pass.
+ *
+ ****************************************************************************/
+
+static void wd_cascade(void)
+{
+  FAR struct wdog_s *wdog;
+  FAR struct wdog_s *next;
+  FAR struct wd_slot_s *ws;
+  int level;
+
+  for (level = WDOG_WHEEL_NLEVELS - 1; level > 0; level--)
+    {
+      uint32_t mask = ((uint32_t)1 << WDOG_WHEEL_SHIFT(level)) - 1;
+
+      if ((g_wdnow & mask) != 0)
+        {
+          continue;
+        }
+
+      ws = &g_wdwheel[level * WDOG_WHEEL_NSLOTS +
+                      ((g_wdnow >> WDOG_WHEEL_SHIFT(level)) &
+                       WDOG_WHEEL_MASK)];
+
+      wdog     = ws->head;
+      ws->head = NULL;
+      ws->tail = NULL;
+
+      for (; wdog != NULL; wdog = next)
+        {
+          next = wdog->next;
+          wd_place(wdog);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_initialize
+ ****************************************************************************/
+
+void wd_wheel_initialize(void)
+{
+  int i;
+
+  for (i = 0; i < WDOG_WHEEL_NLEVELS * WDOG_WHEEL_NSLOTS; i++)
+    {
+      g_wdwheel[i].head = NULL;
+      g_wdwheel[i].tail = NULL;
+    }
+
+  g_wdnow     = 0;
+  g_wdnactive = 0;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_insert
+ ****************************************************************************/
+
+void wd_wheel_insert(FAR struct wdog_s *wdog, int32_t delay)
+{
+  DEBUGASSERT(delay > 0);
+
+  wdog->expire = g_wdnow + (uint32_t)delay;
+  wd_place(wdog);
+  g_wdnactive++;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_remove
+ ****************************************************************************/
+
+void wd_wheel_remove(FAR struct wdog_s *wdog)
+{
+  DEBUGASSERT(g_wdnactive > 0);
+
+  wd_slot_remove(wdog);
+  g_wdnactive--;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_empty
+ ****************************************************************************/
+
+bool wd_wheel_empty(void)
+{
+  return g_wdnactive == 0;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_gettime
+ ****************************************************************************/
+
+int wd_wheel_gettime(FAR struct wdog_s *wdog)
+{
+  return (int)(int32_t)(wdog->expire - g_wdnow);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_advance
+ ****************************************************************************/
+
+unsigned int wd_wheel_advance(unsigned int ticks)
+{
+  unsigned int step;
+
+  if (ticks == 0)
+    {
+      return 0;
+    }
+
+  /* If the wheel is empty, then there is nothing to stop at */
+
+  if (g_wdnactive == 0)
+    {
+      g_wdnow += ticks;
+      return ticks;
+    }
+
+  /* Otherwise, move to the next tick that needs attention (the common case
+   * of the periodic timer needs no search).
+   */
+
+  step = 1;
+  if (ticks > 1)
+    {
+      step = wd_wheel_nextdelay();
+      if (step == 0 || step > ticks)
+        {
+          step = ticks;
+        }
+    }
+
+  g_wdnow += step;
+  wd_cascade();
+  return step;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_expire
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expire(void)
+{
+  FAR struct wd_slot_s *ws = &g_wdwheel[g_wdnow & WDOG_WHEEL_MASK];
+  FAR struct wdog_s *wdog;
+
+  while ((wdog = ws->head) != NULL)
+    {
+      wd_slot_remove(wdog);
+
+      /* This should not happen, but check that the watchdog is really due
+       * before returning it.
+       */
+
+      if ((int32_t)(wdog->expire - g_wdnow) > 0)
+        {
+          wd_place(wdog);
+          continue;
+        }
+
+      g_wdnactive--;
+      return wdog;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_nextdelay
+ ****************************************************************************/
+
+unsigned int wd_wheel_nextdelay(void)
+{
+  unsigned int best = UINT_MAX;
+  unsigned int index;
+  unsigned int delay;
+  uint32_t elapsed;
+  int level;
+  int d;
+
+  if (g_wdnactive == 0)
+    {
+      return 0;
+    }
+
+  /* Level 0 gives the exact delay to the next expiration within the next
+   * WDOG_WHEEL_NSLOTS ticks.
+   */
+
+  for (d = 1; d < WDOG_WHEEL_NSLOTS; d++)
+    {
+      if (g_wdwheel[(g_wdnow + d) & WDOG_WHEEL_MASK].head != NULL)
+        {
+          best = d;
+          break;
+        }
+    }
+
+  /* For the higher levels, find the start of the first occupied slot.  The
+   * current slot of a level is reached again only after a full turn.
+   */
+
+  for (level = 1; level < WDOG_WHEEL_NLEVELS; level++)
+    {
+      index   = (g_wdnow >> WDOG_WHEEL_SHIFT(level)) & WDOG_WHEEL_MASK;
+      elapsed = g_wdnow & (((uint32_t)1 << WDOG_WHEEL_SHIFT(level)) - 1);
+
+      for (d = 1; d <= WDOG_WHEEL_NSLOTS; d++)
+        {
+          if (g_wdwheel[level * WDOG_WHEEL_NSLOTS +
+                        ((index + d) & WDOG_WHEEL_MASK)].head != NULL)
+            {
+              delay = ((uint32_t)d << WDOG_WHEEL_SHIFT(level)) - elapsed;
+              if (delay < best)
+                {
+                  best = delay;
+                }
+
+              break;
+            }
+        }
+    }
+
+  DEBUGASSERT(best != UINT_MAX);
+  return best;
+}
+
+#endif /* CONFIG_WDOG_TIMERWHEEL */
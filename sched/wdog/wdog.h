@@ -70,6 +70,19 @@
 #  define wd_elapse() (0)
 #endif
 
+/* Timing wheel geometry.  Each level has WDOG_WHEEL_NSLOTS slots and each
+ * slot of a level spans all of the slots of the level below.  Together the
+ * levels cover delays of up to 2**(WDOG_WHEEL_BITS * WDOG_WHEEL_NLEVELS)
+ * ticks; longer delays are re-inserted as they come within range.
+ */
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+#  define WDOG_WHEEL_BITS    5
+#  define WDOG_WHEEL_NSLOTS  (1 << WDOG_WHEEL_BITS)
+#  define WDOG_WHEEL_MASK    (WDOG_WHEEL_NSLOTS - 1)
+#  define WDOG_WHEEL_NLEVELS 5
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -90,10 +103,13 @@ extern sq_queue_t g_wdfreelist;
 
 /* The g_wdactivelist data structure is a singly linked list ordered by
  * watchdog expiration time. When watchdog timers expire,the functions on
- * this linked list are removed and the function is called.
+ * this linked list are removed and the function is called.  It is not
+ * used if the watchdogs are kept in a timing wheel.
  */
 
+#ifndef CONFIG_WDOG_TIMERWHEEL
 extern sq_queue_t g_wdactivelist;
+#endif
 
 /* This is the number of free, pre-allocated watchdog structures in the
  * g_wdfreelist.  This value is used to enforce a reserve for interrupt
@@ -166,6 +182,83 @@ unsigned int wd_timer(int ticks);
 void wd_timer(void);
 #endif
 
+/****************************************************************************
+ * Name: wd_wheel_initialize, wd_wheel_insert, wd_wheel_remove
+ *
+ * Description:
+ *   Initialize the timing wheel, add a watchdog to it that will expire
+ *   after 'delay' wheel ticks, or remove an active watchdog from it.
+ *   These take constant time.
+ *
+ * Assumptions:
+ *   Called in a critical section.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+void wd_wheel_initialize(void);
+void wd_wheel_insert(FAR struct wdog_s *wdog, int32_t delay);
+void wd_wheel_remove(FAR struct wdog_s *wdog);
+
+/****************************************************************************
+ * Name: wd_wheel_empty
+ *
+ * Description:
+ *   Return true if there are no active watchdogs in the timing wheel.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_empty(void);
+
+/****************************************************************************
+ * Name: wd_wheel_gettime
+ *
+ * Description:
+ *   Return the number of wheel ticks until the active watchdog expires.
+ *
+ ****************************************************************************/
+
+int wd_wheel_gettime(FAR struct wdog_s *wdog);
+
+/****************************************************************************
+ * Name: wd_wheel_advance
+ *
+ * Description:
+ *   Advance the wheel time by up to 'ticks' ticks.  The advance stops early
+ *   at the first tick where watchdogs expire.  Those watchdogs may then be
+ *   removed with wd_wheel_expire().
+ *
+ * Returned Value:
+ *   The number of ticks actually consumed.
+ *
+ ****************************************************************************/
+
+unsigned int wd_wheel_advance(unsigned int ticks);
+
+/****************************************************************************
+ * Name: wd_wheel_expire
+ *
+ * Description:
+ *   Remove and return the next watchdog that expires at the current wheel
+ *   time, or NULL if there are none.
+ *
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expire(void);
+
+/****************************************************************************
+ * Name: wd_wheel_nextdelay
+ *
+ * Description:
+ *   Return the number of ticks until the wheel next requires attention,
+ *   either because a watchdog expires or because a higher-level slot must
+ *   be redistributed.  Zero is returned if there are no active watchdogs.
+ *
+ ****************************************************************************/
+
+unsigned int wd_wheel_nextdelay(void);
+#endif /* CONFIG_WDOG_TIMERWHEEL */
+
 /****************************************************************************
  * Name: wd_recover
  *
@@ -265,6 +265,7 @@ SYSCALL_LOOKUP(up_assert,                  2, STUB_up_assert)
 
 #if defined(CONFIG_FS_RAMMAP)
   SYSCALL_LOOKUP(munmap,                   2, STUB_munmap)
+  SYSCALL_LOOKUP(msync,                    3, STUB_msync)
 #endif
 
 #if defined(CONFIG_PSEUDOFS_SOFTLINKS)
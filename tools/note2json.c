@@ -0,0 +1,454 @@
+/****************************************************************************
+ * tools/note2json.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MAX_PID   65536
+#define MAX_CPUS  256
+#define MAX_NOTE  256
+
+/* Note types.  These must match enum note_type_e in
+ * include/nuttx/sched_note.h
+ */
+
+#define NOTE_START           0
+#define NOTE_STOP            1
+#define NOTE_SUSPEND         2
+#define NOTE_RESUME          3
+#define NOTE_CPU_START       4
+#define NOTE_CPU_STARTED     5
+#define NOTE_CPU_PAUSE       6
+#define NOTE_CPU_PAUSED      7
+#define NOTE_CPU_RESUME      8
+#define NOTE_CPU_RESUMED     9
+#define NOTE_PREEMPT_LOCK    10
+#define NOTE_PREEMPT_UNLOCK  11
+#define NOTE_CSECTION_ENTER  12
+#define NOTE_CSECTION_LEAVE  13
+#define NOTE_SPINLOCK_LOCK   14
+#define NOTE_SPINLOCK_LOCKED 15
+#define NOTE_SPINLOCK_UNLOCK 16
+#define NOTE_SPINLOCK_ABORT  17
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The decoded common header of a note (struct note_common_s) */
+
+struct note_s
+{
+  unsigned int length;
+  unsigned int type;
+  unsigned int priority;
+  unsigned int cpu;
+  unsigned int pid;
+  uint64_t     time;           /* Time in microseconds */
+  const uint8_t *payload;      /* Data following the common header */
+  unsigned int paylen;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static bool g_smp;               /* Notes include the CPU index */
+static double g_usec = 10000.0;  /* Microseconds per timer tick */
+static FILE *g_out;
+static bool g_first = true;
+
+static uint64_t g_ticks;         /* Extended timer tick count */
+static bool g_haveticks;
+
+static char *g_names[MAX_PID];   /* Task names from NOTE_START */
+static unsigned int g_running[MAX_CPUS];  /* Running PID + 1, 0 if unknown */
+static bool g_cpuseen[MAX_CPUS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void show_usage(const char *progname, int exitcode)
+{
+  fprintf(stderr, "USAGE: %s [-s] [-t <usec>] <infile> [<outfile>]\n",
+          progname);
+  fprintf(stderr, "       %s -h\n\n", progname);
+  fprintf(stderr, "Convert the binary scheduler notes read from /dev/note "
+          "into a Chrome trace\n");
+  fprintf(stderr, "event file that can be loaded into chrome://tracing or "
+          "the Perfetto UI.\n\n");
+  fprintf(stderr, "Where:\n");
+  fprintf(stderr, "  -s         The notes come from an SMP configuration "
+          "(CONFIG_SMP=y)\n");
+  fprintf(stderr, "  -t <usec>  Microseconds per timer tick "
+          "(CONFIG_USEC_PER_TICK, default 10000)\n");
+  fprintf(stderr, "  -h         Show this help text and exit\n");
+  fprintf(stderr, "  <infile>   The binary note data\n");
+  fprintf(stderr, "  <outfile>  The JSON output file (default stdout)\n");
+  exit(exitcode);
+}
+
+/* Extend the 32-bit timer tick count of a note.  Notes from different CPUs
+ * may be slightly out of order, so the count may also step back.
+ */
+
+static uint64_t note_time(uint32_t systime)
+{
+  if (!g_haveticks)
+    {
+      g_ticks     = systime;
+      g_haveticks = true;
+    }
+  else
+    {
+      g_ticks += (int32_t)(systime - (uint32_t)g_ticks);
+    }
+
+  return (uint64_t)(g_ticks * g_usec);
+}
+
+static const char *task_name(unsigned int pid, char *buffer, size_t len)
+{
+  if (g_names[pid] != NULL)
+    {
+      snprintf(buffer, len, "%s (%u)", g_names[pid], pid);
+    }
+  else
+    {
+      snprintf(buffer, len, "PID %u", pid);
+    }
+
+  return buffer;
+}
+
+static void put_json_string(const char *str)
+{
+  fputc('"', g_out);
+  for (; *str != '\0'; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        {
+          fprintf(g_out, "\\%c", *str);
+        }
+      else if ((unsigned char)*str < 0x20)
+        {
+          fprintf(g_out, "\\u%04x", (unsigned char)*str);
+        }
+      else
+        {
+          fputc(*str, g_out);
+        }
+    }
+
+  fputc('"', g_out);
+}
+
+/* Emit one trace event.  All events are placed on the timeline of the CPU
+ * that generated them.
+ */
+
+static void put_event(const char *name, const char *phase,
+                      const struct note_s *note, const char *args)
+{
+  fprintf(g_out, "%s\n  {\"name\": ", g_first ? "" : ",");
+  put_json_string(name);
+  fprintf(g_out, ", \"ph\": \"%s\", \"ts\": %llu, \"pid\": 0, \"tid\": %u",
+          phase, (unsigned long long)note->time, note->cpu);
+
+  if (phase[0] == 'i')
+    {
+      fprintf(g_out, ", \"s\": \"t\"");
+    }
+
+  if (args != NULL)
+    {
+      fprintf(g_out, ", \"args\": {%s}", args);
+    }
+
+  fprintf(g_out, "}");
+  g_first = false;
+}
+
+static void put_cpuname(unsigned int cpu)
+{
+  fprintf(g_out, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", "
+          "\"pid\": 0, \"tid\": %u, \"args\": {\"name\": \"CPU%u\"}}",
+          g_first ? "" : ",", cpu, cpu);
+  g_first = false;
+}
+
+/* End the slice of the task running on the CPU of the note, if any */
+
+static void end_running(const struct note_s *note)
+{
+  char name[64];
+
+  if (g_running[note->cpu] != 0)
+    {
+      put_event(task_name(g_running[note->cpu] - 1, name, sizeof(name)),
+                "E", note, NULL);
+      g_running[note->cpu] = 0;
+    }
+}
+
+static void convert_note(const struct note_s *note)
+{
+  char name[64];
+  char args[64];
+  unsigned int count;
+
+  if (!g_cpuseen[note->cpu])
+    {
+      put_cpuname(note->cpu);
+      g_cpuseen[note->cpu] = true;
+    }
+
+  task_name(note->pid, name, sizeof(name));
+  snprintf(args, sizeof(args), "\"pid\": %u, \"priority\": %u",
+           note->pid, note->priority);
+
+  switch (note->type)
+    {
+      case NOTE_START:
+        free(g_names[note->pid]);
+        g_names[note->pid] = strndup((const char *)note->payload,
+                                     note->paylen);
+        snprintf(name, sizeof(name), "start %s", g_names[note->pid]);
+        put_event(name, "i", note, args);
+        break;
+
+      case NOTE_STOP:
+        if (g_running[note->cpu] == note->pid + 1)
+          {
+            end_running(note);
+          }
+
+        snprintf(args, sizeof(args), "\"pid\": %u", note->pid);
+        put_event("stop", "i", note, args);
+        break;
+
+      case NOTE_SUSPEND:
+        if (g_running[note->cpu] == note->pid + 1)
+          {
+            end_running(note);
+          }
+        break;
+
+      case NOTE_RESUME:
+        end_running(note);
+        put_event(name, "B", note, args);
+        g_running[note->cpu] = note->pid + 1;
+        break;
+
+      case NOTE_CPU_START:
+      case NOTE_CPU_PAUSE:
+      case NOTE_CPU_RESUME:
+        snprintf(args, sizeof(args), "\"pid\": %u, \"target\": %u",
+                 note->pid, note->paylen > 0 ? note->payload[0] : 0);
+        put_event(note->type == NOTE_CPU_START ? "cpu start" :
+                  note->type == NOTE_CPU_PAUSE ? "cpu pause" : "cpu resume",
+                  "i", note, args);
+        break;
+
+      case NOTE_CPU_STARTED:
+      case NOTE_CPU_PAUSED:
+      case NOTE_CPU_RESUMED:
+        put_event(note->type == NOTE_CPU_STARTED ? "cpu started" :
+                  note->type == NOTE_CPU_PAUSED ? "cpu paused" :
+                  "cpu resumed", "i", note, args);
+        break;
+
+      case NOTE_PREEMPT_LOCK:
+      case NOTE_PREEMPT_UNLOCK:
+        count = note->paylen >= 2 ?
+                note->payload[0] | (note->payload[1] << 8) : 0;
+        snprintf(args, sizeof(args), "\"pid\": %u, \"count\": %u",
+                 note->pid, count);
+        put_event(note->type == NOTE_PREEMPT_LOCK ? "sched_lock" :
+                  "sched_unlock", "i", note, args);
+        break;
+
+      case NOTE_CSECTION_ENTER:
+      case NOTE_CSECTION_LEAVE:
+        put_event(note->type == NOTE_CSECTION_ENTER ? "csection enter" :
+                  "csection leave", "i", note, args);
+        break;
+
+      case NOTE_SPINLOCK_LOCK:
+      case NOTE_SPINLOCK_LOCKED:
+      case NOTE_SPINLOCK_UNLOCK:
+      case NOTE_SPINLOCK_ABORT:
+        put_event(note->type == NOTE_SPINLOCK_LOCK ? "spin lock" :
+                  note->type == NOTE_SPINLOCK_LOCKED ? "spin locked" :
+                  note->type == NOTE_SPINLOCK_UNLOCK ? "spin unlock" :
+                  "spin abort", "i", note, args);
+        break;
+
+      default:
+        fprintf(stderr, "WARNING: Unknown note type %u\n", note->type);
+        break;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  uint8_t buffer[MAX_NOTE];
+  struct note_s note;
+  unsigned int hdrlen;
+  unsigned long offset = 0;
+  unsigned long nnotes = 0;
+  uint32_t systime;
+  FILE *in;
+  int ch;
+  int i;
+
+  while ((ch = getopt(argc, argv, ":st:h")) > 0)
+    {
+      switch (ch)
+        {
+          case 's':
+            g_smp = true;
+            break;
+
+          case 't':
+            g_usec = strtod(optarg, NULL);
+            if (g_usec <= 0.0)
+              {
+                fprintf(stderr, "ERROR: Invalid tick period: %s\n", optarg);
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            fprintf(stderr, "ERROR: Unrecognized option\n");
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (optind >= argc || argc - optind > 2)
+    {
+      fprintf(stderr, "ERROR: Expected input and optional output file\n");
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  in = fopen(argv[optind], "rb");
+  if (in == NULL)
+    {
+      fprintf(stderr, "ERROR: Failed to open %s\n", argv[optind]);
+      exit(EXIT_FAILURE);
+    }
+
+  g_out = stdout;
+  if (argc - optind == 2)
+    {
+      g_out = fopen(argv[optind + 1], "w");
+      if (g_out == NULL)
+        {
+          fprintf(stderr, "ERROR: Failed to open %s\n", argv[optind + 1]);
+          exit(EXIT_FAILURE);
+        }
+    }
+
+  /* struct note_common_s: length, type, priority, [cpu], pid[2],
+   * systime[4]
+   */
+
+  hdrlen = g_smp ? 10 : 9;
+
+  fprintf(g_out, "{\"displayTimeUnit\": \"us\", \"traceEvents\": [");
+
+  while ((ch = fgetc(in)) != EOF)
+    {
+      if (ch < (int)hdrlen)
+        {
+          fprintf(stderr, "ERROR: Bad note length %d at offset %lu\n",
+                  ch, offset);
+          break;
+        }
+
+      buffer[0] = (uint8_t)ch;
+      if (fread(&buffer[1], 1, ch - 1, in) != (size_t)(ch - 1))
+        {
+          fprintf(stderr, "ERROR: Truncated note at offset %lu\n", offset);
+          break;
+        }
+
+      i = 3;
+      note.length   = buffer[0];
+      note.type     = buffer[1];
+      note.priority = buffer[2];
+      note.cpu      = g_smp ? buffer[i++] : 0;
+      note.pid      = buffer[i] | (buffer[i + 1] << 8);
+      i += 2;
+
+      systime       = (uint32_t)buffer[i] |
+                      ((uint32_t)buffer[i + 1] << 8) |
+                      ((uint32_t)buffer[i + 2] << 16) |
+                      ((uint32_t)buffer[i + 3] << 24);
+      note.time     = note_time(systime);
+      note.payload  = &buffer[hdrlen];
+      note.paylen   = note.length - hdrlen;
+
+      /* The task name in NOTE_START is NUL terminated */
+
+      if (note.type == NOTE_START && note.paylen > 0 &&
+          note.payload[note.paylen - 1] == '\0')
+        {
+          note.paylen--;
+        }
+
+      convert_note(&note);
+      offset += note.length;
+      nnotes++;
+    }
+
+  fprintf(g_out, "\n]}\n");
+  fprintf(stderr, "Converted %lu notes\n", nnotes);
+
+  fclose(in);
+  if (g_out != stdout)
+    {
+      fclose(g_out);
+    }
+
+  return 0;
+}